@@ -14,6 +14,7 @@ LOCAL_SRC_FILES += \
     HAL3/QCamera3Mem.cpp \
     HAL3/QCamera3Stream.cpp \
     HAL3/QCamera3Channel.cpp \
+    HAL3/QCamera3RawUnpack.cpp \
     HAL3/QCamera3VendorTags.cpp \
     HAL3/QCamera3PostProc.cpp \
     HAL3/QCamera3CropRegionMapper.cpp
@@ -75,4 +76,23 @@ LOCAL_VENDOR_MODULE := true
 LOCAL_32_BIT_ONLY := true
 include $(BUILD_SHARED_LIBRARY)
 
+# Host harness for the raw16 unpack kernels: checks every kernel level
+# bit for bit against the reference and times them on a full frame.
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+        HAL3/test/QCamera3RawUnpackTest.cpp \
+        HAL3/QCamera3RawUnpack.cpp
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror -DRAW16_UNPACK_HOST
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/HAL3
+
+LOCAL_STATIC_LIBRARIES := libcutils liblog
+LOCAL_LDLIBS := -lpthread
+
+LOCAL_MODULE := qcamera3_raw_unpack_test
+LOCAL_MODULE_HOST_OS := linux
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_HOST_EXECUTABLE)
+
 include $(call first-makefiles-under,$(LOCAL_PATH))
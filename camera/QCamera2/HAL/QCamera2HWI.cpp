@@ -2323,6 +2323,9 @@ int QCamera2HardwareInterface::startPreview()
             mCameraHandle->ops->cancel_auto_focus(mCameraHandle->camera_handle);
     }
     updatePostPreviewParameters();
+    if (rc == NO_ERROR) {
+        m_memoryPool.endModeSwitch();
+    }
     CDBG_HIGH("%s: X", __func__);
     return rc;
 }
@@ -2409,9 +2412,17 @@ int QCamera2HardwareInterface::startRecording()
         }
     }
 
+    // Not before the restart above: stopPreview() must not be counted as
+    // part of the video switch, and preparePreview() has already begun it
+    // when the hint was false, which makes this call a no-op
+    m_memoryPool.beginModeSwitch(QCAMERA_MEM_MODE_VIDEO);
+
     if (rc == NO_ERROR) {
         rc = startChannel(QCAMERA_CH_TYPE_VIDEO);
     }
+    if (rc == NO_ERROR) {
+        m_memoryPool.endModeSwitch();
+    }
 
 #ifdef HAS_MULTIMEDIA_HINTS
     if (rc == NO_ERROR) {
@@ -3127,6 +3138,7 @@ int QCamera2HardwareInterface::takePicture()
             return UNKNOWN_ERROR;
         }
     } else {
+        m_memoryPool.beginModeSwitch(QCAMERA_MEM_MODE_CAPTURE);
 
         // start snapshot
         if (mParameters.isJpegPictureFormat() ||
@@ -3224,6 +3236,7 @@ int QCamera2HardwareInterface::takePicture()
                     delChannel(QCAMERA_CH_TYPE_CAPTURE);
                     return rc;
                 }
+                m_memoryPool.endModeSwitch();
 
                 QCameraPicChannel *pCapChannel =
                     (QCameraPicChannel *)m_channels[QCAMERA_CH_TYPE_CAPTURE];
@@ -3286,6 +3299,7 @@ int QCamera2HardwareInterface::takePicture()
                     delChannel(QCAMERA_CH_TYPE_RAW);
                     return rc;
                 }
+                m_memoryPool.endModeSwitch();
             } else {
                 ALOGE("%s: cannot add raw channel", __func__);
                 return rc;
@@ -4238,6 +4252,7 @@ int QCamera2HardwareInterface::dump(int fd)
     dprintf(fd, "StoreMetaDataInFrame: %d \n", mStoreMetaDataInFrame);
     dprintf(fd, "\n Configuration: %s", mParameters.dump().string());
     dprintf(fd, "\n State Information: %s", m_stateMachine.dump().string());
+    dprintf(fd, "\n Memory Pool: %s", m_memoryPool.dump().string());
     dprintf(fd, "\n Camera HAL information End \n");
 
     /* send UPDATE_DEBUG_LEVEL to the backend so that they can read the
@@ -6255,6 +6270,14 @@ int32_t QCamera2HardwareInterface::preparePreview()
     ATRACE_CALL();
     int32_t rc = NO_ERROR;
 
+    if (mParameters.getRecordingHintValue()) {
+        m_memoryPool.beginModeSwitch(QCAMERA_MEM_MODE_VIDEO);
+    } else if (mParameters.isZSLMode()) {
+        m_memoryPool.beginModeSwitch(QCAMERA_MEM_MODE_ZSL_PREVIEW);
+    } else {
+        m_memoryPool.beginModeSwitch(QCAMERA_MEM_MODE_PREVIEW);
+    }
+
     pthread_mutex_lock(&m_parm_lock);
     rc = mParameters.setStreamConfigure(false, false, false);
     if (rc != NO_ERROR) {
@@ -31,8 +31,10 @@
 #define LOG_TAG "QCameraHWI_Mem"
 
 #include <string.h>
+#include <stdlib.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <cutils/properties.h>
 #include <utils/Errors.h>
 #include <utils/Trace.h>
 #include <utils/Log.h>
@@ -526,6 +528,7 @@ int QCameraMemory::allocOneBuffer(QCameraMemInfo &memInfo,
     memInfo.handle = ion_info_fd.handle;
     memInfo.size = alloc.len;
     memInfo.cached = cached;
+    memInfo.secure = (secure_mode == SECURE);
     memInfo.heap_id = heap_id;
 
     ALOGD("%s : ION buffer %lx with size %d allocated",
@@ -582,8 +585,43 @@ void QCameraMemory::deallocOneBuffer(QCameraMemInfo &memInfo)
  * RETURN     : None
  *==========================================================================*/
 QCameraMemoryPool::QCameraMemoryPool()
-{
+    : mBytesHeld(0),
+      mPeakBytesHeld(0),
+      mHighWaterMark(0),
+      mBuffersHeld(0),
+      mReleaseSeq(0),
+      mEvictions(0),
+      mPrefetchedBufs(0),
+      mPrefetchHits(0),
+      mMode(QCAMERA_MEM_MODE_NONE),
+      mPrevMode(QCAMERA_MEM_MODE_NONE),
+      mSwitchPending(false),
+      mSwitchStart(0),
+      mSwitchHits(0),
+      mSwitchMisses(0),
+      mPrefetchEnabled(true),
+      mPrefetchExit(false),
+      mPrefetchLaunched(false),
+      mPoolGen(0),
+      mPrefetchSeq(0),
+      mPrefetchTid(0)
+{
+    char value[PROPERTY_VALUE_MAX];
+
+    memset(mHits, 0, sizeof(mHits));
+    memset(mMisses, 0, sizeof(mMisses));
+    memset(mFootprints, 0, sizeof(mFootprints));
+    memset(&mCurFootprint, 0, sizeof(mCurFootprint));
+    memset(mSwitchStats, 0, sizeof(mSwitchStats));
     pthread_mutex_init(&mLock, NULL);
+    pthread_cond_init(&mPrefetchCond, NULL);
+
+    // High water mark in MB, 0 keeps every released buffer
+    property_get("persist.camera.mem.pool.cap", value, "256");
+    setHighWaterMark((size_t)atoi(value) * 1024 * 1024);
+
+    property_get("persist.camera.mem.prefetch", value, "1");
+    mPrefetchEnabled = (atoi(value) == 1);
 }
 
 
@@ -598,10 +636,43 @@ QCameraMemoryPool::QCameraMemoryPool()
  *==========================================================================*/
 QCameraMemoryPool::~QCameraMemoryPool()
 {
+    pthread_mutex_lock(&mLock);
+    mPrefetchExit = true;
+    pthread_cond_signal(&mPrefetchCond);
+    pthread_mutex_unlock(&mLock);
+    if (mPrefetchLaunched) {
+        pthread_join(mPrefetchTid, NULL);
+    }
+
     clear();
+    pthread_cond_destroy(&mPrefetchCond);
     pthread_mutex_destroy(&mLock);
 }
 
+/*===========================================================================
+ * FUNCTION   : sizeClass
+ *
+ * DESCRIPTION: size class of a buffer, floor(log2(size)) clamped to the
+ *              range of classes kept by the pool
+ *
+ * PARAMETERS :
+ *   @size    : size of the buffer
+ *
+ * RETURN     : size class index
+ *==========================================================================*/
+uint32_t QCameraMemoryPool::sizeClass(size_t size)
+{
+    uint32_t cls = 0;
+
+    size >>= QCAMERA_POOL_MIN_CLASS_SHIFT;
+    while ((size > 1) && (cls < QCAMERA_POOL_NUM_CLASSES - 1)) {
+        size >>= 1;
+        cls++;
+    }
+
+    return cls;
+}
+
 /*===========================================================================
  * FUNCTION   : releaseBuffer
  *
@@ -616,10 +687,118 @@ QCameraMemoryPool::~QCameraMemoryPool()
 void QCameraMemoryPool::releaseBuffer(
         struct QCameraMemory::QCameraMemInfo &memInfo,
         cam_stream_type_t streamType)
+{
+    CDBG("%s: stream %d releases %zu bytes", __func__, streamType,
+            memInfo.size);
+
+    pthread_mutex_lock(&mLock);
+
+    insertBufferLocked(memInfo, false);
+    if (mHighWaterMark > 0) {
+        trimLocked(mHighWaterMark);
+    }
+
+    pthread_mutex_unlock(&mLock);
+}
+
+/*===========================================================================
+ * FUNCTION   : insertBufferLocked
+ *
+ * DESCRIPTION: park a free buffer in its size class
+ *
+ * PARAMETERS :
+ *   @memInfo    : reference to struct that stores additional memory allocation info
+ *   @prefetched : whether the buffer was allocated ahead of time
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::insertBufferLocked(
+        struct QCameraMemory::QCameraMemInfo &memInfo, bool prefetched)
+{
+    QCameraPoolBuffer buf;
+    List<QCameraPoolBuffer>::iterator it;
+
+    buf.memInfo = memInfo;
+    buf.releaseSeq = mReleaseSeq++;
+    buf.prefetched = prefetched;
+
+    // Keep each class sorted by size so the first fit is the best fit
+    List<QCameraPoolBuffer> &pool = mClasses[sizeClass(memInfo.size)];
+    for (it = pool.begin(); it != pool.end(); it++) {
+        if ((*it).memInfo.size > memInfo.size) {
+            break;
+        }
+    }
+    pool.insert(it, buf);
+
+    mBuffersHeld++;
+    mBytesHeld += memInfo.size;
+    if (mBytesHeld > mPeakBytesHeld) {
+        mPeakBytesHeld = mBytesHeld;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : trimLocked
+ *
+ * DESCRIPTION: free least recently released buffers until the pool holds
+ *              no more than the given number of bytes
+ *
+ * PARAMETERS :
+ *   @limit   : number of bytes the pool may keep
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::trimLocked(size_t limit)
+{
+    while ((mBytesHeld > limit) && (mBuffersHeld > 0)) {
+        List<QCameraPoolBuffer>::iterator oldest;
+        int oldest_cls = -1;
+
+        for (int i = 0; i < QCAMERA_POOL_NUM_CLASSES; i++) {
+            List<QCameraPoolBuffer>::iterator it = mClasses[i].begin();
+            for ( ; it != mClasses[i].end(); it++) {
+                if ((oldest_cls < 0) ||
+                        ((int32_t)((*it).releaseSeq -
+                        (*oldest).releaseSeq) < 0)) {
+                    oldest = it;
+                    oldest_cls = i;
+                }
+            }
+        }
+        if (oldest_cls < 0) {
+            break;
+        }
+
+        CDBG_HIGH("%s: evicting %zu bytes, pool holds %zu", __func__,
+                (*oldest).memInfo.size, mBytesHeld);
+        mBytesHeld -= (*oldest).memInfo.size;
+        mBuffersHeld--;
+        mEvictions++;
+        QCameraMemory::deallocOneBuffer((*oldest).memInfo);
+        mClasses[oldest_cls].erase(oldest);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : setHighWaterMark
+ *
+ * DESCRIPTION: set the number of bytes the pool may keep, trimming right
+ *              away if it already holds more
+ *
+ * PARAMETERS :
+ *   @bytes   : high water mark in bytes, 0 for no limit
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::setHighWaterMark(size_t bytes)
 {
     pthread_mutex_lock(&mLock);
 
-    mPools[streamType].push_back(memInfo);
+    mHighWaterMark = bytes;
+    if (mHighWaterMark > 0) {
+        trimLocked(mHighWaterMark);
+    }
 
     pthread_mutex_unlock(&mLock);
 }
@@ -637,15 +816,22 @@ void QCameraMemoryPool::clear()
 {
     pthread_mutex_lock(&mLock);
 
-    for (int i = CAM_STREAM_TYPE_DEFAULT; i < CAM_STREAM_TYPE_MAX; i++ ) {
-        List<struct QCameraMemory::QCameraMemInfo>::iterator it;
-        it = mPools[i].begin();
-        for( ; it != mPools[i].end() ; it++) {
-            QCameraMemory::deallocOneBuffer(*it);
+    for (int i = 0; i < QCAMERA_POOL_NUM_CLASSES; i++) {
+        List<QCameraPoolBuffer>::iterator it;
+        it = mClasses[i].begin();
+        for( ; it != mClasses[i].end() ; it++) {
+            QCameraMemory::deallocOneBuffer((*it).memInfo);
         }
 
-        mPools[i].clear();
+        mClasses[i].clear();
     }
+    mBuffersHeld = 0;
+    mBytesHeld = 0;
+
+    // Buffers the prefetcher is allocating right now are dropped too
+    mPrefetchQueue.clear();
+    mPrefetchSeq++;
+    mPoolGen++;
 
     pthread_mutex_unlock(&mLock);
 }
@@ -653,14 +839,15 @@ void QCameraMemoryPool::clear()
 /*===========================================================================
  * FUNCTION   : findBufferLocked
  *
- * DESCRIPTION: search for a appropriate cached buffer
+ * DESCRIPTION: search for the smallest cached buffer that fits, without
+ *              handing out more than twice the requested size
  *
  * PARAMETERS :
  *   @memInfo : reference to struct that stores additional memory allocation info
  *   @heap_id : type of heap
  *   @size    : size of the buffer
  *   @cached  : whether the buffer should be cached
- *   @streaType: type of stream this buffer belongs to
+ *   @secure  : whether the buffer should be secure
  *
  * RETURN     : int32_t type of status
  *              NO_ERROR  -- success
@@ -668,28 +855,35 @@ void QCameraMemoryPool::clear()
  *==========================================================================*/
 int QCameraMemoryPool::findBufferLocked(
         struct QCameraMemory::QCameraMemInfo &memInfo, unsigned int heap_id,
-        size_t size, bool cached, cam_stream_type_t streamType)
+        size_t size, bool cached, bool secure)
 {
-    int rc = NAME_NOT_FOUND;
+    uint32_t cls = sizeClass(size);
+    uint32_t last_cls = sizeClass(size * 2);
 
-    if (mPools[streamType].empty()) {
-        return NAME_NOT_FOUND;
-    }
-
-    List<struct QCameraMemory::QCameraMemInfo>::iterator it;
-    it = mPools[streamType].begin();
-    for ( ; it != mPools[streamType].end() ; it++) {
-        if ( ((*it).size >= size) &&
-            ((*it).heap_id == heap_id) &&
-            ((*it).cached == cached) ) {
-            memInfo = *it;
-            mPools[streamType].erase(it);
-            rc = NO_ERROR;
-            break;
+    for ( ; cls <= last_cls; cls++) {
+        List<QCameraPoolBuffer>::iterator it = mClasses[cls].begin();
+        for ( ; it != mClasses[cls].end() ; it++) {
+            const QCameraMemory::QCameraMemInfo &info = (*it).memInfo;
+            if (info.size > size * 2) {
+                break;
+            }
+            if ((info.size >= size) &&
+                (info.heap_id == heap_id) &&
+                (info.cached == cached) &&
+                (info.secure == secure)) {
+                memInfo = info;
+                if ((*it).prefetched) {
+                    mPrefetchHits++;
+                }
+                mBytesHeld -= info.size;
+                mBuffersHeld--;
+                mClasses[cls].erase(it);
+                return NO_ERROR;
+            }
         }
     }
 
-    return rc;
+    return NAME_NOT_FOUND;
 }
 
 /*===========================================================================
@@ -718,11 +912,33 @@ int QCameraMemoryPool::allocateBuffer(
 
     pthread_mutex_lock(&mLock);
 
-    rc = findBufferLocked(memInfo, heap_id, size, cached, streamType);
+    if (secure_mode != SECURE) {
+        recordFootprintLocked(heap_id, size, cached, false);
+    }
+
+    rc = findBufferLocked(memInfo, heap_id, size, cached,
+            (secure_mode == SECURE));
     if (NAME_NOT_FOUND == rc ) {
         CDBG_HIGH("%s : Buffer not found!", __func__);
+        mMisses[streamType]++;
+        if (mSwitchPending) {
+            mSwitchMisses++;
+        }
         rc = QCameraMemory::allocOneBuffer(memInfo, heap_id, size, cached,
                  secure_mode);
+        if ((rc != NO_ERROR) && (mBuffersHeld > 0)) {
+            // Buffers parked here may be what ION is short of
+            ALOGE("%s: allocation failed, retrying after freeing %zu bytes",
+                    __func__, mBytesHeld);
+            trimLocked(0);
+            rc = QCameraMemory::allocOneBuffer(memInfo, heap_id, size, cached,
+                     secure_mode);
+        }
+    } else {
+        mHits[streamType]++;
+        if (mSwitchPending) {
+            mSwitchHits++;
+        }
     }
 
     pthread_mutex_unlock(&mLock);
@@ -730,6 +946,378 @@ int QCameraMemoryPool::allocateBuffer(
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : recordFootprintLocked
+ *
+ * DESCRIPTION: remember a buffer requested in the current mode, so it can
+ *              be prefetched the next time this mode is predicted
+ *
+ * PARAMETERS :
+ *   @heap_id : type of heap
+ *   @size    : size of the buffer
+ *   @cached  : whether the buffer should be cached
+ *   @secure  : whether the buffer should be secure
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::recordFootprintLocked(unsigned int heap_id,
+        size_t size, bool cached, bool secure)
+{
+    QCameraPoolFootprint &fp = mCurFootprint;
+
+    if (mMode == QCAMERA_MEM_MODE_NONE) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < fp.numRequests; i++) {
+        QCameraPoolRequest &req = fp.requests[i];
+        if ((req.heap_id == heap_id) && (req.size == size) &&
+                (req.cached == cached) && (req.secure == secure)) {
+            if (req.count < UINT8_MAX) {
+                req.count++;
+            }
+            return;
+        }
+    }
+
+    if (fp.numRequests < QCAMERA_POOL_MAX_FOOTPRINT) {
+        QCameraPoolRequest &req = fp.requests[fp.numRequests++];
+        req.heap_id = heap_id;
+        req.size = size;
+        req.cached = cached;
+        req.secure = secure;
+        req.count = 1;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : countMatchesLocked
+ *
+ * DESCRIPTION: number of parked buffers findBufferLocked would hand out for
+ *              the given request
+ *
+ * PARAMETERS :
+ *   @req     : buffer configuration
+ *
+ * RETURN     : number of matching buffers
+ *==========================================================================*/
+uint32_t QCameraMemoryPool::countMatchesLocked(const QCameraPoolRequest &req)
+{
+    uint32_t matches = 0;
+
+    for (uint32_t cls = sizeClass(req.size);
+            cls <= sizeClass(req.size * 2); cls++) {
+        List<QCameraPoolBuffer>::iterator it = mClasses[cls].begin();
+        for ( ; it != mClasses[cls].end() ; it++) {
+            const QCameraMemory::QCameraMemInfo &info = (*it).memInfo;
+            if ((info.size >= req.size) &&
+                (info.size <= req.size * 2) &&
+                (info.heap_id == req.heap_id) &&
+                (info.cached == req.cached) &&
+                (info.secure == req.secure)) {
+                matches++;
+            }
+        }
+    }
+
+    return matches;
+}
+
+/*===========================================================================
+ * FUNCTION   : beginModeSwitch
+ *
+ * DESCRIPTION: note that the camera starts switching to a new mode. Starts
+ *              the switch latency timer and the footprint of the new mode.
+ *              A repeated call for a mode still being switched to is part
+ *              of the same switch.
+ *
+ * PARAMETERS :
+ *   @mode    : mode being switched to
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::beginModeSwitch(qcamera_mem_mode_t mode)
+{
+    pthread_mutex_lock(&mLock);
+
+    if (mSwitchPending && (mode == mMode)) {
+        pthread_mutex_unlock(&mLock);
+        return;
+    }
+
+    // Keep what the last mode allocated, unless it allocated nothing
+    // because its buffers had been set up by an earlier switch
+    if (mCurFootprint.numRequests > 0) {
+        mFootprints[mMode] = mCurFootprint;
+    }
+    memset(&mCurFootprint, 0, sizeof(mCurFootprint));
+
+    if (mode != mMode) {
+        mPrevMode = mMode;
+        mMode = mode;
+    }
+
+    // Predictions made for the previous mode are stale now
+    mPrefetchQueue.clear();
+    mPrefetchSeq++;
+
+    mSwitchPending = true;
+    mSwitchStart = systemTime();
+    mSwitchHits = 0;
+    mSwitchMisses = 0;
+
+    pthread_mutex_unlock(&mLock);
+}
+
+/*===========================================================================
+ * FUNCTION   : endModeSwitch
+ *
+ * DESCRIPTION: note that the new mode is up. Reports the switch latency and
+ *              starts prefetching buffers for the modes likely to follow.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::endModeSwitch()
+{
+    qcamera_mem_mode_t next[3];
+    uint32_t numNext = 0;
+
+    pthread_mutex_lock(&mLock);
+
+    if (!mSwitchPending) {
+        pthread_mutex_unlock(&mLock);
+        return;
+    }
+    mSwitchPending = false;
+
+    nsecs_t elapsed = systemTime() - mSwitchStart;
+    QCameraPoolSwitchStats &st = mSwitchStats[mMode];
+    st.count++;
+    st.lastNs = elapsed;
+    st.totalNs += elapsed;
+    if (elapsed > st.maxNs) {
+        st.maxNs = elapsed;
+    }
+    st.lastHits = mSwitchHits;
+    st.lastMisses = mSwitchMisses;
+    ALOGI("[KPI Perf] %s: mode %d -> %d took %lld us, pool hits %u misses %u",
+            __func__, mPrevMode, mMode, (long long)(elapsed / 1000),
+            mSwitchHits, mSwitchMisses);
+
+    if (mPrefetchEnabled) {
+        // Preview usually goes on to a snapshot or a recording, ZSL preview
+        // to a recording, and every mode may go back to where it came from
+        switch (mMode) {
+        case QCAMERA_MEM_MODE_PREVIEW:
+            next[numNext++] = QCAMERA_MEM_MODE_CAPTURE;
+            next[numNext++] = QCAMERA_MEM_MODE_VIDEO;
+            break;
+        case QCAMERA_MEM_MODE_ZSL_PREVIEW:
+            next[numNext++] = QCAMERA_MEM_MODE_VIDEO;
+            break;
+        default:
+            break;
+        }
+        if ((mPrevMode != QCAMERA_MEM_MODE_NONE) && (mPrevMode != mMode) &&
+                ((numNext == 0) || (next[0] != mPrevMode)) &&
+                ((numNext < 2) || (next[1] != mPrevMode))) {
+            next[numNext++] = mPrevMode;
+        }
+        for (uint32_t i = 0; i < numNext; i++) {
+            prefetchModeLocked(next[i]);
+        }
+    }
+
+    pthread_mutex_unlock(&mLock);
+}
+
+/*===========================================================================
+ * FUNCTION   : prefetchModeLocked
+ *
+ * DESCRIPTION: queue the footprint last seen for a mode for background
+ *              allocation
+ *
+ * PARAMETERS :
+ *   @mode    : predicted mode
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::prefetchModeLocked(qcamera_mem_mode_t mode)
+{
+    const QCameraPoolFootprint &fp = mFootprints[mode];
+
+    if (fp.numRequests == 0) {
+        return;
+    }
+    if (launchPrefetchLocked() != NO_ERROR) {
+        return;
+    }
+
+    CDBG_HIGH("%s: prefetching %u configurations of mode %d", __func__,
+            fp.numRequests, mode);
+    for (uint32_t i = 0; i < fp.numRequests; i++) {
+        mPrefetchQueue.push_back(fp.requests[i]);
+    }
+    pthread_cond_signal(&mPrefetchCond);
+}
+
+/*===========================================================================
+ * FUNCTION   : launchPrefetchLocked
+ *
+ * DESCRIPTION: start the prefetch thread on first use
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code
+ *==========================================================================*/
+int32_t QCameraMemoryPool::launchPrefetchLocked()
+{
+    if (mPrefetchLaunched) {
+        return NO_ERROR;
+    }
+
+    if (pthread_create(&mPrefetchTid, NULL, prefetchRoutine, this) != 0) {
+        ALOGE("%s: failed to launch prefetch thread", __func__);
+        mPrefetchEnabled = false;
+        return UNKNOWN_ERROR;
+    }
+    pthread_setname_np(mPrefetchTid, "CAM_memPrefetch");
+    mPrefetchLaunched = true;
+
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : prefetchRoutine
+ *
+ * DESCRIPTION: allocates queued buffer configurations into the pool, up to
+ *              the high water mark. ION calls are made without the pool
+ *              lock held, so streams starting meanwhile are not delayed.
+ *
+ * PARAMETERS :
+ *   @data    : ptr to QCameraMemoryPool
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void *QCameraMemoryPool::prefetchRoutine(void *data)
+{
+    QCameraMemoryPool *pme = (QCameraMemoryPool *)data;
+
+    pthread_mutex_lock(&pme->mLock);
+    while (true) {
+        while (!pme->mPrefetchExit && pme->mPrefetchQueue.empty()) {
+            pthread_cond_wait(&pme->mPrefetchCond, &pme->mLock);
+        }
+        if (pme->mPrefetchExit) {
+            break;
+        }
+
+        QCameraPoolRequest req = *pme->mPrefetchQueue.begin();
+        pme->mPrefetchQueue.erase(pme->mPrefetchQueue.begin());
+        uint32_t gen = pme->mPoolGen;
+        uint32_t seq = pme->mPrefetchSeq;
+
+        for (uint32_t have = pme->countMatchesLocked(req);
+                have < req.count; have++) {
+            struct QCameraMemory::QCameraMemInfo memInfo;
+
+            if ((pme->mHighWaterMark > 0) &&
+                    (pme->mBytesHeld + req.size > pme->mHighWaterMark)) {
+                break;
+            }
+
+            memset(&memInfo, 0, sizeof(memInfo));
+            pthread_mutex_unlock(&pme->mLock);
+            int rc = QCameraMemory::allocOneBuffer(memInfo, req.heap_id,
+                    req.size, req.cached, req.secure ? SECURE : NON_SECURE);
+            pthread_mutex_lock(&pme->mLock);
+            if (rc != NO_ERROR) {
+                ALOGE("%s: prefetch of %zu bytes failed", __func__, req.size);
+                break;
+            }
+            if ((gen != pme->mPoolGen) || pme->mPrefetchExit) {
+                QCameraMemory::deallocOneBuffer(memInfo);
+                break;
+            }
+            pme->insertBufferLocked(memInfo, true);
+            pme->mPrefetchedBufs++;
+            if (seq != pme->mPrefetchSeq) {
+                // A new mode switch started, leave ION to it
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&pme->mLock);
+
+    return NULL;
+}
+
+/*===========================================================================
+ * FUNCTION   : dump
+ *
+ * DESCRIPTION: composes a string with the pool occupancy and hit rates
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : Formatted string
+ *==========================================================================*/
+String8 QCameraMemoryPool::dump()
+{
+    String8 str("\n");
+    char s[128];
+    uint32_t hits = 0, misses = 0;
+
+    pthread_mutex_lock(&mLock);
+
+    snprintf(s, 128, "Buffers held: %u (%zu bytes, peak %zu)\n",
+            mBuffersHeld, mBytesHeld, mPeakBytesHeld);
+    str += s;
+
+    snprintf(s, 128, "High water mark: %zu bytes, evictions: %u\n",
+            mHighWaterMark, mEvictions);
+    str += s;
+
+    for (int i = 0; i < CAM_STREAM_TYPE_MAX; i++) {
+        if ((mHits[i] == 0) && (mMisses[i] == 0)) {
+            continue;
+        }
+        snprintf(s, 128, " Stream type %d: hits %u misses %u\n",
+                i, mHits[i], mMisses[i]);
+        str += s;
+        hits += mHits[i];
+        misses += mMisses[i];
+    }
+
+    snprintf(s, 128, "Total: hits %u misses %u\n", hits, misses);
+    str += s;
+
+    snprintf(s, 128, "Prefetched: %u buffers, %u used, mode %d\n",
+            mPrefetchedBufs, mPrefetchHits, mMode);
+    str += s;
+
+    for (int i = 0; i < QCAMERA_MEM_MODE_MAX; i++) {
+        const QCameraPoolSwitchStats &st = mSwitchStats[i];
+        if (st.count == 0) {
+            continue;
+        }
+        snprintf(s, 128, " Switch to mode %d: %u times, last %lld us"
+                " (hits %u misses %u), avg %lld us, max %lld us\n",
+                i, st.count, (long long)(st.lastNs / 1000),
+                st.lastHits, st.lastMisses,
+                (long long)(st.totalNs / st.count / 1000),
+                (long long)(st.maxNs / 1000));
+        str += s;
+    }
+
+    pthread_mutex_unlock(&mLock);
+
+    return str;
+}
+
 /*===========================================================================
  * FUNCTION   : QCameraHeapMemory
  *
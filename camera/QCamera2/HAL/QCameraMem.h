@@ -33,6 +33,8 @@
 #include <hardware/camera.h>
 #include <utils/Mutex.h>
 #include <utils/List.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
 #include <qdMetaData.h>
 
 extern "C" {
@@ -106,6 +108,7 @@ protected:
         ion_user_handle_t handle;
         size_t size;
         bool cached;
+        bool secure;
         unsigned int heap_id;
     };
 
@@ -125,6 +128,25 @@ protected:
     cam_stream_buf_type mBufType;
 };
 
+// Free buffers are kept in power of two size classes, each sorted by size.
+// A request is served with the smallest buffer of the same heap, cache and
+// secure mode that is at least as large and at most twice as large. Buffers
+// beyond the high water mark are freed least recently released first.
+#define QCAMERA_POOL_MIN_CLASS_SHIFT 12
+#define QCAMERA_POOL_NUM_CLASSES 20
+
+// Buffer configurations remembered per camera mode
+#define QCAMERA_POOL_MAX_FOOTPRINT 16
+
+typedef enum {
+    QCAMERA_MEM_MODE_NONE,
+    QCAMERA_MEM_MODE_PREVIEW,
+    QCAMERA_MEM_MODE_ZSL_PREVIEW,
+    QCAMERA_MEM_MODE_VIDEO,
+    QCAMERA_MEM_MODE_CAPTURE,
+    QCAMERA_MEM_MODE_MAX
+} qcamera_mem_mode_t;
+
 class QCameraMemoryPool {
 
 public:
@@ -138,14 +160,87 @@ public:
     void releaseBuffer(struct QCameraMemory::QCameraMemInfo &memInfo,
             cam_stream_type_t streamType);
     void clear();
+    void setHighWaterMark(size_t bytes);
+    void beginModeSwitch(qcamera_mem_mode_t mode);
+    void endModeSwitch();
+    android::String8 dump();
 
 protected:
 
-    int findBufferLocked(struct QCameraMemory::QCameraMemInfo &memInfo,
-            unsigned int heap_id, size_t size, bool cached,
-            cam_stream_type_t streamType);
+    struct QCameraPoolBuffer {
+        struct QCameraMemory::QCameraMemInfo memInfo;
+        uint32_t releaseSeq;
+        bool prefetched;
+    };
 
-    android::List<QCameraMemory::QCameraMemInfo> mPools[CAM_STREAM_TYPE_MAX];
+    // One buffer configuration, as allocated by streams or prefetched
+    struct QCameraPoolRequest {
+        unsigned int heap_id;
+        size_t size;
+        bool cached;
+        bool secure;
+        uint8_t count;
+    };
+
+    struct QCameraPoolFootprint {
+        QCameraPoolRequest requests[QCAMERA_POOL_MAX_FOOTPRINT];
+        uint32_t numRequests;
+    };
+
+    struct QCameraPoolSwitchStats {
+        uint32_t count;
+        nsecs_t lastNs;
+        nsecs_t maxNs;
+        nsecs_t totalNs;
+        uint32_t lastHits;
+        uint32_t lastMisses;
+    };
+
+    int findBufferLocked(struct QCameraMemory::QCameraMemInfo &memInfo,
+            unsigned int heap_id, size_t size, bool cached, bool secure);
+    void insertBufferLocked(struct QCameraMemory::QCameraMemInfo &memInfo,
+            bool prefetched);
+    void trimLocked(size_t limit);
+    void recordFootprintLocked(unsigned int heap_id, size_t size,
+            bool cached, bool secure);
+    uint32_t countMatchesLocked(const QCameraPoolRequest &req);
+    void prefetchModeLocked(qcamera_mem_mode_t mode);
+    int32_t launchPrefetchLocked();
+    static void *prefetchRoutine(void *data);
+    static uint32_t sizeClass(size_t size);
+
+    android::List<QCameraPoolBuffer> mClasses[QCAMERA_POOL_NUM_CLASSES];
+    size_t mBytesHeld;
+    size_t mPeakBytesHeld;
+    size_t mHighWaterMark;
+    uint32_t mBuffersHeld;
+    uint32_t mReleaseSeq;
+    uint32_t mEvictions;
+    uint32_t mHits[CAM_STREAM_TYPE_MAX];
+    uint32_t mMisses[CAM_STREAM_TYPE_MAX];
+    uint32_t mPrefetchedBufs;
+    uint32_t mPrefetchHits;
+
+    // mode tracking, next mode prediction and switch latency
+    qcamera_mem_mode_t mMode;
+    qcamera_mem_mode_t mPrevMode;
+    bool mSwitchPending;
+    nsecs_t mSwitchStart;
+    uint32_t mSwitchHits;
+    uint32_t mSwitchMisses;
+    QCameraPoolFootprint mCurFootprint;
+    QCameraPoolFootprint mFootprints[QCAMERA_MEM_MODE_MAX];
+    QCameraPoolSwitchStats mSwitchStats[QCAMERA_MEM_MODE_MAX];
+
+    // background allocation of predicted buffers
+    android::List<QCameraPoolRequest> mPrefetchQueue;
+    bool mPrefetchEnabled;
+    bool mPrefetchExit;
+    bool mPrefetchLaunched;
+    uint32_t mPoolGen;
+    uint32_t mPrefetchSeq;
+    pthread_t mPrefetchTid;
+    pthread_cond_t mPrefetchCond;
     pthread_mutex_t mLock;
 };
 
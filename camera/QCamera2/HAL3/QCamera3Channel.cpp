@@ -32,6 +32,7 @@
 //#define LOG_NDEBUG 0
 #include <fcntl.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include <cstdlib>
 #include <stdio.h>
 #include <string.h>
@@ -590,6 +591,20 @@ QCamera3RegularChannel::~QCamera3RegularChannel()
 
 int32_t QCamera3RawChannel::initialize(cam_is_type_t isType)
 {
+    if (mIsRaw16) {
+        // Raw16 conversion runs on the stream callback thread plus
+        // these workers, by default one thread per core up to 4
+        char prop[PROPERTY_VALUE_MAX];
+        char def[PROPERTY_VALUE_MAX];
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        int32_t threads = (cpus < 1) ? 1 : ((cpus > 4) ? 4 : (int32_t)cpus);
+        snprintf(def, sizeof(def), "%d", threads);
+        property_get("persist.camera.raw16.threads", prop, def);
+        threads = atoi(prop);
+        if (threads > 1) {
+            mRawConverter.init((uint32_t)(threads - 1));
+        }
+    }
     return QCamera3RegularChannel::initialize(isType);
 }
 int32_t QCamera3RegularChannel::initialize(cam_is_type_t isType)
@@ -1075,25 +1090,19 @@ void QCamera3RawChannel::convertLegacyToRaw16(mm_camera_buf_def_t *frame)
       stream->getFrameOffset(offset);
 
       uint32_t raw16_stride = ((uint32_t)dim.width + 15U) & ~15U;
-      uint16_t* raw16_buffer = (uint16_t *)frame->buffer;
 
       // In-place format conversion.
       // Raw16 format always occupy more memory than opaque raw10.
-      // Convert to Raw16 by iterating through all pixels from bottom-right
-      // to top-left of the image.
+      // Convert to Raw16 by iterating through all rows from bottom to top,
+      // the row kernel goes from right to left. Rows whose output does
+      // not overlap pending input are spread across the raw16 workers.
       // One special notes:
       // 1. Cross-platform raw16's stride is 16 pixels.
       // 2. Opaque raw10's stride is 6 pixels, and aligned to 16 bytes.
-      for (int32_t ys = dim.height - 1; ys >= 0; ys--) {
-          uint32_t y = (uint32_t)ys;
-          uint64_t* row_start = (uint64_t *)frame->buffer +
-                  y * (uint32_t)offset.mp[0].stride_in_bytes / 8;
-          for (int32_t xs = dim.width - 1; xs >= 0; xs--) {
-              uint32_t x = (uint32_t)xs;
-              uint16_t raw16_pixel = 0x3FF & (row_start[x/6] >> (10*(x%6)));
-              raw16_buffer[y*raw16_stride+x] = raw16_pixel;
-          }
-      }
+      mRawConverter.convert(getRaw16UnpackOps()->legacyRow,
+              (uint8_t *)frame->buffer, (uint32_t)dim.width,
+              (uint32_t)dim.height,
+              (uint32_t)offset.mp[0].stride_in_bytes, raw16_stride);
   } else {
       ALOGE("%s: Could not find stream", __func__);
   }
@@ -1118,29 +1127,23 @@ void QCamera3RawChannel::convertMipiToRaw16(mm_camera_buf_def_t *frame)
         stream->getFrameOffset(offset);
 
         uint32_t raw16_stride = ((uint32_t)dim.width + 15U) & ~15U;
-        uint16_t* raw16_buffer = (uint16_t *)frame->buffer;
 
         // In-place format conversion.
         // Raw16 format always occupy more memory than opaque raw10.
-        // Convert to Raw16 by iterating through all pixels from bottom-right
-        // to top-left of the image.
+        // Convert to Raw16 by iterating through all rows from bottom to top,
+        // the row kernel goes from right to left. Rows whose output does
+        // not overlap pending input are spread across the raw16 workers.
         // One special notes:
         // 1. Cross-platform raw16's stride is 16 pixels.
         // 2. mipi raw10's stride is 4 pixels, and aligned to 16 bytes.
-        for (int32_t ys = dim.height - 1; ys >= 0; ys--) {
-            uint32_t y = (uint32_t)ys;
-            uint8_t* row_start = (uint8_t *)frame->buffer +
-                    y * (uint32_t)offset.mp[0].stride_in_bytes;
-            for (int32_t xs = dim.width - 1; xs >= 0; xs--) {
-                uint32_t x = (uint32_t)xs;
-                uint8_t upper_8bit = row_start[5*(x/4)+x%4];
-                uint8_t lower_2bit = ((row_start[5*(x/4)+4] >> (x%4)) & 0x3);
-                uint16_t raw16_pixel =
-                        (uint16_t)(((uint16_t)upper_8bit)<<2 | 
-                        (uint16_t)lower_2bit);
-                raw16_buffer[y*raw16_stride+x] = raw16_pixel;
-            }
-        }
+        // 3. The old per pixel loop stored pixel 2 of row 0 over the low
+        //    bits byte of the first group before reading pixels 0 and 1,
+        //    so their low 2 bits were garbage. The row kernels load the
+        //    group first, so row 0 pixels 0-1 now differ from older output.
+        mRawConverter.convert(getRaw16UnpackOps()->mipiRow,
+                (uint8_t *)frame->buffer, (uint32_t)dim.width,
+                (uint32_t)dim.height,
+                (uint32_t)offset.mp[0].stride_in_bytes, raw16_stride);
     } else {
         ALOGE("%s: Could not find stream", __func__);
     }
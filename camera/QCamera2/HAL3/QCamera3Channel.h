@@ -35,6 +35,7 @@
 #include "QCamera3Mem.h"
 #include "QCamera3PostProc.h"
 #include "QCamera3HALHeader.h"
+#include "QCamera3RawUnpack.h"
 #include "utils/Vector.h"
 #include <utils/List.h>
 
@@ -231,6 +232,7 @@ public:
 private:
     bool mRawDump;
     bool mIsRaw16;
+    QCamera3RawConverter mRawConverter;
 
     void dumpRawSnapshot(mm_camera_buf_def_t *frame);
     void convertLegacyToRaw16(mm_camera_buf_def_t *frame);
@@ -0,0 +1,774 @@
+/* Copyright (c) 2015, The Linux Foundataion. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#define ATRACE_TAG ATRACE_TAG_CAMERA
+#define LOG_TAG "QCamera3RawUnpack"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cutils/properties.h>
+#include <utils/Errors.h>
+#include "QCamera3RawUnpack.h"
+#ifdef RAW16_UNPACK_HOST
+/* host build of test/QCamera3RawUnpackTest.cpp, without the HAL */
+#include <cutils/log.h>
+#define CDBG_HIGH(fmt, args...) ALOGD(fmt, ##args)
+#else
+#include "QCamera3HWI.h"
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RAW16_UNPACK_NEON
+#elif defined(__i386__) || defined(__x86_64__)
+#include <tmmintrin.h>
+#define RAW16_UNPACK_SSSE3
+#define RAW16_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+#if defined(RAW16_UNPACK_NEON) || defined(RAW16_UNPACK_SSSE3)
+#define RAW16_UNPACK_HAS_VECTOR
+#endif
+
+using namespace android;
+
+namespace qcamera {
+
+/*===========================================================================
+ * FUNCTION   : unpackMipiPixels
+ *
+ * DESCRIPTION: per pixel mipi raw10 unpack of pixels [first, last), right
+ *              to left. This is the reference every other kernel has to
+ *              match bit for bit.
+ *              mipi10 opaque raw is stored in the format of:
+ *              P3(1:0) P2(1:0) P1(1:0) P0(1:0) P3(9:2) P2(9:2) P1(9:2) P0(9:2)
+ *
+ * PARAMETERS :
+ *   @src   : start of the packed row
+ *   @dst   : start of the raw16 row
+ *   @first : first pixel to unpack
+ *   @last  : one past the last pixel to unpack
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void unpackMipiPixels(const uint8_t *src, uint16_t *dst,
+        uint32_t first, uint32_t last)
+{
+    uint8_t lower = 0;
+
+    for (uint32_t x = last; x-- > first; ) {
+        /* in place, pixel 2 of the first group lands on its low bits
+         * byte, so read that byte before the group's first store */
+        if (x == last - 1 || x % 4 == 3) {
+            lower = src[5*(x/4)+4];
+        }
+        uint8_t upper_8bit = src[5*(x/4)+x%4];
+        uint8_t lower_2bit = ((lower >> (x%4)) & 0x3);
+        dst[x] = (uint16_t)(((uint16_t)upper_8bit)<<2 |
+                (uint16_t)lower_2bit);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : unpackLegacyPixels
+ *
+ * DESCRIPTION: per pixel opaque raw10 unpack of pixels [first, last), right
+ *              to left. Each 64bit word holds 6 pixels in its low 60 bits.
+ *
+ * PARAMETERS :
+ *   @src   : start of the packed row
+ *   @dst   : start of the raw16 row
+ *   @first : first pixel to unpack
+ *   @last  : one past the last pixel to unpack
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void unpackLegacyPixels(const uint8_t *src, uint16_t *dst,
+        uint32_t first, uint32_t last)
+{
+    for (uint32_t x = last; x-- > first; ) {
+        uint64_t word;
+        memcpy(&word, src + 8*(x/6), sizeof(word));
+        dst[x] = (uint16_t)(0x3FF & (word >> (10*(x%6))));
+    }
+}
+
+static void unpackMipiRowRef(const uint8_t *src, uint16_t *dst,
+        uint32_t width)
+{
+    unpackMipiPixels(src, dst, 0, width);
+}
+
+static void unpackLegacyRowRef(const uint8_t *src, uint16_t *dst,
+        uint32_t width)
+{
+    unpackLegacyPixels(src, dst, 0, width);
+}
+
+/*===========================================================================
+ * FUNCTION   : unpackMipiGroups
+ *
+ * DESCRIPTION: scalar mipi raw10 unpack, 4 pixels per 5 byte group, for
+ *              pixels [4 * first_group, width). A trailing partial group is
+ *              done per pixel first.
+ *
+ * PARAMETERS :
+ *   @src         : start of the packed row
+ *   @dst         : start of the raw16 row
+ *   @first_group : first group of 4 pixels to unpack
+ *   @width       : row width in pixels
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void unpackMipiGroups(const uint8_t *src, uint16_t *dst,
+        uint32_t first_group, uint32_t width)
+{
+    uint32_t groups = width / 4;
+
+    unpackMipiPixels(src, dst, groups * 4, width);
+    for (uint32_t g = groups; g-- > first_group; ) {
+        const uint8_t *s = src + 5 * g;
+        uint16_t *d = dst + 4 * g;
+        uint16_t p0 = s[0], p1 = s[1], p2 = s[2], p3 = s[3];
+        uint16_t lo = s[4];
+
+        d[0] = (uint16_t)(p0 << 2 | (lo & 0x3));
+        d[1] = (uint16_t)(p1 << 2 | ((lo >> 1) & 0x3));
+        d[2] = (uint16_t)(p2 << 2 | ((lo >> 2) & 0x3));
+        d[3] = (uint16_t)(p3 << 2 | ((lo >> 3) & 0x3));
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : unpackLegacyWords
+ *
+ * DESCRIPTION: scalar opaque raw10 unpack, 6 pixels per 64bit word, for
+ *              pixels [6 * first_word, width). A trailing partial word is
+ *              done per pixel first.
+ *
+ * PARAMETERS :
+ *   @src        : start of the packed row
+ *   @dst        : start of the raw16 row
+ *   @first_word : first 64bit word to unpack
+ *   @width      : row width in pixels
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void unpackLegacyWords(const uint8_t *src, uint16_t *dst,
+        uint32_t first_word, uint32_t width)
+{
+    uint32_t words = width / 6;
+
+    unpackLegacyPixels(src, dst, words * 6, width);
+    for (uint32_t w = words; w-- > first_word; ) {
+        uint64_t word;
+        uint16_t *d = dst + 6 * w;
+
+        memcpy(&word, src + 8 * w, sizeof(word));
+        d[0] = (uint16_t)(word & 0x3FF);
+        d[1] = (uint16_t)((word >> 10) & 0x3FF);
+        d[2] = (uint16_t)((word >> 20) & 0x3FF);
+        d[3] = (uint16_t)((word >> 30) & 0x3FF);
+        d[4] = (uint16_t)((word >> 40) & 0x3FF);
+        d[5] = (uint16_t)((word >> 50) & 0x3FF);
+    }
+}
+
+static void unpackMipiRowScalar(const uint8_t *src, uint16_t *dst,
+        uint32_t width)
+{
+    unpackMipiGroups(src, dst, 0, width);
+}
+
+static void unpackLegacyRowScalar(const uint8_t *src, uint16_t *dst,
+        uint32_t width)
+{
+    unpackLegacyWords(src, dst, 0, width);
+}
+
+/*
+ * Vector kernels.
+ *
+ * mipi: 16 pixels come from 20 bytes. Bytes [0, 16) and [4, 20) of the
+ * block are loaded so nothing past the block is touched, and each half
+ * of 8 pixels is gathered from one of them with a table lookup.
+ *
+ * legacy: 24 pixels come from 4 words (32 bytes). Pixel i of a word
+ * starts at bit 10 * i, i.e. byte 10 * i / 8 with a bit shift of
+ * 10 * i % 8. The two bytes holding each pixel are gathered into a 16bit
+ * lane, shifted left so the pixel ends at bit 15 and then right by 6.
+ *
+ * Within a row blocks run from right to left and each block is loaded
+ * completely before it is stored, which keeps in-place expansion safe.
+ */
+#ifdef RAW16_UNPACK_HAS_VECTOR
+static const uint8_t kMipiUpperIdx[8] = { 0, 1, 2, 3, 5, 6, 7, 8 };
+static const uint8_t kMipiLowerIdx[8] = { 4, 4, 4, 4, 9, 9, 9, 9 };
+/* second half of the block is gathered from the load at byte 4 */
+#define MIPI_HALF1_OFFSET 6
+
+/* byte offsets of the 24 pixels of a legacy block */
+static const uint8_t kLegacyByteIdx[24] = {
+     0,  1,  2,  3,  5,  6,  8,  9,
+    10, 11, 13, 14, 16, 17, 18, 19,
+    21, 22, 24, 25, 26, 27, 29, 30 };
+/* left shift bringing bit 9 of each pixel to bit 15 */
+static const uint8_t kLegacyLeftShift[24] = {
+    6, 4, 2, 0, 6, 4, 6, 4,
+    2, 0, 6, 4, 6, 4, 2, 0,
+    6, 4, 6, 4, 2, 0, 6, 4 };
+#endif
+
+#ifdef RAW16_UNPACK_NEON
+static void unpackMipiRowNeon(const uint8_t *src, uint16_t *dst,
+        uint32_t width)
+{
+    uint32_t blocks = width / 16;
+    uint8x8_t upper_idx0 = vld1_u8(kMipiUpperIdx);
+    uint8x8_t lower_idx0 = vld1_u8(kMipiLowerIdx);
+    uint8x8_t upper_idx1 = vadd_u8(upper_idx0, vdup_n_u8(MIPI_HALF1_OFFSET));
+    uint8x8_t lower_idx1 = vadd_u8(lower_idx0, vdup_n_u8(MIPI_HALF1_OFFSET));
+    static const int16_t lower_shift[8] = { 0, -1, -2, -3, 0, -1, -2, -3 };
+    int16x8_t shift = vld1q_s16(lower_shift);
+    uint16x8_t mask = vdupq_n_u16(0x3);
+
+    unpackMipiGroups(src, dst, blocks * 4, width);
+    for (uint32_t b = blocks; b-- > 0; ) {
+        const uint8_t *s = src + 20 * b;
+        uint8x16_t a = vld1q_u8(s);
+        uint8x16_t c = vld1q_u8(s + 4);
+        uint8x8x2_t ta = {{ vget_low_u8(a), vget_high_u8(a) }};
+        uint8x8x2_t tc = {{ vget_low_u8(c), vget_high_u8(c) }};
+        uint16x8_t up0 = vshll_n_u8(vtbl2_u8(ta, upper_idx0), 2);
+        uint16x8_t up1 = vshll_n_u8(vtbl2_u8(tc, upper_idx1), 2);
+        uint16x8_t lo0 = vmovl_u8(vtbl2_u8(ta, lower_idx0));
+        uint16x8_t lo1 = vmovl_u8(vtbl2_u8(tc, lower_idx1));
+
+        lo0 = vandq_u16(vshlq_u16(lo0, shift), mask);
+        lo1 = vandq_u16(vshlq_u16(lo1, shift), mask);
+        vst1q_u16(dst + 16 * b, vorrq_u16(up0, lo0));
+        vst1q_u16(dst + 16 * b + 8, vorrq_u16(up1, lo1));
+    }
+}
+
+static void unpackLegacyRowNeon(const uint8_t *src, uint16_t *dst,
+        uint32_t width)
+{
+    uint32_t blocks = width / 24;
+    uint8x8_t lo_idx[3], hi_idx[3];
+    int16x8_t shift[3];
+
+    for (int i = 0; i < 3; i++) {
+        lo_idx[i] = vld1_u8(kLegacyByteIdx + 8 * i);
+        hi_idx[i] = vadd_u8(lo_idx[i], vdup_n_u8(1));
+        shift[i] = vreinterpretq_s16_u16(
+                vmovl_u8(vld1_u8(kLegacyLeftShift + 8 * i)));
+    }
+
+    unpackLegacyWords(src, dst, blocks * 4, width);
+    for (uint32_t b = blocks; b-- > 0; ) {
+        const uint8_t *s = src + 32 * b;
+        uint8x16_t a = vld1q_u8(s);
+        uint8x16_t c = vld1q_u8(s + 16);
+        uint8x8x4_t t = {{ vget_low_u8(a), vget_high_u8(a),
+                vget_low_u8(c), vget_high_u8(c) }};
+        uint16x8_t px[3];
+
+        for (int i = 0; i < 3; i++) {
+            uint16x8_t v = vorrq_u16(vmovl_u8(vtbl4_u8(t, lo_idx[i])),
+                    vshll_n_u8(vtbl4_u8(t, hi_idx[i]), 8));
+            px[i] = vshrq_n_u16(vshlq_u16(v, shift[i]), 6);
+        }
+        vst1q_u16(dst + 24 * b, px[0]);
+        vst1q_u16(dst + 24 * b + 8, px[1]);
+        vst1q_u16(dst + 24 * b + 16, px[2]);
+    }
+}
+#endif
+
+#ifdef RAW16_UNPACK_SSSE3
+/* build a pshufb mask gathering 8 pixels into 16bit lanes, either one
+ * zero extended byte per lane or a little endian byte pair */
+RAW16_TARGET_SSSE3
+static __m128i buildShuffle(const uint8_t *lo_idx, uint8_t offset,
+        bool pair)
+{
+    uint8_t m[16];
+    for (int i = 0; i < 8; i++) {
+        m[2 * i] = (uint8_t)(lo_idx[i] - offset);
+        m[2 * i + 1] = pair ? (uint8_t)(lo_idx[i] - offset + 1) : 0x80;
+    }
+    return _mm_loadu_si128((const __m128i *)m);
+}
+
+RAW16_TARGET_SSSE3
+static __m128i buildMultiplier(const uint8_t *shift)
+{
+    uint16_t m[8];
+    for (int i = 0; i < 8; i++) {
+        m[i] = (uint16_t)(1U << shift[i]);
+    }
+    return _mm_loadu_si128((const __m128i *)m);
+}
+
+RAW16_TARGET_SSSE3
+static void unpackMipiRowSsse3(const uint8_t *src, uint16_t *dst,
+        uint32_t width)
+{
+    uint32_t blocks = width / 16;
+    uint8_t upper_idx1[8], lower_idx1[8];
+    for (int i = 0; i < 8; i++) {
+        upper_idx1[i] = (uint8_t)(kMipiUpperIdx[i] + MIPI_HALF1_OFFSET);
+        lower_idx1[i] = (uint8_t)(kMipiLowerIdx[i] + MIPI_HALF1_OFFSET);
+    }
+    __m128i upper0 = buildShuffle(kMipiUpperIdx, 0, false);
+    __m128i lower0 = buildShuffle(kMipiLowerIdx, 0, false);
+    __m128i upper1 = buildShuffle(upper_idx1, 0, false);
+    __m128i lower1 = buildShuffle(lower_idx1, 0, false);
+    /* (lo >> k) & 3 == ((lo << (3 - k)) >> 3) & 3 for k = x % 4 */
+    __m128i mult = _mm_setr_epi16(8, 4, 2, 1, 8, 4, 2, 1);
+    __m128i mask = _mm_set1_epi16(0x3);
+
+    unpackMipiGroups(src, dst, blocks * 4, width);
+    for (uint32_t b = blocks; b-- > 0; ) {
+        const uint8_t *s = src + 20 * b;
+        __m128i a = _mm_loadu_si128((const __m128i *)s);
+        __m128i c = _mm_loadu_si128((const __m128i *)(s + 4));
+        __m128i up0 = _mm_slli_epi16(_mm_shuffle_epi8(a, upper0), 2);
+        __m128i up1 = _mm_slli_epi16(_mm_shuffle_epi8(c, upper1), 2);
+        __m128i lo0 = _mm_mullo_epi16(_mm_shuffle_epi8(a, lower0), mult);
+        __m128i lo1 = _mm_mullo_epi16(_mm_shuffle_epi8(c, lower1), mult);
+
+        lo0 = _mm_and_si128(_mm_srli_epi16(lo0, 3), mask);
+        lo1 = _mm_and_si128(_mm_srli_epi16(lo1, 3), mask);
+        _mm_storeu_si128((__m128i *)(dst + 16 * b), _mm_or_si128(up0, lo0));
+        _mm_storeu_si128((__m128i *)(dst + 16 * b + 8),
+                _mm_or_si128(up1, lo1));
+    }
+}
+
+RAW16_TARGET_SSSE3
+static void unpackLegacyRowSsse3(const uint8_t *src, uint16_t *dst,
+        uint32_t width)
+{
+    uint32_t blocks = width / 24;
+    /* each group of 8 pixels lies within 16 bytes from byte 0, 8, 16 */
+    __m128i shuf[3], mult[3];
+
+    for (int i = 0; i < 3; i++) {
+        shuf[i] = buildShuffle(kLegacyByteIdx + 8 * i, (uint8_t)(8 * i), true);
+        mult[i] = buildMultiplier(kLegacyLeftShift + 8 * i);
+    }
+
+    unpackLegacyWords(src, dst, blocks * 4, width);
+    for (uint32_t b = blocks; b-- > 0; ) {
+        const uint8_t *s = src + 32 * b;
+        __m128i in[3];
+        for (int i = 0; i < 3; i++) {
+            in[i] = _mm_loadu_si128((const __m128i *)(s + 8 * i));
+        }
+        for (int i = 0; i < 3; i++) {
+            __m128i v = _mm_shuffle_epi8(in[i], shuf[i]);
+            _mm_storeu_si128((__m128i *)(dst + 24 * b + 8 * i),
+                    _mm_srli_epi16(_mm_mullo_epi16(v, mult[i]), 6));
+        }
+    }
+}
+#endif
+
+static const raw16_unpack_ops_t kRaw16UnpackRef = {
+    "reference", unpackMipiRowRef, unpackLegacyRowRef };
+static const raw16_unpack_ops_t kRaw16UnpackScalar = {
+    "scalar", unpackMipiRowScalar, unpackLegacyRowScalar };
+#if defined(RAW16_UNPACK_NEON)
+static const raw16_unpack_ops_t kRaw16UnpackVector = {
+    "neon", unpackMipiRowNeon, unpackLegacyRowNeon };
+#elif defined(RAW16_UNPACK_SSSE3)
+static const raw16_unpack_ops_t kRaw16UnpackVector = {
+    "ssse3", unpackMipiRowSsse3, unpackLegacyRowSsse3 };
+#endif
+
+static const raw16_unpack_ops_t *gRaw16UnpackOps = &kRaw16UnpackScalar;
+static pthread_once_t gRaw16UnpackOnce = PTHREAD_ONCE_INIT;
+
+/*===========================================================================
+ * FUNCTION   : getRaw16UnpackOpsForLevel
+ *
+ * DESCRIPTION: return the best kernels up to the given level that this cpu
+ *              can run. The vector level falls back to the scalar kernels
+ *              when the cpu lacks the instructions.
+ *
+ * PARAMETERS :
+ *   @level : RAW16_UNPACK_REF, RAW16_UNPACK_SCALAR or RAW16_UNPACK_VECTOR
+ *
+ * RETURN     : kernel table, never NULL
+ *==========================================================================*/
+const raw16_unpack_ops_t *getRaw16UnpackOpsForLevel(int level)
+{
+    if (level <= RAW16_UNPACK_REF) {
+        return &kRaw16UnpackRef;
+    } else if (level == RAW16_UNPACK_SCALAR) {
+        return &kRaw16UnpackScalar;
+    }
+#if defined(RAW16_UNPACK_NEON)
+    return &kRaw16UnpackVector;
+#elif defined(RAW16_UNPACK_SSSE3)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3")) {
+        return &kRaw16UnpackVector;
+    }
+#endif
+    return &kRaw16UnpackScalar;
+}
+
+/*===========================================================================
+ * FUNCTION   : initRaw16UnpackOps
+ *
+ * DESCRIPTION: pick the unpack kernels once per process. The vector
+ *              kernels are used when the cpu supports them, unless
+ *              persist.camera.raw16.unpack asks for the scalar (1) or the
+ *              per pixel reference (0) kernels.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void initRaw16UnpackOps()
+{
+    char prop[PROPERTY_VALUE_MAX];
+    property_get("persist.camera.raw16.unpack", prop, "2");
+
+    gRaw16UnpackOps = getRaw16UnpackOpsForLevel(atoi(prop));
+    CDBG_HIGH("%s: raw16 unpack kernels: %s", __func__,
+            gRaw16UnpackOps->name);
+}
+
+/*===========================================================================
+ * FUNCTION   : getRaw16UnpackOps
+ *
+ * DESCRIPTION: return the raw10 to raw16 row kernels for this cpu
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : kernel table, never NULL
+ *==========================================================================*/
+const raw16_unpack_ops_t *getRaw16UnpackOps()
+{
+    pthread_once(&gRaw16UnpackOnce, initRaw16UnpackOps);
+    return gRaw16UnpackOps;
+}
+
+/* waves smaller than this many rows per thread run on the caller only */
+#define RAW16_CONVERT_MIN_BAND_ROWS 16
+#define RAW16_CONVERT_BANDS_PER_THREAD 2
+
+/*===========================================================================
+ * FUNCTION   : QCamera3RawConverter
+ *
+ * DESCRIPTION: constructor of QCamera3RawConverter
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+QCamera3RawConverter::QCamera3RawConverter()
+    : mNumWorkers(0),
+      mExit(false),
+      mUnpackRow(NULL),
+      mBuf(NULL),
+      mWidth(0),
+      mSrcStride(0),
+      mDstStride(0),
+      mWaveSeq(0),
+      mWaveFirstRow(0),
+      mWaveEndRow(0),
+      mBandRows(0),
+      mNextBand(0),
+      mNumBands(0),
+      mBandsPending(0)
+{
+    pthread_mutex_init(&mLock, NULL);
+    pthread_cond_init(&mWorkCond, NULL);
+    pthread_cond_init(&mDoneCond, NULL);
+}
+
+/*===========================================================================
+ * FUNCTION   : ~QCamera3RawConverter
+ *
+ * DESCRIPTION: deconstructor of QCamera3RawConverter
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+QCamera3RawConverter::~QCamera3RawConverter()
+{
+    deinit();
+    pthread_cond_destroy(&mDoneCond);
+    pthread_cond_destroy(&mWorkCond);
+    pthread_mutex_destroy(&mLock);
+}
+
+/*===========================================================================
+ * FUNCTION   : init
+ *
+ * DESCRIPTION: launch the worker threads. The thread calling convert()
+ *              always takes part, so 0 workers converts on the caller only.
+ *
+ * PARAMETERS :
+ *   @num_workers : number of worker threads to launch
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code
+ *==========================================================================*/
+int32_t QCamera3RawConverter::init(uint32_t num_workers)
+{
+    if (mNumWorkers > 0) {
+        return NO_ERROR;
+    }
+    if (num_workers > RAW16_CONVERT_MAX_WORKERS) {
+        num_workers = RAW16_CONVERT_MAX_WORKERS;
+    }
+
+    for (uint32_t i = 0; i < num_workers; i++) {
+        if (pthread_create(&mWorkers[i], NULL, workerRoutine, this) != 0) {
+            ALOGE("%s: failed to launch raw16 worker %u", __func__, i);
+            break;
+        }
+        pthread_setname_np(mWorkers[i], "CAM_raw16");
+        mNumWorkers++;
+    }
+    CDBG_HIGH("%s: %u raw16 workers", __func__, mNumWorkers);
+
+    return (mNumWorkers == num_workers) ? NO_ERROR : UNKNOWN_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : deinit
+ *
+ * DESCRIPTION: stop and join the worker threads
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3RawConverter::deinit()
+{
+    if (mNumWorkers == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&mLock);
+    mExit = true;
+    pthread_cond_broadcast(&mWorkCond);
+    pthread_mutex_unlock(&mLock);
+
+    for (uint32_t i = 0; i < mNumWorkers; i++) {
+        pthread_join(mWorkers[i], NULL);
+    }
+    mNumWorkers = 0;
+    mExit = false;
+}
+
+/*===========================================================================
+ * FUNCTION   : convert
+ *
+ * DESCRIPTION: convert a packed raw10 frame to raw16 in place. Returns once
+ *              every row has been converted.
+ *
+ * PARAMETERS :
+ *   @unpack_row : row kernel, see getRaw16UnpackOps()
+ *   @buf        : frame buffer
+ *   @width      : frame width in pixels
+ *   @height     : frame height in rows
+ *   @src_stride : packed row stride in bytes
+ *   @dst_stride : raw16 row stride in pixels, at least width and taking
+ *                 no fewer bytes than src_stride
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3RawConverter::convert(raw16_unpack_row_fn unpack_row,
+        uint8_t *buf, uint32_t width, uint32_t height, uint32_t src_stride,
+        uint32_t dst_stride)
+{
+    uint64_t dst_bytes = (uint64_t)dst_stride * sizeof(uint16_t);
+    uint32_t end_row = height;
+
+    mUnpackRow = unpack_row;
+    mBuf = buf;
+    mWidth = width;
+    mSrcStride = src_stride;
+    mDstStride = dst_stride;
+
+    while (end_row > 0) {
+        // Rows [first_row, end_row) write at or after first_row * dst_bytes,
+        // which has to be past the packed data of rows [0, end_row).
+        uint32_t first_row = (uint32_t)(((uint64_t)end_row * src_stride +
+                dst_bytes - 1) / dst_bytes);
+        if (first_row >= end_row) {
+            // Top rows overlap their own packed data, keep them in order
+            convertRows(0, end_row);
+            break;
+        }
+        runWave(first_row, end_row);
+        end_row = first_row;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : runWave
+ *
+ * DESCRIPTION: convert rows [first_row, end_row) in bands spread across the
+ *              caller and the workers, and wait for all of them
+ *
+ * PARAMETERS :
+ *   @first_row : first row of the wave
+ *   @end_row   : one past the last row of the wave
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3RawConverter::runWave(uint32_t first_row, uint32_t end_row)
+{
+    uint32_t rows = end_row - first_row;
+    uint32_t threads = mNumWorkers + 1;
+
+    if (mNumWorkers == 0 || rows < threads * RAW16_CONVERT_MIN_BAND_ROWS) {
+        convertRows(first_row, end_row);
+        return;
+    }
+
+    pthread_mutex_lock(&mLock);
+    mWaveFirstRow = first_row;
+    mWaveEndRow = end_row;
+    mBandRows = (rows + threads * RAW16_CONVERT_BANDS_PER_THREAD - 1) /
+            (threads * RAW16_CONVERT_BANDS_PER_THREAD);
+    mNumBands = (rows + mBandRows - 1) / mBandRows;
+    mNextBand = 0;
+    mBandsPending = mNumBands;
+    mWaveSeq++;
+    pthread_cond_broadcast(&mWorkCond);
+    pthread_mutex_unlock(&mLock);
+
+    runBands();
+
+    pthread_mutex_lock(&mLock);
+    while (mBandsPending > 0) {
+        pthread_cond_wait(&mDoneCond, &mLock);
+    }
+    pthread_mutex_unlock(&mLock);
+}
+
+/*===========================================================================
+ * FUNCTION   : runBands
+ *
+ * DESCRIPTION: take bands of the current wave until none are left
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3RawConverter::runBands()
+{
+    pthread_mutex_lock(&mLock);
+    while (mNextBand < mNumBands) {
+        uint32_t first_row = mWaveFirstRow + mNextBand * mBandRows;
+        uint32_t end_row = first_row + mBandRows;
+        if (end_row > mWaveEndRow) {
+            end_row = mWaveEndRow;
+        }
+        mNextBand++;
+        pthread_mutex_unlock(&mLock);
+
+        convertRows(first_row, end_row);
+
+        pthread_mutex_lock(&mLock);
+        if (--mBandsPending == 0) {
+            pthread_cond_signal(&mDoneCond);
+        }
+    }
+    pthread_mutex_unlock(&mLock);
+}
+
+/*===========================================================================
+ * FUNCTION   : convertRows
+ *
+ * DESCRIPTION: convert rows [first_row, end_row) from the bottom up
+ *
+ * PARAMETERS :
+ *   @first_row : first row to convert
+ *   @end_row   : one past the last row to convert
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3RawConverter::convertRows(uint32_t first_row, uint32_t end_row)
+{
+    uint16_t *raw16 = (uint16_t *)mBuf;
+
+    for (uint32_t y = end_row; y-- > first_row; ) {
+        mUnpackRow(mBuf + (size_t)y * mSrcStride,
+                raw16 + (size_t)y * mDstStride, mWidth);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : workerRoutine
+ *
+ * DESCRIPTION: worker thread, helps with every wave posted by convert()
+ *
+ * PARAMETERS :
+ *   @data    : ptr to QCamera3RawConverter
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void *QCamera3RawConverter::workerRoutine(void *data)
+{
+    QCamera3RawConverter *pme = (QCamera3RawConverter *)data;
+
+    pthread_mutex_lock(&pme->mLock);
+    uint32_t seq = pme->mWaveSeq;
+    while (true) {
+        while (!pme->mExit && pme->mWaveSeq == seq) {
+            pthread_cond_wait(&pme->mWorkCond, &pme->mLock);
+        }
+        if (pme->mExit) {
+            break;
+        }
+        seq = pme->mWaveSeq;
+        pthread_mutex_unlock(&pme->mLock);
+        pme->runBands();
+        pthread_mutex_lock(&pme->mLock);
+    }
+    pthread_mutex_unlock(&pme->mLock);
+
+    return NULL;
+}
+
+}; // namespace qcamera
@@ -0,0 +1,118 @@
+/* Copyright (c) 2015, The Linux Foundataion. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef __QCAMERA3RAWUNPACK_H__
+#define __QCAMERA3RAWUNPACK_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+namespace qcamera {
+
+/* Unpacks one row of 10bit packed bayer into RAW16. Pixels are produced
+ * from right to left and every block is fully loaded before it is stored,
+ * so dst may alias src as long as dst does not start before src. */
+typedef void (*raw16_unpack_row_fn)(const uint8_t *src, uint16_t *dst,
+        uint32_t width);
+
+typedef struct {
+    const char *name;
+    /* MIPI raw10: 4 pixels in 5 bytes */
+    raw16_unpack_row_fn mipiRow;
+    /* Opaque (legacy) raw10: 6 pixels in each 64bit word */
+    raw16_unpack_row_fn legacyRow;
+} raw16_unpack_ops_t;
+
+/* Unpack kernel selection, 0: per pixel reference, 1: scalar blocks,
+ * 2: vector kernels when the cpu has them */
+#define RAW16_UNPACK_REF    0
+#define RAW16_UNPACK_SCALAR 1
+#define RAW16_UNPACK_VECTOR 2
+
+/* kernels picked by persist.camera.raw16.unpack, once per process */
+const raw16_unpack_ops_t *getRaw16UnpackOps();
+const raw16_unpack_ops_t *getRaw16UnpackOpsForLevel(int level);
+
+#define RAW16_CONVERT_MAX_WORKERS 7
+
+/*
+ * Runs the in-place raw10 to raw16 conversion of a frame on the calling
+ * thread plus a small set of persistent worker threads.
+ *
+ * A raw16 row never starts before its packed row, so a row may be written
+ * once every packed row it overlaps has been read. Rows are converted in
+ * waves from the bottom of the frame: the rows of a wave only write past
+ * the packed data of the rows still pending, so each wave is split into
+ * bands that run concurrently, and the next wave starts once all bands
+ * are done.
+ */
+class QCamera3RawConverter {
+public:
+    QCamera3RawConverter();
+    ~QCamera3RawConverter();
+
+    int32_t init(uint32_t num_workers);
+    void deinit();
+    void convert(raw16_unpack_row_fn unpack_row, uint8_t *buf,
+            uint32_t width, uint32_t height, uint32_t src_stride,
+            uint32_t dst_stride);
+
+private:
+    static void *workerRoutine(void *data);
+    void runWave(uint32_t first_row, uint32_t end_row);
+    void runBands();
+    void convertRows(uint32_t first_row, uint32_t end_row);
+
+    pthread_mutex_t mLock;
+    pthread_cond_t mWorkCond;
+    pthread_cond_t mDoneCond;
+    pthread_t mWorkers[RAW16_CONVERT_MAX_WORKERS];
+    uint32_t mNumWorkers;
+    bool mExit;
+
+    /* current frame, only written while no band is in flight */
+    raw16_unpack_row_fn mUnpackRow;
+    uint8_t *mBuf;
+    uint32_t mWidth;
+    uint32_t mSrcStride;
+    uint32_t mDstStride;
+
+    /* current wave, protected by mLock */
+    uint32_t mWaveSeq;
+    uint32_t mWaveFirstRow;
+    uint32_t mWaveEndRow;
+    uint32_t mBandRows;
+    uint32_t mNextBand;
+    uint32_t mNumBands;
+    uint32_t mBandsPending;
+};
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA3RAWUNPACK_H__ */
@@ -0,0 +1,342 @@
+/* Copyright (c) 2015, The Linux Foundataion. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+/*
+ * Host check and benchmark of the raw10 to raw16 unpack kernels.
+ *
+ * Every kernel level is compared bit for bit against the per pixel
+ * reference, row by row and in place, for widths that end on partial
+ * blocks and groups. Whole frames converted in place by
+ * QCamera3RawConverter are compared the same way. Then the kernels and
+ * the converter are timed on a full size frame.
+ *
+ * usage: qcamera3_raw_unpack_test [-i iterations] [-w workers]
+ *                                 [-W width] [-H height]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "QCamera3RawUnpack.h"
+
+using namespace qcamera;
+
+#define RAW16_TEST_BENCH_WIDTH  4208
+#define RAW16_TEST_BENCH_HEIGHT 3120
+#define RAW16_TEST_ITERATIONS   5
+#define RAW16_TEST_SEED         0x5eed
+
+static const uint32_t kTestWidths[] = {
+    1, 3, 4, 5, 6, 7, 15, 16, 17, 23, 24, 25, 31, 47, 48, 49, 100, 333,
+    4000, 4104, 4208
+};
+
+typedef struct {
+    const char *name;
+    bool mipi;
+} raw16_test_format_t;
+
+static const raw16_test_format_t kTestFormats[] = {
+    { "mipi", true },
+    { "legacy", false },
+};
+
+/*===========================================================================
+ * FUNCTION   : srcStride
+ *
+ * DESCRIPTION: bytes per packed row, aligned to 16 bytes like the stream
+ *
+ * PARAMETERS :
+ *   @mipi  : mipi raw10 if true, opaque (legacy) raw10 otherwise
+ *   @width : pixels per row
+ *
+ * RETURN     : stride in bytes
+ *==========================================================================*/
+static uint32_t srcStride(bool mipi, uint32_t width)
+{
+    uint32_t bytes = mipi ? (width + 3) / 4 * 5 : (width + 5) / 6 * 8;
+    return (bytes + 15U) & ~15U;
+}
+
+static uint32_t dstStride(uint32_t width)
+{
+    return (width + 15U) & ~15U;
+}
+
+static raw16_unpack_row_fn rowFn(const raw16_unpack_ops_t *ops, bool mipi)
+{
+    return mipi ? ops->mipiRow : ops->legacyRow;
+}
+
+static double nowMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+/* frame buffer large enough for the raw16 output, packed data at the start */
+static uint8_t *allocFrame(bool mipi, uint32_t width, uint32_t height,
+        size_t *size)
+{
+    size_t src = (size_t)srcStride(mipi, width) * height;
+    size_t dst = (size_t)dstStride(width) * 2 * height;
+    *size = (src > dst ? src : dst) + 64;
+    return (uint8_t *)malloc(*size);
+}
+
+static void fillRandom(uint8_t *buf, size_t size, unsigned *seed)
+{
+    for (size_t i = 0; i < size; i++) {
+        buf[i] = (uint8_t)rand_r(seed);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : checkRows
+ *
+ * DESCRIPTION: unpack single rows with the kernels of ops, once into a
+ *              separate buffer and once in place, and compare both with
+ *              the reference kernels
+ *
+ * PARAMETERS :
+ *   @ops  : kernels under test
+ *   @fmt  : packed format
+ *   @seed : random state
+ *
+ * RETURN     : number of mismatching rows
+ *==========================================================================*/
+static int checkRows(const raw16_unpack_ops_t *ops,
+        const raw16_test_format_t *fmt, unsigned *seed)
+{
+    const raw16_unpack_ops_t *ref = getRaw16UnpackOpsForLevel(RAW16_UNPACK_REF);
+    int fails = 0;
+
+    for (size_t i = 0; i < sizeof(kTestWidths) / sizeof(kTestWidths[0]); i++) {
+        uint32_t width = kTestWidths[i];
+        size_t size;
+        uint8_t *packed = allocFrame(fmt->mipi, width, 1, &size);
+        uint8_t *inplace = (uint8_t *)malloc(size);
+        uint16_t *expect = (uint16_t *)malloc(size);
+        uint16_t *out = (uint16_t *)malloc(size);
+
+        fillRandom(packed, size, seed);
+        memcpy(inplace, packed, size);
+        rowFn(ref, fmt->mipi)(packed, expect, width);
+        rowFn(ops, fmt->mipi)(packed, out, width);
+        rowFn(ops, fmt->mipi)(inplace, (uint16_t *)inplace, width);
+
+        if (memcmp(expect, out, width * sizeof(uint16_t))) {
+            printf("FAIL %s %s width %u\n", ops->name, fmt->name, width);
+            fails++;
+        } else if (memcmp(expect, inplace, width * sizeof(uint16_t))) {
+            printf("FAIL %s %s width %u in place\n", ops->name, fmt->name,
+                    width);
+            fails++;
+        }
+        free(packed);
+        free(inplace);
+        free(expect);
+        free(out);
+    }
+    return fails;
+}
+
+/*===========================================================================
+ * FUNCTION   : checkFrame
+ *
+ * DESCRIPTION: convert a whole frame in place with the converter and
+ *              compare every row with the reference unpack of a copy
+ *
+ * PARAMETERS :
+ *   @conv   : converter, already initialized
+ *   @ops    : kernels under test
+ *   @fmt    : packed format
+ *   @width  : frame width
+ *   @height : frame height
+ *   @seed   : random state
+ *
+ * RETURN     : number of mismatching rows
+ *==========================================================================*/
+static int checkFrame(QCamera3RawConverter *conv,
+        const raw16_unpack_ops_t *ops, const raw16_test_format_t *fmt,
+        uint32_t width, uint32_t height, unsigned *seed)
+{
+    const raw16_unpack_ops_t *ref = getRaw16UnpackOpsForLevel(RAW16_UNPACK_REF);
+    uint32_t src_stride = srcStride(fmt->mipi, width);
+    uint32_t dst_stride = dstStride(width);
+    size_t size;
+    uint8_t *frame = allocFrame(fmt->mipi, width, height, &size);
+    uint8_t *packed = (uint8_t *)malloc(size);
+    uint16_t *expect = (uint16_t *)malloc(width * sizeof(uint16_t));
+    int fails = 0;
+
+    fillRandom(frame, size, seed);
+    memcpy(packed, frame, size);
+    conv->convert(rowFn(ops, fmt->mipi), frame, width, height, src_stride,
+            dst_stride);
+
+    for (uint32_t y = 0; y < height; y++) {
+        rowFn(ref, fmt->mipi)(packed + (size_t)y * src_stride, expect, width);
+        if (memcmp(expect, (uint16_t *)frame + (size_t)y * dst_stride,
+                width * sizeof(uint16_t))) {
+            printf("FAIL %s %s frame %ux%u row %u\n", ops->name, fmt->name,
+                    width, height, y);
+            fails++;
+            break;
+        }
+    }
+    free(frame);
+    free(packed);
+    free(expect);
+    return fails;
+}
+
+/*===========================================================================
+ * FUNCTION   : bench
+ *
+ * DESCRIPTION: time the in place conversion of a full frame, best of the
+ *              given number of runs
+ *
+ * PARAMETERS :
+ *   @conv       : converter, already initialized
+ *   @ops        : kernels to time
+ *   @fmt        : packed format
+ *   @width      : frame width
+ *   @height     : frame height
+ *   @iterations : number of runs
+ *
+ * RETURN     : best time in ms
+ *==========================================================================*/
+static double bench(QCamera3RawConverter *conv, const raw16_unpack_ops_t *ops,
+        const raw16_test_format_t *fmt, uint32_t width, uint32_t height,
+        int iterations)
+{
+    size_t size;
+    uint8_t *frame = allocFrame(fmt->mipi, width, height, &size);
+    double best = 0;
+
+    for (int i = 0; i < iterations; i++) {
+        memset(frame, 0x5a, size);
+        double start = nowMs();
+        conv->convert(rowFn(ops, fmt->mipi), frame, width, height,
+                srcStride(fmt->mipi, width), dstStride(width));
+        double ms = nowMs() - start;
+        if (i == 0 || ms < best) {
+            best = ms;
+        }
+    }
+    free(frame);
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = RAW16_TEST_ITERATIONS;
+    uint32_t workers = RAW16_CONVERT_MAX_WORKERS;
+    uint32_t width = RAW16_TEST_BENCH_WIDTH;
+    uint32_t height = RAW16_TEST_BENCH_HEIGHT;
+    unsigned seed = RAW16_TEST_SEED;
+    int fails = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:w:W:H:")) != -1) {
+        switch (opt) {
+        case 'i':
+            iterations = atoi(optarg);
+            break;
+        case 'w':
+            workers = (uint32_t)atoi(optarg);
+            break;
+        case 'W':
+            width = (uint32_t)atoi(optarg);
+            break;
+        case 'H':
+            height = (uint32_t)atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-i iterations] [-w workers] "
+                    "[-W width] [-H height]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations < 1 || width == 0 || height == 0 ||
+            workers > RAW16_CONVERT_MAX_WORKERS) {
+        fprintf(stderr, "%s: bad arguments\n", argv[0]);
+        return 2;
+    }
+
+    const raw16_unpack_ops_t *levels[] = {
+        getRaw16UnpackOpsForLevel(RAW16_UNPACK_REF),
+        getRaw16UnpackOpsForLevel(RAW16_UNPACK_SCALAR),
+        getRaw16UnpackOpsForLevel(RAW16_UNPACK_VECTOR),
+    };
+    size_t num_levels = sizeof(levels) / sizeof(levels[0]);
+    if (levels[RAW16_UNPACK_VECTOR] == levels[RAW16_UNPACK_SCALAR]) {
+        printf("no vector kernels for this cpu\n");
+        num_levels--;
+    }
+
+    QCamera3RawConverter single, multi;
+    single.init(0);
+    multi.init(workers);
+
+    for (size_t f = 0; f < sizeof(kTestFormats) / sizeof(kTestFormats[0]);
+            f++) {
+        const raw16_test_format_t *fmt = &kTestFormats[f];
+        for (size_t l = RAW16_UNPACK_SCALAR; l < num_levels; l++) {
+            fails += checkRows(levels[l], fmt, &seed);
+            fails += checkFrame(&single, levels[l], fmt, 333, 17, &seed);
+            fails += checkFrame(&multi, levels[l], fmt, 4104, 97, &seed);
+        }
+    }
+    printf("bit exact check: %s\n", fails ? "FAILED" : "ok");
+
+    printf("%ux%u, best of %d runs\n", width, height, iterations);
+    printf("%-8s %-10s %12s %12s\n", "format", "kernels", "1 thread",
+            "workers");
+    for (size_t f = 0; f < sizeof(kTestFormats) / sizeof(kTestFormats[0]);
+            f++) {
+        const raw16_test_format_t *fmt = &kTestFormats[f];
+        for (size_t l = 0; l < num_levels; l++) {
+            double one = bench(&single, levels[l], fmt, width, height,
+                    iterations);
+            double all = bench(&multi, levels[l], fmt, width, height,
+                    iterations);
+            printf("%-8s %-10s %9.2f ms %9.2f ms\n", fmt->name,
+                    levels[l]->name, one, all);
+        }
+    }
+
+    multi.deinit();
+    single.deinit();
+    return fails ? 1 : 0;
+}
@@ -139,8 +139,9 @@ typedef enum {
 } mm_camera_poll_thread_type_t;
 
 /* function ptr defined for poll notify CB,
- * registered at poll thread with poll fd */
-typedef void (*mm_camera_poll_notify_t)(void *user_data);
+ * registered at poll thread with poll fd.
+ * Data notifies return -EAGAIN once the fd has nothing left to dequeue */
+typedef int32_t (*mm_camera_poll_notify_t)(void *user_data);
 
 typedef struct {
     int32_t fd;
@@ -149,22 +150,43 @@ typedef struct {
     void* user_data;
 } mm_camera_poll_entry_t;
 
+/* data notify latency, per frame from the point the poll thread knew the
+ * stream was ready for VIDIOC_DQBUF to the call into mm_stream_data_notify.
+ * That point is the epoll wakeup for the first frame of a stream, the
+ * return of the previous notify for the following ones */
+typedef struct {
+    uint32_t frames;    /* frames dequeued */
+    uint32_t wakeups;   /* poll wakeups that dequeued frames */
+    uint32_t max_batch; /* most frames dequeued in one wakeup */
+    nsecs_t last_ns;
+    nsecs_t max_ns;
+    nsecs_t total_ns;
+} mm_camera_poll_latency_t;
+
 typedef struct {
     mm_camera_poll_thread_type_t poll_type;
     /* array to store poll fd and cb info
      * for MM_CAMERA_POLL_TYPE_EVT, only index 0 is valid;
      * for MM_CAMERA_POLL_TYPE_DATA, depends on valid stream fd */
     mm_camera_poll_entry_t poll_entries[MAX_STREAM_NUM_IN_BUNDLE];
-    int32_t pfds[2];
+    int32_t epoll_fd;
+    int32_t cmd_fd;     /* eventfd waking the poll thread for commands */
     pthread_t pid;
     int32_t state;
     int timeoutms;
-    uint32_t cmd;
-    struct pollfd poll_fds[MAX_STREAM_NUM_IN_BUNDLE + 1];
-    uint8_t num_fds;
+    uint32_t cmd;       /* pending commands, one bit per command type */
+    uint32_t cmd_seq;   /* commands posted */
+    uint32_t done_seq;  /* commands processed by the poll thread */
+    /* fds currently registered with epoll_fd, per poll entry */
+    int32_t poll_fds[MAX_STREAM_NUM_IN_BUNDLE];
+    /* entries that may still have data to dequeue */
+    uint32_t drain_pending;
+    /* CLOCK_MONOTONIC time each entry was last found ready */
+    nsecs_t ready_ns[MAX_STREAM_NUM_IN_BUNDLE];
     pthread_mutex_t mutex;
     pthread_cond_t cond_v;
     int32_t status;
+    mm_camera_poll_latency_t latency;
     char threadName[THREAD_NAME_SIZE];
     //void *my_obj;
 } mm_camera_poll_thread_t;
@@ -680,6 +702,9 @@ extern int32_t mm_camera_poll_thread_del_poll_fd(
                                 mm_camera_call_type_t);
 extern int32_t mm_camera_poll_thread_commit_updates(
         mm_camera_poll_thread_t * poll_cb);
+extern int32_t mm_camera_poll_thread_get_latency(
+        mm_camera_poll_thread_t * poll_cb,
+        mm_camera_poll_latency_t *latency);
 extern int32_t mm_camera_cmd_thread_launch(
                                 mm_camera_cmd_thread_t * cmd_thread,
                                 mm_camera_cmd_cb_t cb,
@@ -145,9 +145,10 @@ static void mm_camera_dispatch_app_event(mm_camera_cmdcb_t *cmd_cb,
  * PARAMETERS :
  *   @user_data: user data ptr (camera object)
  *
- * RETURN     : none
+ * RETURN     : int32_t type of status
+ *              0  -- success
  *==========================================================================*/
-static void mm_camera_event_notify(void* user_data)
+static int32_t mm_camera_event_notify(void* user_data)
 {
     struct v4l2_event ev;
     struct msm_v4l2_event_data *msm_evt = NULL;
@@ -193,6 +194,7 @@ static void mm_camera_event_notify(void* user_data)
             }
         }
     }
+    return 0;
 }
 
 /*===========================================================================
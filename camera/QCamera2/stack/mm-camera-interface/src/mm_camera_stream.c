@@ -241,14 +241,18 @@ void mm_stream_handle_rcvd_buf(mm_stream_t *my_obj,
 /*===========================================================================
  * FUNCTION   : mm_stream_data_notify
  *
- * DESCRIPTION: callback to handle data notify from kernel
+ * DESCRIPTION: callback to handle data notify from kernel, dequeues one
+ *              frame
  *
  * PARAMETERS :
  *   @user_data : user data ptr (stream object)
  *
- * RETURN     : none
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -EAGAIN -- no frame left to dequeue
+ *              -1 -- failure
  *==========================================================================*/
-static void mm_stream_data_notify(void* user_data)
+static int32_t mm_stream_data_notify(void* user_data)
 {
     mm_stream_t *my_obj = (mm_stream_t*)user_data;
     int32_t i, rc;
@@ -256,7 +260,7 @@ static void mm_stream_data_notify(void* user_data)
     mm_camera_buf_info_t buf_info;
 
     if (NULL == my_obj) {
-        return;
+        return -1;
     }
 
     CDBG("%s: E, my_handle = 0x%x, fd = %d, state = %d",
@@ -266,7 +270,7 @@ static void mm_stream_data_notify(void* user_data)
          * if not so, return here */
         CDBG_ERROR("%s: ERROR!! Wrong state (%d) to receive data notify!",
                    __func__, my_obj->state);
-        return;
+        return -1;
     }
 
     if (my_obj->stream_info->streaming_mode == CAM_STREAMING_MODE_BATCH) {
@@ -279,7 +283,7 @@ static void mm_stream_data_notify(void* user_data)
     rc = mm_stream_read_msm_frame(my_obj, &buf_info,
         (uint8_t)length);
     if (rc != 0) {
-        return;
+        return rc;
     }
     uint32_t idx = buf_info.buf->buf_idx;
 
@@ -307,6 +311,7 @@ static void mm_stream_data_notify(void* user_data)
     pthread_mutex_unlock(&my_obj->buf_lock);
 
     mm_stream_handle_rcvd_buf(my_obj, &buf_info, has_cb);
+    return 0;
 }
 
 /*===========================================================================
@@ -1219,6 +1224,7 @@ int32_t mm_stream_read_user_buf(mm_stream_t * my_obj,
  *
  * RETURN     : int32_t type of status
  *              0  -- success
+ *              -EAGAIN -- no frame ready
  *              -1 -- failure
  *==========================================================================*/
 int32_t mm_stream_read_msm_frame(mm_stream_t * my_obj,
@@ -1238,7 +1244,12 @@ int32_t mm_stream_read_msm_frame(mm_stream_t * my_obj,
     vb.length = num_planes;
 
     rc = ioctl(my_obj->fd, VIDIOC_DQBUF, &vb);
-    if (0 > rc) {
+    if (0 > rc && EAGAIN == errno) {
+        /* the poll thread drains until this, not an error */
+        CDBG("%s: no frame ready on stream type %d", __func__,
+            my_obj->stream_info->stream_type);
+        rc = -EAGAIN;
+    } else if (0 > rc) {
         CDBG_ERROR("%s: VIDIOC_DQBUF ioctl call failed on stream type %d (rc=%d): %s",
             __func__, my_obj->stream_info->stream_type, rc, strerror(errno));
     } else {
@@ -35,6 +35,9 @@
 #include <sys/prctl.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
 #include <cam_semaphore.h>
 
 #include "mm_camera_dbg.h"
@@ -60,16 +63,15 @@ typedef enum {
     MM_CAMERA_POLL_TASK_STATE_MAX
 } mm_camera_poll_task_state_type_t;
 
-typedef struct {
-    uint32_t cmd;
-    mm_camera_event_t event;
-} mm_camera_sig_evt_t;
-
+/* epoll user data of the command eventfd, poll entry idx is stored as idx + 1 */
+#define MM_CAMERA_POLL_CMD_KEY 0
+/* max frames dequeued from one stream before yielding to the others */
+#define MM_CAMERA_POLL_DRAIN_MAX 8
 
 /*===========================================================================
  * FUNCTION   : mm_camera_poll_sig_async
  *
- * DESCRIPTION: Asynchoronous call to send a command through pipe.
+ * DESCRIPTION: Asynchoronous call to post a command to the poll thread.
  *
  * PARAMETERS :
  *   @poll_cb      : ptr to poll thread object
@@ -82,40 +84,29 @@ typedef struct {
 static int32_t mm_camera_poll_sig_async(mm_camera_poll_thread_t *poll_cb,
                                   uint32_t cmd)
 {
-    /* send through pipe */
-    /* get the mutex */
-    mm_camera_sig_evt_t cmd_evt;
+    uint64_t val = 1;
 
     CDBG("%s: E cmd = %d", __func__,cmd);
-    memset(&cmd_evt, 0, sizeof(cmd_evt));
-    cmd_evt.cmd = cmd;
     pthread_mutex_lock(&poll_cb->mutex);
-    /* reset the statue to false */
-    poll_cb->status = FALSE;
+    /* commands are coalesced, the eventfd only wakes up the worker */
+    poll_cb->cmd |= (1U << cmd);
+    poll_cb->cmd_seq++;
 
-    /* send cmd to worker */
-    ssize_t len = write(poll_cb->pfds[1], &cmd_evt, sizeof(cmd_evt));
+    ssize_t len = write(poll_cb->cmd_fd, &val, sizeof(val));
     if (len < 1) {
         CDBG_ERROR("%s: len = %lld, errno = %d", __func__,
                 (long long int)len, errno);
-        /* Avoid waiting for the signal */
-        pthread_mutex_unlock(&poll_cb->mutex);
-        return 0;
     }
-    CDBG("%s: begin IN mutex write done, len = %lld", __func__,
-            (long long int)len);
     pthread_mutex_unlock(&poll_cb->mutex);
     CDBG("%s: X", __func__);
     return 0;
 }
 
-
-
-
 /*===========================================================================
  * FUNCTION   : mm_camera_poll_sig
  *
- * DESCRIPTION: synchorinzed call to send a command through pipe.
+ * DESCRIPTION: synchorinzed call to post a command to the poll thread.
+ *              Returns once the poll thread has processed it.
  *
  * PARAMETERS :
  *   @poll_cb      : ptr to poll thread object
@@ -128,19 +119,15 @@ static int32_t mm_camera_poll_sig_async(mm_camera_poll_thread_t *poll_cb,
 static int32_t mm_camera_poll_sig(mm_camera_poll_thread_t *poll_cb,
                                   uint32_t cmd)
 {
-    /* send through pipe */
-    /* get the mutex */
-    mm_camera_sig_evt_t cmd_evt;
+    uint64_t val = 1;
+    uint32_t seq;
 
     CDBG("%s: E cmd = %d", __func__,cmd);
-    memset(&cmd_evt, 0, sizeof(cmd_evt));
-    cmd_evt.cmd = cmd;
     pthread_mutex_lock(&poll_cb->mutex);
-    /* reset the statue to false */
-    poll_cb->status = FALSE;
-    /* send cmd to worker */
+    poll_cb->cmd |= (1U << cmd);
+    seq = ++poll_cb->cmd_seq;
 
-    ssize_t len = write(poll_cb->pfds[1], &cmd_evt, sizeof(cmd_evt));
+    ssize_t len = write(poll_cb->cmd_fd, &val, sizeof(val));
     if(len < 1) {
         CDBG_ERROR("%s: len = %lld, errno = %d", __func__,
                 (long long int)len, errno);
@@ -148,10 +135,8 @@ static int32_t mm_camera_poll_sig(mm_camera_poll_thread_t *poll_cb,
         pthread_mutex_unlock(&poll_cb->mutex);
         return 0;
     }
-    CDBG("%s: begin IN mutex write done, len = %lld", __func__,
-            (long long int)len);
-    /* wait till worker task gives positive signal */
-    if (FALSE == poll_cb->status) {
+    /* wait till worker task has processed this command */
+    while ((int32_t)(poll_cb->done_seq - seq) < 0) {
         CDBG("%s: wait", __func__);
         pthread_cond_wait(&poll_cb->cond_v, &poll_cb->mutex);
     }
@@ -162,20 +147,22 @@ static int32_t mm_camera_poll_sig(mm_camera_poll_thread_t *poll_cb,
 }
 
 /*===========================================================================
- * FUNCTION   : mm_camera_poll_sig
+ * FUNCTION   : mm_camera_poll_sig_done
  *
  * DESCRIPTION: signal the status of done
  *
  * PARAMETERS :
  *   @poll_cb : ptr to poll thread object
+ *   @seq     : last command sequence processed
  *
  * RETURN     : none
  *==========================================================================*/
-static void mm_camera_poll_sig_done(mm_camera_poll_thread_t *poll_cb)
+static void mm_camera_poll_sig_done(mm_camera_poll_thread_t *poll_cb,
+                                    uint32_t seq)
 {
     pthread_mutex_lock(&poll_cb->mutex);
-    poll_cb->status = TRUE;
-    pthread_cond_signal(&poll_cb->cond_v);
+    poll_cb->done_seq = seq;
+    pthread_cond_broadcast(&poll_cb->cond_v);
     CDBG("%s: done, in mutex", __func__);
     pthread_mutex_unlock(&poll_cb->mutex);
 }
@@ -198,74 +185,210 @@ static void mm_camera_poll_set_state(mm_camera_poll_thread_t *poll_cb,
 }
 
 /*===========================================================================
- * FUNCTION   : mm_camera_poll_proc_pipe
+ * FUNCTION   : mm_camera_poll_now
+ *
+ * DESCRIPTION: current CLOCK_MONOTONIC time, for the notify latency
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : time in ns
+ *==========================================================================*/
+static nsecs_t mm_camera_poll_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (nsecs_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_update_entries
  *
- * DESCRIPTION: polling thread routine to process pipe
+ * DESCRIPTION: sync the epoll set with poll_entries. Data fds are added
+ *              edge-triggered, the event fd level-triggered on POLLPRI.
  *
  * PARAMETERS :
  *   @poll_cb : ptr to poll thread object
  *
  * RETURN     : none
  *==========================================================================*/
-static void mm_camera_poll_proc_pipe(mm_camera_poll_thread_t *poll_cb)
+static void mm_camera_poll_update_entries(mm_camera_poll_thread_t *poll_cb)
 {
-    ssize_t read_len;
-    int i;
-    mm_camera_sig_evt_t cmd_evt;
-    read_len = read(poll_cb->pfds[0], &cmd_evt, sizeof(cmd_evt));
-    CDBG("%s: read_fd = %d, read_len = %d, expect_len = %d cmd = %d",
-         __func__, poll_cb->pfds[0], (int)read_len, (int)sizeof(cmd_evt), cmd_evt.cmd);
-    switch (cmd_evt.cmd) {
-    case MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED:
-    case MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC:
-        /* we always have index 0 for pipe read */
-        poll_cb->num_fds = 0;
-        poll_cb->poll_fds[poll_cb->num_fds].fd = poll_cb->pfds[0];
-        poll_cb->poll_fds[poll_cb->num_fds].events = POLLIN|POLLRDNORM|POLLPRI;
-        poll_cb->num_fds++;
-
-        if (MM_CAMERA_POLL_TYPE_EVT == poll_cb->poll_type &&
-                poll_cb->num_fds < MAX_STREAM_NUM_IN_BUNDLE) {
-            if (poll_cb->poll_entries[0].fd >= 0) {
-                /* fd is valid, we update poll_fds */
-                poll_cb->poll_fds[poll_cb->num_fds].fd = poll_cb->poll_entries[0].fd;
-                poll_cb->poll_fds[poll_cb->num_fds].events = POLLIN|POLLRDNORM|POLLPRI;
-                poll_cb->num_fds++;
+    struct epoll_event ev;
+    nsecs_t now = mm_camera_poll_now();
+    int32_t fd;
+    int i, cnt;
+
+    cnt = (MM_CAMERA_POLL_TYPE_EVT == poll_cb->poll_type) ?
+            1 : MAX_STREAM_NUM_IN_BUNDLE;
+
+    /* remove stale fds first, a closed fd number may already be reused
+     * by another entry and must not be deleted after it is added */
+    for (i = 0; i < cnt; i++) {
+        if (poll_cb->poll_fds[i] >= 0 &&
+                poll_cb->poll_fds[i] != poll_cb->poll_entries[i].fd) {
+            if (epoll_ctl(poll_cb->epoll_fd, EPOLL_CTL_DEL,
+                    poll_cb->poll_fds[i], NULL) < 0 &&
+                    errno != ENOENT && errno != EBADF) {
+                CDBG_ERROR("%s: EPOLL_CTL_DEL fd %d failed: %s",
+                        __func__, poll_cb->poll_fds[i], strerror(errno));
             }
-        } else if (MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type &&
-                poll_cb->num_fds <= MAX_STREAM_NUM_IN_BUNDLE) {
-            for(i = 0; i < MAX_STREAM_NUM_IN_BUNDLE; i++) {
-                if(poll_cb->poll_entries[i].fd >= 0) {
-                    /* fd is valid, we update poll_fds to this fd */
-                    poll_cb->poll_fds[poll_cb->num_fds].fd = poll_cb->poll_entries[i].fd;
-                    poll_cb->poll_fds[poll_cb->num_fds].events = POLLIN|POLLRDNORM|POLLPRI;
-                    poll_cb->num_fds++;
-                } else {
-                    /* fd is invalid, we set the entry to -1 to prevent polling.
-                     * According to spec, polling will not poll on entry with fd=-1.
-                     * If this is not the case, we need to skip these invalid fds
-                     * when updating this array.
-                     * We still keep fd=-1 in this array because this makes easier to
-                     * map cb associated with this fd once incoming data avail by directly
-                     * using the index-1(0 is reserved for pipe read, so need to reduce index by 1) */
-                    poll_cb->poll_fds[poll_cb->num_fds].fd = -1;
-                    poll_cb->poll_fds[poll_cb->num_fds].events = 0;
-                    poll_cb->num_fds++;
-                }
+            poll_cb->poll_fds[i] = -1;
+        }
+    }
+
+    for (i = 0; i < cnt; i++) {
+        fd = poll_cb->poll_entries[i].fd;
+        if (fd < 0) {
+            continue;
+        }
+        if (MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type) {
+            /* a frame may have completed while the entry was being
+             * swapped, edge-triggered epoll will not report it again */
+            if (!(poll_cb->drain_pending & (1U << i))) {
+                poll_cb->ready_ns[i] = now;
             }
+            poll_cb->drain_pending |= (1U << i);
+        }
+        if (poll_cb->poll_fds[i] == fd) {
+            continue;
+        }
+
+        memset(&ev, 0, sizeof(ev));
+        if (MM_CAMERA_POLL_TYPE_EVT == poll_cb->poll_type) {
+            ev.events = EPOLLPRI;
+        } else {
+            ev.events = EPOLLIN | EPOLLRDNORM | EPOLLET;
+        }
+        ev.data.u32 = (uint32_t)i + 1;
+        if (epoll_ctl(poll_cb->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0 &&
+                (errno != EEXIST ||
+                epoll_ctl(poll_cb->epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0)) {
+            CDBG_ERROR("%s: failed to add fd %d to epoll: %s",
+                    __func__, fd, strerror(errno));
+            continue;
         }
-        if (cmd_evt.cmd != MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC)
-            mm_camera_poll_sig_done(poll_cb);
-        break;
-
-    case MM_CAMERA_PIPE_CMD_COMMIT:
-        mm_camera_poll_sig_done(poll_cb);
-        break;
-    case MM_CAMERA_PIPE_CMD_EXIT:
-    default:
+        poll_cb->poll_fds[i] = fd;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_proc_cmd
+ *
+ * DESCRIPTION: polling thread routine to process pending commands
+ *
+ * PARAMETERS :
+ *   @poll_cb : ptr to poll thread object
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void mm_camera_poll_proc_cmd(mm_camera_poll_thread_t *poll_cb)
+{
+    uint64_t val = 0;
+    uint32_t cmds, seq;
+    ssize_t read_len;
+
+    /* reset the eventfd counter before picking up the commands, anything
+     * posted after this point raises it again */
+    read_len = read(poll_cb->cmd_fd, &val, sizeof(val));
+
+    pthread_mutex_lock(&poll_cb->mutex);
+    cmds = poll_cb->cmd;
+    poll_cb->cmd = 0;
+    seq = poll_cb->cmd_seq;
+    pthread_mutex_unlock(&poll_cb->mutex);
+
+    CDBG("%s: cmd_fd = %d, read_len = %d, wakeups = %lld cmds = 0x%x",
+         __func__, poll_cb->cmd_fd, (int)read_len, (long long)val, cmds);
+
+    if (cmds & ((1U << MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED) |
+            (1U << MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC))) {
+        mm_camera_poll_update_entries(poll_cb);
+    }
+    if (cmds & ~((1U << MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED) |
+            (1U << MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC) |
+            (1U << MM_CAMERA_PIPE_CMD_COMMIT))) {
         mm_camera_poll_set_state(poll_cb, MM_CAMERA_POLL_TASK_STATE_STOPPED);
-        mm_camera_poll_sig_done(poll_cb);
-        break;
+    }
+    mm_camera_poll_sig_done(poll_cb, seq);
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_drain_entry
+ *
+ * DESCRIPTION: dispatch data notifies for one stream until VIDIOC_DQBUF
+ *              finds nothing left (-EAGAIN), as required by edge-triggered
+ *              polling
+ *
+ * PARAMETERS :
+ *   @poll_cb  : ptr to poll thread object
+ *   @idx      : poll entry index
+ *
+ * RETURN     : number of frames dequeued
+ *==========================================================================*/
+static uint32_t mm_camera_poll_drain_entry(mm_camera_poll_thread_t *poll_cb,
+                                           int idx)
+{
+    mm_camera_poll_entry_t *entry = &poll_cb->poll_entries[idx];
+    int32_t fd = poll_cb->poll_fds[idx];
+    uint32_t frames = 0;
+    nsecs_t ready_ns = poll_cb->ready_ns[idx];
+    nsecs_t call_ns, latency;
+    int32_t rc;
+
+    while (fd >= 0 && entry->fd == fd && NULL != entry->notify_cb) {
+        if (frames == MM_CAMERA_POLL_DRAIN_MAX) {
+            /* let the other streams run, come back on the next pass */
+            poll_cb->ready_ns[idx] = ready_ns;
+            poll_cb->drain_pending |= (1U << idx);
+            break;
+        }
+
+        CDBG("%s: mm_stream_data_notify\n", __func__);
+        call_ns = mm_camera_poll_now();
+        rc = entry->notify_cb(entry->user_data);
+        if (rc < 0) {
+            /* -EAGAIN: drained, anything else: the stream can't take more */
+            break;
+        }
+        frames++;
+        latency = call_ns - ready_ns;
+
+        pthread_mutex_lock(&poll_cb->mutex);
+        poll_cb->latency.frames++;
+        poll_cb->latency.last_ns = latency;
+        poll_cb->latency.total_ns += latency;
+        if (latency > poll_cb->latency.max_ns) {
+            poll_cb->latency.max_ns = latency;
+        }
+        pthread_mutex_unlock(&poll_cb->mutex);
+
+        /* the drain goes for the next frame from here */
+        ready_ns = mm_camera_poll_now();
+    }
+    return frames;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_wait_cmd
+ *
+ * DESCRIPTION: block on the command eventfd alone. Used when epoll_wait
+ *              fails so the thread neither spins nor misses an exit.
+ *
+ * PARAMETERS :
+ *   @poll_cb : ptr to poll thread object
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void mm_camera_poll_wait_cmd(mm_camera_poll_thread_t *poll_cb)
+{
+    struct pollfd pfd;
+
+    pfd.fd = poll_cb->cmd_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, -1) > 0 && (pfd.revents & POLLIN)) {
+        mm_camera_poll_proc_cmd(poll_cb);
     }
 }
 
@@ -281,52 +404,88 @@ static void mm_camera_poll_proc_pipe(mm_camera_poll_thread_t *poll_cb)
  *==========================================================================*/
 static void *mm_camera_poll_fn(mm_camera_poll_thread_t *poll_cb)
 {
-    int rc = 0, i;
+    struct epoll_event events[MAX_STREAM_NUM_IN_BUNDLE + 1];
+    uint32_t frames, pending;
+    nsecs_t now;
+    uint8_t cmd_rcvd;
+    int rc = 0, i, idx;
 
     if (NULL == poll_cb) {
         CDBG_ERROR("%s: poll_cb is NULL!\n", __func__);
         return NULL;
     }
-    CDBG("%s: poll type = %d, num_fd = %d poll_cb = %p\n",
-         __func__, poll_cb->poll_type, poll_cb->num_fds,poll_cb);
+    CDBG("%s: poll type = %d, epoll fd = %d poll_cb = %p\n",
+         __func__, poll_cb->poll_type, poll_cb->epoll_fd, poll_cb);
     do {
-         for(i = 0; i < poll_cb->num_fds; i++) {
-            poll_cb->poll_fds[i].events = POLLIN|POLLRDNORM|POLLPRI;
-         }
-
-         rc = poll(poll_cb->poll_fds, poll_cb->num_fds, poll_cb->timeoutms);
-         if(rc > 0) {
-            if ((poll_cb->poll_fds[0].revents & POLLIN) &&
-                (poll_cb->poll_fds[0].revents & POLLRDNORM)) {
-                /* if we have data on pipe, we only process pipe in this iteration */
-                CDBG("%s: cmd received on pipe\n", __func__);
-                mm_camera_poll_proc_pipe(poll_cb);
-            } else {
-                for(i=1; i<poll_cb->num_fds; i++) {
-                    /* Checking for ctrl events */
-                    if ((poll_cb->poll_type == MM_CAMERA_POLL_TYPE_EVT) &&
-                        (poll_cb->poll_fds[i].revents & POLLPRI)) {
-                        CDBG("%s: mm_camera_evt_notify\n", __func__);
-                        if (NULL != poll_cb->poll_entries[i-1].notify_cb) {
-                            poll_cb->poll_entries[i-1].notify_cb(poll_cb->poll_entries[i-1].user_data);
-                        }
-                    }
-
-                    if ((MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type) &&
-                        (poll_cb->poll_fds[i].revents & POLLIN) &&
-                        (poll_cb->poll_fds[i].revents & POLLRDNORM)) {
-                        CDBG("%s: mm_stream_data_notify\n", __func__);
-                        if (NULL != poll_cb->poll_entries[i-1].notify_cb) {
-                            poll_cb->poll_entries[i-1].notify_cb(poll_cb->poll_entries[i-1].user_data);
-                        }
-                    }
-                }
+        rc = epoll_wait(poll_cb->epoll_fd, events,
+                MAX_STREAM_NUM_IN_BUNDLE + 1,
+                poll_cb->drain_pending ? 0 : poll_cb->timeoutms);
+        if (rc < 0) {
+            if (errno != EINTR) {
+                CDBG_ERROR("%s: epoll_wait failed: %s", __func__,
+                        strerror(errno));
+                mm_camera_poll_wait_cmd(poll_cb);
             }
-        } else {
-            /* in error case sleep 10 us and then continue. hard coded here */
-            usleep(10);
             continue;
         }
+
+        cmd_rcvd = FALSE;
+        frames = 0;
+        now = mm_camera_poll_now();
+        for (i = 0; i < rc; i++) {
+            if (MM_CAMERA_POLL_CMD_KEY == events[i].data.u32) {
+                /* handled after all ready streams are drained */
+                cmd_rcvd = TRUE;
+                continue;
+            }
+            idx = (int)events[i].data.u32 - 1;
+            if (idx < 0 || idx >= MAX_STREAM_NUM_IN_BUNDLE) {
+                continue;
+            }
+
+            /* Checking for ctrl events */
+            if ((MM_CAMERA_POLL_TYPE_EVT == poll_cb->poll_type) &&
+                (events[i].events & EPOLLPRI)) {
+                CDBG("%s: mm_camera_evt_notify\n", __func__);
+                if (NULL != poll_cb->poll_entries[idx].notify_cb) {
+                    poll_cb->poll_entries[idx].notify_cb(poll_cb->poll_entries[idx].user_data);
+                }
+            }
+
+            if ((MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type) &&
+                (events[i].events & EPOLLIN) &&
+                (events[i].events & EPOLLRDNORM)) {
+                /* a stream left over from a capped drain was ready earlier */
+                if (!(poll_cb->drain_pending & (1U << idx))) {
+                    poll_cb->ready_ns[idx] = now;
+                }
+                poll_cb->drain_pending &= ~(1U << idx);
+                frames += mm_camera_poll_drain_entry(poll_cb, idx);
+            }
+        }
+
+        /* streams left over from a capped drain or an entries update */
+        pending = poll_cb->drain_pending;
+        poll_cb->drain_pending = 0;
+        for (idx = 0; pending != 0; idx++, pending >>= 1) {
+            if (pending & 1) {
+                frames += mm_camera_poll_drain_entry(poll_cb, idx);
+            }
+        }
+
+        if (frames > 0) {
+            pthread_mutex_lock(&poll_cb->mutex);
+            poll_cb->latency.wakeups++;
+            if (frames > poll_cb->latency.max_batch) {
+                poll_cb->latency.max_batch = frames;
+            }
+            pthread_mutex_unlock(&poll_cb->mutex);
+        }
+
+        if (cmd_rcvd) {
+            CDBG("%s: cmd received on eventfd\n", __func__);
+            mm_camera_poll_proc_cmd(poll_cb);
+        }
     } while ((poll_cb != NULL) && (poll_cb->state == MM_CAMERA_POLL_TASK_STATE_POLL));
     return NULL;
 }
@@ -346,11 +505,11 @@ static void *mm_camera_poll_thread(void *data)
     prctl(PR_SET_NAME, (unsigned long)"mm_cam_poll_th", 0, 0, 0);
     mm_camera_poll_thread_t *poll_cb = (mm_camera_poll_thread_t *)data;
 
-    /* add pipe read fd into poll first */
-    poll_cb->poll_fds[poll_cb->num_fds++].fd = poll_cb->pfds[0];
-
-    mm_camera_poll_sig_done(poll_cb);
+    pthread_mutex_lock(&poll_cb->mutex);
     mm_camera_poll_set_state(poll_cb, MM_CAMERA_POLL_TASK_STATE_POLL);
+    poll_cb->status = TRUE;
+    pthread_cond_signal(&poll_cb->cond_v);
+    pthread_mutex_unlock(&poll_cb->mutex);
     return mm_camera_poll_fn(poll_cb);
 }
 
@@ -388,6 +547,34 @@ int32_t mm_camera_poll_thread_commit_updates(mm_camera_poll_thread_t * poll_cb)
     return mm_camera_poll_sig(poll_cb, MM_CAMERA_PIPE_CMD_COMMIT);
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_thread_get_latency
+ *
+ * DESCRIPTION: read the data notify latency counters, measured per frame
+ *              from the poll thread knowing a stream fd is ready for
+ *              VIDIOC_DQBUF to the call into its notify_cb
+ *              (mm_stream_data_notify)
+ *
+ * PARAMETERS :
+ *   @poll_cb : ptr to poll thread object
+ *   @latency : ptr to store the counters
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+int32_t mm_camera_poll_thread_get_latency(mm_camera_poll_thread_t * poll_cb,
+                                          mm_camera_poll_latency_t *latency)
+{
+    if (NULL == poll_cb || NULL == latency) {
+        return -1;
+    }
+    pthread_mutex_lock(&poll_cb->mutex);
+    *latency = poll_cb->latency;
+    pthread_mutex_unlock(&poll_cb->mutex);
+    return 0;
+}
+
 /*===========================================================================
  * FUNCTION   : mm_camera_poll_thread_add_poll_fd
  *
@@ -496,32 +683,57 @@ int32_t mm_camera_poll_thread_launch(mm_camera_poll_thread_t * poll_cb,
 {
     int32_t rc = 0;
     size_t i = 0, cnt = 0;
+    struct epoll_event ev;
     poll_cb->poll_type = poll_type;
 
     //Initialize poll_fds
     cnt = sizeof(poll_cb->poll_fds) / sizeof(poll_cb->poll_fds[0]);
     for (i = 0; i < cnt; i++) {
-        poll_cb->poll_fds[i].fd = -1;
+        poll_cb->poll_fds[i] = -1;
     }
     //Initialize poll_entries
     cnt = sizeof(poll_cb->poll_entries) / sizeof(poll_cb->poll_entries[0]);
     for (i = 0; i < cnt; i++) {
         poll_cb->poll_entries[i].fd = -1;
     }
-    //Initialize pipe fds
-    poll_cb->pfds[0] = -1;
-    poll_cb->pfds[1] = -1;
-    rc = pipe(poll_cb->pfds);
-    if(rc < 0) {
-        CDBG_ERROR("%s: pipe open rc=%d\n", __func__, rc);
+    poll_cb->cmd = 0;
+    poll_cb->cmd_seq = 0;
+    poll_cb->done_seq = 0;
+    poll_cb->drain_pending = 0;
+    memset(&poll_cb->latency, 0, sizeof(poll_cb->latency));
+
+    //Initialize epoll and command eventfd
+    poll_cb->cmd_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (poll_cb->cmd_fd < 0) {
+        CDBG_ERROR("%s: eventfd open failed: %s\n", __func__, strerror(errno));
+        return -1;
+    }
+    poll_cb->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (poll_cb->epoll_fd < 0) {
+        CDBG_ERROR("%s: epoll open failed: %s\n", __func__, strerror(errno));
+        close(poll_cb->cmd_fd);
+        poll_cb->cmd_fd = -1;
+        return -1;
+    }
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = MM_CAMERA_POLL_CMD_KEY;
+    rc = epoll_ctl(poll_cb->epoll_fd, EPOLL_CTL_ADD, poll_cb->cmd_fd, &ev);
+    if (rc < 0) {
+        CDBG_ERROR("%s: failed to add eventfd to epoll: %s\n", __func__,
+                strerror(errno));
+        close(poll_cb->epoll_fd);
+        close(poll_cb->cmd_fd);
+        poll_cb->epoll_fd = -1;
+        poll_cb->cmd_fd = -1;
         return -1;
     }
 
     poll_cb->timeoutms = -1;  /* Infinite seconds */
 
-    CDBG("%s: poll_type = %d, read fd = %d, write fd = %d timeout = %d",
+    CDBG("%s: poll_type = %d, epoll fd = %d, cmd fd = %d timeout = %d",
         __func__, poll_cb->poll_type,
-        poll_cb->pfds[0], poll_cb->pfds[1],poll_cb->timeoutms);
+        poll_cb->epoll_fd, poll_cb->cmd_fd, poll_cb->timeoutms);
 
     pthread_mutex_init(&poll_cb->mutex, NULL);
     pthread_cond_init(&poll_cb->cond_v, NULL);
@@ -530,7 +742,7 @@ int32_t mm_camera_poll_thread_launch(mm_camera_poll_thread_t * poll_cb,
     pthread_mutex_lock(&poll_cb->mutex);
     poll_cb->status = 0;
     pthread_create(&poll_cb->pid, NULL, mm_camera_poll_thread, (void *)poll_cb);
-    if(!poll_cb->status) {
+    while (!poll_cb->status) {
         pthread_cond_wait(&poll_cb->cond_v, &poll_cb->mutex);
     }
     if (!strlen(poll_cb->threadName)) {
@@ -558,19 +770,28 @@ int32_t mm_camera_poll_thread_release(mm_camera_poll_thread_t *poll_cb)
         CDBG_ERROR("%s: pthread dead already\n", __func__);
     }
 
-    /* close pipe */
-    if(poll_cb->pfds[0] >= 0) {
-        close(poll_cb->pfds[0]);
+    if (poll_cb->latency.frames > 0) {
+        CDBG_HIGH("%s: poll type %d: %u frames in %u wakeups (max batch %u),"
+                " notify latency avg %lld ns max %lld ns", __func__,
+                poll_cb->poll_type, poll_cb->latency.frames,
+                poll_cb->latency.wakeups, poll_cb->latency.max_batch,
+                (long long)(poll_cb->latency.total_ns / poll_cb->latency.frames),
+                (long long)poll_cb->latency.max_ns);
+    }
+
+    /* close epoll and eventfd, closing epoll drops all registered fds */
+    if(poll_cb->epoll_fd >= 0) {
+        close(poll_cb->epoll_fd);
     }
-    if(poll_cb->pfds[1] >= 0) {
-        close(poll_cb->pfds[1]);
+    if(poll_cb->cmd_fd >= 0) {
+        close(poll_cb->cmd_fd);
     }
 
     pthread_mutex_destroy(&poll_cb->mutex);
     pthread_cond_destroy(&poll_cb->cond_v);
     memset(poll_cb, 0, sizeof(mm_camera_poll_thread_t));
-    poll_cb->pfds[0] = -1;
-    poll_cb->pfds[1] = -1;
+    poll_cb->epoll_fd = -1;
+    poll_cb->cmd_fd = -1;
     return rc;
 }
 
@@ -0,0 +1,92 @@
+/*
+Copyright (c) 2014, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_CfgSnapshot.h
+
+	@brief
+	This file implements the binary snapshots of the parsed XML configuration
+
+	@Author
+
+*/
+#ifndef IPACM_CFG_SNAPSHOT_H
+#define IPACM_CFG_SNAPSHOT_H
+
+#include <stdint.h>
+#include "IPACM_Xml.h"
+
+/* A snapshot is the raw parsed structure behind a header identifying the
+	 XML it came from. It is used as long as the XML has the same mtime and
+	 size, or the same content hash, otherwise the XML is parsed again and
+	 the snapshot rewritten */
+#define IPACM_SNAPSHOT_DIR "/data/misc/ipa/"
+#define IPACM_SNAPSHOT_SUFFIX ".snap"
+#define IPACM_SNAPSHOT_MAGIC 0x49505343 /* "IPSC" */
+#define IPACM_SNAPSHOT_VERSION 1
+
+#define IPACM_SNAPSHOT_KIND_CFG 1
+#define IPACM_SNAPSHOT_KIND_FIREWALL 2
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t kind;
+	uint32_t conf_size;
+	int64_t src_mtime_sec;
+	int64_t src_mtime_nsec;
+	int64_t src_size;
+	uint64_t src_hash;
+	char src_path[IPA_MAX_FILE_LEN];
+} ipacm_snapshot_hdr;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ipacm_read_cfg_xml() through the snapshot */
+int ipacm_read_cfg_snapshot
+(
+	char *xml_file,
+	IPACM_conf_t *config
+);
+
+/* IPACM_read_firewall_xml() through the snapshot */
+int IPACM_read_firewall_snapshot
+(
+	char *xml_file,
+	IPACM_firewall_conf_t *config
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IPACM_CFG_SNAPSHOT_H */
@@ -60,45 +60,81 @@ typedef struct cmd_s
 	ipacm_cmd_q_data data;
 }cmd_t;
 
+/* Number of preallocated queue slots, must be a power of 2 */
+#define IPACM_MSG_QUEUE_SLOTS 1024
+
+/* One slot of the command ring. seq tells producers and the consumer
+	 whose turn it is: seq == pos means free for the producer claiming pos,
+	 seq == pos + 1 means filled and ready for the consumer */
 class Message
 {
-private:
-	Message *m_next;
-
 public:
+	uint32_t seq;
 	cmd_t evt;
+	/* Only used when the message sits on the consumer overflow list */
+	Message *next;
 
 	Message()
 	{
-		m_next = NULL;
+		seq = 0;
 		evt.callback_ptr = NULL;
+		next = NULL;
 	}
 	~Message() { }
-	void setnext(Message *item) { m_next = item; }
-	Message* getnext()       { return m_next; }
 };
 
+/* Bounded lock free multi producer, single consumer command queue.
+	 Producers claim a slot with a CAS on Tail, the consumer (Process
+	 thread) owns Head and sleeps on a futex only when the ring is empty.
+	 When the ring is full, posts from the consumer itself go to an
+	 unbounded overflow list, posts from any other thread wait for a
+	 free slot, no event is ever dropped */
 class MessageQueue
 {
 
 private:
-	Message *Head;
-	Message *Tail;
-	Message* dequeue(void);
+	Message Slots[IPACM_MSG_QUEUE_SLOTS];
+	uint32_t Head;
+	uint32_t Tail;
+
+	/* Bumped on every post, the consumer futex waits on it */
+	uint32_t wake_seq;
+	uint32_t waiting;
+
+	/* Number of posts that found the ring full */
+	uint32_t full_cnt;
+
+	/* Bumped on every dequeue, producers waiting for a slot futex
+		 wait on it */
+	uint32_t space_seq;
+	uint32_t space_waiters;
+
+	/* Consumer owned overflow list, drained after the ring */
+	Message *OvfHead;
+	Message *OvfTail;
+
+	/* Process thread, valid once consumer_set is set */
+	pthread_t consumer;
+	uint32_t consumer_set;
+
+	bool isConsumer(void);
+	void enqueueOverflow(const cmd_t *evt);
+	void waitSpace(uint32_t pos);
+	bool dequeue(cmd_t *evt);
+	void wait(void);
+
 	static MessageQueue *inst;
 
-	MessageQueue()
-	{
-		Head = NULL;
-		Tail = NULL;
-	}
+	MessageQueue();
 
 public:
 
 	~MessageQueue() { }
-	void enqueue(Message *item);
+
+	int enqueue(const cmd_t *evt);
 
 	static void* Process(void *);
+
 	static MessageQueue* getInstance();
 
 };
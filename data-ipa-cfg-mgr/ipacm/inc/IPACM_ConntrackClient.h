@@ -70,6 +70,50 @@ using namespace std;
 #define INOTIFY_EVT_SIZE  (sizeof(struct inotify_event))
 #define INOTIFY_BUFFER_LEN     (INOTIFY_EVT_SIZE + 2*sizeof(IPACM_TCP_FILE_NAME))
 
+/* addresses compiled into the kernel conntrack filters */
+#define IPACM_CT_MAX_IGNORE_IFACES 32
+#define IPACM_CT_MAX_IGNORE_CLNTS 50
+#define IPACM_CT_LOOPBACK_NET 0x7F000000
+#define IPACM_CT_LOOPBACK_MASK 0xFF000000
+
+#define IPACM_CT_PORT_BITS_WORDS (65536 / 32)
+
+/* local interface whose connections the filters drop; bcast_addr is 0
+	 for the bridge, which only contributes its own address */
+typedef struct _ipacm_ct_ignore_iface
+{
+	char ifname[IPA_IFACE_NAME_LEN];
+	int if_index;
+	uint32_t addr;
+	uint32_t bcast_addr;
+} ipacm_ct_ignore_iface;
+
+/* original direction tuple, used to merge events of one connection */
+typedef struct _ipacm_ct_tuple
+{
+	uint32_t src_ip;
+	uint32_t dst_ip;
+	uint16_t src_port;
+	uint16_t dst_port;
+	uint8_t proto;
+} ipacm_ct_tuple;
+
+/* per conntrack handle batch, filled by the event callback and
+	 posted once the socket has been drained */
+typedef struct _ipacm_ct_batch_ctx
+{
+	const char *name;
+	ipacm_ct_evt_batch *batch;
+	ipacm_ct_tuple keys[IPACM_CT_BATCH_MAX];
+	uint32_t num_rcvd;
+	uint32_t num_merged;
+	uint32_t num_filtered;
+	/* this thread's copy of the ALG port set, refreshed when
+		 alg_port_gen moves so lookups never take filter_lock */
+	uint32_t alg_port_gen;
+	uint32_t alg_port_bits[2][IPACM_CT_PORT_BITS_WORDS];
+} ipacm_ct_batch_ctx;
+
 class IPACM_ConntrackClient
 {
 
@@ -78,11 +122,33 @@ private:
 
    struct nfct_handle *tcp_hdl;
    struct nfct_handle *udp_hdl;
-   struct nfct_filter *tcp_filter;
-   struct nfct_filter *udp_filter;
-   static int IPA_Conntrack_Filters_Ignore_Local_Addrs(struct nfct_filter *filter);
-   static int IPA_Conntrack_Filters_Ignore_Bridge_Addrs(struct nfct_filter *filter);
-   static int IPA_Conntrack_Filters_Ignore_Local_Iface(struct nfct_filter *, ipacm_event_iface_up *);
+   ipacm_ct_batch_ctx tcp_batch;
+   ipacm_ct_batch_ctx udp_batch;
+
+   /* filter_lock protects the ignore lists, the ALG port set and
+      filter (re)attachment */
+   pthread_mutex_t filter_lock;
+   int num_ignore_ifaces;
+   ipacm_ct_ignore_iface ignore_ifaces[IPACM_CT_MAX_IGNORE_IFACES];
+   int num_ignore_clnts;
+   uint32_t ignore_clnts[IPACM_CT_MAX_IGNORE_CLNTS];
+   uint32_t alg_port_bits[2][IPACM_CT_PORT_BITS_WORDS];
+   /* bumped after every alg_port_bits reload */
+   uint32_t alg_port_gen;
+
+   static int IPA_Conntrack_Filters_Ignore_Addr(struct nfct_filter *, uint32_t, uint32_t);
+   static int IPA_Conntrack_Filters_Ignore_Bridge_Addrs(void);
+   static int IPA_Conntrack_Filters_Ignore_Local_Iface(ipacm_event_iface_up *);
+   static struct nfct_filter *IPA_Conntrack_Build_Filter(uint8_t l4proto);
+   static ipacm_ct_ignore_iface *IPA_Conntrack_Get_Ignore_Iface(const char *ifname);
+   static int IPA_Conntrack_Attach_Filter(struct nfct_handle *, uint8_t l4proto);
+   static void LoadAlgPorts(void);
+   static void SyncAlgPorts(ipacm_ct_batch_ctx *);
+   static bool IsAlgPort(ipacm_ct_batch_ctx *, uint8_t proto, uint16_t port);
+   static bool IsCTEventUseful(ipacm_ct_batch_ctx *, struct nf_conntrack *, enum nf_conntrack_msg_type);
+   static int BatchCTEvent(ipacm_ct_batch_ctx *, struct nf_conntrack *, enum nf_conntrack_msg_type);
+   static void FlushCTBatch(ipacm_ct_batch_ctx *);
+   static int CatchCTEvents(struct nfct_handle *, ipacm_ct_batch_ctx *);
    IPACM_ConntrackClient();
 
 public:
@@ -99,6 +165,8 @@ public:
 
    static void UpdateUDPFilters(void *, bool);
    static void UpdateTCPFilters(void *, bool);
+   static void UpdateNonNatClient(uint32_t, bool);
+   static void RemoveLocalIface(int if_index);
    static void Read_TcpUdp_Timeout(char *in, int len);
 
    static IPACM_ConntrackClient* GetInstance();
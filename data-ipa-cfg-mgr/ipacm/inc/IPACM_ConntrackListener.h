@@ -49,6 +49,11 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define MAX_NAT_IFACES 50
 #define MAX_STA_CLNT_IFACES 10
 
+/* one bit per hashed nat iface address, lets most connections skip
+	 the nat_iface_ipv4_addr scan */
+#define NAT_IFACE_BITSET_BITS 256
+#define NAT_IFACE_BITSET_WORDS (NAT_IFACE_BITSET_BITS / 32)
+
 using namespace std;
 
 class IPACM_ConntrackListener : public IPACM_Listener
@@ -64,6 +69,7 @@ private:
 	int StaClntCnt;
 	NatIfaces *pNatIfaces;
 	uint32_t nat_iface_ipv4_addr[MAX_NAT_IFACES];
+	uint32_t nat_iface_bits[NAT_IFACE_BITSET_WORDS];
 	uint32_t nonnat_iface_ipv4_addr[MAX_NAT_IFACES];
 	uint32_t sta_clnt_ipv4_addr[MAX_STA_CLNT_IFACES];
 	IPACM_Config *pConfig;
@@ -72,6 +78,18 @@ private:
 #endif
 
 	void ProcessCTMessage(void *);
+	void ProcessCTBatch(void *);
+	void UpdateNatIfaceBits(void);
+	inline uint32_t NatIfaceBit(uint32_t ip_addr)
+	{
+		return (ip_addr ^ (ip_addr >> 8) ^ (ip_addr >> 16) ^ (ip_addr >> 24)) &
+			(NAT_IFACE_BITSET_BITS - 1);
+	}
+	inline bool MayBeNatIface(uint32_t ip_addr)
+	{
+		uint32_t bit = NatIfaceBit(ip_addr);
+		return (nat_iface_bits[bit >> 5] & (1U << (bit & 31))) != 0;
+	}
 	void ProcessTCPorUDPMsg(struct nf_conntrack *,
 	enum nf_conntrack_msg_type, u_int8_t);
 	void TriggerWANUp(void *);
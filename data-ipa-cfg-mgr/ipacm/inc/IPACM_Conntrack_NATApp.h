@@ -32,6 +32,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string.h>  /* for stderror */
 #include <stdlib.h>
 #include <cstdio>  /* for perror */
+#include <pthread.h>
 
 #include "IPACM_Config.h"
 #include "IPACM_Xml.h"
@@ -44,6 +45,18 @@ extern "C"
 
 #define MAX_TEMP_ENTRIES 25
 
+/* Sentinel for the cache slot index lists */
+#define NAT_CACHE_INVALID_SLOT -1
+
+/* The cache is split into shards by connection hash, each with its own lock,
+   so the conntrack threads only contend on the NAT table itself */
+#define NAT_CACHE_SHARD_BITS 2
+#define NAT_CACHE_SHARDS (1 << NAT_CACHE_SHARD_BITS)
+
+/* Slots of the timestamp check timer wheel, one tick is UDP_TIMEOUT_UPDATE secs */
+#define NAT_TIMER_WHEEL_SLOTS 64
+#define NAT_TIMER_TICK_NONE 0xFFFFFFFF
+
 typedef struct _nat_table_entry
 {
 	uint32_t private_ip;
@@ -64,6 +77,22 @@ typedef struct _nat_table_entry
 
 }nat_table_entry;
 
+/* A shard starts out with a contiguous range of cache slots on its free list.
+   Once that runs dry it borrows from NatApp::pool_head, then from the free
+   list of another shard, so one busy shard can use the whole cache.
+   NatApp::slot_shard[] tells which shard a used slot belongs to.
+   Its 5-tuple hash index chains slots through NatApp::hash_next,
+   unused slots are chained through hash_next starting at free_head.
+   active[0..curCnt-1] lists used slots, NatApp::active_pos[] is the reverse map */
+typedef struct _nat_cache_shard
+{
+	pthread_mutex_t lock;
+	int *hash_head;
+	int free_head;
+	int *active;
+	int curCnt;
+}nat_cache_shard;
+
 #define CHK_TBL_HDL()  if(nat_table_hdl == 0){ return -1; }
 
 class NatApp
@@ -74,11 +103,45 @@ private:
 
 	nat_table_entry *cache;
 	nat_table_entry temp[MAX_TEMP_ENTRIES];
+	pthread_mutex_t temp_lock;
 	uint32_t pub_ip_addr;
 	uint32_t pub_ip_addr_pre;
 	uint32_t nat_table_hdl;
 
-	int curCnt, max_entries;
+	int max_entries;
+
+	/* Lock order: shard locks (ascending), table_lock, timer_lock.
+	   pool_lock is only taken under a shard lock and nests nothing */
+	nat_cache_shard shards[NAT_CACHE_SHARDS];
+	int shard_size;
+	int *hash_next;
+	int hash_mask;
+	int *active_pos;
+	int *slot_shard;
+
+	/* Slots freed by a shard that borrowed them */
+	int pool_head;
+	pthread_mutex_t pool_lock;
+
+	/* Serializes the NAT table handle and all libipanat calls */
+	pthread_mutex_t table_lock;
+
+	/* Scratch arrays to re-program the cache on WAN up in one batch */
+	ipa_nat_ipv4_rule *restore_rules;
+	uint32_t *restore_hdls;
+	int *restore_slots;
+
+	/* Hashed timer wheel of enabled entries, keyed on the tick at which
+	   their HW timestamp has to be checked against conntrack expiry */
+	int timer_wheel[NAT_TIMER_WHEEL_SLOTS];
+	int *timer_next;
+	int *timer_prev;
+	uint32_t *timer_expiry;
+	uint32_t timer_tick;
+	uint32_t timer_wait_tick;
+	int *timer_due;
+	pthread_mutex_t timer_lock;
+	pthread_cond_t timer_cond;
 
 	ipacm_alg *pALGPorts;
 	uint16_t nALGPort;
@@ -95,7 +158,25 @@ private:
 	int Init();
 
 	void UpdateCTUdpTs(nat_table_entry *, uint32_t);
-	bool ChkForDup(const nat_table_entry *);
+	bool ChkForDup(nat_cache_shard *, uint32_t, const nat_table_entry *);
+	uint32_t HashEntry(const nat_table_entry *);
+	nat_cache_shard *GetShard(uint32_t);
+	nat_cache_shard *GetSlotShard(int);
+	void LockAllShards();
+	void UnlockAllShards();
+	int FindEntry(nat_cache_shard *, uint32_t, const nat_table_entry *);
+	int AllocSlot(nat_cache_shard *);
+	int AllocEntry(nat_cache_shard *, uint32_t, const nat_table_entry *);
+	void FreeEntry(int);
+	int AddHwRule(int);
+	int DelHwRule(int);
+	uint32_t GetTimerTick();
+	uint32_t GetTimerDelay(const nat_table_entry *);
+	void LinkTimer(int, uint32_t);
+	void UnlinkTimer(int);
+	void ScheduleTimer(int);
+	void CancelTimer(int);
+	void WaitForTimers();
 	bool isAlgPort(uint8_t, uint16_t);
 	void Reset();
 	bool isPwrSaveIf(uint32_t);
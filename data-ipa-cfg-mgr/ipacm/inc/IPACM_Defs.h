@@ -187,6 +187,8 @@ typedef enum
 	IPA_HANDLE_WAN_DOWN_TETHER,               /* 57 ipacm_event_iface_up_tehter */
 	IPA_HANDLE_WAN_UP_V6_TETHER,		  /* 58 ipacm_event_iface_up_tehter */
 	IPA_HANDLE_WAN_DOWN_V6_TETHER,		  /* 59 ipacm_event_iface_up_tehter */
+	IPA_PROCESS_CT_MESSAGE_BATCH,             /* 60 ipacm_ct_evt_batch */
+	IPA_LAN_TO_LAN_POLICY_TIMER,              /* 61 NULL */
 	IPACM_EVENT_MAX
 } ipa_cm_event_id;
 
@@ -214,6 +216,15 @@ typedef struct
 	enum nf_conntrack_msg_type type;
 }ipacm_ct_evt_data;
 
+/* conntrack events drained from one socket wakeup, one entry per tuple */
+#define IPACM_CT_BATCH_MAX 64
+
+typedef struct
+{
+	int num_evts;
+	ipacm_ct_evt_data evts[IPACM_CT_BATCH_MAX];
+}ipacm_ct_evt_batch;
+
 typedef struct
 {
 	char iface_name[IPA_IFACE_NAME_LEN];
@@ -45,13 +45,18 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Defs.h"
 #include "IPACM_Listener.h"
 
-/* queue */
+/* Dispatch latency histogram, bucket n counts callbacks of [2^(n-1), 2^n) usecs */
+#define IPACM_EVT_LAT_BUCKETS 16
+
+/* Listeners registered for one event, in registration order. Entries
+	 deregistered while that event is being dispatched are left NULL and
+	 squeezed out once the dispatch is done */
 typedef struct _cmd_evts
 {
-	ipa_cm_event_id event;
-	IPACM_Listener *obj;
-	//int ipa_interface_index;
-	_cmd_evts *next;
+	IPACM_Listener **obj;
+	int num;
+	int size;
+	bool dirty;
 }  cmd_evts;
 
 
@@ -70,7 +75,10 @@ public:
 	static void ProcessEvt(ipacm_cmd_q_data *);
 
 private:
-	static cmd_evts *head;
+	static cmd_evts evts[IPACM_EVENT_MAX];
+	static int cur_evt;
+
+	static void compact(cmd_evts *list);
 };
 
 #endif /* IPACM_EvtDispatcher_H */
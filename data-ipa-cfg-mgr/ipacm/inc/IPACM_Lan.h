@@ -47,6 +47,9 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Iface.h"
 #include "IPACM_Routing.h"
 #include "IPACM_Filtering.h"
+#include "IPACM_RuleTxn.h"
+#include "IPACM_MacIndex.h"
+#include "IPACM_Stats.h"
 #include "IPACM_Config.h"
 #include "IPACM_Conntrack_NATApp.h"
 
@@ -154,7 +157,8 @@ public:
 	void event_callback(ipa_cm_event_id event,
 											void *data);
 
-	virtual int handle_wan_up(ipa_ip_type ip_type);
+	/* install the default WAN filter rule now, or queue it on txn if given */
+	virtual int handle_wan_up(ipa_ip_type ip_type, IPACM_RuleTxn *txn = NULL);
 
 	/* configure filter rule for wan_up event*/
 	virtual int handle_wan_up_ex(ipacm_ext_prop* ext_prop, ipa_ip_type iptype);
@@ -178,7 +182,9 @@ public:
 	/* install UL filter rule from Q6 */
 	virtual int handle_uplink_filter_rule(ipacm_ext_prop* prop, ipa_ip_type iptype);
 
-	int add_lan2lan_flt_rule(ipa_ip_type iptype, uint32_t src_v4_addr, uint32_t dst_v4_addr, uint32_t* src_v6_addr, uint32_t* dst_v6_addr, uint32_t* rule_hdl);
+	/* takes a lan2lan filter rule slot, the rule is committed now or
+		 queued on txn if given */
+	int add_lan2lan_flt_rule(ipa_ip_type iptype, uint32_t src_v4_addr, uint32_t dst_v4_addr, uint32_t* src_v6_addr, uint32_t* dst_v6_addr, uint32_t* rule_hdl, IPACM_RuleTxn *txn = NULL);
 
 	int del_lan2lan_flt_rule(ipa_ip_type iptype, uint32_t rule_hdl);
 
@@ -204,6 +210,7 @@ public:
 
 	static eth_bridge_subnet_client_info eth_bridge_wlan_client[IPA_LAN_TO_LAN_MAX_WLAN_CLIENT];
 	static eth_bridge_subnet_client_info eth_bridge_usb_client[IPA_LAN_TO_LAN_MAX_USB_CLIENT];
+	static IPACM_MacIndex eth_bridge_wlan_client_idx;
 
 	static int num_wlan_client;
 	static int num_usb_client;
@@ -215,6 +222,7 @@ protected:
 
 	eth_bridge_client_flt_info eth_bridge_wlan_client_flt_info[IPA_LAN_TO_LAN_MAX_WLAN_CLIENT];
 	int wlan_client_flt_info_count;
+	IPACM_MacIndex wlan_client_flt_info_idx;
 
 	eth_bridge_client_rt_info* eth_bridge_usb_client_rt_info_v4;
 	eth_bridge_client_rt_info* eth_bridge_usb_client_rt_info_v6;
@@ -273,7 +281,7 @@ protected:
 	/*handle lan2lan client active*/
 	int handle_lan2lan_client_active(ipacm_event_data_all *data, ipa_cm_event_id event);
 
-	int install_ipv6_prefix_flt_rule(uint32_t* prefix);
+	int install_ipv6_prefix_flt_rule(uint32_t* prefix, IPACM_RuleTxn *txn = NULL);
 
 	int install_ipv6_icmp_flt_rule();
 
@@ -282,6 +290,13 @@ protected:
 	/* handle tethering stats */
 	int handle_tethering_stats_event(ipa_get_data_stats_resp_msg_v01 *data);
 
+	/* HW pipes of tx/rx props, queried once for the stats handler */
+	int init_stats_pipe_mask();
+
+	uint32_t stats_ul_pipe_mask;
+	uint32_t stats_dl_pipe_mask;
+	bool stats_pipe_mask_valid;
+
 	/* handle tethering client */
 	int handle_tethering_client(bool reset, ipacm_client_enum ipa_client);
 
@@ -319,6 +334,9 @@ protected:
 
 private:
 
+	bool lan2lan_flt_rule_mdfy(ipa_ip_type iptype, struct ipa_flt_rule_mdfy *flt_rule,
+														 IPACM_RuleTxn *txn, IPACM_RuleTxn *own_txn);
+
 	/* dynamically allocate lan iface's unicast routing rule structure */
 
 	bool is_mode_switch; /* indicate mode switch, need post internal up event */
@@ -382,7 +400,8 @@ private:
 		return IPACM_INVALID_INDEX;
 	}
 
-	inline int delete_eth_rtrules(int clt_indx, ipa_ip_type iptype)
+	/* delete the client RT rules now, or queue them on txn if given */
+	inline int delete_eth_rtrules(int clt_indx, ipa_ip_type iptype, IPACM_RuleTxn *txn = NULL)
 	{
 		uint32_t tx_index;
 		uint32_t rt_hdl;
@@ -397,7 +416,8 @@ private:
 					IPACMDBG_H("Delete client index %d ipv4 RT-rules for tx:%d\n",clt_indx,tx_index);
 					rt_hdl = get_client_memptr(eth_client, clt_indx)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v4;
 
-					if(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v4) == false)
+					if((txn != NULL) ? (txn->DelRtRule(IPA_IP_v4, rt_hdl) == false) :
+							(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v4) == false))
 					{
 						return IPACM_FAILURE;
 					}
@@ -421,13 +441,15 @@ private:
 					{
 						IPACMDBG_H("Delete client index %d ipv6 RT-rules for %d-st ipv6 for tx:%d\n", clt_indx,num_v6,tx_index);
 						rt_hdl = get_client_memptr(eth_client, clt_indx)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6[num_v6];
-						if(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v6) == false)
+						if((txn != NULL) ? (txn->DelRtRule(IPA_IP_v6, rt_hdl) == false) :
+								(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v6) == false))
 							{
 								return IPACM_FAILURE;
 							}
 
 							rt_hdl = get_client_memptr(eth_client, clt_indx)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6_wan[num_v6];
-							if(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v6) == false)
+							if((txn != NULL) ? (txn->DelRtRule(IPA_IP_v6, rt_hdl) == false) :
+									(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v6) == false))
 							{
 								return IPACM_FAILURE;
 							}
@@ -38,6 +38,8 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define IPACM_LANTOLAN_H
 
 #include <stdint.h>
+#include <time.h>
+#include <pthread.h>
 #include "linux/msm_ipa.h"
 #include "IPACM_Iface.h"
 #include "IPACM_Defs.h"
@@ -50,12 +52,19 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <list>
 #endif /* ndefined(FEATURE_IPA_ANDROID)*/
 
+//a pair is offloaded once it has this many connections or its first
+//connection has lasted this long, so short flows don't churn the
+//MAX_OFFLOAD_PAIR rule slots
+#define LAN2LAN_OFFLOAD_MIN_CONN 2
+#define LAN2LAN_OFFLOAD_MIN_AGE 5	//seconds
+
 struct client_info;
 
 struct peer_info
 {
 	struct client_info* peer_pointer;
 	int num_connection;
+	time_t first_conn_time;
 };
 
 //used to store rule handles for offload link (one direction)
@@ -67,9 +76,44 @@ struct offload_link_info
 	uint32_t hdr_hdl;
 };
 
-typedef list<peer_info> peer_info_list;
-typedef list<offload_link_info> offload_link_info_list;
-typedef list<ipacm_event_connection> connection_list;
+//peers and offload links of a client are keyed by the peer's entry
+typedef unordered_map<client_info*, peer_info> peer_info_table;
+typedef unordered_map<client_info*, offload_link_info> offload_link_info_table;
+
+//cached connections are keyed by (src, dst) address pair
+struct cached_connection
+{
+	ipacm_event_connection conn;
+	int num_connection;
+};
+
+struct connection_key_v6
+{
+	uint32_t src_ipv6_addr[4];
+	uint32_t dst_ipv6_addr[4];
+
+	bool operator==(const connection_key_v6& other) const
+	{
+		return memcmp(this, &other, sizeof(connection_key_v6)) == 0;
+	}
+};
+
+struct connection_key_v6_hash
+{
+	size_t operator()(const connection_key_v6& key) const
+	{
+		uint32_t hash = 0;
+		for(int i = 0; i < 4; i++)
+		{
+			hash = hash * 31 + key.src_ipv6_addr[i];
+			hash = hash * 31 + key.dst_ipv6_addr[i];
+		}
+		return hash;
+	}
+};
+
+typedef unordered_map<uint64_t, cached_connection> connection_table_v4;
+typedef unordered_map<connection_key_v6, cached_connection, connection_key_v6_hash> connection_table_v6;
 
 struct client_info
 {
@@ -82,8 +126,8 @@ struct client_info
 	bool is_active;
 	bool is_powersave;
 	IPACM_Lan* p_iface;
-	peer_info_list peer;
-	offload_link_info_list link;
+	peer_info_table peer;
+	offload_link_info_table link;
 };
 
 struct v6_addr
@@ -115,8 +159,17 @@ private:
 		client_table_v4 client_info_v4_;
 		client_table_v6 client_info_v6_;
 
-		connection_list connection_v4_;
-		connection_list connection_v6_;
+		connection_table_v4 connection_v4_;
+		connection_table_v6 connection_v6_;
+		int num_cache_connection_v4_;
+		int num_cache_connection_v6_;
+
+		//pairs waiting on the offload policy, the policy thread posts
+		//IPA_LAN_TO_LAN_POLICY_TIMER while there are any
+		int num_pending_pair_;
+		pthread_mutex_t policy_lock_;
+		pthread_cond_t policy_cond_;
+		pthread_t policy_thread_;
 
 		static IPACM_LanToLan* p_instance;
 
@@ -128,6 +181,18 @@ private:
 
 		int add_offload_link(ipa_ip_type iptype, client_info* client, client_info* peer);
 
+		bool should_offload(peer_info* peer);
+
+		int add_offload_pair(ipa_ip_type iptype, client_info* client, client_info* peer);
+
+		void try_offload_pair(ipa_ip_type iptype, client_info* client, client_info* peer);
+
+		void set_pending_pair(int num);
+
+		void handle_policy_timer();
+
+		static void* policy_timer_thread(void* param);
+
 		void handle_client_inactive(ipacm_event_lan_client* data);
 
 		int turnoff_offload_links(ipa_ip_type iptype, client_info* client);
@@ -0,0 +1,94 @@
+/*
+Copyright (c) 2014, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_MacIndex.h
+
+	@brief
+	This file implements the MAC address keyed client index definitions
+
+	@Author
+
+*/
+#ifndef IPACM_MAC_INDEX_H
+#define IPACM_MAC_INDEX_H
+
+#include <stdint.h>
+#include "IPACM_Defs.h"
+
+/* Slots per index, power of 2 and at least twice the largest client
+	 table so probe chains stay short */
+#define IPACM_MAC_INDEX_SLOTS 64
+#define IPACM_MAC_INDEX_EMPTY (-1)
+
+#if (IPACM_MAC_INDEX_SLOTS < 2 * IPA_MAX_NUM_WIFI_CLIENTS) || \
+		(IPACM_MAC_INDEX_SLOTS < 2 * IPA_LAN_TO_LAN_MAX_WLAN_CLIENT)
+#error "IPACM_MAC_INDEX_SLOTS too small for the client tables"
+#endif
+
+typedef struct
+{
+	uint8_t mac[IPA_MAC_ADDR_SIZE];
+	int pos;
+} ipacm_mac_index_slot;
+
+/* Open addressing (linear probe) map from client MAC to its position in
+	 a client array. The owner of the array keeps it in sync: Insert() when
+	 a client is added or moved, Remove() when it is dropped */
+class IPACM_MacIndex
+{
+public:
+
+	IPACM_MacIndex();
+
+	/* position of mac or IPACM_INVALID_INDEX */
+	int Find(const uint8_t *mac);
+
+	/* add mac at pos, or update its position if already present */
+	bool Insert(const uint8_t *mac, int pos);
+
+	void Remove(const uint8_t *mac);
+
+	void Reset();
+
+	int GetCount()
+	{
+		return num;
+	}
+
+private:
+
+	ipacm_mac_index_slot slot[IPACM_MAC_INDEX_SLOTS];
+	int num;
+
+	int Hash(const uint8_t *mac);
+	int Lookup(const uint8_t *mac);
+};
+
+#endif /* IPACM_MAC_INDEX_H */
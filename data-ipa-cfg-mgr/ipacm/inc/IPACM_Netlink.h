@@ -60,6 +60,8 @@ extern "C"
 
 #define MAX_NUM_OF_FD 10
 #define IPA_NL_MSG_MAX_LEN (2048)
+/* Netlink datagrams read per recvmmsg() call */
+#define IPA_NL_RECV_BATCH (8)
 
 /*--------------------------------------------------------------------------- 
 	 Type representing enumeration of NetLink event indication messages
@@ -90,6 +92,21 @@ extern "C"
 #define IPA_RTA_PARAM_METRICS     (0x0100)
 
 
+/* Neighbor events coalescing, see ipa_nl_neigh_coalesce() */
+#define IPA_NL_NEIGH_CACHE_SIZE   (256)
+#define IPA_NL_NEIGH_HASH_SIZE    (64)
+#define IPA_NL_NEIGH_CANCEL_MS    (500)
+#define IPA_NL_NEIGH_DUP_MS       (1000)
+
+typedef struct
+{
+	uint32_t fwd_new;           /* RTM_NEWNEIGH forwarded as a real change */
+	uint32_t fwd_del;           /* RTM_DELNEIGH forwarded once the window expired */
+	uint32_t dup_suppressed;    /* refreshes of an unchanged neighbor dropped */
+	uint32_t cancel_suppressed; /* del/new pairs that cancelled out, counted per event */
+	uint32_t evicted;           /* least recently used entries dropped to make room */
+} ipa_nl_neigh_stats_t;
+
 /*--------------------------------------------------------------------------- 
 	 Type representing function callback registered with a socket listener 
 	 thread for reading from a socket on receipt of an incoming message
@@ -213,6 +230,9 @@ int ipa_nl_listener_init
 /*  Virtual function registered to receive incoming messages over the NETLINK routing socket*/
 int ipa_nl_recv_msg(int fd);
 
+/* Snapshot of the neighbor event coalescing counters */
+void ipa_nl_get_neigh_stats(ipa_nl_neigh_stats_t *stats);
+
 /* map mask value for ipv6 */
 int mask_v6(int index, uint32_t *mask);
 
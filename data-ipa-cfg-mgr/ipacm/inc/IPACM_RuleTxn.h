@@ -0,0 +1,168 @@
+/* 
+Copyright (c) 2014, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_RuleTxn.h
+
+	@brief
+	This file implements the IPACM filter/route/header rule transaction definitions
+
+	@Author
+
+*/
+#ifndef IPACM_RULE_TXN_H
+#define IPACM_RULE_TXN_H
+
+#include <stdint.h>
+#include <linux/msm_ipa.h>
+#include "IPACM_Defs.h"
+#include "IPACM_Filtering.h"
+#include "IPACM_Routing.h"
+#include "IPACM_Header.h"
+
+/* Max rules/handles in one add/del ioctl, the count fields are uint8_t */
+#define IPACM_TXN_MAX_RULES_PER_IOCTL 255
+
+typedef struct
+{
+	ipa_ip_type ip;
+	ipa_client_type ep;
+	uint8_t global;
+	struct ipa_flt_rule_add rule;
+	uint32_t *hdl;
+} ipacm_txn_flt_add;
+
+typedef struct
+{
+	ipa_ip_type ip;
+	char rt_tbl_name[IPA_RESOURCE_NAME_MAX];
+	struct ipa_rt_rule_add rule;
+	uint32_t *hdl;
+} ipacm_txn_rt_add;
+
+typedef struct
+{
+	ipa_ip_type ip;
+	struct ipa_flt_rule_mdfy rule;
+} ipacm_txn_flt_mdfy;
+
+typedef struct
+{
+	ipa_ip_type ip;
+	uint32_t hdl;
+	uint32_t *loc;
+} ipacm_txn_del;
+
+/* Order in which Commit() makes the queued updates visible to HW */
+typedef enum
+{
+	/* deletions first, then additions/modifications */
+	IPACM_TXN_BREAK_BEFORE_MAKE,
+	/* additions first, then modifications and deletions. If an addition
+		 fails the added rules are taken out again and nothing else is
+		 applied, for updates that replace rules which must never be
+		 missing from a table (firewall default rule) */
+	IPACM_TXN_MAKE_BEFORE_BREAK
+} ipacm_txn_order;
+
+/* Collects the filter, route and header updates of one event and pushes
+	 them to the driver with one ioctl per table/IP type and a single
+	 commit per IP type, instead of an ioctl + commit per rule.
+
+	 Handles of added rules are only valid after Commit(), they are written
+	 to the location passed to AddFltRule()/AddRtRule() (0 on failure).
+	 DelFltRuleHdl() clears the handle at the given location once the rule
+	 is gone from HW, so a caller can tell what a failed commit removed */
+class IPACM_RuleTxn
+{
+public:
+
+	IPACM_RuleTxn(IPACM_Filtering *flt, IPACM_Routing *rt, IPACM_Header *hdr);
+	~IPACM_RuleTxn();
+
+	bool AddFltRule(ipa_ip_type ip, ipa_client_type ep, bool global,
+									const struct ipa_flt_rule_add *rule, uint32_t *hdl);
+	bool ModifyFltRule(ipa_ip_type ip, const struct ipa_flt_rule_mdfy *rule);
+	bool DelFltRule(ipa_ip_type ip, uint32_t hdl);
+	bool DelFltRules(ipa_ip_type ip, const uint32_t *hdls, int num);
+	bool DelFltRuleHdl(ipa_ip_type ip, uint32_t *hdl);
+
+	bool AddRtRule(ipa_ip_type ip, const char *rt_tbl_name,
+								 const struct ipa_rt_rule_add *rule, uint32_t *hdl);
+	bool DelRtRule(ipa_ip_type ip, uint32_t hdl);
+
+	bool DelHdr(uint32_t hdl);
+
+	/* Issue everything queued in two phases, in the given order: deletes,
+		 committed to HW filter -> route -> header, and route adds, filter
+		 adds and modifies, committed header -> route -> filter. Returns false
+		 if any operation failed, the queue is emptied either way */
+	bool Commit(ipacm_txn_order order = IPACM_TXN_BREAK_BEFORE_MAKE);
+
+	/* Drop everything queued without touching HW */
+	void Abort();
+
+private:
+
+	IPACM_Filtering *m_flt;
+	IPACM_Routing *m_rt;
+	IPACM_Header *m_hdr;
+
+	ipacm_txn_flt_add *flt_add;
+	int num_flt_add, max_flt_add;
+	ipacm_txn_rt_add *rt_add;
+	int num_rt_add, max_rt_add;
+	ipacm_txn_flt_mdfy *flt_mdfy;
+	int num_flt_mdfy, max_flt_mdfy;
+	ipacm_txn_del *flt_del;
+	int num_flt_del, max_flt_del;
+	ipacm_txn_del *rt_del;
+	int num_rt_del, max_rt_del;
+	ipacm_txn_del *hdr_del;
+	int num_hdr_del, max_hdr_del;
+
+	/* IP types with pending filter/route changes, bit per ipa_ip_type */
+	uint32_t flt_dirty;
+	uint32_t rt_dirty;
+	bool hdr_dirty;
+
+	bool Grow(void **arr, int *max, int num, size_t size);
+	bool CommitFltDel();
+	bool CommitRtDel();
+	bool CommitHdrDel();
+	bool CommitRtAdd();
+	bool CommitFltAdd();
+	bool CommitFltMdfy();
+	bool CommitTables(bool deletion);
+	bool CommitDel();
+	bool CommitAdd();
+	bool RollbackAdd();
+};
+
+#endif /* IPACM_RULE_TXN_H */
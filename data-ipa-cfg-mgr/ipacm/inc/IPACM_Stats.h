@@ -0,0 +1,214 @@
+/*
+Copyright (c) 2014, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_Stats.h
+
+	@brief
+	This file implements the memory mapped tethering statistics region
+
+	@Author
+
+*/
+#ifndef IPACM_STATS_H
+#define IPACM_STATS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "IPACM_Defs.h"
+
+/* The region is a fixed layout file shared with the framework. ipacm is
+	 the only writer, readers map it read-only and use ipacm_stats_read()
+	 to take a consistent snapshot of one interface entry.
+
+	 The report handlers still fopen/fprintf the tether_stats and
+	 network_stats text files after updating the region, since the
+	 framework reads those. Until those readers move to the region the
+	 stats path is not yet allocation and syscall free; the text writes
+	 are meant to go away with them. */
+#define IPACM_STATS_FILE_NAME "/data/misc/ipa/ipacm_stats"
+#define IPACM_STATS_MAGIC 0x49505354 /* "IPST" */
+#define IPACM_STATS_VERSION 1
+#define IPACM_STATS_MAX_PIPE 32 /* HW pipe index, fits a uint32_t mask */
+#define IPACM_STATS_MAX_IFACE IPA_MAX_IFACE_ENTRIES /* indexed by ipa_if_num */
+#define IPACM_STATS_READ_RETRY 16
+
+typedef struct
+{
+	uint64_t ul_packets;
+	uint64_t ul_bytes;
+	uint64_t dl_packets;
+	uint64_t dl_bytes;
+} ipacm_stats_counter;
+
+typedef struct
+{
+	/* odd while the writer is updating the entry */
+	volatile uint32_t seq;
+	uint32_t valid;
+	char dev_name[IPA_IFACE_NAME_LEN];
+	char upstream_name[IPA_IFACE_NAME_LEN];
+	/* counters of the latest modem report */
+	ipacm_stats_counter last;
+	/* sum of all reports since the entry was claimed, kept across restarts */
+	ipacm_stats_counter total;
+	/* per HW pipe sums, tether entries only */
+	ipacm_stats_counter pipe[IPACM_STATS_MAX_PIPE];
+} ipacm_stats_iface;
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	uint32_t num_iface;
+	ipacm_stats_iface tether[IPACM_STATS_MAX_IFACE];
+	ipacm_stats_iface network[IPACM_STATS_MAX_IFACE];
+} ipacm_stats_region;
+
+class IPACM_Stats
+{
+public:
+
+	static IPACM_Stats* GetInstance();
+
+	/* entry of a tethered iface, reset if it was used by another device */
+	ipacm_stats_iface* GetTetherEntry(int ipa_if_num, const char *dev_name);
+
+	/* entry of a WAN iface (APN level stats) */
+	ipacm_stats_iface* GetNetworkEntry(int ipa_if_num, const char *dev_name);
+
+	static inline void BeginUpdate(ipacm_stats_iface *entry)
+	{
+		entry->seq++;
+		__sync_synchronize();
+	}
+
+	static inline void EndUpdate(ipacm_stats_iface *entry)
+	{
+		__sync_synchronize();
+		entry->seq++;
+	}
+
+	static inline void AddCounter(ipacm_stats_counter *to, const ipacm_stats_counter *from)
+	{
+		to->ul_packets += from->ul_packets;
+		to->ul_bytes += from->ul_bytes;
+		to->dl_packets += from->dl_packets;
+		to->dl_bytes += from->dl_bytes;
+	}
+
+private:
+
+	static IPACM_Stats *pInstance;
+
+	ipacm_stats_region *region;
+
+	/* scratch entry handed out when there is no slot to update */
+	ipacm_stats_iface dummy;
+
+	IPACM_Stats();
+
+	ipacm_stats_iface* ClaimEntry(ipacm_stats_iface *entry, const char *dev_name);
+
+	void ValidateEntry(ipacm_stats_iface *entry);
+};
+
+/* Reader side, usable without linking ipacm */
+
+/* map the region read-only, NULL if missing or of another layout */
+static inline const ipacm_stats_region* ipacm_stats_map(const char *path)
+{
+	int fd;
+	struct stat st;
+	void *addr;
+	const ipacm_stats_region *region;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return NULL;
+	}
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(ipacm_stats_region))
+	{
+		close(fd);
+		return NULL;
+	}
+	addr = mmap(NULL, sizeof(ipacm_stats_region), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	region = (const ipacm_stats_region *)addr;
+	if (region->magic != IPACM_STATS_MAGIC || region->version != IPACM_STATS_VERSION
+		|| region->size != sizeof(ipacm_stats_region))
+	{
+		munmap(addr, sizeof(ipacm_stats_region));
+		return NULL;
+	}
+	return region;
+}
+
+static inline void ipacm_stats_unmap(const ipacm_stats_region *region)
+{
+	munmap((void *)region, sizeof(ipacm_stats_region));
+}
+
+/* copy a consistent snapshot of entry to out, 0 on success, -1 if the
+	 writer kept it busy or it is not in use */
+static inline int ipacm_stats_read(const ipacm_stats_iface *entry, ipacm_stats_iface *out)
+{
+	uint32_t seq;
+	int i;
+
+	for (i = 0; i < IPACM_STATS_READ_RETRY; i++)
+	{
+		seq = entry->seq;
+		if (seq & 1)
+		{
+			continue;
+		}
+		__sync_synchronize();
+		memcpy(out, (const void *)entry, sizeof(ipacm_stats_iface));
+		__sync_synchronize();
+		if (entry->seq == seq)
+		{
+			return (out->valid != 0) ? 0 : -1;
+		}
+	}
+	return -1;
+}
+
+#endif /* IPACM_STATS_H */
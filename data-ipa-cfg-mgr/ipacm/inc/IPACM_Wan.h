@@ -174,6 +174,12 @@ private:
 	uint32_t firewall_hdl_v4[IPACM_MAX_FIREWALL_ENTRIES];
 	uint32_t firewall_hdl_v6[IPACM_MAX_FIREWALL_ENTRIES];
 	uint32_t dft_wan_fl_hdl[IPA_NUM_DEFAULT_WAN_FILTER_RULES];
+	/* rules behind firewall_hdl_v4/v6 and dft_wan_fl_hdl, for incremental firewall reload */
+	struct ipa_flt_rule firewall_rule_v4[IPACM_MAX_FIREWALL_ENTRIES];
+	struct ipa_flt_rule firewall_rule_v6[IPACM_MAX_FIREWALL_ENTRIES];
+	struct ipa_flt_rule dft_wan_fl_rule[IPA_NUM_DEFAULT_WAN_FILTER_RULES];
+	bool firewall_enable_v4, firewall_enable_v6;
+	bool firewall_accept_v4, firewall_accept_v6;
 	uint32_t ipv6_dest_flt_rule_hdl[MAX_DEFAULT_v6_ROUTE_RULES];
 	int num_ipv6_dest_flt_rule;
 	uint32_t ODU_fl_hdl[IPA_NUM_DEFAULT_WAN_FILTER_RULES];
@@ -332,6 +338,13 @@ private:
 
 	int config_dft_firewall_rules(ipa_ip_type iptype);
 
+	/* build the firewall filter rules of iptype from config, TCP_UDP entries expanded */
+	int build_firewall_rules(IPACM_firewall_conf_t *config, ipa_ip_type iptype,
+		struct ipa_flt_rule *rules, int max_rules);
+
+	/* apply a firewall config change as a delta against the installed rules */
+	int update_dft_firewall_rules(ipa_ip_type iptype);
+
 	/* configure the initial firewall filter rules */
 	int config_dft_embms_rules(ipa_ioc_add_flt_rule *pFilteringTable_v4, ipa_ioc_add_flt_rule *pFilteringTable_v6);
 
@@ -124,6 +124,12 @@ private:
 	eth_bridge_client_rt_info* eth_bridge_wlan_client_rt_from_wlan_info_v6;
 	int wlan_client_rt_from_wlan_info_count_v6;
 
+	/* MAC -> position in the eth bridge client rt info tables above */
+	IPACM_MacIndex wlan_client_rt_from_usb_info_idx_v4;
+	IPACM_MacIndex wlan_client_rt_from_usb_info_idx_v6;
+	IPACM_MacIndex wlan_client_rt_from_wlan_info_idx_v4;
+	IPACM_MacIndex wlan_client_rt_from_wlan_info_idx_v6;
+
 	virtual int eth_bridge_add_wlan_guest_ap_flt_rule(ipa_ip_type iptype);
 
 	int eth_bridge_install_wlan_guest_ap_ipv6_flt_rule();
@@ -150,6 +156,8 @@ private:
 
 	eth_bridge_client_rt_info* eth_bridge_get_client_rt_info_ptr(uint8_t index, eth_bridge_src_iface src, ipa_ip_type iptype);
 
+	IPACM_MacIndex* eth_bridge_get_client_rt_info_idx(eth_bridge_src_iface src, ipa_ip_type iptype);
+
 	void eth_bridge_add_wlan_client(uint8_t* mac, int if_num);
 
 	void eth_bridge_del_wlan_client(uint8_t* mac);
@@ -160,6 +168,8 @@ private:
 
 	int header_name_count;
 	int num_wifi_client;
+	/* MAC -> position in wlan_client, kept in sync on client add/del */
+	IPACM_MacIndex wlan_client_idx;
 
 	int wlan_ap_index;
 
@@ -179,32 +189,35 @@ private:
 	inline int get_wlan_client_index(uint8_t *mac_addr)
 	{
 		int cnt;
-		int num_wifi_client_tmp = num_wifi_client;
 
 		IPACMDBG_H("Passed MAC %02x:%02x:%02x:%02x:%02x:%02x\n",
 						 mac_addr[0], mac_addr[1], mac_addr[2],
 						 mac_addr[3], mac_addr[4], mac_addr[5]);
 
-		for(cnt = 0; cnt < num_wifi_client_tmp; cnt++)
+		cnt = wlan_client_idx.Find(mac_addr);
+		if(cnt != IPACM_INVALID_INDEX)
+		{
+			IPACMDBG_H("Matched client index: %d\n", cnt);
+		}
+		return cnt;
+	}
+
+	/* point the index at the first remaining entry of mac_addr, a station
+		 that re-associated without a del has more than one */
+	inline void reindex_wlan_client(uint8_t *mac_addr)
+	{
+		int cnt;
+
+		wlan_client_idx.Remove(mac_addr);
+		for(cnt = 0; cnt < num_wifi_client; cnt++)
 		{
-			IPACMDBG_H("stored MAC %02x:%02x:%02x:%02x:%02x:%02x\n",
-							 get_client_memptr(wlan_client, cnt)->mac[0],
-							 get_client_memptr(wlan_client, cnt)->mac[1],
-							 get_client_memptr(wlan_client, cnt)->mac[2],
-							 get_client_memptr(wlan_client, cnt)->mac[3],
-							 get_client_memptr(wlan_client, cnt)->mac[4],
-							 get_client_memptr(wlan_client, cnt)->mac[5]);
-
-			if(memcmp(get_client_memptr(wlan_client, cnt)->mac,
-								mac_addr,
-								sizeof(get_client_memptr(wlan_client, cnt)->mac)) == 0)
+			if(memcmp(get_client_memptr(wlan_client, cnt)->mac, mac_addr,
+								IPA_MAC_ADDR_SIZE) == 0)
 			{
-				IPACMDBG_H("Matched client index: %d\n", cnt);
-				return cnt;
+				wlan_client_idx.Insert(mac_addr, cnt);
+				break;
 			}
 		}
-
-		return IPACM_INVALID_INDEX;
 	}
 
 	inline int delete_default_qos_rtrules(int clt_indx, ipa_ip_type iptype)
@@ -45,6 +45,9 @@ LOCAL_SRC_FILES := IPACM_Main.cpp \
 		IPACM_Filtering.cpp \
 		IPACM_Routing.cpp \
 		IPACM_Header.cpp \
+		IPACM_RuleTxn.cpp \
+		IPACM_MacIndex.cpp \
+		IPACM_Stats.cpp \
 		IPACM_Lan.cpp \
 		IPACM_Iface.cpp \
 		IPACM_Wlan.cpp \
@@ -53,6 +56,7 @@ LOCAL_SRC_FILES := IPACM_Main.cpp \
 		IPACM_Neighbor.cpp \
 		IPACM_Netlink.cpp \
 		IPACM_Xml.cpp \
+		IPACM_CfgSnapshot.cpp \
 		IPACM_Conntrack_NATApp.cpp\
 		IPACM_ConntrackClient.cpp \
 		IPACM_ConntrackListener.cpp \
@@ -69,6 +73,118 @@ LOCAL_SHARED_LIBRARIES += libnetfilter_conntrack
 LOCAL_MODULE_PATH := $(TARGET_OUT_VENDOR_EXECUTABLES)
 include $(BUILD_EXECUTABLE)
 
+# NatApp connection cache and timer wheel benchmark. libipanat,
+# libnetfilter_conntrack and IPACM_Config are stubbed in the bench, so it
+# runs without IPA hardware.
+# It stays a target build: the ipacm headers need the IPA UAPI from the
+# generated kernel headers.
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../src
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../inc
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../../ipanat/inc
+ifeq ($(call is-platform-sdk-version-at-least,20),true)
+LOCAL_C_INCLUDES += external/icu/icu4c/source/common
+else
+LOCAL_C_INCLUDES += external/icu4c/common
+endif
+LOCAL_C_INCLUDES += external/libxml2/include
+LOCAL_C_INCLUDES += external/libnetfilter_conntrack/include
+LOCAL_C_INCLUDES += external/libnfnetlink/include
+
+LOCAL_HEADER_LIBRARIES := generated_kernel_headers
+
+LOCAL_CFLAGS := -DFEATURE_IPA_ANDROID
+LOCAL_CFLAGS += \
+    -Wno-format \
+    -Wno-sign-compare \
+    -Wno-unused-parameter \
+    -Wno-unused-variable \
+    -Wno-writable-strings
+
+ifeq ($(TARGET_ARCH),arm)
+LOCAL_CFLAGS += -include bionic/libc/kernel/arch-arm/asm/posix_types.h
+LOCAL_CFLAGS += -include bionic/libc/kernel/arch-arm/asm/byteorder.h
+endif
+
+LOCAL_SRC_FILES := IPACM_NatAppBench.cpp \
+		IPACM_Conntrack_NATApp.cpp
+
+LOCAL_MODULE := ipacm_natapp_bench
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_SHARED_LIBRARIES := libdl
+
+LOCAL_MODULE_PATH := $(TARGET_OUT_VENDOR_EXECUTABLES)
+include $(BUILD_EXECUTABLE)
+
+# XML configuration parse benchmark, a target build for the same reason
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../src
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../inc
+ifeq ($(call is-platform-sdk-version-at-least,20),true)
+LOCAL_C_INCLUDES += external/icu/icu4c/source/common
+else
+LOCAL_C_INCLUDES += external/icu4c/common
+endif
+LOCAL_C_INCLUDES += external/libxml2/include
+
+LOCAL_HEADER_LIBRARIES := generated_kernel_headers
+
+LOCAL_CFLAGS := -DFEATURE_IPA_ANDROID
+LOCAL_CFLAGS += \
+    -Wno-format \
+    -Wno-sign-compare \
+    -Wno-unused-parameter \
+    -Wno-unused-variable \
+    -Wno-writable-strings
+
+ifeq ($(TARGET_ARCH),arm)
+LOCAL_CFLAGS += -include bionic/libc/kernel/arch-arm/asm/posix_types.h
+LOCAL_CFLAGS += -include bionic/libc/kernel/arch-arm/asm/byteorder.h
+endif
+
+LOCAL_SRC_FILES := IPACM_XmlBench.cpp \
+		IPACM_Xml.cpp
+
+LOCAL_MODULE := ipacm_xml_bench
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_SHARED_LIBRARIES := libxml2
+
+LOCAL_MODULE_PATH := $(TARGET_OUT_VENDOR_EXECUTABLES)
+include $(BUILD_EXECUTABLE)
+
+# MAC index benchmark, a target build since IPACM_Defs.h needs the IPA UAPI
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../src
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../inc
+
+LOCAL_HEADER_LIBRARIES := generated_kernel_headers
+
+LOCAL_CFLAGS := -DFEATURE_IPA_ANDROID
+LOCAL_CFLAGS += \
+    -Wno-format \
+    -Wno-sign-compare \
+    -Wno-unused-parameter \
+    -Wno-unused-variable
+
+ifeq ($(TARGET_ARCH),arm)
+LOCAL_CFLAGS += -include bionic/libc/kernel/arch-arm/asm/posix_types.h
+LOCAL_CFLAGS += -include bionic/libc/kernel/arch-arm/asm/byteorder.h
+endif
+
+LOCAL_SRC_FILES := IPACM_MacIndexBench.cpp \
+		IPACM_MacIndex.cpp
+
+LOCAL_MODULE := ipacm_macindex_bench
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_MODULE_PATH := $(TARGET_OUT_VENDOR_EXECUTABLES)
+include $(BUILD_EXECUTABLE)
+
 include $(CLEAR_VARS)
 LOCAL_MODULE := IPACM_cfg.xml
 LOCAL_MODULE_CLASS := ETC
@@ -0,0 +1,262 @@
+/*
+Copyright (c) 2014, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_CfgSnapshot.cpp
+
+	@brief
+	This file implements the binary snapshots of the parsed XML configuration
+
+	@Author
+
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "IPACM_CfgSnapshot.h"
+#include "IPACM_Log.h"
+
+#define IPACM_SNAPSHOT_PATH_LEN (sizeof(IPACM_SNAPSHOT_DIR) + IPA_MAX_FILE_LEN + sizeof(IPACM_SNAPSHOT_SUFFIX))
+
+/* snapshot of /vendor/etc/IPACM_cfg.xml is /data/misc/ipa/IPACM_cfg.xml.snap */
+static void ipacm_snapshot_path(const char *xml_file, char *path, size_t len)
+{
+	const char *base;
+
+	base = strrchr(xml_file, '/');
+	base = (base == NULL) ? xml_file : base + 1;
+	snprintf(path, len, "%s%s%s", IPACM_SNAPSHOT_DIR, base, IPACM_SNAPSHOT_SUFFIX);
+}
+
+/* 64 bit FNV-1a of the XML content, 0 if it can't be read */
+static uint64_t ipacm_snapshot_hash(const char *xml_file, off_t size)
+{
+	int fd;
+	void *addr;
+	const uint8_t *p;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	off_t i;
+
+	if (size <= 0)
+	{
+		return 0;
+	}
+	fd = open(xml_file, O_RDONLY);
+	if (fd < 0)
+	{
+		return 0;
+	}
+	addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED)
+	{
+		return 0;
+	}
+
+	p = (const uint8_t *)addr;
+	for (i = 0; i < size; i++)
+	{
+		hash ^= p[i];
+		hash *= 0x100000001b3ULL;
+	}
+	munmap(addr, size);
+	return hash;
+}
+
+static void ipacm_snapshot_fill_hdr(ipacm_snapshot_hdr *hdr, const char *xml_file, const struct stat *st,
+	uint64_t hash, uint32_t kind, uint32_t conf_size)
+{
+	memset(hdr, 0, sizeof(ipacm_snapshot_hdr));
+	hdr->magic = IPACM_SNAPSHOT_MAGIC;
+	hdr->version = IPACM_SNAPSHOT_VERSION;
+	hdr->kind = kind;
+	hdr->conf_size = conf_size;
+	hdr->src_mtime_sec = st->st_mtim.tv_sec;
+	hdr->src_mtime_nsec = st->st_mtim.tv_nsec;
+	hdr->src_size = st->st_size;
+	hdr->src_hash = hash;
+	strncpy(hdr->src_path, xml_file, sizeof(hdr->src_path) - 1);
+}
+
+/* write the snapshot next to a temporary name and rename it in place so a
+	 reader never maps a partial file */
+static void ipacm_snapshot_store(const char *xml_file, const char *path, const struct stat *st,
+	uint64_t hash, uint32_t kind, const void *conf, uint32_t conf_size)
+{
+	char tmp_path[IPACM_SNAPSHOT_PATH_LEN + 4];
+	ipacm_snapshot_hdr hdr;
+	int fd;
+	bool ok;
+
+	if (hash == 0)
+	{
+		hash = ipacm_snapshot_hash(xml_file, st->st_size);
+	}
+	ipacm_snapshot_fill_hdr(&hdr, xml_file, st, hash, kind, conf_size);
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		IPACMERR("Failed opening %s, error is %d - %s\n", tmp_path, errno, strerror(errno));
+		return;
+	}
+	ok = (write(fd, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr))
+		&& (write(fd, conf, conf_size) == (ssize_t)conf_size);
+	close(fd);
+
+	if (!ok || rename(tmp_path, path) < 0)
+	{
+		IPACMERR("Failed to write config snapshot %s\n", path);
+		unlink(tmp_path);
+		return;
+	}
+	IPACMDBG_H("Stored config snapshot %s\n", path);
+}
+
+/* copy the snapshot of xml_file to conf if it is still current */
+static int ipacm_snapshot_load(const char *xml_file, const char *path, const struct stat *st,
+	uint32_t kind, void *conf, uint32_t conf_size)
+{
+	int fd;
+	size_t len;
+	void *addr;
+	struct stat snap_st;
+	ipacm_snapshot_hdr *hdr;
+	uint64_t hash;
+	int ret = IPACM_FAILURE;
+
+	len = sizeof(ipacm_snapshot_hdr) + conf_size;
+	fd = open(path, O_RDWR);
+	if (fd < 0)
+	{
+		IPACMDBG_H("No config snapshot %s\n", path);
+		return IPACM_FAILURE;
+	}
+	if (fstat(fd, &snap_st) < 0 || snap_st.st_size != (off_t)len)
+	{
+		IPACMDBG_H("Config snapshot %s has unexpected size\n", path);
+		close(fd);
+		return IPACM_FAILURE;
+	}
+	addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED)
+	{
+		return IPACM_FAILURE;
+	}
+
+	hdr = (ipacm_snapshot_hdr *)addr;
+	if (hdr->magic != IPACM_SNAPSHOT_MAGIC || hdr->version != IPACM_SNAPSHOT_VERSION
+		|| hdr->kind != kind || hdr->conf_size != conf_size
+		|| strncmp(hdr->src_path, xml_file, sizeof(hdr->src_path)) != 0)
+	{
+		IPACMDBG_H("Config snapshot %s is of another layout\n", path);
+		goto unmap;
+	}
+
+	if (hdr->src_mtime_sec != st->st_mtim.tv_sec || hdr->src_mtime_nsec != st->st_mtim.tv_nsec
+		|| hdr->src_size != st->st_size)
+	{
+		/* the file was touched, it may still carry the same content */
+		hash = ipacm_snapshot_hash(xml_file, st->st_size);
+		if (hash == 0 || hash != hdr->src_hash)
+		{
+			IPACMDBG_H("%s changed, config snapshot is stale\n", xml_file);
+			goto unmap;
+		}
+		ipacm_snapshot_fill_hdr(hdr, xml_file, st, hash, kind, conf_size);
+	}
+
+	memcpy(conf, (uint8_t *)addr + sizeof(ipacm_snapshot_hdr), conf_size);
+	ret = IPACM_SUCCESS;
+
+unmap:
+	munmap(addr, len);
+	return ret;
+}
+
+int ipacm_read_cfg_snapshot(char *xml_file, IPACM_conf_t *config)
+{
+	char path[IPACM_SNAPSHOT_PATH_LEN];
+	struct stat st;
+
+	if (stat(xml_file, &st) < 0)
+	{
+		IPACMERR("Failed to stat %s, error is %d - %s\n", xml_file, errno, strerror(errno));
+		return IPACM_FAILURE;
+	}
+
+	ipacm_snapshot_path(xml_file, path, sizeof(path));
+	if (ipacm_snapshot_load(xml_file, path, &st, IPACM_SNAPSHOT_KIND_CFG, config, sizeof(IPACM_conf_t)) == IPACM_SUCCESS)
+	{
+		IPACMDBG_H("Loaded %s from snapshot\n", xml_file);
+		return IPACM_SUCCESS;
+	}
+
+	if (ipacm_read_cfg_xml(xml_file, config) != IPACM_SUCCESS)
+	{
+		return IPACM_FAILURE;
+	}
+	ipacm_snapshot_store(xml_file, path, &st, 0, IPACM_SNAPSHOT_KIND_CFG, config, sizeof(IPACM_conf_t));
+	return IPACM_SUCCESS;
+}
+
+int IPACM_read_firewall_snapshot(char *xml_file, IPACM_firewall_conf_t *config)
+{
+	char path[IPACM_SNAPSHOT_PATH_LEN];
+	struct stat st;
+
+	IPACM_ASSERT(xml_file != NULL);
+	IPACM_ASSERT(config != NULL);
+
+	if (stat(xml_file, &st) < 0)
+	{
+		IPACMDBG_H("Failed to stat %s, error is %d - %s\n", xml_file, errno, strerror(errno));
+		return IPACM_FAILURE;
+	}
+
+	ipacm_snapshot_path(xml_file, path, sizeof(path));
+	if (ipacm_snapshot_load(xml_file, path, &st, IPACM_SNAPSHOT_KIND_FIREWALL, config, sizeof(IPACM_firewall_conf_t)) == IPACM_SUCCESS)
+	{
+		IPACMDBG_H("Loaded %s from snapshot\n", xml_file);
+		return IPACM_SUCCESS;
+	}
+
+	if (IPACM_read_firewall_xml(xml_file, config) != IPACM_SUCCESS)
+	{
+		return IPACM_FAILURE;
+	}
+	ipacm_snapshot_store(xml_file, path, &st, 0, IPACM_SNAPSHOT_KIND_FIREWALL, config, sizeof(IPACM_firewall_conf_t));
+	return IPACM_SUCCESS;
+}
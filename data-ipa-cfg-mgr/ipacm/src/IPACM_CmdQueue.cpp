@@ -38,71 +38,258 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 */
 #include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 #include "IPACM_CmdQueue.h"
 #include "IPACM_Log.h"
 
-pthread_mutex_t mutex    = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t  cond_var = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t inst_lock = PTHREAD_MUTEX_INITIALIZER;
 
 MessageQueue* MessageQueue::inst = NULL;
+
+static int futex_wait(uint32_t *addr, uint32_t val)
+{
+	return syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static int futex_wake(uint32_t *addr, int cnt)
+{
+	return syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, cnt, NULL, NULL, 0);
+}
+
+MessageQueue::MessageQueue()
+{
+	uint32_t cnt;
+
+	for(cnt = 0; cnt < IPACM_MSG_QUEUE_SLOTS; cnt++)
+	{
+		Slots[cnt].seq = cnt;
+	}
+	Head = 0;
+	Tail = 0;
+	wake_seq = 0;
+	waiting = 0;
+	full_cnt = 0;
+	space_seq = 0;
+	space_waiters = 0;
+	OvfHead = NULL;
+	OvfTail = NULL;
+	consumer_set = 0;
+}
+
 MessageQueue* MessageQueue::getInstance()
 {
+	MessageQueue *tmp;
+
+	tmp = __atomic_load_n(&inst, __ATOMIC_ACQUIRE);
+	if(tmp != NULL)
+	{
+		return tmp;
+	}
+
+	pthread_mutex_lock(&inst_lock);
 	if(inst == NULL)
 	{
-		inst = new MessageQueue();
-		if(inst == NULL)
+		tmp = new MessageQueue();
+		if(tmp == NULL)
 		{
 			IPACMERR("unable to create Message Queue instance\n");
+			pthread_mutex_unlock(&inst_lock);
 			return NULL;
 		}
+		__atomic_store_n(&inst, tmp, __ATOMIC_RELEASE);
 	}
+	pthread_mutex_unlock(&inst_lock);
 
 	return inst;
 }
 
-void MessageQueue::enqueue(Message *item)
+bool MessageQueue::isConsumer(void)
+{
+	return __atomic_load_n(&consumer_set, __ATOMIC_ACQUIRE) &&
+				 pthread_equal(consumer, pthread_self());
+}
+
+/* Consumer only, the Process thread never blocks on its own ring */
+void MessageQueue::enqueueOverflow(const cmd_t *evt)
 {
-	if(!Head)
+	Message *item;
+
+	item = new Message();
+	memcpy(&item->evt, evt, sizeof(item->evt));
+	if(OvfTail == NULL)
 	{
-		Tail = item;
-		Head = item;
+		OvfHead = item;
 	}
 	else
 	{
-		if(Tail == NULL)
+		OvfTail->next = item;
+	}
+	OvfTail = item;
+}
+
+/* Producers other than the consumer, sleeps until the slot at pos
+	 is handed back by dequeue() */
+void MessageQueue::waitSpace(uint32_t pos)
+{
+	Message *item;
+	uint32_t val;
+
+	val = __atomic_load_n(&space_seq, __ATOMIC_SEQ_CST);
+	__atomic_add_fetch(&space_waiters, 1, __ATOMIC_SEQ_CST);
+
+	/* Recheck after advertising, the consumer may have freed it already */
+	item = &Slots[pos & (IPACM_MSG_QUEUE_SLOTS - 1)];
+	if((int32_t)(__atomic_load_n(&item->seq, __ATOMIC_ACQUIRE) - pos) < 0)
+	{
+		if(futex_wait(&space_seq, val) != 0 && errno != EAGAIN && errno != EINTR)
 		{
-			IPACMDBG("Tail is null\n");
-			Head->setnext(item);
+			IPACMERR("futex wait failed: %d\n", errno);
+		}
+	}
+
+	__atomic_sub_fetch(&space_waiters, 1, __ATOMIC_SEQ_CST);
+}
+
+/* Called from any thread, copies the command into a free slot */
+int MessageQueue::enqueue(const cmd_t *evt)
+{
+	Message *item;
+	uint32_t pos, seq, full;
+	int32_t diff;
+
+	if(isConsumer() && OvfHead != NULL)
+	{
+		/* Keep the consumer's own posts in order behind its earlier overflow */
+		enqueueOverflow(evt);
+		return IPACM_SUCCESS;
+	}
+
+	pos = __atomic_load_n(&Tail, __ATOMIC_RELAXED);
+	while(1)
+	{
+		item = &Slots[pos & (IPACM_MSG_QUEUE_SLOTS - 1)];
+		seq = __atomic_load_n(&item->seq, __ATOMIC_ACQUIRE);
+		diff = (int32_t)(seq - pos);
+
+		if(diff == 0)
+		{
+			if(__atomic_compare_exchange_n(&Tail, &pos, pos + 1, true,
+																		 __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			{
+				break;
+			}
+			/* pos reloaded by the failed CAS */
+		}
+		else if(diff < 0)
+		{
+			full = __atomic_add_fetch(&full_cnt, 1, __ATOMIC_RELAXED);
+			if(isConsumer())
+			{
+				/* Handlers post from the Process thread, waiting here would
+					 never let the ring drain */
+				IPACMDBG("command queue full, event %d to overflow list\n", evt->data.event);
+				enqueueOverflow(evt);
+				return IPACM_SUCCESS;
+			}
+			/* Control events must not be lost, hold the poster until
+				 the consumer frees a slot */
+			IPACMDBG("command queue full, event %d waits for a slot (%u full so far)\n",
+							 evt->data.event, full);
+			waitSpace(pos);
+			pos = __atomic_load_n(&Tail, __ATOMIC_RELAXED);
 		}
 		else
 		{
-			Tail->setnext(item);
+			pos = __atomic_load_n(&Tail, __ATOMIC_RELAXED);
 		}
-		Tail = item;
 	}
-}
 
+	memcpy(&item->evt, evt, sizeof(item->evt));
+	__atomic_store_n(&item->seq, pos + 1, __ATOMIC_RELEASE);
 
-Message* MessageQueue::dequeue(void)
-{
-	if(Head == NULL)
+	/* Pairs with the fence in wait(), only pay for the syscall
+		 when the consumer is actually asleep */
+	__atomic_fetch_add(&wake_seq, 1, __ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&waiting, __ATOMIC_SEQ_CST))
 	{
-		return NULL;
+		futex_wake(&wake_seq, 1);
 	}
-	else
+
+	return IPACM_SUCCESS;
+}
+
+/* Consumer only */
+bool MessageQueue::dequeue(cmd_t *evt)
+{
+	Message *item;
+	uint32_t seq;
+
+	item = &Slots[Head & (IPACM_MSG_QUEUE_SLOTS - 1)];
+	seq = __atomic_load_n(&item->seq, __ATOMIC_ACQUIRE);
+	if(seq != Head + 1)
 	{
-		Message *tmp = Head;
-		Head = Head->getnext();
+		if(OvfHead == NULL)
+		{
+			return false;
+		}
+		item = OvfHead;
+		OvfHead = item->next;
+		if(OvfHead == NULL)
+		{
+			OvfTail = NULL;
+		}
+		memcpy(evt, &item->evt, sizeof(*evt));
+		delete item;
+		return true;
+	}
 
-		return tmp;
+	memcpy(evt, &item->evt, sizeof(*evt));
+	/* Hand the slot back to producers for the next lap */
+	__atomic_store_n(&item->seq, Head + IPACM_MSG_QUEUE_SLOTS, __ATOMIC_RELEASE);
+	Head++;
+
+	/* Pairs with the recheck in waitSpace() */
+	__atomic_fetch_add(&space_seq, 1, __ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&space_waiters, __ATOMIC_SEQ_CST))
+	{
+		futex_wake(&space_seq, INT_MAX);
 	}
+
+	return true;
 }
 
+/* Consumer only, sleeps until a producer posts */
+void MessageQueue::wait(void)
+{
+	uint32_t val;
+	Message *item;
+
+	val = __atomic_load_n(&wake_seq, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&waiting, 1, __ATOMIC_SEQ_CST);
+
+	/* Recheck after advertising, a post may have raced with us */
+	item = &Slots[Head & (IPACM_MSG_QUEUE_SLOTS - 1)];
+	if(__atomic_load_n(&item->seq, __ATOMIC_ACQUIRE) != Head + 1)
+	{
+		IPACMDBG("Waiting for Message\n");
+		if(futex_wait(&wake_seq, val) != 0 && errno != EAGAIN && errno != EINTR)
+		{
+			IPACMERR("futex wait failed: %d\n", errno);
+		}
+	}
+
+	__atomic_store_n(&waiting, 0, __ATOMIC_RELAXED);
+}
 
 void* MessageQueue::Process(void *param)
 {
 	MessageQueue *MsgQueue = NULL;
-	Message *item = NULL;
+	cmd_t evt;
+
 	IPACMDBG("MessageQueue::Process()\n");
 
 	MsgQueue = MessageQueue::getInstance();
@@ -112,54 +299,18 @@ void* MessageQueue::Process(void *param)
 		return NULL;
 	}
 
+	MsgQueue->consumer = pthread_self();
+	__atomic_store_n(&MsgQueue->consumer_set, 1, __ATOMIC_RELEASE);
+
 	while(1)
 	{
-		if(pthread_mutex_lock(&mutex) != 0)
-		{
-			IPACMERR("unable to lock the mutex\n");
-			return NULL;
-		}
-
-		item = MsgQueue->dequeue();
-
-		if(item == NULL)
-		{
-			IPACMDBG("Waiting for Message\n");
-
-			if(pthread_cond_wait(&cond_var, &mutex) != 0)
-			{
-				IPACMERR("unable to lock the mutex\n");
-
-				if(pthread_mutex_unlock(&mutex) != 0)
-				{
-					IPACMERR("unable to unlock the mutex\n");
-					return NULL;
-				}
-
-				return NULL;
-			}
-
-			if(pthread_mutex_unlock(&mutex) != 0)
-			{
-				IPACMERR("unable to unlock the mutex\n");
-				return NULL;
-			}
-
-		}
-		else
+		if(MsgQueue->dequeue(&evt) == false)
 		{
-			if(pthread_mutex_unlock(&mutex) != 0)
-			{
-				IPACMERR("unable to unlock the mutex\n");
-				return NULL;
-			}
-
-			IPACMDBG("Processing item %p event ID: %d\n",item,item->evt.data.event);
-			item->evt.callback_ptr(&item->evt.data);
-			delete item;
-			item = NULL;
+			MsgQueue->wait();
+			continue;
 		}
 
+		IPACMDBG("Processing event ID: %d\n", evt.data.event);
+		evt.callback_ptr(&evt.data);
 	} /* Go forever until a termination indication is received */
-
 }
@@ -40,6 +40,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <IPACM_Config.h>
 #include <IPACM_Log.h>
 #include <IPACM_Iface.h>
+#include <IPACM_CfgSnapshot.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
 
@@ -111,7 +112,7 @@ int IPACM_Config::Init(void)
 	strncpy(IPACM_config_file, "/vendor/etc/IPACM_cfg.xml", sizeof(IPACM_config_file));
 
 	IPACMDBG_H("\n IPACM XML file is %s \n", IPACM_config_file);
-	if (IPACM_SUCCESS == ipacm_read_cfg_xml(IPACM_config_file, cfg))
+	if (IPACM_SUCCESS == ipacm_read_cfg_snapshot(IPACM_config_file, cfg))
 	{
 		IPACMDBG_H("\n IPACM XML read OK \n");
 	}
@@ -34,6 +34,8 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/ioctl.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <net/if.h>
 #include "IPACM_Iface.h"
 #include "IPACM_ConntrackListener.h"
@@ -58,8 +60,19 @@ IPACM_ConntrackClient::IPACM_ConntrackClient()
 
 	tcp_hdl = NULL;
 	udp_hdl = NULL;
-	tcp_filter = NULL;
-	udp_filter = NULL;
+
+	memset(&tcp_batch, 0, sizeof(tcp_batch));
+	memset(&udp_batch, 0, sizeof(udp_batch));
+	tcp_batch.name = "tcp";
+	udp_batch.name = "udp";
+
+	pthread_mutex_init(&filter_lock, NULL);
+	num_ignore_ifaces = 0;
+	num_ignore_clnts = 0;
+	memset(ignore_ifaces, 0, sizeof(ignore_ifaces));
+	memset(ignore_clnts, 0, sizeof(ignore_clnts));
+	memset(alg_port_bits, 0, sizeof(alg_port_bits));
+	alg_port_gen = 0;
 }
 
 IPACM_ConntrackClient* IPACM_ConntrackClient::GetInstance()
@@ -67,24 +80,7 @@ IPACM_ConntrackClient* IPACM_ConntrackClient::GetInstance()
 	if(pInstance == NULL)
 	{
 		pInstance = new IPACM_ConntrackClient();
-
-		pInstance->udp_filter = nfct_filter_create();
-		if(pInstance->udp_filter == NULL)
-		{
-			IPACMERR("unable to create UDP filter\n");
-			delete pInstance;
-			return NULL;
-		}
-		IPACMDBG("Created UDP filter\n");
-
-		pInstance->tcp_filter = nfct_filter_create();
-		if(pInstance->tcp_filter == NULL)
-		{
-			IPACMERR("unable to create TCP filter\n");
-			delete pInstance;
-			return NULL;
-		}
-		IPACMDBG("Created TCP filter\n");
+		IPACMDBG("Created conntrack client\n");
 	}
 
 	return pInstance;
@@ -97,66 +93,336 @@ int IPACM_ConntrackClient::IPAConntrackEventCB
 	 void *data
 	 )
 {
+	uint8_t ip_type = 0;
+#ifdef CT_OPT
 	ipacm_cmd_q_data evt_data;
 	ipacm_ct_evt_data *ct_data;
-	uint8_t ip_type = 0;
+#endif
 
 	IPACMDBG("Event callback called with msgtype: %d\n",type);
 
 	/* Retrieve ip type */
 	ip_type = nfct_get_attr_u8(ct, ATTR_REPL_L3PROTO);
 
-#ifndef CT_OPT
 	if(AF_INET6 == ip_type)
 	{
+#ifndef CT_OPT
 		IPACMDBG("Ignoring ipv6(%d) connections\n", ip_type);
 		goto IGNORE;
-	}
+#else
+		ct_data = (ipacm_ct_evt_data *)malloc(sizeof(ipacm_ct_evt_data));
+		if(ct_data == NULL)
+		{
+			IPACMERR("unable to allocate memory \n");
+			goto IGNORE;
+		}
 
+		ct_data->ct = ct;
+		ct_data->type = type;
+
+		evt_data.event = IPA_PROCESS_CT_MESSAGE_V6;
+		evt_data.evt_data = (void *)ct_data;
+
+		if(0 != IPACM_EvtDispatcher::PostEvt(&evt_data))
+		{
+			IPACMERR("Error sending Conntrack message to processing thread!\n");
+			free(ct_data);
+			goto IGNORE;
+		}
+		return NFCT_CB_STOLEN;
 #endif
+	}
 
-	ct_data = (ipacm_ct_evt_data *)malloc(sizeof(ipacm_ct_evt_data));
-	if(ct_data == NULL)
+	if(data == NULL)
 	{
-		IPACMERR("unable to allocate memory \n");
+		IPACMERR("no batch for conntrack handle\n");
 		goto IGNORE;
 	}
 
-	ct_data->ct = ct;
-	ct_data->type = type;
+	/* ct is owned by the batch from here on */
+	BatchCTEvent((ipacm_ct_batch_ctx *)data, ct, type);
 
-	evt_data.event = IPA_PROCESS_CT_MESSAGE;
-	evt_data.evt_data = (void *)ct_data;
+/* NFCT_CB_STOLEN means that the conntrack object is not released after the
+	 callback That must be manually done later when the object is no longer needed. */
+	return NFCT_CB_STOLEN;
 
-#ifdef CT_OPT
-	if(AF_INET6 == ip_type)
+IGNORE:
+	nfct_destroy(ct);
+	return NFCT_CB_STOLEN;
+
+}
+
+/* Drop events ProcessTCPorUDPMsg() would ignore anyway, so they are
+	 neither queued nor allowed to supersede a useful event of the same
+	 connection in the batch */
+bool IPACM_ConntrackClient::IsCTEventUseful
+(
+	 ipacm_ct_batch_ctx *ctx,
+	 struct nf_conntrack *ct,
+	 enum nf_conntrack_msg_type type
+)
+{
+	uint8_t l4proto, tcp_state;
+	uint32_t status;
+
+	l4proto = nfct_get_attr_u8(ct, ATTR_ORIG_L4PROTO);
+	if(IPPROTO_TCP == l4proto)
 	{
-		evt_data.event = IPA_PROCESS_CT_MESSAGE_V6;
+		if(NFCT_T_DESTROY != type)
+		{
+			tcp_state = nfct_get_attr_u8(ct, ATTR_TCP_STATE);
+			if(TCP_CONNTRACK_ESTABLISHED != tcp_state &&
+				 TCP_CONNTRACK_FIN_WAIT != tcp_state)
+			{
+				return false;
+			}
+		}
+	}
+	else if(IPPROTO_UDP == l4proto)
+	{
+		if(NFCT_T_NEW != type && NFCT_T_DESTROY != type)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	/* NatApp never offloads a nat'ed connection using an ALG port; the
+		 original source and reply source ports are its private and
+		 target ports for both source and destination nat.
+		 nfct_filter has no port match, so these events still wake the
+		 thread; this only keeps them out of the batch */
+	status = nfct_get_attr_u32(ct, ATTR_STATUS);
+	if((status & (IPS_SRC_NAT | IPS_DST_NAT)) &&
+		 (IsAlgPort(ctx, l4proto, ntohs(nfct_get_attr_u16(ct, ATTR_ORIG_PORT_SRC))) ||
+			IsAlgPort(ctx, l4proto, ntohs(nfct_get_attr_u16(ct, ATTR_REPL_PORT_SRC)))))
+	{
+		return false;
 	}
-#endif
+
+	return true;
+}
+
+/* Queue one event on the batch; the last event seen for a tuple
+	 replaces any earlier one, since only the final state matters */
+int IPACM_ConntrackClient::BatchCTEvent
+(
+	 ipacm_ct_batch_ctx *ctx,
+	 struct nf_conntrack *ct,
+	 enum nf_conntrack_msg_type type
+)
+{
+	ipacm_ct_evt_batch *batch;
+	ipacm_ct_tuple key;
+	int cnt;
+
+	ctx->num_rcvd++;
+	if(!IsCTEventUseful(ctx, ct, type))
+	{
+		ctx->num_filtered++;
+		nfct_destroy(ct);
+		return 0;
+	}
+
+	if(ctx->batch == NULL)
+	{
+		ctx->batch = (ipacm_ct_evt_batch *)malloc(sizeof(ipacm_ct_evt_batch));
+		if(ctx->batch == NULL)
+		{
+			IPACMERR("unable to allocate memory \n");
+			nfct_destroy(ct);
+			return -1;
+		}
+		ctx->batch->num_evts = 0;
+	}
+	batch = ctx->batch;
+
+	memset(&key, 0, sizeof(key));
+	key.src_ip = nfct_get_attr_u32(ct, ATTR_ORIG_IPV4_SRC);
+	key.dst_ip = nfct_get_attr_u32(ct, ATTR_ORIG_IPV4_DST);
+	key.src_port = nfct_get_attr_u16(ct, ATTR_ORIG_PORT_SRC);
+	key.dst_port = nfct_get_attr_u16(ct, ATTR_ORIG_PORT_DST);
+	key.proto = nfct_get_attr_u8(ct, ATTR_ORIG_L4PROTO);
+
+	for(cnt = 0; cnt < batch->num_evts; cnt++)
+	{
+		if(memcmp(&ctx->keys[cnt], &key, sizeof(key)) == 0)
+		{
+			nfct_destroy(batch->evts[cnt].ct);
+			batch->evts[cnt].ct = ct;
+			batch->evts[cnt].type = type;
+			ctx->num_merged++;
+			return 0;
+		}
+	}
+
+	ctx->keys[batch->num_evts] = key;
+	batch->evts[batch->num_evts].ct = ct;
+	batch->evts[batch->num_evts].type = type;
+	batch->num_evts++;
+
+	if(batch->num_evts == IPACM_CT_BATCH_MAX)
+	{
+		FlushCTBatch(ctx);
+	}
+
+	return 0;
+}
+
+/* Hand the pending batch to the processing thread as one event */
+void IPACM_ConntrackClient::FlushCTBatch(ipacm_ct_batch_ctx *ctx)
+{
+	ipacm_cmd_q_data evt_data;
+	int cnt;
+
+	if(ctx->batch == NULL)
+	{
+		return;
+	}
+
+	if(ctx->batch->num_evts == 0)
+	{
+		free(ctx->batch);
+		ctx->batch = NULL;
+		return;
+	}
+
+	IPACMDBG("%s: posting %d events (total rcvd %d, merged %d, filtered %d)\n",
+					 ctx->name, ctx->batch->num_evts, ctx->num_rcvd,
+					 ctx->num_merged, ctx->num_filtered);
+
+	evt_data.event = IPA_PROCESS_CT_MESSAGE_BATCH;
+	evt_data.evt_data = (void *)ctx->batch;
 
 	if(0 != IPACM_EvtDispatcher::PostEvt(&evt_data))
 	{
-		IPACMERR("Error sending Conntrack message to processing thread!\n");
-		free(ct_data);
-		goto IGNORE;
+		IPACMERR("Error sending Conntrack batch to processing thread!\n");
+		for(cnt = 0; cnt < ctx->batch->num_evts; cnt++)
+		{
+			nfct_destroy(ctx->batch->evts[cnt].ct);
+		}
+		free(ctx->batch);
 	}
 
-/* NFCT_CB_STOLEN means that the conntrack object is not released after the
-	 callback That must be manually done later when the object is no longer needed. */
-	return NFCT_CB_STOLEN;
+	ctx->batch = NULL;
+	return;
+}
 
-IGNORE:
-	nfct_destroy(ct);
-	return NFCT_CB_STOLEN;
+/* Wait for the conntrack socket and drain every pending message on each
+	 wakeup, so a burst of events is posted as a single batch */
+int IPACM_ConntrackClient::CatchCTEvents
+(
+	 struct nfct_handle *hdl,
+	 ipacm_ct_batch_ctx *ctx
+)
+{
+	struct pollfd pfd;
+	int fd, flags, ret;
+
+	fd = nfct_fd(hdl);
+	flags = fcntl(fd, F_GETFL, 0);
+	if(flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+	{
+		PERROR("unable to set conntrack socket non-blocking");
+		return -1;
+	}
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+
+	while(1)
+	{
+		ret = poll(&pfd, 1, -1);
+		if(ret < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			PERROR("poll on conntrack socket failed");
+			return -1;
+		}
 
+		SyncAlgPorts(ctx);
+
+		/* on a non-blocking socket nfct_catch() returns -1 with
+			 EAGAIN once there is nothing left to read */
+		ret = nfct_catch(hdl);
+		if(ret == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+		{
+			IPACMERR("(%d)(%s)\n", ret, strerror(errno));
+			FlushCTBatch(ctx);
+			return -1;
+		}
+
+		FlushCTBatch(ctx);
+	}
+
+	return 0;
+}
+
+/* Append addr to an ignore list unless already present, caller holds filter_lock */
+static int ipacm_ct_add_ignore(uint32_t *list, int *num, int max, uint32_t addr)
+{
+	int cnt;
+
+	for(cnt = 0; cnt < *num; cnt++)
+	{
+		if(list[cnt] == addr)
+		{
+			return 0;
+		}
+	}
+
+	if(*num >= max)
+	{
+		IPACMERR("ignore list full(%d), can't add 0x%x\n", max, addr);
+		return -1;
+	}
+
+	list[(*num)++] = addr;
+	return 0;
 }
 
-int IPACM_ConntrackClient::IPA_Conntrack_Filters_Ignore_Bridge_Addrs
+/* Ignore entry of ifname, a free one if it has none yet or NULL when
+	 the table is full. Caller holds filter_lock */
+ipacm_ct_ignore_iface *IPACM_ConntrackClient::IPA_Conntrack_Get_Ignore_Iface
 (
-	 struct nfct_filter *filter
+	 const char *ifname
 )
 {
+	ipacm_ct_ignore_iface *entry;
+	int cnt;
+
+	for(cnt = 0; cnt < pInstance->num_ignore_ifaces; cnt++)
+	{
+		if(strncmp(pInstance->ignore_ifaces[cnt].ifname, ifname, IPA_IFACE_NAME_LEN) == 0)
+		{
+			return &pInstance->ignore_ifaces[cnt];
+		}
+	}
+
+	if(pInstance->num_ignore_ifaces >= IPACM_CT_MAX_IGNORE_IFACES)
+	{
+		IPACMERR("ignore list full(%d), can't add %s\n", IPACM_CT_MAX_IGNORE_IFACES, ifname);
+		return NULL;
+	}
+
+	entry = &pInstance->ignore_ifaces[pInstance->num_ignore_ifaces++];
+	memset(entry, 0, sizeof(*entry));
+	(void)strlcpy(entry->ifname, ifname, sizeof(entry->ifname));
+	return entry;
+}
+
+/* Remember the current bridge interface address, re-read on every
+	 local iface up so a changed bridge address replaces the old one.
+	 Caller holds filter_lock */
+int IPACM_ConntrackClient::IPA_Conntrack_Filters_Ignore_Bridge_Addrs(void)
+{
+	ipacm_ct_ignore_iface *entry;
 	int fd;
 	fd = socket(AF_INET, SOCK_DGRAM, 0);
 	if(fd < 0)
@@ -194,167 +460,276 @@ int IPACM_ConntrackClient::IPA_Conntrack_Filters_Ignore_Bridge_Addrs
 	ipv4_addr = ntohl(((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr.s_addr);
 	close(fd);
 
-	/* ignore whatever is destined to or originates from broadcast ip address */
-	struct nfct_filter_ipv4 filter_ipv4;
-
-	filter_ipv4.addr = ipv4_addr;
-	filter_ipv4.mask = 0xffffffff;
-
-	nfct_filter_set_logic(filter,
-												NFCT_FILTER_DST_IPV4,
-												NFCT_FILTER_LOGIC_NEGATIVE);
-
-	nfct_filter_add_attr(filter, NFCT_FILTER_DST_IPV4, &filter_ipv4);
-
-	nfct_filter_set_logic(filter,
-												NFCT_FILTER_SRC_IPV4,
-												NFCT_FILTER_LOGIC_NEGATIVE);
-
-	nfct_filter_add_attr(filter, NFCT_FILTER_SRC_IPV4, &filter_ipv4);
-
-  return 0;
+	entry = IPA_Conntrack_Get_Ignore_Iface(ifr.ifr_name);
+	if(entry == NULL)
+	{
+		return -1;
+	}
+	entry->if_index = if_nametoindex(ifr.ifr_name);
+	entry->addr = ipv4_addr;
+	entry->bcast_addr = 0;
+	return 0;
 }
 
+/* Remember a local interface address and its broadcast address,
+	 replacing what an earlier up event of the iface left behind.
+	 Caller holds filter_lock */
 int IPACM_ConntrackClient::IPA_Conntrack_Filters_Ignore_Local_Iface
 (
-	 struct nfct_filter *filter,
 	 ipacm_event_iface_up *param
 )
 {
-	struct nfct_filter_ipv4 filter_ipv4;
-
-	filter_ipv4.addr = param->ipv4_addr;
-	filter_ipv4.mask = 0xffffffff;
-
-	/* ignore whatever is destined to local interfaces */
-	IPACMDBG("Ignore connections destinated to interface %s", param->ifname);
-	iptodot("with ipv4 address", param->ipv4_addr);
-	nfct_filter_set_logic(filter,
-												NFCT_FILTER_DST_IPV4,
-												NFCT_FILTER_LOGIC_NEGATIVE);
-
-	nfct_filter_add_attr(filter, NFCT_FILTER_DST_IPV4, &filter_ipv4);
-
-	IPACMDBG("Ignore connections orignated from interface %s", param->ifname);
-	iptodot("with ipv4 address", filter_ipv4.addr);
-	nfct_filter_set_logic(filter,
-												NFCT_FILTER_SRC_IPV4,
-												NFCT_FILTER_LOGIC_NEGATIVE);
-
-	nfct_filter_add_attr(filter, NFCT_FILTER_SRC_IPV4, &filter_ipv4);
-
-	/* Retrieve broadcast address */
+	ipacm_ct_ignore_iface *entry;
 	/* Intialize with 255.255.255.255 */
 	uint32_t bc_ip_addr = 0xFFFFFFFF;
 
+	/* ignore whatever is destined to or orignated from local interfaces */
+	IPACMDBG("Ignore connections of interface %s", param->ifname);
+	iptodot("with ipv4 address", param->ipv4_addr);
+
 	/* calculate broadcast address from addr and addr_mask */
 	bc_ip_addr = (bc_ip_addr & (~param->addr_mask));
 	bc_ip_addr = (bc_ip_addr | (param->ipv4_addr & param->addr_mask));
+	iptodot("with broadcast address", bc_ip_addr);
 
-	/* netfitler expecting in host-byte order */
-	filter_ipv4.addr = bc_ip_addr;
-	filter_ipv4.mask = 0xffffffff;
-
-	iptodot("with broadcast address", filter_ipv4.addr);
-	nfct_filter_set_logic(filter,
-												NFCT_FILTER_DST_IPV4,
-												NFCT_FILTER_LOGIC_NEGATIVE);
-
-	nfct_filter_add_attr(filter, NFCT_FILTER_DST_IPV4, &filter_ipv4);
-
+	entry = IPA_Conntrack_Get_Ignore_Iface(param->ifname);
+	if(entry == NULL)
+	{
+		return -1;
+	}
+	entry->if_index = if_nametoindex(param->ifname);
+	entry->addr = param->ipv4_addr;
+	entry->bcast_addr = bc_ip_addr;
 	return 0;
 }
 
-/* Function which sets up filters to ignore
-		 connections to and from local interfaces */
-int IPACM_ConntrackClient::IPA_Conntrack_Filters_Ignore_Local_Addrs
+/* Drop connections from or to addr/mask, netfitler expects host-byte order */
+int IPACM_ConntrackClient::IPA_Conntrack_Filters_Ignore_Addr
 (
-	 struct nfct_filter *filter
+	 struct nfct_filter *filter,
+	 uint32_t addr,
+	 uint32_t mask
 )
 {
 	struct nfct_filter_ipv4 filter_ipv4;
 
-	/* ignore whatever is destined to or originates from broadcast ip address */
-	filter_ipv4.addr = 0xffffffff;
-	filter_ipv4.mask = 0xffffffff;
-
-	nfct_filter_set_logic(filter,
-												NFCT_FILTER_DST_IPV4,
-												NFCT_FILTER_LOGIC_NEGATIVE);
+	filter_ipv4.addr = addr;
+	filter_ipv4.mask = mask;
 
 	nfct_filter_add_attr(filter, NFCT_FILTER_DST_IPV4, &filter_ipv4);
-
-	nfct_filter_set_logic(filter,
-												NFCT_FILTER_SRC_IPV4,
-												NFCT_FILTER_LOGIC_NEGATIVE);
-
 	nfct_filter_add_attr(filter, NFCT_FILTER_SRC_IPV4, &filter_ipv4);
 
 	return 0;
-} /* IPA_Conntrack_Filters_Ignore_Local_Addrs() */
+}
 
-/* Initialize TCP Filter */
-int IPACM_ConntrackClient::IPA_Conntrack_TCP_Filter_Init(void)
+/* Compile the current ignore lists into a new filter. nfct_filter
+	 attributes can't be removed, so every change builds a fresh one.
+	 Caller holds filter_lock */
+struct nfct_filter *IPACM_ConntrackClient::IPA_Conntrack_Build_Filter(uint8_t l4proto)
 {
-	int ret = 0;
-	IPACM_ConntrackClient *pClient;
-
-	IPACMDBG("\n");
+	struct nfct_filter *filter;
+	struct nfct_filter_proto tcp_proto_state;
+	int cnt, ret;
 
-	pClient = IPACM_ConntrackClient::GetInstance();
-	if(pClient == NULL)
+	filter = nfct_filter_create();
+	if(filter == NULL)
 	{
-		IPACMERR("unable to get conntrack client instance\n");
-		return -1;
+		IPACMERR("unable to create filter for proto %d\n", l4proto);
+		return NULL;
 	}
 
-	ret = nfct_filter_set_logic(pClient->tcp_filter,
+	ret = nfct_filter_set_logic(filter,
 															NFCT_FILTER_L4PROTO,
 															NFCT_FILTER_LOGIC_POSITIVE);
 	if(ret == -1)
 	{
 		IPACMERR("Unable to set filter logic\n");
-		return -1;
+		goto fail;
 	}
+	nfct_filter_add_attr_u32(filter, NFCT_FILTER_L4PROTO, l4proto);
 
-	/* set protocol filters as tcp and udp */
-	nfct_filter_add_attr_u32(pClient->tcp_filter, NFCT_FILTER_L4PROTO, IPPROTO_TCP);
+	if(IPPROTO_TCP == l4proto)
+	{
+		ret = nfct_filter_set_logic(filter,
+																NFCT_FILTER_L4PROTO_STATE,
+																NFCT_FILTER_LOGIC_POSITIVE);
+		if(ret == -1)
+		{
+			IPACMERR("unable to set filter logic\n");
+			goto fail;
+		}
 
+		tcp_proto_state.proto = IPPROTO_TCP;
+		tcp_proto_state.state = TCP_CONNTRACK_ESTABLISHED;
+		nfct_filter_add_attr(filter, NFCT_FILTER_L4PROTO_STATE, &tcp_proto_state);
 
-	struct nfct_filter_proto tcp_proto_state;
-	tcp_proto_state.proto = IPPROTO_TCP;
-	tcp_proto_state.state = TCP_CONNTRACK_ESTABLISHED;
+		tcp_proto_state.state = TCP_CONNTRACK_FIN_WAIT;
+		nfct_filter_add_attr(filter, NFCT_FILTER_L4PROTO_STATE, &tcp_proto_state);
+	}
 
-	ret = nfct_filter_set_logic(pClient->tcp_filter,
-															NFCT_FILTER_L4PROTO_STATE,
-															NFCT_FILTER_LOGIC_POSITIVE);
-	if(ret == -1)
+	if(nfct_filter_set_logic(filter, NFCT_FILTER_DST_IPV4, NFCT_FILTER_LOGIC_NEGATIVE) == -1 ||
+		 nfct_filter_set_logic(filter, NFCT_FILTER_SRC_IPV4, NFCT_FILTER_LOGIC_NEGATIVE) == -1)
 	{
 		IPACMERR("unable to set filter logic\n");
-		return -1;
+		goto fail;
 	}
-	nfct_filter_add_attr(pClient->tcp_filter,
-											 NFCT_FILTER_L4PROTO_STATE,
-											 &tcp_proto_state);
 
+	/* loopback and limited broadcast are never offloaded */
+	IPA_Conntrack_Filters_Ignore_Addr(filter, IPACM_CT_LOOPBACK_NET, IPACM_CT_LOOPBACK_MASK);
+	IPA_Conntrack_Filters_Ignore_Addr(filter, 0xFFFFFFFF, 0xFFFFFFFF);
 
-	tcp_proto_state.proto = IPPROTO_TCP;
-	tcp_proto_state.state = TCP_CONNTRACK_FIN_WAIT;
-	ret = nfct_filter_set_logic(pClient->tcp_filter,
-															NFCT_FILTER_L4PROTO_STATE,
-															NFCT_FILTER_LOGIC_POSITIVE);
+	for(cnt = 0; cnt < pInstance->num_ignore_ifaces; cnt++)
+	{
+		IPA_Conntrack_Filters_Ignore_Addr(filter, pInstance->ignore_ifaces[cnt].addr, 0xFFFFFFFF);
+		if(pInstance->ignore_ifaces[cnt].bcast_addr != 0)
+		{
+			IPA_Conntrack_Filters_Ignore_Addr(filter, pInstance->ignore_ifaces[cnt].bcast_addr, 0xFFFFFFFF);
+		}
+	}
+
+#ifndef CT_OPT
+	/* clients behind non nat ifaces only ever get temp entries, lan2lan
+		 needs their connections so keep them with CT_OPT */
+	for(cnt = 0; cnt < pInstance->num_ignore_clnts; cnt++)
+	{
+		IPA_Conntrack_Filters_Ignore_Addr(filter, pInstance->ignore_clnts[cnt], 0xFFFFFFFF);
+	}
+#endif
+
+	IPACMDBG("Built proto %d filter ignoring %d ifaces, %d clients\n",
+					 l4proto, pInstance->num_ignore_ifaces, pInstance->num_ignore_clnts);
+	return filter;
+
+fail:
+	nfct_filter_destroy(filter);
+	return NULL;
+}
+
+/* Build and attach a filter for l4proto, caller holds filter_lock */
+int IPACM_ConntrackClient::IPA_Conntrack_Attach_Filter
+(
+	 struct nfct_handle *hdl,
+	 uint8_t l4proto
+)
+{
+	struct nfct_filter *filter;
+	int ret;
+
+	LoadAlgPorts();
+
+	filter = IPA_Conntrack_Build_Filter(l4proto);
+	if(filter == NULL)
+	{
+		return -1;
+	}
+
+	/* the kernel keeps its own copy, the filter object is not needed
+		 once attached */
+	ret = nfct_filter_attach(nfct_fd(hdl), filter);
+	nfct_filter_destroy(filter);
 	if(ret == -1)
 	{
-		IPACMERR("unable to set filter logic\n");
+		PERROR("unable to attach the filter\n");
+		IPACMERR("handle:%p, fd:%d proto:%d Error: %d\n", hdl, nfct_fd(hdl), l4proto, ret);
 		return -1;
 	}
 
-	nfct_filter_add_attr(pClient->tcp_filter,
-											 NFCT_FILTER_L4PROTO_STATE,
-											 &tcp_proto_state);
 	return 0;
 }
 
+/* Refresh the ALG port set used by IsCTEventUseful(), caller holds
+	 filter_lock. The conntrack threads pick it up through alg_port_gen */
+void IPACM_ConntrackClient::LoadAlgPorts(void)
+{
+	IPACM_Config *pConfig;
+	ipacm_alg *pAlgPorts;
+	int nPorts, cnt, idx;
+
+	memset(pInstance->alg_port_bits, 0, sizeof(pInstance->alg_port_bits));
+
+	pConfig = IPACM_Config::GetInstance();
+	if(pConfig == NULL)
+	{
+		IPACMERR("Unable to get Config instance\n");
+		goto publish;
+	}
+
+	nPorts = pConfig->GetAlgPortCnt();
+	if(nPorts <= 0)
+	{
+		goto publish;
+	}
+
+	pAlgPorts = (ipacm_alg *)malloc(sizeof(ipacm_alg) * nPorts);
+	if(pAlgPorts == NULL)
+	{
+		IPACMERR("Unable to allocate memory for alg prots\n");
+		goto publish;
+	}
+
+	if(pConfig->GetAlgPorts(nPorts, pAlgPorts) == 0)
+	{
+		for(cnt = 0; cnt < nPorts; cnt++)
+		{
+			idx = (pAlgPorts[cnt].protocol == IPPROTO_TCP) ? 0 : 1;
+			pInstance->alg_port_bits[idx][pAlgPorts[cnt].port >> 5] |=
+				(1U << (pAlgPorts[cnt].port & 31));
+		}
+	}
+
+	free(pAlgPorts);
+
+publish:
+	__atomic_add_fetch(&pInstance->alg_port_gen, 1, __ATOMIC_RELEASE);
+	return;
+}
+
+/* Copy the ALG port set into ctx if it was reloaded since the last
+	 copy. Called once per socket wakeup, the lock is only taken when
+	 the set actually changed */
+void IPACM_ConntrackClient::SyncAlgPorts(ipacm_ct_batch_ctx *ctx)
+{
+	if(__atomic_load_n(&pInstance->alg_port_gen, __ATOMIC_ACQUIRE) == ctx->alg_port_gen)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&pInstance->filter_lock);
+	memcpy(ctx->alg_port_bits, pInstance->alg_port_bits, sizeof(ctx->alg_port_bits));
+	ctx->alg_port_gen = pInstance->alg_port_gen;
+	pthread_mutex_unlock(&pInstance->filter_lock);
+	return;
+}
+
+bool IPACM_ConntrackClient::IsAlgPort(ipacm_ct_batch_ctx *ctx, uint8_t proto, uint16_t port)
+{
+	int idx = (proto == IPPROTO_TCP) ? 0 : 1;
+
+	return (ctx->alg_port_bits[idx][port >> 5] & (1U << (port & 31))) != 0;
+}
+
+/* Initialize TCP Filter */
+int IPACM_ConntrackClient::IPA_Conntrack_TCP_Filter_Init(void)
+{
+	int ret = 0;
+	IPACM_ConntrackClient *pClient;
+
+	IPACMDBG("\n");
+
+	pClient = IPACM_ConntrackClient::GetInstance();
+	if(pClient == NULL)
+	{
+		IPACMERR("unable to get conntrack client instance\n");
+		return -1;
+	}
+
+	pthread_mutex_lock(&pClient->filter_lock);
+	ret = IPA_Conntrack_Attach_Filter(pClient->tcp_hdl, IPPROTO_TCP);
+	pthread_mutex_unlock(&pClient->filter_lock);
+
+	return ret;
+}
+
 
 /* Initialize UDP Filter */
 int IPACM_ConntrackClient::IPA_Conntrack_UDP_Filter_Init(void)
@@ -367,17 +742,11 @@ int IPACM_ConntrackClient::IPA_Conntrack_UDP_Filter_Init(void)
 		return -1;
 	}
 
-	ret = nfct_filter_set_logic(pClient->udp_filter,
-															NFCT_FILTER_L4PROTO,
-															NFCT_FILTER_LOGIC_POSITIVE);
-	if(ret == -1)
-	{
-		IPACMERR("unable to set filter logic\n");
-	}
-	/* set protocol filters as tcp and udp */
-	nfct_filter_add_attr_u32(pClient->udp_filter, NFCT_FILTER_L4PROTO, IPPROTO_UDP);
+	pthread_mutex_lock(&pClient->filter_lock);
+	ret = IPA_Conntrack_Attach_Filter(pClient->udp_hdl, IPPROTO_UDP);
+	pthread_mutex_unlock(&pClient->filter_lock);
 
-	return 0;
+	return ret;
 }
 
 void* IPACM_ConntrackClient::UDPConnTimeoutUpdate(void *ptr)
@@ -395,10 +764,10 @@ void* IPACM_ConntrackClient::UDPConnTimeoutUpdate(void *ptr)
 		return NULL;
 	}
 
+	/* UpdateUDPTimeStamp() sleeps until the next entry is due */
 	while(1)
 	{
 		nat_inst->UpdateUDPTimeStamp();
-		sleep(UDP_TIMEOUT_UPDATE);
 	} /* end of while(1) loop */
 
 #ifdef IPACM_DEBUG
@@ -436,7 +805,7 @@ void* IPACM_ConntrackClient::TCPRegisterWithConnTrack(void *)
 		return NULL;
 	}
 
-	/* Initialize the filter */
+	/* Build and attach the filter to net filter handler */
 	ret = IPA_Conntrack_TCP_Filter_Init();
 	if(ret == -1)
 	{
@@ -444,42 +813,28 @@ void* IPACM_ConntrackClient::TCPRegisterWithConnTrack(void *)
 		return NULL;
 	}
 
-	/* Attach the filter to net filter handler */
-	ret = nfct_filter_attach(nfct_fd(pClient->tcp_hdl), pClient->tcp_filter);
-	if(ret == -1)
-	{
-		IPACMDBG("unable to attach TCP filter\n");
-		return NULL;
-	}
-
 	/* Register callback with netfilter handler */
 	IPACMDBG("tcp handle:%p, fd:%d\n", pClient->tcp_hdl, nfct_fd(pClient->tcp_hdl));
 #ifndef CT_OPT
 	nfct_callback_register(pClient->tcp_hdl,
 			(nf_conntrack_msg_type)	(NFCT_T_UPDATE | NFCT_T_DESTROY | NFCT_T_NEW),
-						IPAConntrackEventCB, NULL);
+						IPAConntrackEventCB, &pClient->tcp_batch);
 #else
-	nfct_callback_register(pClient->tcp_hdl, (nf_conntrack_msg_type) NFCT_T_ALL, IPAConntrackEventCB, NULL);
+	nfct_callback_register(pClient->tcp_hdl, (nf_conntrack_msg_type) NFCT_T_ALL,
+						IPAConntrackEventCB, &pClient->tcp_batch);
 #endif
 
 	/* Block to catch events from net filter connection track */
-	/* nfct_catch() receives conntrack events from kernel-space, by default it
-			 blocks waiting for events. */
 	IPACMDBG("Waiting for events\n");
 
-	ret = nfct_catch(pClient->tcp_hdl);
+	ret = CatchCTEvents(pClient->tcp_hdl, &pClient->tcp_batch);
 	if(ret == -1)
 	{
-		IPACMERR("(%d)(%s)\n", ret, strerror(errno));
 		return NULL;
 	}
 
 	IPACMDBG("Exit from tcp thread\n");
 
-	/* destroy the filter.. this will not detach the filter */
-	nfct_filter_destroy(pClient->tcp_filter);
-	pClient->tcp_filter = NULL;
-
 	/* de-register the callback */
 	nfct_callback_unregister(pClient->tcp_hdl);
 	/* close the handle */
@@ -513,7 +868,7 @@ void* IPACM_ConntrackClient::UDPRegisterWithConnTrack(void *)
 		return NULL;
 	}
 
-	/* Initialize Filter */
+	/* Build and attach the filter to net filter handler */
 	ret = IPA_Conntrack_UDP_Filter_Init();
 	if(-1 == ret)
 	{
@@ -521,41 +876,22 @@ void* IPACM_ConntrackClient::UDPRegisterWithConnTrack(void *)
 		return NULL;
 	}
 
-	/* Attach the filter to net filter handler */
-	ret = nfct_filter_attach(nfct_fd(pClient->udp_hdl), pClient->udp_filter);
-	if(ret == -1)
-	{
-		IPACMDBG("unable to attach the filter\n");
-		return NULL;
-	}
-
 	/* Register callback with netfilter handler */
 	IPACMDBG("udp handle:%p, fd:%d\n", pClient->udp_hdl, nfct_fd(pClient->udp_hdl));
 	nfct_callback_register(pClient->udp_hdl,
 												 (nf_conntrack_msg_type)(NFCT_T_NEW | NFCT_T_DESTROY),
 												 IPAConntrackEventCB,
-												 NULL);
+												 &pClient->udp_batch);
 
 	/* Block to catch events from net filter connection track */
-ctcatch:
-	ret = nfct_catch(pClient->udp_hdl);
+	ret = CatchCTEvents(pClient->udp_hdl, &pClient->udp_batch);
 	if(ret == -1)
 	{
-		IPACMDBG("(%d)(%s)\n", ret, strerror(errno));
 		return NULL;
 	}
-	else
-	{
-		IPACMDBG("ctcatch ret:%d\n", ret);
-		goto ctcatch;
-	}
 
 	IPACMDBG("Exit from udp thread with ret: %d\n", ret);
 
-	/* destroy the filter.. this will not detach the filter */
-	nfct_filter_destroy(pClient->udp_filter);
-	pClient->udp_filter = NULL;
-
 	/* de-register the callback */
 	nfct_callback_unregister(pClient->udp_hdl);
 	/* close the handle */
@@ -568,8 +904,6 @@ ctcatch:
 
 void IPACM_ConntrackClient::UpdateUDPFilters(void *param, bool isWan)
 {
-	static bool isIgnore = false;
-	int ret = 0;
 	IPACM_ConntrackClient *pClient = NULL;
 
 	pClient = IPACM_ConntrackClient::GetInstance();
@@ -579,44 +913,26 @@ void IPACM_ConntrackClient::UpdateUDPFilters(void *param, bool isWan)
 		return;
 	}
 
-	if(pClient->udp_filter == NULL)
-	{
-		 return;
-	}
-
+	pthread_mutex_lock(&pClient->filter_lock);
 	if(!isWan)
 	{
-		IPA_Conntrack_Filters_Ignore_Local_Iface(pClient->udp_filter,
-																		 (ipacm_event_iface_up *)param);
-
-		if(!isIgnore)
-		{
-			IPA_Conntrack_Filters_Ignore_Bridge_Addrs(pClient->udp_filter);
-			IPA_Conntrack_Filters_Ignore_Local_Addrs(pClient->udp_filter);
-			isIgnore = true;
-		}
+		IPA_Conntrack_Filters_Ignore_Local_Iface((ipacm_event_iface_up *)param);
+		IPA_Conntrack_Filters_Ignore_Bridge_Addrs();
 	}
 
 	/* Attach the filter to udp handle */
 	if(pClient->udp_hdl != NULL)
 	{
 		IPACMDBG("attaching the filter to udp handle\n");
-		ret = nfct_filter_attach(nfct_fd(pClient->udp_hdl), pClient->udp_filter);
-		if(ret == -1)
-		{
-			PERROR("unable to attach the filter to udp handle\n");
-			IPACMERR("udp handle:%p, fd:%d Error: %d\n",pClient->udp_hdl, nfct_fd(pClient->udp_hdl), ret);
-			return;
-		}
+		IPA_Conntrack_Attach_Filter(pClient->udp_hdl, IPPROTO_UDP);
 	}
+	pthread_mutex_unlock(&pClient->filter_lock);
 
 	return;
 }
 
 void IPACM_ConntrackClient::UpdateTCPFilters(void *param, bool isWan)
 {
-	static bool isIgnore = false;
-	int ret = 0;
 	IPACM_ConntrackClient *pClient = NULL;
 
 	pClient = IPACM_ConntrackClient::GetInstance();
@@ -626,36 +942,125 @@ void IPACM_ConntrackClient::UpdateTCPFilters(void *param, bool isWan)
 		return;
 	}
 
-	if(pClient->tcp_filter == NULL)
+	pthread_mutex_lock(&pClient->filter_lock);
+	if(!isWan)
+	{
+		IPA_Conntrack_Filters_Ignore_Local_Iface((ipacm_event_iface_up *)param);
+		IPA_Conntrack_Filters_Ignore_Bridge_Addrs();
+	}
+
+	/* Attach the filter to tcp handle */
+	if(pClient->tcp_hdl != NULL)
+	{
+		IPACMDBG("attaching the filter to tcp handle\n");
+		IPA_Conntrack_Attach_Filter(pClient->tcp_hdl, IPPROTO_TCP);
+	}
+	pthread_mutex_unlock(&pClient->filter_lock);
+
+  return;
+}
+
+/* Add or remove a client of a non nat iface from the kernel filters */
+void IPACM_ConntrackClient::UpdateNonNatClient(uint32_t ip_addr, bool isAdd)
+{
+	IPACM_ConntrackClient *pClient = NULL;
+	int cnt;
+
+	pClient = IPACM_ConntrackClient::GetInstance();
+	if(pClient == NULL)
+	{
+		IPACMERR("unable to retrieve conntrack client instance\n");
 		return;
+	}
 
-	if(!isWan)
+	pthread_mutex_lock(&pClient->filter_lock);
+	if(isAdd)
 	{
-		IPA_Conntrack_Filters_Ignore_Local_Iface(pClient->tcp_filter,
-																	(ipacm_event_iface_up *)param);
+		if(ipacm_ct_add_ignore(pClient->ignore_clnts, &pClient->num_ignore_clnts,
+													 IPACM_CT_MAX_IGNORE_CLNTS, ip_addr) != 0)
+		{
+			goto unlock;
+		}
+	}
+	else
+	{
+		for(cnt = 0; cnt < pClient->num_ignore_clnts; cnt++)
+		{
+			if(pClient->ignore_clnts[cnt] == ip_addr)
+			{
+				break;
+			}
+		}
 
-		if(!isIgnore)
+		if(cnt == pClient->num_ignore_clnts)
 		{
-			IPA_Conntrack_Filters_Ignore_Bridge_Addrs(pClient->udp_filter);
-			IPA_Conntrack_Filters_Ignore_Local_Addrs(pClient->udp_filter);
-			isIgnore = true;
+			goto unlock;
 		}
+
+		pClient->num_ignore_clnts--;
+		pClient->ignore_clnts[cnt] = pClient->ignore_clnts[pClient->num_ignore_clnts];
 	}
 
-	/* Attach the filter to tcp handle */
 	if(pClient->tcp_hdl != NULL)
 	{
-		IPACMDBG("attaching the filter to tcp handle\n");
-		ret = nfct_filter_attach(nfct_fd(pClient->tcp_hdl), pClient->tcp_filter);
-		if(ret == -1)
+		IPA_Conntrack_Attach_Filter(pClient->tcp_hdl, IPPROTO_TCP);
+	}
+
+	if(pClient->udp_hdl != NULL)
+	{
+		IPA_Conntrack_Attach_Filter(pClient->udp_hdl, IPPROTO_UDP);
+	}
+
+unlock:
+	pthread_mutex_unlock(&pClient->filter_lock);
+	return;
+}
+
+/* Forget the addresses of a local iface that went down and drop them
+	 from both kernel filters */
+void IPACM_ConntrackClient::RemoveLocalIface(int if_index)
+{
+	IPACM_ConntrackClient *pClient = NULL;
+	bool removed = false;
+	int cnt;
+
+	pClient = IPACM_ConntrackClient::GetInstance();
+	if(pClient == NULL)
+	{
+		IPACMERR("unable to retrieve conntrack client instance\n");
+		return;
+	}
+
+	pthread_mutex_lock(&pClient->filter_lock);
+	for(cnt = 0; cnt < pClient->num_ignore_ifaces; )
+	{
+		if(pClient->ignore_ifaces[cnt].if_index != if_index)
 		{
-			PERROR("unable to attach the filter to tcp handle\n");
-			IPACMERR("tcp handle:%p, fd:%d Error: %d\n",pClient->tcp_hdl, nfct_fd(pClient->tcp_hdl), ret);
-			return;
+			cnt++;
+			continue;
 		}
+
+		IPACMDBG("Stop ignoring connections of interface %s\n",
+						 pClient->ignore_ifaces[cnt].ifname);
+		pClient->num_ignore_ifaces--;
+		pClient->ignore_ifaces[cnt] = pClient->ignore_ifaces[pClient->num_ignore_ifaces];
+		removed = true;
 	}
 
-  return;
+	if(removed)
+	{
+		if(pClient->tcp_hdl != NULL)
+		{
+			IPA_Conntrack_Attach_Filter(pClient->tcp_hdl, IPPROTO_TCP);
+		}
+
+		if(pClient->udp_hdl != NULL)
+		{
+			IPA_Conntrack_Attach_Filter(pClient->udp_hdl, IPPROTO_UDP);
+		}
+	}
+	pthread_mutex_unlock(&pClient->filter_lock);
+	return;
 }
 
 void IPACM_ConntrackClient::Read_TcpUdp_Timeout(char *in, int len)
@@ -49,6 +49,7 @@ IPACM_ConntrackListener::IPACM_ConntrackListener()
 	 pConfig = NULL;
 
 	 memset(nat_iface_ipv4_addr, 0, sizeof(nat_iface_ipv4_addr));
+	 memset(nat_iface_bits, 0, sizeof(nat_iface_bits));
 	 memset(nonnat_iface_ipv4_addr, 0, sizeof(nonnat_iface_ipv4_addr));
 	 memset(sta_clnt_ipv4_addr, 0, sizeof(sta_clnt_ipv4_addr));
 
@@ -56,8 +57,10 @@ IPACM_ConntrackListener::IPACM_ConntrackListener()
 	 IPACM_EvtDispatcher::registr(IPA_HANDLE_WAN_DOWN, this);
 	 IPACM_EvtDispatcher::registr(IPA_PROCESS_CT_MESSAGE, this);
 	 IPACM_EvtDispatcher::registr(IPA_PROCESS_CT_MESSAGE_V6, this);
+	 IPACM_EvtDispatcher::registr(IPA_PROCESS_CT_MESSAGE_BATCH, this);
 	 IPACM_EvtDispatcher::registr(IPA_HANDLE_WLAN_UP, this);
 	 IPACM_EvtDispatcher::registr(IPA_HANDLE_LAN_UP, this);
+	 IPACM_EvtDispatcher::registr(IPA_LINK_DOWN_EVENT, this);
 
 #ifdef CT_OPT
 	 p_lan2lan = IPACM_LanToLan::getLan2LanInstance();
@@ -82,6 +85,11 @@ void IPACM_ConntrackListener::event_callback(ipa_cm_event_id evt,
 			ProcessCTMessage(data);
 			break;
 
+	 case IPA_PROCESS_CT_MESSAGE_BATCH:
+			IPACMDBG("Received IPA_PROCESS_CT_MESSAGE_BATCH event\n");
+			ProcessCTBatch(data);
+			break;
+
 #ifdef CT_OPT
 	 case IPA_PROCESS_CT_MESSAGE_V6:
 			IPACMDBG("Received IPA_PROCESS_CT_MESSAGE_V6 event\n");
@@ -119,6 +127,13 @@ void IPACM_ConntrackListener::event_callback(ipa_cm_event_id evt,
 			IPACM_ConntrackClient::UpdateTCPFilters(data, false);
 			break;
 
+	/* stop ignoring the addresses of a local iface once it is gone */
+	 case IPA_LINK_DOWN_EVENT:
+			IPACMDBG("Received IPA_LINK_DOWN_EVENT with if index: %d\n",
+							 ((ipacm_event_data_fid *)data)->if_index);
+			IPACM_ConntrackClient::RemoveLocalIface(((ipacm_event_data_fid *)data)->if_index);
+			break;
+
 	 default:
 			IPACMDBG("Ignore cmd %d\n", evt);
 			break;
@@ -213,6 +228,7 @@ void IPACM_ConntrackListener::HandleNeighIpAddrAddEvt(ipacm_event_data_all *data
 				if(nat_iface_ipv4_addr[j] == 0)
 				{
 					nat_iface_ipv4_addr[j] = data->ipv4_addr;
+					UpdateNatIfaceBits();
 					nat_inst->ResetPwrSaveIf(data->ipv4_addr);
 					nat_inst->FlushTempEntries(data->ipv4_addr, true);
 					break;
@@ -242,6 +258,7 @@ void IPACM_ConntrackListener::HandleNeighIpAddrAddEvt(ipacm_event_data_all *data
 			{
 				nonnat_iface_ipv4_addr[i] = data->ipv4_addr;
 				nat_inst->FlushTempEntries(data->ipv4_addr, false);
+				IPACM_ConntrackClient::UpdateNonNatClient(data->ipv4_addr, true);
 				break;
 			}
 		}
@@ -270,6 +287,7 @@ void IPACM_ConntrackListener::HandleNeighIpAddrDelEvt(uint32_t ipv4_addr)
 			IPACMDBG("Reseting ct nat iface, entry (%d) ", cnt);
 			iptodot("with ipv4 address", nat_iface_ipv4_addr[cnt]);
 			nat_iface_ipv4_addr[cnt] = 0;
+			UpdateNatIfaceBits();
 		}
 
 		if(nonnat_iface_ipv4_addr[cnt] == ipv4_addr)
@@ -277,6 +295,7 @@ void IPACM_ConntrackListener::HandleNeighIpAddrDelEvt(uint32_t ipv4_addr)
 			IPACMDBG("Reseting ct filters, entry (%d) ", cnt);
 			iptodot("with ipv4 address", nonnat_iface_ipv4_addr[cnt]);
 			nonnat_iface_ipv4_addr[cnt] = 0;
+			IPACM_ConntrackClient::UpdateNonNatClient(ipv4_addr, false);
 		}
 	}
 
@@ -285,6 +304,25 @@ void IPACM_ConntrackListener::HandleNeighIpAddrDelEvt(uint32_t ipv4_addr)
 	return;
 }
 
+/* Rebuild the nat iface bitset, bits may be shared so they can't
+	 simply be cleared on delete */
+void IPACM_ConntrackListener::UpdateNatIfaceBits(void)
+{
+	int cnt;
+	uint32_t bit;
+
+	memset(nat_iface_bits, 0, sizeof(nat_iface_bits));
+	for(cnt = 0; cnt < MAX_NAT_IFACES; cnt++)
+	{
+		if(nat_iface_ipv4_addr[cnt] != 0)
+		{
+			bit = NatIfaceBit(nat_iface_ipv4_addr[cnt]);
+			nat_iface_bits[bit >> 5] |= (1U << (bit & 31));
+		}
+	}
+	return;
+}
+
 void IPACM_ConntrackListener::TriggerWANUp(void *in_param)
 {
 	 ipacm_event_iface_up *wanup_data = (ipacm_event_iface_up *)in_param;
@@ -631,6 +669,21 @@ void IPACM_ConntrackListener::ProcessCTMessage(void *param)
 }
 
 
+void IPACM_ConntrackListener::ProcessCTBatch(void *param)
+{
+	ipacm_ct_evt_batch *batch = (ipacm_ct_evt_batch *)param;
+	int cnt;
+
+	IPACMDBG("Processing %d conntrack events\n", batch->num_evts);
+	for(cnt = 0; cnt < batch->num_evts; cnt++)
+	{
+		/* frees the conntrack object */
+		ProcessCTMessage(&batch->evts[cnt]);
+	}
+
+	return;
+}
+
 /* conntrack send in host order and ipa expects in host order */
 void IPACM_ConntrackListener::ProcessTCPorUDPMsg(
 	 struct nf_conntrack *ct,
@@ -818,8 +871,14 @@ void IPACM_ConntrackListener::ProcessTCPorUDPMsg(
 
 	 if(rule.private_ip != wan_ipaddr)
 	 {
-		 int cnt;
-		 for(cnt = 0; cnt < MAX_NAT_IFACES; cnt++)
+		 int cnt = MAX_NAT_IFACES;
+
+		 if(MayBeNatIface(rule.private_ip) || MayBeNatIface(rule.target_ip))
+		 {
+			 cnt = 0;
+		 }
+
+		 for(; cnt < MAX_NAT_IFACES; cnt++)
 		 {
 			 if(nat_iface_ipv4_addr[cnt] != 0)
 			 {
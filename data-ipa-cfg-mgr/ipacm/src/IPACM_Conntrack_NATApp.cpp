@@ -26,6 +26,7 @@ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
 OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
 IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
+#include <time.h>
 #include "IPACM_Conntrack_NATApp.h"
 #include "IPACM_ConntrackClient.h"
 
@@ -41,7 +42,24 @@ NatApp::NatApp()
 	nat_table_hdl = 0;
 	pub_ip_addr = 0;
 
-	curCnt = 0;
+	restore_rules = NULL;
+	restore_hdls = NULL;
+	restore_slots = NULL;
+
+	timer_next = NULL;
+	timer_prev = NULL;
+	timer_expiry = NULL;
+	timer_tick = 0;
+	timer_wait_tick = NAT_TIMER_TICK_NONE;
+	timer_due = NULL;
+
+	memset(shards, 0, sizeof(shards));
+	shard_size = 0;
+	hash_next = NULL;
+	hash_mask = 0;
+	active_pos = NULL;
+	slot_shard = NULL;
+	pool_head = NAT_CACHE_INVALID_SLOT;
 
 	pALGPorts = NULL;
 	nALGPort = 0;
@@ -56,6 +74,9 @@ int NatApp::Init(void)
 {
 	IPACM_Config *pConfig;
 	int size = 0;
+	int nbuckets, cnt, idx, first, last;
+	nat_cache_shard *shard;
+	pthread_condattr_t cond_attr;
 
 	pConfig = IPACM_Config::GetInstance();
 	if(pConfig == NULL)
@@ -76,6 +97,101 @@ int NatApp::Init(void)
 	IPACMDBG("Allocated %d bytes for config manager nat cache\n", size);
 	memset(cache, 0, size);
 
+	/* Each shard owns shard_size slots, its bucket count is the
+	   next power of two >= shard_size */
+	shard_size = (max_entries + NAT_CACHE_SHARDS - 1) / NAT_CACHE_SHARDS;
+	nbuckets = 1;
+	while(nbuckets < shard_size)
+	{
+		nbuckets <<= 1;
+	}
+	hash_mask = nbuckets - 1;
+
+	hash_next = (int *)malloc(sizeof(int) * (max_entries + 1));
+	active_pos = (int *)malloc(sizeof(int) * (max_entries + 1));
+	slot_shard = (int *)malloc(sizeof(int) * (max_entries + 1));
+	if(hash_next == NULL || active_pos == NULL || slot_shard == NULL)
+	{
+		IPACMERR("Unable to allocate memory for nat cache index\n");
+		goto fail;
+	}
+
+	for(idx = 0; idx < NAT_CACHE_SHARDS; idx++)
+	{
+		shard = &shards[idx];
+		pthread_mutex_init(&shard->lock, NULL);
+		shard->hash_head = (int *)malloc(sizeof(int) * nbuckets);
+		/* a shard may end up holding every slot of the cache */
+		shard->active = (int *)malloc(sizeof(int) * (max_entries + 1));
+		if(shard->hash_head == NULL || shard->active == NULL)
+		{
+			IPACMERR("Unable to allocate memory for nat cache shard %d\n", idx);
+			goto fail;
+		}
+
+		for(cnt = 0; cnt < nbuckets; cnt++)
+		{
+			shard->hash_head[cnt] = NAT_CACHE_INVALID_SLOT;
+		}
+
+		/* Initially every slot of the shard is on its free list */
+		first = idx * shard_size;
+		last = (first + shard_size < max_entries) ? (first + shard_size) : max_entries;
+		shard->free_head = (first < last) ? first : NAT_CACHE_INVALID_SLOT;
+		for(cnt = first; cnt < last; cnt++)
+		{
+			hash_next[cnt] = (cnt + 1 < last) ? (cnt + 1) : NAT_CACHE_INVALID_SLOT;
+			active_pos[cnt] = NAT_CACHE_INVALID_SLOT;
+			slot_shard[cnt] = idx;
+		}
+		shard->curCnt = 0;
+	}
+	pool_head = NAT_CACHE_INVALID_SLOT;
+	pthread_mutex_init(&pool_lock, NULL);
+	IPACMDBG("Nat cache uses %d shards of %d slots, %d hash buckets each\n",
+					 NAT_CACHE_SHARDS, shard_size, nbuckets);
+	pthread_mutex_init(&table_lock, NULL);
+	pthread_mutex_init(&temp_lock, NULL);
+
+	restore_rules = (ipa_nat_ipv4_rule *)malloc(sizeof(ipa_nat_ipv4_rule) * (max_entries + 1));
+	restore_hdls = (uint32_t *)malloc(sizeof(uint32_t) * (max_entries + 1));
+	restore_slots = (int *)malloc(sizeof(int) * (max_entries + 1));
+	if(restore_rules == NULL || restore_hdls == NULL || restore_slots == NULL)
+	{
+		IPACMERR("Unable to allocate memory for nat cache restore\n");
+		goto fail;
+	}
+
+	timer_next = (int *)malloc(sizeof(int) * (max_entries + 1));
+	timer_prev = (int *)malloc(sizeof(int) * (max_entries + 1));
+	timer_expiry = (uint32_t *)malloc(sizeof(uint32_t) * (max_entries + 1));
+	timer_due = (int *)malloc(sizeof(int) * (max_entries + 1));
+	if(timer_next == NULL || timer_prev == NULL || timer_expiry == NULL ||
+		 timer_due == NULL)
+	{
+		IPACMERR("Unable to allocate memory for nat timer wheel\n");
+		goto fail;
+	}
+
+	for(cnt = 0; cnt < NAT_TIMER_WHEEL_SLOTS; cnt++)
+	{
+		timer_wheel[cnt] = NAT_CACHE_INVALID_SLOT;
+	}
+	for(cnt = 0; cnt < max_entries; cnt++)
+	{
+		timer_next[cnt] = NAT_CACHE_INVALID_SLOT;
+		timer_prev[cnt] = NAT_CACHE_INVALID_SLOT;
+		timer_expiry[cnt] = NAT_TIMER_TICK_NONE;
+	}
+
+	/* Timer deadlines are on the monotonic clock */
+	pthread_condattr_init(&cond_attr);
+	pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&timer_cond, &cond_attr);
+	pthread_condattr_destroy(&cond_attr);
+	pthread_mutex_init(&timer_lock, NULL);
+	timer_tick = GetTimerTick();
+
 	nALGPort = pConfig->GetAlgPortCnt();
 	pALGPorts = (ipacm_alg *)malloc(sizeof(ipacm_alg) * nALGPort);
 	if(pALGPorts == NULL)
@@ -92,7 +208,7 @@ int NatApp::Init(void)
 	}
 
 	IPACMDBG("Printing %d alg ports information\n", nALGPort);
-	for(int cnt=0; cnt<nALGPort; cnt++)
+	for(cnt=0; cnt<nALGPort; cnt++)
 	{
 		IPACMDBG("%d: Proto[%d], port[%d]\n", cnt, pALGPorts[cnt].protocol, pALGPorts[cnt].port);
 	}
@@ -101,6 +217,21 @@ int NatApp::Init(void)
 
 fail:
 	free(cache);
+	for(idx = 0; idx < NAT_CACHE_SHARDS; idx++)
+	{
+		free(shards[idx].hash_head);
+		free(shards[idx].active);
+	}
+	free(hash_next);
+	free(active_pos);
+	free(slot_shard);
+	free(restore_rules);
+	free(restore_hdls);
+	free(restore_slots);
+	free(timer_next);
+	free(timer_prev);
+	free(timer_expiry);
+	free(timer_due);
 	free(pALGPorts);
 	return -1;
 }
@@ -126,8 +257,8 @@ NatApp* NatApp::GetInstance()
 int NatApp::AddTable(uint32_t pub_ip)
 {
 	int ret;
-	int cnt = 0;
-	ipa_nat_ipv4_rule nat_rule;
+	int cnt = 0, idx, shard, num_rules;
+	ipa_nat_ipv4_rule *nat_rule;
 	IPACMDBG("%s() %d\n", __FUNCTION__, __LINE__);
 
 	/* Not reset the cache wait it timeout by destroy event */
@@ -139,10 +270,14 @@ int NatApp::AddTable(uint32_t pub_ip)
 		curCnt = 0;
 	}
 #endif
+	LockAllShards();
+	pthread_mutex_lock(&table_lock);
 	ret = ipa_nat_add_ipv4_tbl(pub_ip, max_entries, &nat_table_hdl);
 	if(ret)
 	{
 		IPACMERR("unable to create nat table Error:%d\n", ret);
+		pthread_mutex_unlock(&table_lock);
+		UnlockAllShards();
 		return ret;
 	}
 
@@ -150,41 +285,64 @@ int NatApp::AddTable(uint32_t pub_ip)
 	if (pub_ip == pub_ip_addr_pre)
 	{
 		IPACMDBG("Restore the cache to ipa NAT-table\n");
-		for(cnt = 0; cnt < max_entries; cnt++)
+		num_rules = 0;
+		for(shard = 0; shard < NAT_CACHE_SHARDS; shard++)
 		{
-			if(cache[cnt].private_ip !=0)
+			for(idx = 0; idx < shards[shard].curCnt; idx++)
 			{
-				memset(&nat_rule, 0 , sizeof(nat_rule));
-				nat_rule.private_ip = cache[cnt].private_ip;
-				nat_rule.target_ip = cache[cnt].target_ip;
-				nat_rule.target_port = cache[cnt].target_port;
-				nat_rule.private_port = cache[cnt].private_port;
-				nat_rule.public_port = cache[cnt].public_port;
-				nat_rule.protocol = cache[cnt].protocol;
-
-				if(ipa_nat_add_ipv4_rule(nat_table_hdl, &nat_rule, &cache[cnt].rule_hdl) < 0)
-				{
-					IPACMERR("unable to add the rule delete from cache\n");
-					memset(&cache[cnt], 0, sizeof(cache[cnt]));
-					curCnt--;
-					continue;
-				}
-				cache[cnt].enabled = true;
+				restore_slots[num_rules++] = shards[shard].active[idx];
+			}
+		}
+		for(idx = 0; idx < num_rules; idx++)
+		{
+			cnt = restore_slots[idx];
+			nat_rule = &restore_rules[idx];
+			memset(nat_rule, 0 , sizeof(*nat_rule));
+			nat_rule->private_ip = cache[cnt].private_ip;
+			nat_rule->target_ip = cache[cnt].target_ip;
+			nat_rule->target_port = cache[cnt].target_port;
+			nat_rule->private_port = cache[cnt].private_port;
+			nat_rule->public_port = cache[cnt].public_port;
+			nat_rule->protocol = cache[cnt].protocol;
+		}
+
+		/* Program the whole cache with batched dma commands */
+		if(num_rules > 0 &&
+			 ipa_nat_add_ipv4_rules(nat_table_hdl, restore_rules, num_rules, restore_hdls) < 0)
+		{
+			IPACMERR("unable to add some of the %d cached rules\n", num_rules);
+		}
 
-				IPACMDBG("On wan-iface reset added below rule successfully\n");
-				iptodot("Private IP", nat_rule.private_ip);
-				iptodot("Target IP", nat_rule.target_ip);
-				IPACMDBG("Private Port:%d \t Target Port: %d\t", nat_rule.private_port, nat_rule.target_port);
-				IPACMDBG("Public Port:%d\n", nat_rule.public_port);
-				IPACMDBG("protocol: %d\n", nat_rule.protocol);
+		for(idx = 0; idx < num_rules; idx++)
+		{
+			cnt = restore_slots[idx];
+			nat_rule = &restore_rules[idx];
+			if(restore_hdls[idx] == 0)
+			{
+				IPACMERR("unable to add the rule delete from cache\n");
+				FreeEntry(cnt);
+				continue;
 			}
+			cache[cnt].rule_hdl = restore_hdls[idx];
+			cache[cnt].enabled = true;
+			ScheduleTimer(cnt);
+
+			IPACMDBG("On wan-iface reset added below rule successfully\n");
+			iptodot("Private IP", nat_rule->private_ip);
+			iptodot("Target IP", nat_rule->target_ip);
+			IPACMDBG("Private Port:%d \t Target Port: %d\t", nat_rule->private_port, nat_rule->target_port);
+			IPACMDBG("Public Port:%d\n", nat_rule->public_port);
+			IPACMDBG("protocol: %d\n", nat_rule->protocol);
 		}
 	}
 
 	pub_ip_addr = pub_ip;
+	pthread_mutex_unlock(&table_lock);
+	UnlockAllShards();
 	return 0;
 }
 
+/* Called with all shard locks and table_lock held */
 void NatApp::Reset()
 {
 	int cnt = 0;
@@ -194,7 +352,7 @@ void NatApp::Reset()
 	/* NAT tbl deleted, reset enabled bit */
 	for(cnt = 0; cnt < max_entries; cnt++)
 	{
-		cache[cnt].enabled ==false;
+		cache[cnt].enabled = false;
 	}
 }
 
@@ -205,32 +363,90 @@ int NatApp::DeleteTable(uint32_t pub_ip)
 
 	CHK_TBL_HDL();
 
+	LockAllShards();
+	pthread_mutex_lock(&table_lock);
 	if(pub_ip_addr != pub_ip)
 	{
 		IPACMDBG("Public ip address is not matching\n");
 		IPACMERR("unable to delete the nat table\n");
-		return -1;
+		ret = -1;
+		goto unlock;
 	}
 
 	ret = ipa_nat_del_ipv4_tbl(nat_table_hdl);
 	if(ret)
 	{
 		IPACMERR("unable to delete nat table Error: %d\n", ret);;
-		return ret;
+		goto unlock;
 	}
 
 	pub_ip_addr_pre = pub_ip_addr;
 	Reset();
-	return 0;
+
+unlock:
+	pthread_mutex_unlock(&table_lock);
+	UnlockAllShards();
+	return ret;
 }
 
-/* Check for duplicate entries */
-bool NatApp::ChkForDup(const nat_table_entry *rule)
+/* Hash the connection 5-tuple, the low bits pick the shard and
+	 the rest the bucket within it */
+uint32_t NatApp::HashEntry(const nat_table_entry *rule)
 {
-	int cnt = 0;
-	IPACMDBG("%s() %d\n", __FUNCTION__, __LINE__);
+	uint32_t hash;
+
+	hash = rule->private_ip * 0x9E3779B1;
+	hash ^= rule->target_ip + 0x7F4A7C15 + (hash << 6) + (hash >> 2);
+	hash ^= (((uint32_t)rule->private_port << 16) | rule->target_port) +
+		0x7F4A7C15 + (hash << 6) + (hash >> 2);
+	hash ^= rule->protocol;
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6B;
+	hash ^= hash >> 13;
+
+	return hash;
+}
+
+nat_cache_shard *NatApp::GetShard(uint32_t hash)
+{
+	return &shards[hash & (NAT_CACHE_SHARDS - 1)];
+}
+
+/* Shard of a used slot. Stable while that shard's lock is held, callers
+	 without it have to check again once they took the lock */
+nat_cache_shard *NatApp::GetSlotShard(int cnt)
+{
+	return &shards[__atomic_load_n(&slot_shard[cnt], __ATOMIC_RELAXED)];
+}
+
+void NatApp::LockAllShards()
+{
+	int idx;
+
+	for(idx = 0; idx < NAT_CACHE_SHARDS; idx++)
+	{
+		pthread_mutex_lock(&shards[idx].lock);
+	}
+}
+
+void NatApp::UnlockAllShards()
+{
+	int idx;
 
-	for(; cnt < max_entries; cnt++)
+	for(idx = NAT_CACHE_SHARDS - 1; idx >= 0; idx--)
+	{
+		pthread_mutex_unlock(&shards[idx].lock);
+	}
+}
+
+/* Look up the cache slot holding the connection, -1 if not cached.
+	 Called with the shard lock held */
+int NatApp::FindEntry(nat_cache_shard *shard, uint32_t hash, const nat_table_entry *rule)
+{
+	int cnt;
+
+	for(cnt = shard->hash_head[(hash >> NAT_CACHE_SHARD_BITS) & hash_mask];
+			cnt != NAT_CACHE_INVALID_SLOT; cnt = hash_next[cnt])
 	{
 		if(cache[cnt].private_ip == rule->private_ip &&
 			 cache[cnt].target_ip == rule->target_ip &&
@@ -238,15 +454,201 @@ bool NatApp::ChkForDup(const nat_table_entry *rule)
 			 cache[cnt].target_port == rule->target_port &&
 			 cache[cnt].protocol == rule->protocol)
 		{
-			IPACMDBG("Duplicate Rule\n");
-			iptodot("Private IP", rule->private_ip);
-			iptodot("Target IP", rule->target_ip);
-			IPACMDBG("Private Port: %d\t Target Port: %d\t", rule->private_port, rule->target_port);
-			IPACMDBG("protocolcol: %d\n", rule->protocol);
-			return true;
+			return cnt;
 		}
 	}
 
+	return NAT_CACHE_INVALID_SLOT;
+}
+
+/* Get a free slot for the shard: its own free list first, then the
+	 shared pool, then the free list of another shard. The lock order
+	 only allows a try on the other shard locks, a shard that is busy
+	 right now is skipped. Called with the shard lock held */
+int NatApp::AllocSlot(nat_cache_shard *shard)
+{
+	int cnt, idx;
+
+	cnt = shard->free_head;
+	if(cnt != NAT_CACHE_INVALID_SLOT)
+	{
+		shard->free_head = hash_next[cnt];
+		return cnt;
+	}
+
+	pthread_mutex_lock(&pool_lock);
+	cnt = pool_head;
+	if(cnt != NAT_CACHE_INVALID_SLOT)
+	{
+		pool_head = hash_next[cnt];
+	}
+	pthread_mutex_unlock(&pool_lock);
+	if(cnt != NAT_CACHE_INVALID_SLOT)
+	{
+		return cnt;
+	}
+
+	for(idx = 0; idx < NAT_CACHE_SHARDS; idx++)
+	{
+		if(&shards[idx] == shard || pthread_mutex_trylock(&shards[idx].lock) != 0)
+		{
+			continue;
+		}
+		cnt = shards[idx].free_head;
+		if(cnt != NAT_CACHE_INVALID_SLOT)
+		{
+			shards[idx].free_head = hash_next[cnt];
+		}
+		pthread_mutex_unlock(&shards[idx].lock);
+		if(cnt != NAT_CACHE_INVALID_SLOT)
+		{
+			IPACMDBG("Shard %d borrowed slot %d from shard %d\n", (int)(shard - shards), cnt, idx);
+			return cnt;
+		}
+	}
+
+	return NAT_CACHE_INVALID_SLOT;
+}
+
+/* Take a free slot, fill in the 5-tuple and index it.
+	 Called with the shard lock held */
+int NatApp::AllocEntry(nat_cache_shard *shard, uint32_t hash, const nat_table_entry *rule)
+{
+	int cnt;
+	uint32_t bucket;
+
+	cnt = AllocSlot(shard);
+	if(cnt == NAT_CACHE_INVALID_SLOT)
+	{
+		return NAT_CACHE_INVALID_SLOT;
+	}
+	__atomic_store_n(&slot_shard[cnt], (int)(shard - shards), __ATOMIC_RELAXED);
+
+	memset(&cache[cnt], 0, sizeof(cache[cnt]));
+	cache[cnt].private_ip = rule->private_ip;
+	cache[cnt].target_ip = rule->target_ip;
+	cache[cnt].target_port = rule->target_port;
+	cache[cnt].private_port = rule->private_port;
+	cache[cnt].protocol = rule->protocol;
+	cache[cnt].public_port = rule->public_port;
+	cache[cnt].dst_nat = rule->dst_nat;
+
+	bucket = (hash >> NAT_CACHE_SHARD_BITS) & hash_mask;
+	hash_next[cnt] = shard->hash_head[bucket];
+	shard->hash_head[bucket] = cnt;
+
+	shard->active[shard->curCnt] = cnt;
+	active_pos[cnt] = shard->curCnt;
+	shard->curCnt++;
+
+	return cnt;
+}
+
+/* Unindex the slot, clear it and return it to the free list.
+	 Called with the lock of the slot's shard held */
+void NatApp::FreeEntry(int cnt)
+{
+	nat_cache_shard *shard = GetSlotShard(cnt);
+	int *link;
+	int last;
+
+	if(active_pos[cnt] == NAT_CACHE_INVALID_SLOT)
+	{
+		return;
+	}
+
+	CancelTimer(cnt);
+
+	link = &shard->hash_head[(HashEntry(&cache[cnt]) >> NAT_CACHE_SHARD_BITS) & hash_mask];
+	while(*link != NAT_CACHE_INVALID_SLOT && *link != cnt)
+	{
+		link = &hash_next[*link];
+	}
+	if(*link == cnt)
+	{
+		*link = hash_next[cnt];
+	}
+
+	/* swap the last active slot into the hole */
+	shard->curCnt--;
+	last = shard->active[shard->curCnt];
+	shard->active[active_pos[cnt]] = last;
+	active_pos[last] = active_pos[cnt];
+	active_pos[cnt] = NAT_CACHE_INVALID_SLOT;
+
+	memset(&cache[cnt], 0, sizeof(cache[cnt]));
+
+	/* Slots go back to the free list of the shard whose range they are
+	   in, borrowed ones to the pool where any shard can take them */
+	if(cnt / shard_size == (int)(shard - shards))
+	{
+		hash_next[cnt] = shard->free_head;
+		shard->free_head = cnt;
+	}
+	else
+	{
+		pthread_mutex_lock(&pool_lock);
+		hash_next[cnt] = pool_head;
+		pool_head = cnt;
+		pthread_mutex_unlock(&pool_lock);
+	}
+}
+
+/* Program the cached entry into the NAT table.
+	 Called with the lock of the slot's shard held */
+int NatApp::AddHwRule(int cnt)
+{
+	ipa_nat_ipv4_rule nat_rule;
+	int ret;
+
+	memset(&nat_rule, 0 , sizeof(nat_rule));
+	nat_rule.private_ip = cache[cnt].private_ip;
+	nat_rule.target_ip = cache[cnt].target_ip;
+	nat_rule.target_port = cache[cnt].target_port;
+	nat_rule.private_port = cache[cnt].private_port;
+	nat_rule.public_port = cache[cnt].public_port;
+	nat_rule.protocol = cache[cnt].protocol;
+
+	pthread_mutex_lock(&table_lock);
+	if(nat_table_hdl == 0)
+	{
+		pthread_mutex_unlock(&table_lock);
+		return -1;
+	}
+	ret = ipa_nat_add_ipv4_rule(nat_table_hdl, &nat_rule, &cache[cnt].rule_hdl);
+	pthread_mutex_unlock(&table_lock);
+
+	return ret;
+}
+
+/* Remove the cached entry from the NAT table.
+	 Called with the lock of the slot's shard held */
+int NatApp::DelHwRule(int cnt)
+{
+	int ret;
+
+	pthread_mutex_lock(&table_lock);
+	ret = ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl);
+	pthread_mutex_unlock(&table_lock);
+
+	return ret;
+}
+
+/* Check for duplicate entries, called with the shard lock held */
+bool NatApp::ChkForDup(nat_cache_shard *shard, uint32_t hash, const nat_table_entry *rule)
+{
+	IPACMDBG("%s() %d\n", __FUNCTION__, __LINE__);
+
+	if(FindEntry(shard, hash, rule) != NAT_CACHE_INVALID_SLOT)
+	{
+		IPACMDBG("Duplicate Rule\n");
+		iptodot("Private IP", rule->private_ip);
+		iptodot("Target IP", rule->target_ip);
+		IPACMDBG("Private Port: %d\t Target Port: %d\t", rule->private_port, rule->target_port);
+		IPACMDBG("protocolcol: %d\n", rule->protocol);
+		return true;
+	}
+
 	return false;
 }
 
@@ -254,6 +656,8 @@ bool NatApp::ChkForDup(const nat_table_entry *rule)
 int NatApp::DeleteEntry(const nat_table_entry *rule)
 {
 	int cnt = 0;
+	uint32_t hash;
+	nat_cache_shard *shard;
 	IPACMDBG("%s() %d\n", __FUNCTION__, __LINE__);
 
 	IPACMDBG("Received below nat entry for deletion\n");
@@ -262,34 +666,29 @@ int NatApp::DeleteEntry(const nat_table_entry *rule)
 	IPACMDBG("Private Port: %d\t Target Port: %d\t", rule->private_port, rule->target_port);
 	IPACMDBG("protocolcol: %d\n", rule->protocol);
 
-	for(; cnt < max_entries; cnt++)
+	hash = HashEntry(rule);
+	shard = GetShard(hash);
+	pthread_mutex_lock(&shard->lock);
+	cnt = FindEntry(shard, hash, rule);
+	if(cnt != NAT_CACHE_INVALID_SLOT)
 	{
-		if(cache[cnt].private_ip == rule->private_ip &&
-			 cache[cnt].target_ip == rule->target_ip &&
-			 cache[cnt].private_port ==  rule->private_port  &&
-			 cache[cnt].target_port == rule->target_port &&
-			 cache[cnt].protocol == rule->protocol)
+		if(cache[cnt].enabled == true)
 		{
-
-			if(cache[cnt].enabled == true)
-			{
-				if(ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl) < 0)
-				{
-					IPACMERR("%s() %d deletion failed\n", __FUNCTION__, __LINE__);
-				}
-
-				IPACMDBG("Deleted Nat entry(%d) Successfully\n", cnt);
-			}
-			else
+			if(DelHwRule(cnt) < 0)
 			{
-				IPACMDBG("Deleted Nat entry(%d) only from cache\n", cnt);
+				IPACMERR("%s() %d deletion failed\n", __FUNCTION__, __LINE__);
 			}
 
-			memset(&cache[cnt], 0, sizeof(cache[cnt]));
-			curCnt--;
-			break;
+			IPACMDBG("Deleted Nat entry(%d) Successfully\n", cnt);
+		}
+		else
+		{
+			IPACMDBG("Deleted Nat entry(%d) only from cache\n", cnt);
 		}
+
+		FreeEntry(cnt);
 	}
+	pthread_mutex_unlock(&shard->lock);
 
 	return 0;
 }
@@ -299,7 +698,8 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 {
 
 	int cnt = 0;
-	ipa_nat_ipv4_rule nat_rule;
+	uint32_t hash;
+	nat_cache_shard *shard;
 	IPACMDBG("%s() %d\n", __FUNCTION__, __LINE__);
 
 	CHK_TBL_HDL();
@@ -327,79 +727,47 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 		return 0;
 	}
 
-	if(!ChkForDup(rule))
+	hash = HashEntry(rule);
+	shard = GetShard(hash);
+	pthread_mutex_lock(&shard->lock);
+	if(ChkForDup(shard, hash, rule))
 	{
-		for(; cnt < max_entries; cnt++)
-		{
-			if(cache[cnt].private_ip == 0 &&
-				 cache[cnt].target_ip == 0 &&
-				 cache[cnt].private_port == 0  &&
-				 cache[cnt].target_port == 0 &&
-				 cache[cnt].protocol == 0)
-			{
-				break;
-			}
-		}
-
-		if(max_entries == cnt)
-		{
-			IPACMERR("Error: Unable to add, reached maximum rules\n");
-			return -1;
-		}
-		else
-		{
-			nat_rule.private_ip = rule->private_ip;
-			nat_rule.target_ip = rule->target_ip;
-			nat_rule.target_port = rule->target_port;
-			nat_rule.private_port = rule->private_port;
-			nat_rule.public_port = rule->public_port;
-			nat_rule.protocol = rule->protocol;
-
-			if(isPwrSaveIf(rule->private_ip) ||
-				 isPwrSaveIf(rule->target_ip))
-			{
-				IPACMDBG("Device is Power Save mode: Dont insert into nat table but cache\n");
-				cache[cnt].enabled = false;
-				cache[cnt].rule_hdl = 0;
-			}
-			else
-			{
-
-				if(ipa_nat_add_ipv4_rule(nat_table_hdl, &nat_rule, &cache[cnt].rule_hdl) < 0)
-				{
-					IPACMERR("unable to add the rule\n");
-					return -1;
-				}
-
-				cache[cnt].enabled = true;
-			}
-
-			cache[cnt].private_ip = rule->private_ip;
-			cache[cnt].target_ip = rule->target_ip;
-			cache[cnt].target_port = rule->target_port;
-			cache[cnt].private_port = rule->private_port;
-			cache[cnt].protocol = rule->protocol;
-			cache[cnt].timestamp = 0;
-			cache[cnt].public_port = rule->public_port;
-			cache[cnt].dst_nat = rule->dst_nat;
-			curCnt++;
-		}
-
+		pthread_mutex_unlock(&shard->lock);
+		IPACMERR("Duplicate rule. Ignore it\n");
+		return -1;
 	}
-	else
+
+	cnt = AllocEntry(shard, hash, rule);
+	if(cnt == NAT_CACHE_INVALID_SLOT)
 	{
-		IPACMERR("Duplicate rule. Ignore it\n");
+		pthread_mutex_unlock(&shard->lock);
+		IPACMERR("Error: Unable to add, reached maximum rules\n");
 		return -1;
 	}
 
-	if(cache[cnt].enabled == true)
+	if(isPwrSaveIf(rule->private_ip) ||
+		 isPwrSaveIf(rule->target_ip))
 	{
+		IPACMDBG("Device is Power Save mode: Dont insert into nat table but cache\n");
+		cache[cnt].enabled = false;
+		cache[cnt].rule_hdl = 0;
+		IPACMDBG("Cached rule(%d) successfully\n", cnt);
+	}
+	else
+	{
+		if(AddHwRule(cnt) < 0)
+		{
+			IPACMERR("unable to add the rule\n");
+			FreeEntry(cnt);
+			pthread_mutex_unlock(&shard->lock);
+			return -1;
+		}
+
+		cache[cnt].enabled = true;
+		ScheduleTimer(cnt);
 		IPACMDBG("Added rule(%d) successfully\n", cnt);
 	}
-  else
-  {
-    IPACMDBG("Cached rule(%d) successfully\n", cnt);
-  }
+	pthread_mutex_unlock(&shard->lock);
 
 	return 0;
 }
@@ -487,35 +855,229 @@ void NatApp::UpdateCTUdpTs(nat_table_entry *rule, uint32_t new_ts)
 	return;
 }
 
+/* Current timer wheel tick on the monotonic clock */
+uint32_t NatApp::GetTimerTick()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)(now.tv_sec / UDP_TIMEOUT_UPDATE);
+}
+
+/* Ticks until the entry has to be checked: one tick before the
+	 conntrack entry refreshed now would expire */
+uint32_t NatApp::GetTimerDelay(const nat_table_entry *rule)
+{
+	uint32_t timeout;
+
+	timeout = (rule->protocol == IPPROTO_UDP) ? udp_timeout : tcp_timeout;
+	if(timeout <= 2 * UDP_TIMEOUT_UPDATE)
+	{
+		return 1;
+	}
+
+	return (timeout - UDP_TIMEOUT_UPDATE) / UDP_TIMEOUT_UPDATE;
+}
+
+/* Called with timer_lock held */
+void NatApp::LinkTimer(int cnt, uint32_t expiry)
+{
+	int slot = expiry % NAT_TIMER_WHEEL_SLOTS;
+
+	timer_expiry[cnt] = expiry;
+	timer_prev[cnt] = NAT_CACHE_INVALID_SLOT;
+	timer_next[cnt] = timer_wheel[slot];
+	if(timer_wheel[slot] != NAT_CACHE_INVALID_SLOT)
+	{
+		timer_prev[timer_wheel[slot]] = cnt;
+	}
+	timer_wheel[slot] = cnt;
+}
+
+/* Called with timer_lock held */
+void NatApp::UnlinkTimer(int cnt)
+{
+	if(timer_expiry[cnt] == NAT_TIMER_TICK_NONE)
+	{
+		return;
+	}
+
+	if(timer_prev[cnt] != NAT_CACHE_INVALID_SLOT)
+	{
+		timer_next[timer_prev[cnt]] = timer_next[cnt];
+	}
+	else
+	{
+		timer_wheel[timer_expiry[cnt] % NAT_TIMER_WHEEL_SLOTS] = timer_next[cnt];
+	}
+
+	if(timer_next[cnt] != NAT_CACHE_INVALID_SLOT)
+	{
+		timer_prev[timer_next[cnt]] = timer_prev[cnt];
+	}
+
+	timer_next[cnt] = NAT_CACHE_INVALID_SLOT;
+	timer_prev[cnt] = NAT_CACHE_INVALID_SLOT;
+	timer_expiry[cnt] = NAT_TIMER_TICK_NONE;
+}
+
+/* (Re)arm the timestamp check of a newly enabled entry */
+void NatApp::ScheduleTimer(int cnt)
+{
+	uint32_t expiry;
+
+	pthread_mutex_lock(&timer_lock);
+	UnlinkTimer(cnt);
+	expiry = GetTimerTick() + GetTimerDelay(&cache[cnt]);
+	LinkTimer(cnt, expiry);
+
+	/* Only wake the timer thread if it sleeps past this deadline */
+	if(expiry < timer_wait_tick)
+	{
+		pthread_cond_signal(&timer_cond);
+	}
+	pthread_mutex_unlock(&timer_lock);
+}
+
+void NatApp::CancelTimer(int cnt)
+{
+	pthread_mutex_lock(&timer_lock);
+	UnlinkTimer(cnt);
+	pthread_mutex_unlock(&timer_lock);
+}
+
+/* Sleep until the first non empty wheel slot is due,
+	 called with timer_lock held */
+void NatApp::WaitForTimers()
+{
+	struct timespec deadline;
+	uint32_t tick;
+
+	timer_wait_tick = NAT_TIMER_TICK_NONE;
+	for(tick = timer_tick; tick < timer_tick + NAT_TIMER_WHEEL_SLOTS; tick++)
+	{
+		if(timer_wheel[tick % NAT_TIMER_WHEEL_SLOTS] != NAT_CACHE_INVALID_SLOT)
+		{
+			timer_wait_tick = tick;
+			break;
+		}
+	}
+
+	if(timer_wait_tick == NAT_TIMER_TICK_NONE)
+	{
+		IPACMDBG("No offloaded entries, waiting for new ones\n");
+		pthread_cond_wait(&timer_cond, &timer_lock);
+	}
+	else if(timer_wait_tick > GetTimerTick())
+	{
+		deadline.tv_sec = (time_t)timer_wait_tick * UDP_TIMEOUT_UPDATE;
+		deadline.tv_nsec = 0;
+		pthread_cond_timedwait(&timer_cond, &timer_lock, &deadline);
+	}
+
+	timer_wait_tick = NAT_TIMER_TICK_NONE;
+}
+
+/* Block until some entries are due for a timestamp check, then refresh
+	 the conntrack timeout of those whose HW timestamp moved. Entries are
+	 only looked at once per conntrack timeout while active, and once
+	 per tick once idle, until conntrack destroys them */
 void NatApp::UpdateUDPTimeStamp()
 {
-	int cnt;
-	uint32_t ts;
+	int cnt, next, idx, num_due = 0;
+	uint32_t ts, now, delay;
+	nat_cache_shard *shard;
+	int checked = 0, updated = 0, ret;
 
-	for(cnt = 0; cnt < max_entries; cnt++)
+	pthread_mutex_lock(&timer_lock);
+	WaitForTimers();
+
+	now = GetTimerTick();
+	if(now - timer_tick >= NAT_TIMER_WHEEL_SLOTS)
 	{
-		ts = 0;
-		if(cache[cnt].enabled == true)
+		/* One lap of the wheel visits every pending entry */
+		timer_tick = now - NAT_TIMER_WHEEL_SLOTS + 1;
+	}
+
+	for(; timer_tick <= now; timer_tick++)
+	{
+		for(cnt = timer_wheel[timer_tick % NAT_TIMER_WHEEL_SLOTS];
+				cnt != NAT_CACHE_INVALID_SLOT; cnt = next)
 		{
-			IPACMDBG("\n");
-			if(ipa_nat_query_timestamp(nat_table_hdl, cache[cnt].rule_hdl, &ts) < 0)
+			next = timer_next[cnt];
+			if(timer_expiry[cnt] > now)
 			{
-				IPACMERR("unable to retrieve timeout for rule hanle: %d\n", cache[cnt].rule_hdl);
 				continue;
 			}
 
+			UnlinkTimer(cnt);
+			timer_due[num_due++] = cnt;
+		}
+	}
+	pthread_mutex_unlock(&timer_lock);
+
+	/* Check the due entries under their shard lock only, so the
+	   conntrack threads keep adding entries to the other shards */
+	for(idx = 0; idx < num_due; idx++)
+	{
+		cnt = timer_due[idx];
+		shard = GetSlotShard(cnt);
+		pthread_mutex_lock(&shard->lock);
+		while(GetSlotShard(cnt) != shard)
+		{
+			/* freed and taken by another shard before we got the lock */
+			pthread_mutex_unlock(&shard->lock);
+			shard = GetSlotShard(cnt);
+			pthread_mutex_lock(&shard->lock);
+		}
+
+		/* Skip entries freed, disabled or re-armed since they were unlinked */
+		if(active_pos[cnt] == NAT_CACHE_INVALID_SLOT ||
+			 cache[cnt].enabled != true ||
+			 timer_expiry[cnt] != NAT_TIMER_TICK_NONE)
+		{
+			pthread_mutex_unlock(&shard->lock);
+			continue;
+		}
+
+		checked++;
+		ts = 0;
+		pthread_mutex_lock(&table_lock);
+		ret = ipa_nat_query_timestamp(nat_table_hdl, cache[cnt].rule_hdl, &ts);
+		pthread_mutex_unlock(&table_lock);
+		if(ret < 0)
+		{
+			IPACMERR("unable to retrieve timeout for rule hanle: %d\n", cache[cnt].rule_hdl);
+			delay = 1;
+		}
+		else if(cache[cnt].timestamp == ts)
+		{
+			IPACMDBG("No Change in Time Stamp: cahce:%d, ipahw:%d\n",
+							                  cache[cnt].timestamp, ts);
+			delay = 1;
+		}
+		else
+		{
+			UpdateCTUdpTs(&cache[cnt], ts);
 			if(cache[cnt].timestamp == ts)
 			{
-				IPACMDBG("No Change in Time Stamp: cahce:%d, ipahw:%d\n",
-								                  cache[cnt].timestamp, ts);
-				continue;
+				updated++;
+				delay = GetTimerDelay(&cache[cnt]);
 			}
+			else
+			{
+				/* conntrack update failed, retry on the next tick */
+				delay = 1;
+			}
+		}
 
-			UpdateCTUdpTs(&cache[cnt], ts);
-		} /* end of outer if */
-
-	} /* end of for loop */
+		pthread_mutex_lock(&timer_lock);
+		LinkTimer(cnt, now + delay);
+		pthread_mutex_unlock(&timer_lock);
+		pthread_mutex_unlock(&shard->lock);
+	}
 
+	IPACMDBG("Checked %d entries, updated %d conntrack timeouts\n", checked, updated);
 }
 
 bool NatApp::isAlgPort(uint8_t proto, uint16_t port)
@@ -549,9 +1111,11 @@ bool NatApp::isPwrSaveIf(uint32_t ip_addr)
 	return false;
 }
 
+/* PwrSaveIfs[] is only changed with all shard locks held, so holding
+	 any one of them is enough to read it */
 int NatApp::UpdatePwrSaveIf(uint32_t client_lan_ip)
 {
-	int cnt;
+	int cnt, idx, shard;
 	IPACMDBG("Received IP address: 0x%x\n", client_lan_ip);
 
 	if(client_lan_ip == INVALID_IP_ADDR)
@@ -560,12 +1124,14 @@ int NatApp::UpdatePwrSaveIf(uint32_t client_lan_ip)
 		return -1;
 	}
 
+	LockAllShards();
 	/* check for duplicate events */
 	for(cnt = 0; cnt < IPA_MAX_NUM_WIFI_CLIENTS; cnt++)
 	{
 		if(PwrSaveIfs[cnt] == client_lan_ip)
 		{
 			IPACMDBG("The client 0x%x is already in power save\n", client_lan_ip);
+			UnlockAllShards();
 			return 0;
 		}
 	}
@@ -580,29 +1146,33 @@ int NatApp::UpdatePwrSaveIf(uint32_t client_lan_ip)
 		}
 	}
 
-	for(cnt = 0; cnt < max_entries; cnt++)
+	for(shard = 0; shard < NAT_CACHE_SHARDS; shard++)
 	{
-		if(cache[cnt].private_ip == client_lan_ip &&
-			 cache[cnt].enabled == true)
+		for(idx = 0; idx < shards[shard].curCnt; idx++)
 		{
-			if(ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl) < 0)
+			cnt = shards[shard].active[idx];
+			if(cache[cnt].private_ip == client_lan_ip &&
+				 cache[cnt].enabled == true)
 			{
-				IPACMERR("unable to delete the rule\n");
-				continue;
-			}
+				if(DelHwRule(cnt) < 0)
+				{
+					IPACMERR("unable to delete the rule\n");
+					continue;
+				}
 
-			cache[cnt].enabled = false;
-			cache[cnt].rule_hdl = 0;
+				cache[cnt].enabled = false;
+				cache[cnt].rule_hdl = 0;
+			}
 		}
 	}
+	UnlockAllShards();
 
 	return 0;
 }
 
 int NatApp::ResetPwrSaveIf(uint32_t client_lan_ip)
 {
-	int cnt;
-	ipa_nat_ipv4_rule nat_rule;
+	int cnt, idx, shard;
 
 	IPACMDBG("Received ip address: 0x%x\n", client_lan_ip);
 
@@ -612,6 +1182,7 @@ int NatApp::ResetPwrSaveIf(uint32_t client_lan_ip)
 		return -1;
 	}
 
+	LockAllShards();
 	for(cnt = 0; cnt < IPA_MAX_NUM_WIFI_CLIENTS; cnt++)
 	{
 		if(PwrSaveIfs[cnt] == client_lan_ip)
@@ -621,39 +1192,37 @@ int NatApp::ResetPwrSaveIf(uint32_t client_lan_ip)
 		}
 	}
 
-	for(cnt = 0; cnt < max_entries; cnt++)
+	for(shard = 0; shard < NAT_CACHE_SHARDS; shard++)
 	{
-		IPACMDBG("cache (%d): enable %d, ip 0x%x\n", cnt, cache[cnt].enabled, cache[cnt].private_ip);
-
-		if(cache[cnt].private_ip == client_lan_ip &&
-			 cache[cnt].enabled == false)
+		/* Walk backwards so FreeEntry() can compact active[] under us */
+		for(idx = shards[shard].curCnt - 1; idx >= 0; idx--)
 		{
-			memset(&nat_rule, 0 , sizeof(nat_rule));
-			nat_rule.private_ip = cache[cnt].private_ip;
-			nat_rule.target_ip = cache[cnt].target_ip;
-			nat_rule.target_port = cache[cnt].target_port;
-			nat_rule.private_port = cache[cnt].private_port;
-			nat_rule.public_port = cache[cnt].public_port;
-			nat_rule.protocol = cache[cnt].protocol;
+			cnt = shards[shard].active[idx];
+			IPACMDBG("cache (%d): enable %d, ip 0x%x\n", cnt, cache[cnt].enabled, cache[cnt].private_ip);
 
-			if(ipa_nat_add_ipv4_rule(nat_table_hdl, &nat_rule, &cache[cnt].rule_hdl) < 0)
+			if(cache[cnt].private_ip == client_lan_ip &&
+				 cache[cnt].enabled == false)
 			{
-				IPACMERR("unable to add the rule delete from cache\n");
-				memset(&cache[cnt], 0, sizeof(cache[cnt]));
-				curCnt--;
-				continue;
-			}
-			cache[cnt].enabled = true;
+				if(AddHwRule(cnt) < 0)
+				{
+					IPACMERR("unable to add the rule delete from cache\n");
+					FreeEntry(cnt);
+					continue;
+				}
+				cache[cnt].enabled = true;
+				ScheduleTimer(cnt);
 
-			IPACMDBG("On power reset added below rule successfully\n");
-			iptodot("Private IP", nat_rule.private_ip);
-			iptodot("Target IP", nat_rule.target_ip);
-			IPACMDBG("Private Port:%d \t Target Port: %d\t", nat_rule.private_port, nat_rule.target_port);
-			IPACMDBG("Public Port:%d\n", nat_rule.public_port);
-			IPACMDBG("protocol: %d\n", nat_rule.protocol);
+				IPACMDBG("On power reset added below rule successfully\n");
+				iptodot("Private IP", cache[cnt].private_ip);
+				iptodot("Target IP", cache[cnt].target_ip);
+				IPACMDBG("Private Port:%d \t Target Port: %d\t", cache[cnt].private_port, cache[cnt].target_port);
+				IPACMDBG("Public Port:%d\n", cache[cnt].public_port);
+				IPACMDBG("protocol: %d\n", cache[cnt].protocol);
 
+			}
 		}
 	}
+	UnlockAllShards();
 
 	return -1;
 }
@@ -692,16 +1261,19 @@ void NatApp::AddTempEntry(const nat_table_entry *new_entry)
 	IPACMDBG("Private Port: %d\t Target Port: %d\t", new_entry->private_port, new_entry->target_port);
 	IPACMDBG("protocolcol: %d\n", new_entry->protocol);
 
+	pthread_mutex_lock(&temp_lock);
 	for(cnt=0; cnt<MAX_TEMP_ENTRIES; cnt++)
 	{
 		if(temp[cnt].private_ip == 0 &&
 			 temp[cnt].target_ip == 0)
 		{
 			memcpy(&temp[cnt], new_entry, sizeof(nat_table_entry));
+			pthread_mutex_unlock(&temp_lock);
 			IPACMDBG("Added Temp Entry\n");
 			return;
 		}
 	}
+	pthread_mutex_unlock(&temp_lock);
 
 	IPACMDBG("unable to add temp entry, cache full\n");
 	return;
@@ -717,6 +1289,7 @@ void NatApp::DeleteTempEntry(const nat_table_entry *entry)
 	IPACMDBG("Private Port: %d\t Target Port: %d\t", entry->private_port, entry->target_port);
 	IPACMDBG("protocolcol: %d\n", entry->protocol);
 
+	pthread_mutex_lock(&temp_lock);
 	for(cnt=0; cnt<MAX_TEMP_ENTRIES; cnt++)
 	{
 		if(temp[cnt].private_ip == entry->private_ip &&
@@ -726,10 +1299,12 @@ void NatApp::DeleteTempEntry(const nat_table_entry *entry)
 			 temp[cnt].protocol == entry->protocol)
 		{
 			memset(&temp[cnt], 0, sizeof(nat_table_entry));
+			pthread_mutex_unlock(&temp_lock);
 			IPACMDBG("Delete Temp Entry\n");
 			return;
 		}
 	}
+	pthread_mutex_unlock(&temp_lock);
 
 	IPACMDBG("No Such Entry exists\n");
 	return;
@@ -737,39 +1312,46 @@ void NatApp::DeleteTempEntry(const nat_table_entry *entry)
 
 void NatApp::FlushTempEntries(uint32_t ip_addr, bool isAdd)
 {
-	int cnt;
+	nat_table_entry flush[MAX_TEMP_ENTRIES];
+	int cnt, num_flush = 0;
 	int ret;
 
 	IPACMDBG("Received below with isAdd:%d\n", isAdd);
 	iptodot("IP Address:", ip_addr);
 
+	/* Take the entries out first, AddEntry() locks the cache shards */
+	pthread_mutex_lock(&temp_lock);
 	for(cnt=0; cnt<MAX_TEMP_ENTRIES; cnt++)
 	{
 		if(temp[cnt].private_ip == ip_addr ||
 			 temp[cnt].target_ip == ip_addr)
 		{
-			if(isAdd)
+			if(isAdd && temp[cnt].public_ip == pub_ip_addr)
 			{
-				if(temp[cnt].public_ip == pub_ip_addr)
-				{
-					ret = AddEntry(&temp[cnt]);
-					if(ret)
-					{
-						IPACMERR("unable to add temp entry: %d\n", ret);
-						continue;
-					}
-				}
+				memcpy(&flush[num_flush++], &temp[cnt], sizeof(nat_table_entry));
 			}
 			memset(&temp[cnt], 0, sizeof(nat_table_entry));
 		}
 	}
+	pthread_mutex_unlock(&temp_lock);
+
+	for(cnt=0; cnt<num_flush; cnt++)
+	{
+		ret = AddEntry(&flush[cnt]);
+		if(ret)
+		{
+			IPACMERR("unable to add temp entry: %d\n", ret);
+			/* keep it for the next flush */
+			AddTempEntry(&flush[cnt]);
+		}
+	}
 
 	return;
 }
 
 int NatApp::DelEntriesOnClntDiscon(uint32_t ip_addr)
 {
- 	int cnt, tmp = curCnt;
+	int cnt, idx, shard;
 	IPACMDBG("Received IP address: 0x%x\n", ip_addr);
 
 	if(ip_addr == INVALID_IP_ADDR)
@@ -778,44 +1360,45 @@ int NatApp::DelEntriesOnClntDiscon(uint32_t ip_addr)
 		return -1;
 	}
 
+	LockAllShards();
+	for(cnt = 0; cnt < IPA_MAX_NUM_WIFI_CLIENTS; cnt++)
+	{
+		if(PwrSaveIfs[cnt] == ip_addr)
+		{
+			PwrSaveIfs[cnt] = 0;
+			IPACMDBG("Remove %d power save entry\n", cnt);
+			break;
+		}
+	}
 
-  for(cnt = 0; cnt < IPA_MAX_NUM_WIFI_CLIENTS; cnt++)
-  {
-    if(PwrSaveIfs[cnt] == ip_addr)
-    {
-      PwrSaveIfs[cnt] = 0;
-      IPACMDBG("Remove %d power save entry\n", cnt);
-      break;
-    }
-  }
-
-  for(cnt = 0; cnt < max_entries; cnt++)
-  {
-	if(cache[cnt].private_ip == ip_addr)
+	for(shard = 0; shard < NAT_CACHE_SHARDS; shard++)
 	{
-		if(cache[cnt].enabled == true)
-      		{
-			if(ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl) < 0)
+		for(idx = 0; idx < shards[shard].curCnt; idx++)
+		{
+			cnt = shards[shard].active[idx];
+			if(cache[cnt].private_ip == ip_addr)
 			{
-				IPACMERR("unable to delete the rule\n");
-				continue;
+				if(cache[cnt].enabled == true)
+				{
+					if(DelHwRule(cnt) < 0)
+					{
+						IPACMERR("unable to delete the rule\n");
+						continue;
+					}
+					cache[cnt].enabled = false;
+				}
+				IPACMDBG("won't delete the rule for entry %d, enabled %d\n",cnt, cache[cnt].enabled);
 			}
-			else
-			{
-				IPACMDBG("won't delete the rule\n");
-				cache[cnt].enabled = false;
-		        }
-	        }
-		IPACMDBG("won't delete the rule for entry %d, enabled %d\n",cnt, cache[cnt].enabled);
+		}
 	}
-  }
-  IPACMDBG("Deleted %d entries\n", (tmp - curCnt));
-  return 0;
+	UnlockAllShards();
+
+	return 0;
 }
 
 int NatApp::DelEntriesOnSTAClntDiscon(uint32_t ip_addr)
 {
-	int cnt, tmp = curCnt;
+	int cnt, idx, shard, num_del = 0;
 	IPACMDBG("Received IP address: 0x%x\n", ip_addr);
 
 	if(ip_addr == INVALID_IP_ADDR)
@@ -824,32 +1407,41 @@ int NatApp::DelEntriesOnSTAClntDiscon(uint32_t ip_addr)
 		return -1;
 	}
 
-
-	for(cnt = 0; cnt < max_entries; cnt++)
+	LockAllShards();
+	for(shard = 0; shard < NAT_CACHE_SHARDS; shard++)
 	{
-		if(cache[cnt].target_ip == ip_addr)
+		/* Walk backwards so FreeEntry() can compact active[] under us */
+		for(idx = shards[shard].curCnt - 1; idx >= 0; idx--)
 		{
-			if(cache[cnt].enabled == true)
+			cnt = shards[shard].active[idx];
+			if(cache[cnt].target_ip == ip_addr)
 			{
-				if(ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl) < 0)
+				if(cache[cnt].enabled == true)
 				{
-					IPACMERR("unable to delete the rule\n");
-					continue;
+					if(DelHwRule(cnt) < 0)
+					{
+						IPACMERR("unable to delete the rule\n");
+						continue;
+					}
 				}
-			}
 
-			memset(&cache[cnt], 0, sizeof(cache[cnt]));
-			curCnt--;
+				FreeEntry(cnt);
+				num_del++;
+			}
 		}
 	}
+	UnlockAllShards();
 
-	IPACMDBG("Deleted %d entries\n", (tmp - curCnt));
+	IPACMDBG("Deleted %d entries\n", num_del);
 	return 0;
 }
 
 void NatApp::CacheEntry(const nat_table_entry *rule)
 {
 	int cnt;
+	uint32_t hash;
+	nat_cache_shard *shard;
+
 	if(rule->private_ip == 0 ||
 		 rule->target_ip == 0 ||
 		 rule->private_port == 0  ||
@@ -860,44 +1452,21 @@ void NatApp::CacheEntry(const nat_table_entry *rule)
 		return;
 	}
 
-	if(!ChkForDup(rule))
+	hash = HashEntry(rule);
+	shard = GetShard(hash);
+	pthread_mutex_lock(&shard->lock);
+	if(ChkForDup(shard, hash, rule))
 	{
-		for(; cnt < max_entries; cnt++)
-		{
-			if(cache[cnt].private_ip == 0 &&
-				 cache[cnt].target_ip == 0 &&
-				 cache[cnt].private_port == 0  &&
-				 cache[cnt].target_port == 0 &&
-				 cache[cnt].protocol == 0)
-			{
-				break;
-			}
-		}
-
-		if(max_entries == cnt)
-		{
-			IPACMERR("Error: Unable to add, reached maximum rules\n");
-			return;
-		}
-		else
-		{
-			cache[cnt].enabled = false;
-			cache[cnt].rule_hdl = 0;
-			cache[cnt].private_ip = rule->private_ip;
-			cache[cnt].target_ip = rule->target_ip;
-			cache[cnt].target_port = rule->target_port;
-			cache[cnt].private_port = rule->private_port;
-			cache[cnt].protocol = rule->protocol;
-			cache[cnt].timestamp = 0;
-			cache[cnt].public_port = rule->public_port;
-			cache[cnt].dst_nat = rule->dst_nat;
-			curCnt++;
-		}
-
+		pthread_mutex_unlock(&shard->lock);
+		IPACMERR("Duplicate rule. Ignore it\n");
+		return;
 	}
-	else
+
+	cnt = AllocEntry(shard, hash, rule);
+	pthread_mutex_unlock(&shard->lock);
+	if(cnt == NAT_CACHE_INVALID_SLOT)
 	{
-		IPACMERR("Duplicate rule. Ignore it\n");
+		IPACMERR("Error: Unable to add, reached maximum rules\n");
 		return;
 	}
 
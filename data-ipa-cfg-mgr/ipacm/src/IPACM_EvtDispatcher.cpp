@@ -37,6 +37,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 */
 #include <string.h>
+#include <time.h>
 #include <pthread.h>
 #include <IPACM_EvtDispatcher.h>
 #include <IPACM_Neighbor.h>
@@ -44,18 +45,25 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Defs.h"
 
 
-extern pthread_mutex_t mutex;
-extern pthread_cond_t  cond_var;
-
-cmd_evts *IPACM_EvtDispatcher::head = NULL;
+cmd_evts IPACM_EvtDispatcher::evts[IPACM_EVENT_MAX];
+int IPACM_EvtDispatcher::cur_evt = IPACM_EVENT_MAX;
 extern uint32_t ipacm_event_stats[IPACM_EVENT_MAX];
+extern uint32_t ipacm_event_latency[IPACM_EVENT_MAX][IPACM_EVT_LAT_BUCKETS];
+
+static uint64_t get_time_us(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
 
 int IPACM_EvtDispatcher::PostEvt
 (
 	 ipacm_cmd_q_data *data
 )
 {
-	Message *item = NULL;
+	cmd_t evt;
 	MessageQueue *MsgQueue = NULL;
 
 	MsgQueue = MessageQueue::getInstance();
@@ -65,72 +73,72 @@ int IPACM_EvtDispatcher::PostEvt
 		return IPACM_FAILURE;
 	}
 
-	item = new Message();
-	if(item == NULL)
-	{
-		IPACMERR("unable to create new message item\n");
-		return IPACM_FAILURE;
-	}
-
 	IPACMDBG("Populating item to post to queue\n");
-	item->evt.callback_ptr = IPACM_EvtDispatcher::ProcessEvt;
-	memcpy(&item->evt.data, data, sizeof(ipacm_cmd_q_data));
+	evt.callback_ptr = IPACM_EvtDispatcher::ProcessEvt;
+	memcpy(&evt.data, data, sizeof(ipacm_cmd_q_data));
 
-	if(pthread_mutex_lock(&mutex) != 0)
+	if(MsgQueue->enqueue(&evt) != IPACM_SUCCESS)
 	{
-		IPACMERR("unable to lock the mutex\n");
-		return IPACM_FAILURE;
-	}
-
-	IPACMDBG("Enqueing item\n");
-	MsgQueue->enqueue(item);
-	IPACMDBG("Enqueued item %p\n", item);
-
-	if(pthread_cond_signal(&cond_var) != 0)
-	{
-		IPACMDBG("unable to lock the mutex\n");
-		/* Release the mutex before you return failure */
-		if(pthread_mutex_unlock(&mutex) != 0)
-		{
-			IPACMERR("unable to unlock the mutex\n");
-			return IPACM_FAILURE;
-		}
-		return IPACM_FAILURE;
-	}
-
-	if(pthread_mutex_unlock(&mutex) != 0)
-	{
-		IPACMERR("unable to unlock the mutex\n");
+		IPACMERR("unable to enqueue event %d\n", data->event);
 		return IPACM_FAILURE;
 	}
+	IPACMDBG("Enqueued event %d\n", data->event);
 
 	return IPACM_SUCCESS;
 }
 
 void IPACM_EvtDispatcher::ProcessEvt(ipacm_cmd_q_data *data)
 {
+	cmd_evts *list;
+	IPACM_Listener *obj;
+	uint64_t start, delta;
+	int cnt, bucket;
 
-	cmd_evts *tmp = head, tmp1;
+	if(data->event >= IPACM_EVENT_MAX)
+	{
+		IPACMERR("invalid event:%d\n", data->event);
+		goto free_data;
+	}
 
-	if(head == NULL)
+	list = &evts[data->event];
+	if(list->num == 0)
 	{
-		IPACMDBG("Queue is empty\n");
+		IPACMDBG("No listener for event:%d\n", data->event);
 	}
 
-	while(tmp != NULL)
+	cur_evt = data->event;
+	/* num is re-read so listeners registered by a callback still get
+		 this event, as with the old list walk */
+	for(cnt = 0; cnt < list->num; cnt++)
 	{
-	        memcpy(&tmp1, tmp, sizeof(tmp1));
-		if(data->event == tmp1.event)
+		obj = list->obj[cnt];
+		if(obj == NULL)
 		{
-			ipacm_event_stats[data->event]++;
-			tmp1.obj->event_callback(data->event, data->evt_data);
-			IPACMDBG(" Find matched registered events\n");
+			continue;
 		}
-	        tmp = tmp1.next;
+
+		ipacm_event_stats[data->event]++;
+		start = get_time_us();
+		obj->event_callback(data->event, data->evt_data);
+		delta = get_time_us() - start;
+
+		for(bucket = 0; bucket < IPACM_EVT_LAT_BUCKETS - 1 && delta != 0; bucket++)
+		{
+			delta >>= 1;
+		}
+		ipacm_event_latency[data->event][bucket]++;
+		IPACMDBG(" Find matched registered events\n");
+	}
+	cur_evt = IPACM_EVENT_MAX;
+
+	if(list->dirty)
+	{
+		compact(list);
 	}
 
 	IPACMDBG(" Finished process events\n");
-			
+
+free_data:
 	if(data->evt_data != NULL)
 	{
 		IPACMDBG("free the event:%d data: %p\n", data->event, data->evt_data);
@@ -139,67 +147,82 @@ void IPACM_EvtDispatcher::ProcessEvt(ipacm_cmd_q_data *data)
 	return;
 }
 
-int IPACM_EvtDispatcher::registr(ipa_cm_event_id event, IPACM_Listener *obj)
+/* Drop the NULL slots left by deregistr() during dispatch */
+void IPACM_EvtDispatcher::compact(cmd_evts *list)
 {
-	cmd_evts *tmp = head,*nw;
+	int cnt, num = 0;
 
-	nw = (cmd_evts *)malloc(sizeof(cmd_evts));
-	if(nw != NULL)
+	for(cnt = 0; cnt < list->num; cnt++)
 	{
-		nw->event = event;
-		nw->obj = obj;
-		nw->next = NULL;
+		if(list->obj[cnt] != NULL)
+		{
+			list->obj[num++] = list->obj[cnt];
+		}
 	}
-	else
+	list->num = num;
+	list->dirty = false;
+}
+
+int IPACM_EvtDispatcher::registr(ipa_cm_event_id event, IPACM_Listener *obj)
+{
+	cmd_evts *list;
+	IPACM_Listener **tmp;
+	int size;
+
+	if(event >= IPACM_EVENT_MAX)
 	{
+		IPACMERR("invalid event:%d\n", event);
 		return IPACM_FAILURE;
 	}
 
-	if(head == NULL)
-	{
-		head = nw;
-	}
-	else
+	list = &evts[event];
+	if(list->num == list->size)
 	{
-		while(tmp->next)
+		size = (list->size == 0) ? 4 : list->size * 2;
+		tmp = (IPACM_Listener **)realloc(list->obj, sizeof(IPACM_Listener *) * size);
+		if(tmp == NULL)
 		{
-			tmp = tmp->next;
+			return IPACM_FAILURE;
 		}
-		tmp->next = nw;
+		list->obj = tmp;
+		list->size = size;
 	}
+
+	list->obj[list->num++] = obj;
 	return IPACM_SUCCESS;
 }
 
 
 int IPACM_EvtDispatcher::deregistr(IPACM_Listener *param)
 {
-	cmd_evts *tmp = head,*tmp1,*prev = head;
+	cmd_evts *list;
+	int evt, cnt;
+	bool found;
 
-	while(tmp != NULL)
+	for(evt = 0; evt < IPACM_EVENT_MAX; evt++)
 	{
-		if(tmp->obj == param)
+		list = &evts[evt];
+		found = false;
+		for(cnt = 0; cnt < list->num; cnt++)
 		{
-			tmp1 = tmp;
-			if(tmp == head)
+			if(list->obj[cnt] == param)
 			{
-				head = head->next;
+				list->obj[cnt] = NULL;
+				found = true;
 			}
-			else if(tmp->next == NULL)
+		}
+
+		if(found)
+		{
+			/* Keep indexes stable under a running dispatch loop */
+			if(evt == cur_evt)
 			{
-				prev->next = NULL;
+				list->dirty = true;
 			}
 			else
 			{
-				prev->next = tmp->next;
+				compact(list);
 			}
-
-			tmp = tmp->next;
-			free(tmp1);
-		}
-		else
-		{
-			prev = tmp;
-			tmp = tmp->next;
 		}
 	}
 	return IPACM_SUCCESS;
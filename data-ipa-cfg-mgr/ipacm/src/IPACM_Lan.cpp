@@ -67,6 +67,7 @@ hdr_proc_ctx_info IPACM_Lan::wlan_to_wlan_hdr_proc_ctx;
 
 eth_bridge_subnet_client_info IPACM_Lan::eth_bridge_wlan_client[IPA_LAN_TO_LAN_MAX_WLAN_CLIENT];
 eth_bridge_subnet_client_info IPACM_Lan::eth_bridge_usb_client[IPA_LAN_TO_LAN_MAX_USB_CLIENT];
+IPACM_MacIndex IPACM_Lan::eth_bridge_wlan_client_idx;
 
 int IPACM_Lan::num_wlan_client = 0;
 int IPACM_Lan::num_usb_client = 0;
@@ -163,6 +164,9 @@ IPACM_Lan::IPACM_Lan(int iface_index) : IPACM_Iface(iface_index)
 	memset(tcp_ctl_flt_rule_hdl_v4, 0, NUM_TCP_CTL_FLT_RULE*sizeof(uint32_t));
 	memset(tcp_ctl_flt_rule_hdl_v6, 0, NUM_TCP_CTL_FLT_RULE*sizeof(uint32_t));
 	is_mode_switch = false;
+	stats_ul_pipe_mask = 0;
+	stats_dl_pipe_mask = 0;
+	stats_pipe_mask_valid = false;
 	if_ipv4_subnet =0;
 	memset(private_fl_rule_hdl, 0, IPA_MAX_PRIVATE_SUBNET_ENTRIES * sizeof(uint32_t));
 	memset(ipv6_prefix_flt_rule_hdl, 0, NUM_IPV6_PREFIX_FLT_RULE * sizeof(uint32_t));
@@ -226,6 +230,7 @@ IPACM_Lan::IPACM_Lan(int iface_index) : IPACM_Iface(iface_index)
 
 	memset(eth_bridge_wlan_client_flt_info, 0, IPA_LAN_TO_LAN_MAX_WLAN_CLIENT * sizeof(eth_bridge_client_flt_info));
 	wlan_client_flt_info_count = 0;
+	wlan_client_flt_info_idx.Reset();
 	eth_bridge_usb_client_rt_info_v4 = NULL;
 	eth_bridge_usb_client_rt_info_v6 = NULL;
 #ifdef FEATURE_ETH_BRIDGE_LE
@@ -431,15 +436,20 @@ void IPACM_Lan::event_callback(ipa_cm_event_id event, void *param)
 						{
 							if((data->iptype == IPA_IP_v6 || data->iptype == IPA_IP_MAX) && num_dft_rt_v6 == 1)
 							{
-								install_ipv6_prefix_flt_rule(IPACM_Wan::backhaul_ipv6_prefix);
+								IPACM_RuleTxn txn(&m_filtering, &m_routing, &m_header);
+
+								/* STA mode: the prefix and default rule go in with one commit */
+								install_ipv6_prefix_flt_rule(IPACM_Wan::backhaul_ipv6_prefix, &txn);
 								if(IPACM_Wan::backhaul_is_sta_mode == false)
 								{
+									txn.Commit();
 									ext_prop = IPACM_Iface::ipacmcfg->GetExtProp(IPA_IP_v6);
 									handle_wan_up_ex(ext_prop, IPA_IP_v6);
 								}
 								else
 								{
-									handle_wan_up(IPA_IP_v6);
+									handle_wan_up(IPA_IP_v6, &txn);
+									txn.Commit();
 								}
 							}
 						}
@@ -533,15 +543,20 @@ void IPACM_Lan::event_callback(ipa_cm_event_id event, void *param)
 		{
 			if(ip_type == IPA_IP_v6 || ip_type == IPA_IP_MAX)
 			{
-					install_ipv6_prefix_flt_rule(data_wan_tether->ipv6_prefix);
+					IPACM_RuleTxn txn(&m_filtering, &m_routing, &m_header);
+
+					/* STA mode: the prefix and default rule go in with one commit */
+					install_ipv6_prefix_flt_rule(data_wan_tether->ipv6_prefix, &txn);
 					if(data_wan_tether->is_sta == false)
 					{
+						txn.Commit();
 						ext_prop = IPACM_Iface::ipacmcfg->GetExtProp(IPA_IP_v6);
 						handle_wan_up_ex(ext_prop, IPA_IP_v6);
 					}
 					else
 					{
-						handle_wan_up(IPA_IP_v6);
+						handle_wan_up(IPA_IP_v6, &txn);
+						txn.Commit();
 					}
 			}
 		}
@@ -628,15 +643,20 @@ void IPACM_Lan::event_callback(ipa_cm_event_id event, void *param)
 		IPACMDBG_H("Backhaul is sta mode?%d\n", data_wan->is_sta);
 		if(ip_type == IPA_IP_v6 || ip_type == IPA_IP_MAX)
 		{
-			install_ipv6_prefix_flt_rule(data_wan->ipv6_prefix);
+			IPACM_RuleTxn txn(&m_filtering, &m_routing, &m_header);
+
+			/* STA mode: the prefix and default rule go in with one commit */
+			install_ipv6_prefix_flt_rule(data_wan->ipv6_prefix, &txn);
 		if(data_wan->is_sta == false)
 		{
+				txn.Commit();
 				ext_prop = IPACM_Iface::ipacmcfg->GetExtProp(IPA_IP_v6);
 				handle_wan_up_ex(ext_prop, IPA_IP_v6);
 			}
 		else
 		{
-			handle_wan_up(IPA_IP_v6);
+			handle_wan_up(IPA_IP_v6, &txn);
+			txn.Commit();
 		}
 		}
 		break;
@@ -1241,11 +1261,12 @@ int IPACM_Lan::handle_private_subnet(ipa_ip_type iptype)
 
 
 /* for STA mode wan up:  configure filter rule for wan_up event*/
-int IPACM_Lan::handle_wan_up(ipa_ip_type ip_type)
+int IPACM_Lan::handle_wan_up(ipa_ip_type ip_type, IPACM_RuleTxn *txn)
 {
 	struct ipa_flt_rule_add flt_rule_entry;
-	int len = 0;
-	ipa_ioc_add_flt_rule *m_pFilteringTable;
+	IPACM_RuleTxn own_txn(&m_filtering, &m_routing, &m_header);
+	bool commit = (txn == NULL);
+	uint32_t *rule_hdl;
 
 	IPACMDBG_H("set WAN interface as default filter rule\n");
 
@@ -1255,107 +1276,51 @@ int IPACM_Lan::handle_wan_up(ipa_ip_type ip_type)
 		return IPACM_SUCCESS;
 	}
 
-	if(ip_type == IPA_IP_v4)
+	if (txn == NULL)
 	{
-		len = sizeof(struct ipa_ioc_add_flt_rule) + (1 * sizeof(struct ipa_flt_rule_add));
-		m_pFilteringTable = (struct ipa_ioc_add_flt_rule *)calloc(1, len);
-		if (m_pFilteringTable == NULL)
-		{
-			PERROR("Error Locate ipa_flt_rule_add memory...\n");
-			return IPACM_FAILURE;
-		}
+		txn = &own_txn;
+	}
 
-		m_pFilteringTable->commit = 1;
-		m_pFilteringTable->ep = rx_prop->rx[0].src_pipe;
-		m_pFilteringTable->global = false;
-		m_pFilteringTable->ip = IPA_IP_v4;
-		m_pFilteringTable->num_rules = (uint8_t)1;
+	memset(&flt_rule_entry, 0, sizeof(struct ipa_flt_rule_add)); // Zero All Fields
+	flt_rule_entry.at_rear = true;
+	flt_rule_entry.flt_rule_hdl = -1;
+	flt_rule_entry.status = -1;
+
+	memcpy(&flt_rule_entry.rule.attrib,
+				 &rx_prop->rx[0].attrib,
+				 sizeof(flt_rule_entry.rule.attrib));
+	flt_rule_entry.rule.attrib.attrib_mask |= IPA_FLT_DST_ADDR;
 
+	if(ip_type == IPA_IP_v4)
+	{
 		IPACMDBG_H("Retrieving routing hanle for table: %s\n",
 						 IPACM_Iface::ipacmcfg->rt_tbl_wan_v4.name);
 		if (false == m_routing.GetRoutingTable(&IPACM_Iface::ipacmcfg->rt_tbl_wan_v4))
 		{
 			IPACMERR("m_routing.GetRoutingTable(&IPACM_Iface::ipacmcfg->rt_tbl_wan_v4=0x%p) Failed.\n",
 							 &IPACM_Iface::ipacmcfg->rt_tbl_wan_v4);
-			free(m_pFilteringTable);
 			return IPACM_FAILURE;
 		}
 		IPACMDBG_H("Routing hanle for table: %d\n", IPACM_Iface::ipacmcfg->rt_tbl_wan_v4.hdl);
 
-
-		memset(&flt_rule_entry, 0, sizeof(struct ipa_flt_rule_add)); // Zero All Fields
-		flt_rule_entry.at_rear = true;
-		flt_rule_entry.flt_rule_hdl = -1;
-		flt_rule_entry.status = -1;
 		flt_rule_entry.rule.action = IPA_PASS_TO_SRC_NAT; //IPA_PASS_TO_ROUTING
 		flt_rule_entry.rule.rt_tbl_hdl = IPACM_Iface::ipacmcfg->rt_tbl_wan_v4.hdl;
-
-		memcpy(&flt_rule_entry.rule.attrib,
-					 &rx_prop->rx[0].attrib,
-					 sizeof(flt_rule_entry.rule.attrib));
-
-		flt_rule_entry.rule.attrib.attrib_mask |= IPA_FLT_DST_ADDR;
 		flt_rule_entry.rule.attrib.u.v4.dst_addr_mask = 0x0;
 		flt_rule_entry.rule.attrib.u.v4.dst_addr = 0x0;
 
-		memcpy(&m_pFilteringTable->rules[0], &flt_rule_entry, sizeof(flt_rule_entry));
-		if (false == m_filtering.AddFilteringRule(m_pFilteringTable))
-		{
-			IPACMERR("Error Adding RuleTable(0) to Filtering, aborting...\n");
-			free(m_pFilteringTable);
-			return IPACM_FAILURE;
-		}
-		else
-		{
-			IPACMDBG_H("flt rule hdl0=0x%x, status=0x%x\n",
-							 m_pFilteringTable->rules[0].flt_rule_hdl,
-							 m_pFilteringTable->rules[0].status);
-		}
-
-
-		/* copy filter hdls  */
-		lan_wan_fl_rule_hdl[0] = m_pFilteringTable->rules[0].flt_rule_hdl;
-		free(m_pFilteringTable);
+		rule_hdl = &lan_wan_fl_rule_hdl[0];
 	}
 	else if(ip_type == IPA_IP_v6)
 	{
 		/* add default v6 filter rule */
-		m_pFilteringTable = (struct ipa_ioc_add_flt_rule *)
-			 calloc(1, sizeof(struct ipa_ioc_add_flt_rule) +
-					1 * sizeof(struct ipa_flt_rule_add));
-
-		if (!m_pFilteringTable)
-		{
-			PERROR("Error Locate ipa_flt_rule_add memory...\n");
-			return IPACM_FAILURE;
-		}
-
-		m_pFilteringTable->commit = 1;
-		m_pFilteringTable->ep = rx_prop->rx[0].src_pipe;
-		m_pFilteringTable->global = false;
-		m_pFilteringTable->ip = IPA_IP_v6;
-		m_pFilteringTable->num_rules = (uint8_t)1;
-
 		if (false == m_routing.GetRoutingTable(&IPACM_Iface::ipacmcfg->rt_tbl_v6))
 		{
 			IPACMERR("m_routing.GetRoutingTable(&IPACM_Iface::ipacmcfg->rt_tbl_v6=0x%p) Failed.\n", &IPACM_Iface::ipacmcfg->rt_tbl_v6);
-			free(m_pFilteringTable);
 			return IPACM_FAILURE;
 		}
 
-		memset(&flt_rule_entry, 0, sizeof(struct ipa_flt_rule_add));
-
-		flt_rule_entry.at_rear = true;
-		flt_rule_entry.flt_rule_hdl = -1;
-		flt_rule_entry.status = -1;
 		flt_rule_entry.rule.action = IPA_PASS_TO_ROUTING;
-			flt_rule_entry.rule.rt_tbl_hdl = IPACM_Iface::ipacmcfg->rt_tbl_v6.hdl;
-
-		memcpy(&flt_rule_entry.rule.attrib,
-					 &rx_prop->rx[0].attrib,
-					 sizeof(flt_rule_entry.rule.attrib));
-
-		flt_rule_entry.rule.attrib.attrib_mask |= IPA_FLT_DST_ADDR;
+		flt_rule_entry.rule.rt_tbl_hdl = IPACM_Iface::ipacmcfg->rt_tbl_v6.hdl;
 		flt_rule_entry.rule.attrib.u.v6.dst_addr_mask[0] = 0x00000000;
 		flt_rule_entry.rule.attrib.u.v6.dst_addr_mask[1] = 0x00000000;
 		flt_rule_entry.rule.attrib.u.v6.dst_addr_mask[2] = 0x00000000;
@@ -1365,21 +1330,29 @@ int IPACM_Lan::handle_wan_up(ipa_ip_type ip_type)
 		flt_rule_entry.rule.attrib.u.v6.dst_addr[2] = 0x00000000;
 		flt_rule_entry.rule.attrib.u.v6.dst_addr[3] = 0X00000000;
 
-		memcpy(&(m_pFilteringTable->rules[0]), &flt_rule_entry, sizeof(struct ipa_flt_rule_add));
-		if (false == m_filtering.AddFilteringRule(m_pFilteringTable))
+		rule_hdl = &dft_v6fl_rule_hdl[IPV6_DEFAULT_FILTERTING_RULES];
+	}
+	else
+	{
+		return IPACM_SUCCESS;
+	}
+
+	/* the handle is filled in when the txn commits */
+	if (false == txn->AddFltRule(ip_type, rx_prop->rx[0].src_pipe, false, &flt_rule_entry, rule_hdl))
+	{
+		IPACMERR("Error queueing filtering rule, aborting...\n");
+		txn->Abort();
+		return IPACM_FAILURE;
+	}
+
+	if (commit)
+	{
+		if (false == own_txn.Commit())
 		{
 			IPACMERR("Error Adding Filtering rule, aborting...\n");
-			free(m_pFilteringTable);
 			return IPACM_FAILURE;
 		}
-		else
-		{
-			IPACMDBG_H("flt rule hdl0=0x%x, status=0x%x\n", m_pFilteringTable->rules[0].flt_rule_hdl, m_pFilteringTable->rules[0].status);
-		}
-
-		/* copy filter hdls */
-		dft_v6fl_rule_hdl[IPV6_DEFAULT_FILTERTING_RULES] = m_pFilteringTable->rules[0].flt_rule_hdl;
-		free(m_pFilteringTable);
+		IPACMDBG_H("flt rule hdl0=0x%x\n", *rule_hdl);
 	}
 
 	return IPACM_SUCCESS;
@@ -1793,11 +1766,10 @@ int IPACM_Lan::handle_eth_client_ipaddr(ipacm_event_data_all *data)
 /*handle eth client routing rule*/
 int IPACM_Lan::handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptype)
 {
-	struct ipa_ioc_add_rt_rule *rt_rule;
-	struct ipa_rt_rule_add *rt_rule_entry;
+	struct ipa_rt_rule_add rt_rule_entry;
+	IPACM_RuleTxn txn(&m_filtering, &m_routing, &m_header);
 	uint32_t tx_index;
 	int eth_index,v6_num;
-	const int NUM = 1;
 
 	if(tx_prop == NULL)
 	{
@@ -1842,20 +1814,8 @@ int IPACM_Lan::handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptyp
 			IPACMDBG_H("depend Got pipe %d rm index : %d \n", tx_prop->tx[0].dst_pipe, IPACM_Iface::ipacmcfg->ipa_client_rm_map_tbl[tx_prop->tx[0].dst_pipe]);
 			IPACM_Iface::ipacmcfg->AddRmDepend(IPACM_Iface::ipacmcfg->ipa_client_rm_map_tbl[tx_prop->tx[0].dst_pipe],false);
 		}
-		rt_rule = (struct ipa_ioc_add_rt_rule *)
-			 calloc(1, sizeof(struct ipa_ioc_add_rt_rule) +
-						NUM * sizeof(struct ipa_rt_rule_add));
-
-		if (rt_rule == NULL)
-		{
-			PERROR("Error Locate ipa_ioc_add_rt_rule memory...\n");
-			return IPACM_FAILURE;
-		}
-
-		rt_rule->commit = 1;
-		rt_rule->num_rules = (uint8_t)NUM;
-		rt_rule->ip = iptype;
 
+		/* queue the rules of all tx props, they go down in one ioctl per table */
 		for (tx_index = 0; tx_index < iface_query->num_tx_props; tx_index++)
 		{
 			if(iptype != tx_prop->tx[tx_index].ip)
@@ -1865,8 +1825,8 @@ int IPACM_Lan::handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptyp
 		   	        continue;
 		    }
 
-  	   	    rt_rule_entry = &rt_rule->rules[0];
-			rt_rule_entry->at_rear = 0;
+			memset(&rt_rule_entry, 0, sizeof(rt_rule_entry));
+			rt_rule_entry.at_rear = 0;
 
 			if (iptype == IPA_IP_v4)
 			{
@@ -1876,37 +1836,29 @@ int IPACM_Lan::handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptyp
                 IPACMDBG_H("client(%d): v4 header handle:(0x%x)\n",
 		  				 eth_index,
 		  				 get_client_memptr(eth_client, eth_index)->hdr_hdl_v4);
-				strncpy(rt_rule->rt_tbl_name,
-								IPACM_Iface::ipacmcfg->rt_tbl_lan_v4.name,
-								sizeof(rt_rule->rt_tbl_name));
 
-
-			    rt_rule_entry->rule.dst = tx_prop->tx[tx_index].dst_pipe;
-			    memcpy(&rt_rule_entry->rule.attrib,
+			    rt_rule_entry.rule.dst = tx_prop->tx[tx_index].dst_pipe;
+			    memcpy(&rt_rule_entry.rule.attrib,
 						 &tx_prop->tx[tx_index].attrib,
-						 sizeof(rt_rule_entry->rule.attrib));
-			    rt_rule_entry->rule.attrib.attrib_mask |= IPA_FLT_DST_ADDR;
-		   	    rt_rule_entry->rule.hdr_hdl = get_client_memptr(eth_client, eth_index)->hdr_hdl_v4;
-				rt_rule_entry->rule.attrib.u.v4.dst_addr = get_client_memptr(eth_client, eth_index)->v4_addr;
-				rt_rule_entry->rule.attrib.u.v4.dst_addr_mask = 0xFFFFFFFF;
+						 sizeof(rt_rule_entry.rule.attrib));
+			    rt_rule_entry.rule.attrib.attrib_mask |= IPA_FLT_DST_ADDR;
+		   	    rt_rule_entry.rule.hdr_hdl = get_client_memptr(eth_client, eth_index)->hdr_hdl_v4;
+				rt_rule_entry.rule.attrib.u.v4.dst_addr = get_client_memptr(eth_client, eth_index)->v4_addr;
+				rt_rule_entry.rule.attrib.u.v4.dst_addr_mask = 0xFFFFFFFF;
 
 				/* Replace the v4 header in ODU interface */
 				if (IPACM_Iface::ipacmcfg->iface_table[ipa_if_num].if_cat == ODU_IF)
-				rt_rule_entry->rule.hdr_hdl = ODU_hdr_hdl_v4;
+				rt_rule_entry.rule.hdr_hdl = ODU_hdr_hdl_v4;
 
-			    if (false == m_routing.AddRoutingRule(rt_rule))
+			    /* ipv4 RT hdl is copied on commit */
+			    if (false == txn.AddRtRule(IPA_IP_v4, IPACM_Iface::ipacmcfg->rt_tbl_lan_v4.name, &rt_rule_entry,
+						&get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v4))
   	            {
   	          	            IPACMERR("Routing rule addition failed!\n");
-  	          	            free(rt_rule);
+  	          	            txn.Abort();
   	          	            return IPACM_FAILURE;
 			    }
 
-			    /* copy ipv4 RT hdl */
-		        get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v4 =
-  	   	        rt_rule->rules[0].rt_rule_hdl;
-		        IPACMDBG_H("tx:%d, rt rule hdl=%x ip-type: %d\n", tx_index,
-		      	get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v4, iptype);
-
   	   	    } else {
 
 		        for(v6_num = get_client_memptr(eth_client, eth_index)->route_rule_set_v6;v6_num < get_client_memptr(eth_client, eth_index)->ipv6_set;v6_num++)
@@ -1915,77 +1867,68 @@ int IPACM_Lan::handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptyp
 		  	    			 eth_index,
 		  	    			 get_client_memptr(eth_client, eth_index)->hdr_hdl_v6);
 
-		            /* v6 LAN_RT_TBL */
-			    	strncpy(rt_rule->rt_tbl_name,
-			    					IPACM_Iface::ipacmcfg->rt_tbl_v6.name,
-			    					sizeof(rt_rule->rt_tbl_name));
-
 				   /* Replace v6 header in ODU interface */
 				   if (IPACM_Iface::ipacmcfg->iface_table[ipa_if_num].if_cat == ODU_IF)
-						rt_rule_entry->rule.hdr_hdl = ODU_hdr_hdl_v6;
+						rt_rule_entry.rule.hdr_hdl = ODU_hdr_hdl_v6;
 
 		            /* Support QCMAP LAN traffic feature, send to A5 */
-					rt_rule_entry->rule.dst = IPA_CLIENT_APPS_LAN_CONS;
-			        memset(&rt_rule_entry->rule.attrib, 0, sizeof(rt_rule_entry->rule.attrib));
-		   	        rt_rule_entry->rule.hdr_hdl = 0;
-			        rt_rule_entry->rule.attrib.attrib_mask |= IPA_FLT_DST_ADDR;
-		   	        rt_rule_entry->rule.attrib.u.v6.dst_addr[0] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][0];
-		   	        rt_rule_entry->rule.attrib.u.v6.dst_addr[1] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][1];
-		   	        rt_rule_entry->rule.attrib.u.v6.dst_addr[2] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][2];
-		   	        rt_rule_entry->rule.attrib.u.v6.dst_addr[3] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][3];
-					rt_rule_entry->rule.attrib.u.v6.dst_addr_mask[0] = 0xFFFFFFFF;
-					rt_rule_entry->rule.attrib.u.v6.dst_addr_mask[1] = 0xFFFFFFFF;
-					rt_rule_entry->rule.attrib.u.v6.dst_addr_mask[2] = 0xFFFFFFFF;
-					rt_rule_entry->rule.attrib.u.v6.dst_addr_mask[3] = 0xFFFFFFFF;
-
-   	                if (false == m_routing.AddRoutingRule(rt_rule))
+					rt_rule_entry.rule.dst = IPA_CLIENT_APPS_LAN_CONS;
+			        memset(&rt_rule_entry.rule.attrib, 0, sizeof(rt_rule_entry.rule.attrib));
+		   	        rt_rule_entry.rule.hdr_hdl = 0;
+			        rt_rule_entry.rule.attrib.attrib_mask |= IPA_FLT_DST_ADDR;
+		   	        rt_rule_entry.rule.attrib.u.v6.dst_addr[0] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][0];
+		   	        rt_rule_entry.rule.attrib.u.v6.dst_addr[1] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][1];
+		   	        rt_rule_entry.rule.attrib.u.v6.dst_addr[2] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][2];
+		   	        rt_rule_entry.rule.attrib.u.v6.dst_addr[3] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][3];
+					rt_rule_entry.rule.attrib.u.v6.dst_addr_mask[0] = 0xFFFFFFFF;
+					rt_rule_entry.rule.attrib.u.v6.dst_addr_mask[1] = 0xFFFFFFFF;
+					rt_rule_entry.rule.attrib.u.v6.dst_addr_mask[2] = 0xFFFFFFFF;
+					rt_rule_entry.rule.attrib.u.v6.dst_addr_mask[3] = 0xFFFFFFFF;
+
+		            /* v6 LAN_RT_TBL */
+   	                if (false == txn.AddRtRule(IPA_IP_v6, IPACM_Iface::ipacmcfg->rt_tbl_v6.name, &rt_rule_entry,
+							&get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6[v6_num]))
   	                {
   	                	    IPACMERR("Routing rule addition failed!\n");
-  	                	    free(rt_rule);
+  	                	    txn.Abort();
   	                	    return IPACM_FAILURE;
 			        }
 
-		            get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6[v6_num] = rt_rule->rules[0].rt_rule_hdl;
-		            IPACMDBG_H("tx:%d, rt rule hdl=%x ip-type: %d\n", tx_index,
-		            				 get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6[v6_num], iptype);
-
-			        /*Copy same rule to v6 WAN RT TBL*/
-  	                strncpy(rt_rule->rt_tbl_name,
-  	                 					IPACM_Iface::ipacmcfg->rt_tbl_wan_v6.name,
-  	                 					sizeof(rt_rule->rt_tbl_name));
-
                     /* Downlink traffic from Wan iface, directly through IPA */
-					rt_rule_entry->rule.dst = tx_prop->tx[tx_index].dst_pipe;
-			        memcpy(&rt_rule_entry->rule.attrib,
+					rt_rule_entry.rule.dst = tx_prop->tx[tx_index].dst_pipe;
+			        memcpy(&rt_rule_entry.rule.attrib,
 						 &tx_prop->tx[tx_index].attrib,
-						 sizeof(rt_rule_entry->rule.attrib));
-		   	        rt_rule_entry->rule.hdr_hdl = get_client_memptr(eth_client, eth_index)->hdr_hdl_v6;
-			        rt_rule_entry->rule.attrib.attrib_mask |= IPA_FLT_DST_ADDR;
-		   	        rt_rule_entry->rule.attrib.u.v6.dst_addr[0] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][0];
-		   	        rt_rule_entry->rule.attrib.u.v6.dst_addr[1] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][1];
-		   	        rt_rule_entry->rule.attrib.u.v6.dst_addr[2] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][2];
-		   	        rt_rule_entry->rule.attrib.u.v6.dst_addr[3] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][3];
-					rt_rule_entry->rule.attrib.u.v6.dst_addr_mask[0] = 0xFFFFFFFF;
-					rt_rule_entry->rule.attrib.u.v6.dst_addr_mask[1] = 0xFFFFFFFF;
-					rt_rule_entry->rule.attrib.u.v6.dst_addr_mask[2] = 0xFFFFFFFF;
-					rt_rule_entry->rule.attrib.u.v6.dst_addr_mask[3] = 0xFFFFFFFF;
-
-		            if (false == m_routing.AddRoutingRule(rt_rule))
+						 sizeof(rt_rule_entry.rule.attrib));
+		   	        rt_rule_entry.rule.hdr_hdl = get_client_memptr(eth_client, eth_index)->hdr_hdl_v6;
+
+			        rt_rule_entry.rule.attrib.attrib_mask |= IPA_FLT_DST_ADDR;
+		   	        rt_rule_entry.rule.attrib.u.v6.dst_addr[0] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][0];
+		   	        rt_rule_entry.rule.attrib.u.v6.dst_addr[1] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][1];
+		   	        rt_rule_entry.rule.attrib.u.v6.dst_addr[2] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][2];
+		   	        rt_rule_entry.rule.attrib.u.v6.dst_addr[3] = get_client_memptr(eth_client, eth_index)->v6_addr[v6_num][3];
+					rt_rule_entry.rule.attrib.u.v6.dst_addr_mask[0] = 0xFFFFFFFF;
+					rt_rule_entry.rule.attrib.u.v6.dst_addr_mask[1] = 0xFFFFFFFF;
+					rt_rule_entry.rule.attrib.u.v6.dst_addr_mask[2] = 0xFFFFFFFF;
+					rt_rule_entry.rule.attrib.u.v6.dst_addr_mask[3] = 0xFFFFFFFF;
+
+		            /*Copy same rule to v6 WAN RT TBL*/
+		            if (false == txn.AddRtRule(IPA_IP_v6, IPACM_Iface::ipacmcfg->rt_tbl_wan_v6.name, &rt_rule_entry,
+							&get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6_wan[v6_num]))
 		            {
 							IPACMERR("Routing rule addition failed!\n");
-							free(rt_rule);
+							txn.Abort();
 							return IPACM_FAILURE;
 		            }
-
-		            get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6_wan[v6_num] = rt_rule->rules[0].rt_rule_hdl;
-					IPACMDBG_H("tx:%d, rt rule hdl=%x ip-type: %d\n", tx_index,
-		            				 get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6_wan[v6_num], iptype);
 			    }
 			}
 
   	    } /* end of for loop */
 
-		free(rt_rule);
+		if (false == txn.Commit())
+		{
+			IPACMERR("Routing rule addition failed!\n");
+			return IPACM_FAILURE;
+		}
 
 		if (iptype == IPA_IP_v4)
 		{
@@ -2442,6 +2385,7 @@ int IPACM_Lan::handle_down_evt()
 {
 	int i;
 	int res = IPACM_SUCCESS;
+	IPACM_RuleTxn txn(&m_filtering, &m_routing, &m_header);
 	uint32_t temp_eth_bridge_flt_rule[IPA_LAN_TO_LAN_MAX_WLAN_CLIENT];
 
 	if (IPACM_Iface::ipacmcfg->iface_table[ipa_if_num].if_cat == ODU_IF)
@@ -2504,7 +2448,7 @@ int IPACM_Lan::handle_down_evt()
 	/* delete default filter rules */
 	if (ip_type != IPA_IP_v6 && rx_prop != NULL)
 	{
-		if (m_filtering.DeleteFilteringHdls(dft_v4fl_rule_hdl, IPA_IP_v4, IPV4_DEFAULT_FILTERTING_RULES) == false)
+		if (txn.DelFltRules(IPA_IP_v4, dft_v4fl_rule_hdl, IPV4_DEFAULT_FILTERTING_RULES) == false)
 		{
 			IPACMERR("Error Deleting Filtering Rule, aborting...\n");
 			res = IPACM_FAILURE;
@@ -2515,14 +2459,14 @@ int IPACM_Lan::handle_down_evt()
 		{
 			temp_eth_bridge_flt_rule[i] = wlan_client_flt_rule_hdl_v4[i].rule_hdl;
 		}
-		if (m_filtering.DeleteFilteringHdls(temp_eth_bridge_flt_rule, IPA_IP_v4, IPA_LAN_TO_LAN_MAX_WLAN_CLIENT) == false)
+		if (txn.DelFltRules(IPA_IP_v4, temp_eth_bridge_flt_rule, IPA_LAN_TO_LAN_MAX_WLAN_CLIENT) == false)
 		{
 			IPACMERR("Error Deleting Filtering Rule, aborting...\n");
 			res = IPACM_FAILURE;
 			goto fail;
 		}
 #endif
-		if(m_filtering.DeleteFilteringHdls(ipv6_icmp_flt_rule_hdl, IPA_IP_v6, NUM_IPV6_ICMP_FLT_RULE) == false)
+		if(txn.DelFltRules(IPA_IP_v6, ipv6_icmp_flt_rule_hdl, NUM_IPV6_ICMP_FLT_RULE) == false)
 		{
 			IPACMERR("Error Deleting ICMPv6 Filtering Rule, aborting...\n");
 			res = IPACM_FAILURE;
@@ -2530,7 +2474,7 @@ int IPACM_Lan::handle_down_evt()
 		}
 #ifndef FEATURE_ETH_BRIDGE_LE
 #ifdef CT_OPT
-		if (m_filtering.DeleteFilteringHdls(tcp_ctl_flt_rule_hdl_v4, IPA_IP_v4, NUM_TCP_CTL_FLT_RULE) == false)
+		if (txn.DelFltRules(IPA_IP_v4, tcp_ctl_flt_rule_hdl_v4, NUM_TCP_CTL_FLT_RULE) == false)
 		{
 			IPACMERR("Error deleting default filtering Rule, aborting...\n");
 			res = IPACM_FAILURE;
@@ -2539,7 +2483,7 @@ int IPACM_Lan::handle_down_evt()
 #endif
 		for(i=0; i<MAX_OFFLOAD_PAIR; i++)
 		{
-			if(m_filtering.DeleteFilteringHdls(&(lan2lan_flt_rule_hdl_v4[i].rule_hdl), IPA_IP_v4, 1) == false)
+			if(txn.DelFltRules(IPA_IP_v4, &(lan2lan_flt_rule_hdl_v4[i].rule_hdl), 1) == false)
 			{
 				IPACMERR("Error deleting lan2lan IPv4 flt rules.\n");
 				res = IPACM_FAILURE;
@@ -2558,14 +2502,14 @@ int IPACM_Lan::handle_down_evt()
 		}
 
 #ifdef FEATURE_IPA_ANDROID
-		if(m_filtering.DeleteFilteringHdls(private_fl_rule_hdl, IPA_IP_v4, IPA_MAX_PRIVATE_SUBNET_ENTRIES) == false)
+		if(txn.DelFltRules(IPA_IP_v4, private_fl_rule_hdl, IPA_MAX_PRIVATE_SUBNET_ENTRIES) == false)
 		{
 			IPACMERR("Error deleting private subnet IPv4 flt rules.\n");
 			res = IPACM_FAILURE;
 			goto fail;
 		}
 #else
-		if (m_filtering.DeleteFilteringHdls(private_fl_rule_hdl, IPA_IP_v4, IPACM_Iface::ipacmcfg->ipa_num_private_subnet) == false)
+		if (txn.DelFltRules(IPA_IP_v4, private_fl_rule_hdl, IPACM_Iface::ipacmcfg->ipa_num_private_subnet) == false)
 		{
 			IPACMERR("Error Deleting RuleTable(1) to Filtering, aborting...\n");
 			res = IPACM_FAILURE;
@@ -2577,9 +2521,7 @@ int IPACM_Lan::handle_down_evt()
 
 	if (ip_type != IPA_IP_v4 && rx_prop != NULL)
 	{
-		if (m_filtering.DeleteFilteringHdls(dft_v6fl_rule_hdl,
-																				IPA_IP_v6,
-																				(IPV6_DEFAULT_FILTERTING_RULES + IPV6_DEFAULT_LAN_FILTERTING_RULES)) == false)
+		if (txn.DelFltRules(IPA_IP_v6, dft_v6fl_rule_hdl, (IPV6_DEFAULT_FILTERTING_RULES + IPV6_DEFAULT_LAN_FILTERTING_RULES)) == false)
 		{
 			IPACMERR("Error Adding RuleTable(1) to Filtering, aborting...\n");
 			res = IPACM_FAILURE;
@@ -2590,7 +2532,7 @@ int IPACM_Lan::handle_down_evt()
 		{
 			temp_eth_bridge_flt_rule[i] = wlan_client_flt_rule_hdl_v6[i].rule_hdl;
 		}
-		if (m_filtering.DeleteFilteringHdls(temp_eth_bridge_flt_rule, IPA_IP_v6, IPA_LAN_TO_LAN_MAX_WLAN_CLIENT) == false)
+		if (txn.DelFltRules(IPA_IP_v6, temp_eth_bridge_flt_rule, IPA_LAN_TO_LAN_MAX_WLAN_CLIENT) == false)
 		{
 			IPACMERR("Error Deleting Filtering Rule, aborting...\n");
 			res = IPACM_FAILURE;
@@ -2599,7 +2541,7 @@ int IPACM_Lan::handle_down_evt()
 #endif
 #ifndef FEATURE_ETH_BRIDGE_LE
 #ifdef CT_OPT
-		if (m_filtering.DeleteFilteringHdls(tcp_ctl_flt_rule_hdl_v6, IPA_IP_v6, NUM_TCP_CTL_FLT_RULE) == false)
+		if (txn.DelFltRules(IPA_IP_v6, tcp_ctl_flt_rule_hdl_v6, NUM_TCP_CTL_FLT_RULE) == false)
 		{
 			IPACMERR("Error deleting default filtering Rule, aborting...\n");
 			res = IPACM_FAILURE;
@@ -2608,7 +2550,7 @@ int IPACM_Lan::handle_down_evt()
 #endif
 		for(i=0; i<MAX_OFFLOAD_PAIR; i++)
 		{
-			if(m_filtering.DeleteFilteringHdls(&(lan2lan_flt_rule_hdl_v6[i].rule_hdl), IPA_IP_v6, 1) == false)
+			if(txn.DelFltRules(IPA_IP_v6, &(lan2lan_flt_rule_hdl_v6[i].rule_hdl), 1) == false)
 			{
 				IPACMERR("Error deleting lan2lan IPv4 flt rules.\n");
 				res = IPACM_FAILURE;
@@ -2622,7 +2564,7 @@ int IPACM_Lan::handle_down_evt()
 
 	if (ip_type != IPA_IP_v6)
 	{
-		if (m_routing.DeleteRoutingHdl(dft_rt_rule_hdl[0], IPA_IP_v4)
+		if (txn.DelRtRule(IPA_IP_v4, dft_rt_rule_hdl[0])
 				== false)
 		{
 			IPACMERR("Routing rule deletion failed!\n");
@@ -2638,7 +2580,7 @@ int IPACM_Lan::handle_down_evt()
 		/* may have multiple ipv6 iface-RT rules*/
 		for (i = 0; i < 2*num_dft_rt_v6; i++)
 		{
-			if (m_routing.DeleteRoutingHdl(dft_rt_rule_hdl[MAX_DEFAULT_v4_ROUTE_RULES + i], IPA_IP_v6)
+			if (txn.DelRtRule(IPA_IP_v6, dft_rt_rule_hdl[MAX_DEFAULT_v4_ROUTE_RULES + i])
 					== false)
 			{
 				IPACMERR("Routing rule deletion failed!\n");
@@ -2666,14 +2608,14 @@ int IPACM_Lan::handle_down_evt()
 				CtList->HandleNeighIpAddrDelEvt(get_client_memptr(eth_client, i)->v4_addr);
 			}
 
-			if (delete_eth_rtrules(i, IPA_IP_v4))
+			if (delete_eth_rtrules(i, IPA_IP_v4, &txn))
 			{
 				IPACMERR("unbale to delete ecm-client v4 route rules for index %d\n", i);
 				res = IPACM_FAILURE;
 				goto fail;
 			}
 
-			if (delete_eth_rtrules(i, IPA_IP_v6))
+			if (delete_eth_rtrules(i, IPA_IP_v6, &txn))
 			{
 				IPACMERR("unbale to delete ecm-client v6 route rules for index %d\n", i);
 				res = IPACM_FAILURE;
@@ -2685,7 +2627,7 @@ int IPACM_Lan::handle_down_evt()
 
 			if(get_client_memptr(eth_client, i)->ipv4_header_set == true)
 			{
-				if (m_header.DeleteHeaderHdl(get_client_memptr(eth_client, i)->hdr_hdl_v4)
+				if (txn.DelHdr(get_client_memptr(eth_client, i)->hdr_hdl_v4)
 					== false)
 				{
 					res = IPACM_FAILURE;
@@ -2695,7 +2637,7 @@ int IPACM_Lan::handle_down_evt()
 
 			if(get_client_memptr(eth_client, i)->ipv6_header_set == true)
 			{
-			if (m_header.DeleteHeaderHdl(get_client_memptr(eth_client, i)->hdr_hdl_v6)
+			if (txn.DelHdr(get_client_memptr(eth_client, i)->hdr_hdl_v6)
 					== false)
 			{
 				res = IPACM_FAILURE;
@@ -2704,6 +2646,14 @@ int IPACM_Lan::handle_down_evt()
 			}
 	} /* end of for loop */
 
+	/* flt/rt/hdr deletes above go down in one ioctl per table and ip type */
+	if (txn.Commit() == false)
+	{
+		IPACMERR("Failed to delete iface rules\n");
+		res = IPACM_FAILURE;
+		goto fail;
+	}
+
 	/* free the edm clients cache */
 	IPACMDBG_H("Free ecm clients cache\n");
 
@@ -2743,6 +2693,8 @@ int IPACM_Lan::handle_down_evt()
 	}
 #endif /* defined(FEATURE_IPA_ANDROID)*/
 fail:
+	/* flush whatever was queued before an error */
+	txn.Commit();
 	if (odu_route_rule_v4_hdl != NULL)
 	{
 		free(odu_route_rule_v4_hdl);
@@ -3061,7 +3013,31 @@ int IPACM_Lan::handle_lan2lan_client_active(ipacm_event_data_all *data, ipa_cm_e
 	return IPACM_SUCCESS;
 }
 
-int IPACM_Lan::add_lan2lan_flt_rule(ipa_ip_type iptype, uint32_t src_v4_addr, uint32_t dst_v4_addr, uint32_t* src_v6_addr, uint32_t* dst_v6_addr, uint32_t* rule_hdl)
+/* modify a lan2lan filter rule now, or queue it on txn if given. With a
+	 txn the rule slot is taken when queued, the caller commits */
+bool IPACM_Lan::lan2lan_flt_rule_mdfy(ipa_ip_type iptype, struct ipa_flt_rule_mdfy *flt_rule,
+																			IPACM_RuleTxn *txn, IPACM_RuleTxn *own_txn)
+{
+	if (txn != NULL)
+	{
+		if (false == txn->ModifyFltRule(iptype, flt_rule))
+		{
+			IPACMERR("Error queueing filtering rule modify.\n");
+			return false;
+		}
+		return true;
+	}
+
+	if (false == own_txn->ModifyFltRule(iptype, flt_rule) || false == own_txn->Commit())
+	{
+		IPACMERR("Error modifying filtering rule.\n");
+		own_txn->Abort();
+		return false;
+	}
+	return true;
+}
+
+int IPACM_Lan::add_lan2lan_flt_rule(ipa_ip_type iptype, uint32_t src_v4_addr, uint32_t dst_v4_addr, uint32_t* src_v6_addr, uint32_t* dst_v6_addr, uint32_t* rule_hdl, IPACM_RuleTxn *txn)
 {
 	if(rx_prop == NULL)
 	{
@@ -3076,24 +3052,9 @@ int IPACM_Lan::add_lan2lan_flt_rule(ipa_ip_type iptype, uint32_t src_v4_addr, ui
 
 	IPACMDBG_H("Got a new lan2lan flt rule with IP type: %d\n", iptype);
 
-	int i, len, res = IPACM_SUCCESS;
+	int i, res = IPACM_SUCCESS;
 	struct ipa_flt_rule_mdfy flt_rule;
-	struct ipa_ioc_mdfy_flt_rule* pFilteringTable;
-
-	len = sizeof(struct ipa_ioc_mdfy_flt_rule) + sizeof(struct ipa_flt_rule_mdfy);
-
-	pFilteringTable = (struct ipa_ioc_mdfy_flt_rule*)malloc(len);
-
-	if (pFilteringTable == NULL)
-	{
-		IPACMERR("Error allocate lan2lan flt rule memory...\n");
-		return IPACM_FAILURE;
-	}
-	memset(pFilteringTable, 0, len);
-
-	pFilteringTable->commit = 1;
-	pFilteringTable->ip = iptype;
-	pFilteringTable->num_rules = 1;
+	IPACM_RuleTxn own_txn(&m_filtering, &m_routing, &m_header);
 
 	memset(&flt_rule, 0, sizeof(struct ipa_flt_rule_mdfy));
 
@@ -3151,21 +3112,15 @@ int IPACM_Lan::add_lan2lan_flt_rule(ipa_ip_type iptype, uint32_t src_v4_addr, ui
 		flt_rule.rule.attrib.u.v4.dst_addr = dst_v4_addr;
 		flt_rule.rule.attrib.u.v4.dst_addr_mask = 0xFFFFFFFF;
 
-		memcpy(&(pFilteringTable->rules[0]), &flt_rule, sizeof(struct ipa_flt_rule_mdfy));
-		if (false == m_filtering.ModifyFilteringRule(pFilteringTable))
+		if (false == lan2lan_flt_rule_mdfy(iptype, &flt_rule, txn, &own_txn))
 		{
-			IPACMERR("Error modifying filtering rule.\n");
 			res = IPACM_FAILURE;
 			goto fail;
 		}
-		else
-		{
-			lan2lan_flt_rule_hdl_v4[i].valid = true;
-			*rule_hdl = lan2lan_flt_rule_hdl_v4[i].rule_hdl;
-			num_lan2lan_flt_rule_v4++;
-			IPACMDBG_H("Flt rule modified, hdl: 0x%x, status: %d\n", pFilteringTable->rules[0].rule_hdl,
-						pFilteringTable->rules[0].status);
-		}
+		lan2lan_flt_rule_hdl_v4[i].valid = true;
+		*rule_hdl = lan2lan_flt_rule_hdl_v4[i].rule_hdl;
+		num_lan2lan_flt_rule_v4++;
+		IPACMDBG_H("Flt rule modified, hdl: 0x%x\n", flt_rule.rule_hdl);
 	}
 	else if(iptype == IPA_IP_v6)
 	{
@@ -3240,21 +3195,15 @@ int IPACM_Lan::add_lan2lan_flt_rule(ipa_ip_type iptype, uint32_t src_v4_addr, ui
 		flt_rule.rule.attrib.u.v6.dst_addr_mask[2] = 0xFFFFFFFF;
 		flt_rule.rule.attrib.u.v6.dst_addr_mask[3] = 0xFFFFFFFF;
 
-		memcpy(&(pFilteringTable->rules[0]), &flt_rule, sizeof(struct ipa_flt_rule_mdfy));
-		if (false == m_filtering.ModifyFilteringRule(pFilteringTable))
+		if (false == lan2lan_flt_rule_mdfy(iptype, &flt_rule, txn, &own_txn))
 		{
-			IPACMERR("Error modifying filtering rule.\n");
 			res = IPACM_FAILURE;
 			goto fail;
 		}
-		else
-		{
-			lan2lan_flt_rule_hdl_v6[i].valid = true;
-			*rule_hdl = lan2lan_flt_rule_hdl_v6[i].rule_hdl;
-			num_lan2lan_flt_rule_v6++;
-			IPACMDBG_H("Flt rule modified, hdl: 0x%x, status: %d\n", pFilteringTable->rules[0].rule_hdl,
-						pFilteringTable->rules[0].status);
-		}
+		lan2lan_flt_rule_hdl_v6[i].valid = true;
+		*rule_hdl = lan2lan_flt_rule_hdl_v6[i].rule_hdl;
+		num_lan2lan_flt_rule_v6++;
+		IPACMDBG_H("Flt rule modified, hdl: 0x%x\n", flt_rule.rule_hdl);
 	}
 	else
 	{
@@ -3264,7 +3213,6 @@ int IPACM_Lan::add_lan2lan_flt_rule(ipa_ip_type iptype, uint32_t src_v4_addr, ui
 	}
 
 fail:
-	free(pFilteringTable);
 	return res;
 }
 
@@ -4409,7 +4357,7 @@ fail:
 	return res;
 }
 
-int IPACM_Lan::install_ipv6_prefix_flt_rule(uint32_t* prefix)
+int IPACM_Lan::install_ipv6_prefix_flt_rule(uint32_t* prefix, IPACM_RuleTxn *txn)
 {
 	if(prefix == NULL)
 	{
@@ -4418,27 +4366,17 @@ int IPACM_Lan::install_ipv6_prefix_flt_rule(uint32_t* prefix)
 	}
 	IPACMDBG_H("Receive IPv6 prefix: 0x%08x%08x.\n", prefix[0], prefix[1]);
 
-	int len;
-	struct ipa_ioc_add_flt_rule* flt_rule;
 	struct ipa_flt_rule_add flt_rule_entry;
+	IPACM_RuleTxn own_txn(&m_filtering, &m_routing, &m_header);
+	bool commit = (txn == NULL);
 
 	if(rx_prop != NULL)
 	{
-		len = sizeof(struct ipa_ioc_add_flt_rule) + sizeof(struct ipa_flt_rule_add);
-
-		flt_rule = (struct ipa_ioc_add_flt_rule *)calloc(1, len);
-		if (!flt_rule)
+		if (txn == NULL)
 		{
-			IPACMERR("Error Locate ipa_flt_rule_add memory...\n");
-			return IPACM_FAILURE;
+			txn = &own_txn;
 		}
 
-		flt_rule->commit = 1;
-		flt_rule->ep = rx_prop->rx[0].src_pipe;
-		flt_rule->global = false;
-		flt_rule->ip = IPA_IP_v6;
-		flt_rule->num_rules = 1;
-
 		memset(&flt_rule_entry, 0, sizeof(struct ipa_flt_rule_add));
 
 		flt_rule_entry.rule.retain_hdr = 1;
@@ -4460,21 +4398,24 @@ int IPACM_Lan::install_ipv6_prefix_flt_rule(uint32_t* prefix)
 		flt_rule_entry.rule.attrib.u.v6.dst_addr_mask[1] = 0xFFFFFFFF;
 		flt_rule_entry.rule.attrib.u.v6.dst_addr_mask[2] = 0x0;
 		flt_rule_entry.rule.attrib.u.v6.dst_addr_mask[3] = 0x0;
-		memcpy(&(flt_rule->rules[0]), &flt_rule_entry, sizeof(struct ipa_flt_rule_add));
 
-		if (m_filtering.AddFilteringRule(flt_rule) == false)
+		if (txn->AddFltRule(IPA_IP_v6, rx_prop->rx[0].src_pipe, false, &flt_rule_entry,
+												&ipv6_prefix_flt_rule_hdl[0]) == false)
 		{
-			IPACMERR("Error Adding Filtering rule, aborting...\n");
-			free(flt_rule);
+			IPACMERR("Error queueing Filtering rule, aborting...\n");
+			txn->Abort();
 			return IPACM_FAILURE;
 		}
-		else
+		if (commit && own_txn.Commit() == false)
 		{
-			ipv6_prefix_flt_rule_hdl[0] = flt_rule->rules[0].flt_rule_hdl;
-			IPACMDBG_H("IPv6 prefix filter rule HDL:0x%x\n", ipv6_prefix_flt_rule_hdl[0]);
-			flt_rule_count_v6++;
-			free(flt_rule);
+			IPACMERR("Error Adding Filtering rule, aborting...\n");
+			return IPACM_FAILURE;
 		}
+
+		/* the rule holds its slot in the table from here on, with a caller
+			 txn the handle is valid once that is committed */
+		IPACMDBG_H("IPv6 prefix filter rule HDL:0x%x\n", ipv6_prefix_flt_rule_hdl[0]);
+		flt_rule_count_v6++;
 	}
 	return IPACM_SUCCESS;
 }
@@ -4774,19 +4715,15 @@ int IPACM_Lan::eth_bridge_add_wlan_client_flt_rule(uint8_t* mac, ipa_ip_type ipt
 		return IPACM_FAILURE;
 	}
 
-	for(i=0; i<wlan_client_flt_info_count; i++)
+	client_position = wlan_client_flt_info_idx.Find(mac);
+	if(client_position != IPACM_INVALID_INDEX)
 	{
-		if(memcmp(eth_bridge_wlan_client_flt_info[i].mac, mac, sizeof(eth_bridge_wlan_client_flt_info[i].mac)) == 0)
+		client_is_found = true;
+		if( (iptype == IPA_IP_v4 && eth_bridge_wlan_client_flt_info[client_position].flt_rule_set_v4 == true)
+			|| (iptype == IPA_IP_v6 && eth_bridge_wlan_client_flt_info[client_position].flt_rule_set_v6 == true))
 		{
-			client_is_found = true;
-			client_position = i;
-			if( (iptype == IPA_IP_v4 && eth_bridge_wlan_client_flt_info[i].flt_rule_set_v4 == true)
-				|| (iptype == IPA_IP_v6 && eth_bridge_wlan_client_flt_info[i].flt_rule_set_v6 == true))
-			{
-				IPACMDBG_H("Flt rule for iptype %d has been set.\n", iptype);
-				return IPACM_SUCCESS;
-			}
-			break;
+			IPACMDBG_H("Flt rule for iptype %d has been set.\n", iptype);
+			return IPACM_SUCCESS;
 		}
 	}
 
@@ -4911,6 +4848,7 @@ int IPACM_Lan::eth_bridge_add_wlan_client_flt_rule(uint8_t* mac, ipa_ip_type ipt
 	{
 		client_position = wlan_client_flt_info_count;
 		wlan_client_flt_info_count++;
+		wlan_client_flt_info_idx.Insert(mac, client_position);
 	}
 
 	memcpy(eth_bridge_wlan_client_flt_info[client_position].mac, mac, sizeof(eth_bridge_wlan_client_flt_info[client_position].mac));
@@ -4944,15 +4882,8 @@ int IPACM_Lan::eth_bridge_del_wlan_client_flt_rule(uint8_t* mac)
 	IPACMDBG_H("Receive WLAN client MAC 0x%02x%02x%02x%02x%02x%02x.\n", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
 
 	int i, j, res = IPACM_SUCCESS;
-	for(i=0; i<wlan_client_flt_info_count; i++)
-	{
-		if(memcmp(eth_bridge_wlan_client_flt_info[i].mac, mac, sizeof(eth_bridge_wlan_client_flt_info[i].mac)) == 0)
-		{
-			break;
-		}
-	}
-
-	if(i == wlan_client_flt_info_count)
+	i = wlan_client_flt_info_idx.Find(mac);
+	if(i == IPACM_INVALID_INDEX)
 	{
 		IPACMERR("Do not find the wlan client.\n");
 		return IPACM_FAILURE;
@@ -5007,11 +4938,15 @@ int IPACM_Lan::eth_bridge_del_wlan_client_flt_rule(uint8_t* mac)
 		}
 	}
 
-	for(j=i+1; j<wlan_client_flt_info_count; j++)
+	/* fill the hole with the last entry, the table is unordered */
+	wlan_client_flt_info_idx.Remove(mac);
+	j = wlan_client_flt_info_count - 1;
+	if(i != j)
 	{
-		memcpy(&(eth_bridge_wlan_client_flt_info[j-1]), &(eth_bridge_wlan_client_flt_info[j]), sizeof(eth_bridge_client_flt_info));
+		memcpy(&(eth_bridge_wlan_client_flt_info[i]), &(eth_bridge_wlan_client_flt_info[j]), sizeof(eth_bridge_client_flt_info));
+		wlan_client_flt_info_idx.Insert(eth_bridge_wlan_client_flt_info[i].mac, i);
 	}
-	memset(&(eth_bridge_wlan_client_flt_info[wlan_client_flt_info_count-1]), 0, sizeof(eth_bridge_client_flt_info));
+	memset(&(eth_bridge_wlan_client_flt_info[j]), 0, sizeof(eth_bridge_client_flt_info));
 	wlan_client_flt_info_count--;
 
 	return res;
@@ -5577,89 +5512,83 @@ int IPACM_Lan::del_hdr_proc_ctx()
 /*handle reset usb-client rt-rules */
 int IPACM_Lan::handle_tethering_stats_event(ipa_get_data_stats_resp_msg_v01 *data)
 {
-	int cnt, pipe_len, fd;
-	uint64_t num_ul_packets, num_ul_bytes;
-	uint64_t num_dl_packets, num_dl_bytes;
+	int pipe_len, pipe;
+	ipacm_stats_iface *entry;
+	ipacm_stats_counter sum;
 	bool ul_pipe_found, dl_pipe_found;
 	FILE *fp = NULL;
 
-	fd = open(IPA_DEVICE_NAME, O_RDWR);
-	if (fd < 0)
+	if (stats_pipe_mask_valid == false && init_stats_pipe_mask() == IPACM_FAILURE)
 	{
-		IPACMERR("Failed opening %s.\n", IPA_DEVICE_NAME);
 		return IPACM_FAILURE;
 	}
 
-
 	ul_pipe_found = false;
 	dl_pipe_found = false;
-	num_ul_packets = 0;
-	num_dl_packets = 0;
-	num_ul_bytes = 0;
-	num_dl_bytes = 0;
+	memset(&sum, 0, sizeof(sum));
+
+	entry = IPACM_Stats::GetInstance()->GetTetherEntry(ipa_if_num, dev_name);
+	IPACM_Stats::BeginUpdate(entry);
 
 	if (data->dl_dst_pipe_stats_list_valid)
 	{
-		if(tx_prop != NULL)
+		for (pipe_len = 0; pipe_len < data->dl_dst_pipe_stats_list_len; pipe_len++)
 		{
-			for (pipe_len = 0; pipe_len < data->dl_dst_pipe_stats_list_len; pipe_len++)
+			pipe = data->dl_dst_pipe_stats_list[pipe_len].pipe_index;
+			if (pipe >= IPACM_STATS_MAX_PIPE || (stats_dl_pipe_mask & (1U << pipe)) == 0)
 			{
-				IPACMDBG_H("Check entry(%d) dl_dst_pipe(%d)\n", pipe_len, data->dl_dst_pipe_stats_list[pipe_len].pipe_index);
-				for (cnt=0; cnt<tx_prop->num_tx_props; cnt++)
-				{
-					IPACMDBG_H("Check Tx_prop_entry(%d) pipe(%d)\n", cnt, ioctl(fd, IPA_IOC_QUERY_EP_MAPPING, tx_prop->tx[cnt].dst_pipe));
-					if(ioctl(fd, IPA_IOC_QUERY_EP_MAPPING, tx_prop->tx[cnt].dst_pipe) == data->dl_dst_pipe_stats_list[pipe_len].pipe_index)
-					{
-						/* update the DL stats */
-						dl_pipe_found = true;
-						num_dl_packets += data->dl_dst_pipe_stats_list[pipe_len].num_ipv4_packets;
-						num_dl_packets += data->dl_dst_pipe_stats_list[pipe_len].num_ipv6_packets;
-						num_dl_bytes += data->dl_dst_pipe_stats_list[pipe_len].num_ipv4_bytes;
-						num_dl_bytes += data->dl_dst_pipe_stats_list[pipe_len].num_ipv6_bytes;
-						IPACMDBG_H("Got matched dst-pipe (%d) from %d tx props\n", data->dl_dst_pipe_stats_list[pipe_len].pipe_index, cnt);
-						IPACMDBG_H("DL_packets:(%lu) DL_bytes:(%lu) \n", num_dl_packets, num_dl_bytes);
-						break;
-					}
-				}
+				continue;
 			}
+			/* update the DL stats */
+			dl_pipe_found = true;
+			entry->pipe[pipe].dl_packets += data->dl_dst_pipe_stats_list[pipe_len].num_ipv4_packets
+				+ data->dl_dst_pipe_stats_list[pipe_len].num_ipv6_packets;
+			entry->pipe[pipe].dl_bytes += data->dl_dst_pipe_stats_list[pipe_len].num_ipv4_bytes
+				+ data->dl_dst_pipe_stats_list[pipe_len].num_ipv6_bytes;
+			sum.dl_packets += data->dl_dst_pipe_stats_list[pipe_len].num_ipv4_packets
+				+ data->dl_dst_pipe_stats_list[pipe_len].num_ipv6_packets;
+			sum.dl_bytes += data->dl_dst_pipe_stats_list[pipe_len].num_ipv4_bytes
+				+ data->dl_dst_pipe_stats_list[pipe_len].num_ipv6_bytes;
 		}
 	}
 
 	if (data->ul_src_pipe_stats_list_valid)
 	{
-		if(rx_prop != NULL)
+		for (pipe_len = 0; pipe_len < data->ul_src_pipe_stats_list_len; pipe_len++)
 		{
-			for (pipe_len = 0; pipe_len < data->ul_src_pipe_stats_list_len; pipe_len++)
+			pipe = data->ul_src_pipe_stats_list[pipe_len].pipe_index;
+			if (pipe >= IPACM_STATS_MAX_PIPE || (stats_ul_pipe_mask & (1U << pipe)) == 0)
 			{
-				IPACMDBG_H("Check entry(%d) dl_dst_pipe(%d)\n", pipe_len, data->ul_src_pipe_stats_list[pipe_len].pipe_index);
-				for (cnt=0; cnt < rx_prop->num_rx_props; cnt++)
-				{
-					IPACMDBG_H("Check Rx_prop_entry(%d) pipe(%d)\n", cnt, ioctl(fd, IPA_IOC_QUERY_EP_MAPPING, rx_prop->rx[cnt].src_pipe));
-					if(ioctl(fd, IPA_IOC_QUERY_EP_MAPPING, rx_prop->rx[cnt].src_pipe) == data->ul_src_pipe_stats_list[pipe_len].pipe_index)
-					{
-						/* update the UL stats */
-						ul_pipe_found = true;
-						num_ul_packets += data->ul_src_pipe_stats_list[pipe_len].num_ipv4_packets;
-						num_ul_packets += data->ul_src_pipe_stats_list[pipe_len].num_ipv6_packets;
-						num_ul_bytes += data->ul_src_pipe_stats_list[pipe_len].num_ipv4_bytes;
-						num_ul_bytes += data->ul_src_pipe_stats_list[pipe_len].num_ipv6_bytes;
-						IPACMDBG_H("Got matched dst-pipe (%d) from %d tx props\n", data->ul_src_pipe_stats_list[pipe_len].pipe_index, cnt);
-						IPACMDBG_H("UL_packets:(%lu) UL_bytes:(%lu) \n", num_ul_packets, num_ul_bytes);
-						break;
-					}
-				}
+				continue;
 			}
+			/* update the UL stats */
+			ul_pipe_found = true;
+			entry->pipe[pipe].ul_packets += data->ul_src_pipe_stats_list[pipe_len].num_ipv4_packets
+				+ data->ul_src_pipe_stats_list[pipe_len].num_ipv6_packets;
+			entry->pipe[pipe].ul_bytes += data->ul_src_pipe_stats_list[pipe_len].num_ipv4_bytes
+				+ data->ul_src_pipe_stats_list[pipe_len].num_ipv6_bytes;
+			sum.ul_packets += data->ul_src_pipe_stats_list[pipe_len].num_ipv4_packets
+				+ data->ul_src_pipe_stats_list[pipe_len].num_ipv6_packets;
+			sum.ul_bytes += data->ul_src_pipe_stats_list[pipe_len].num_ipv4_bytes
+				+ data->ul_src_pipe_stats_list[pipe_len].num_ipv6_bytes;
 		}
 	}
-	close(fd);
+
+	if (ul_pipe_found || dl_pipe_found)
+	{
+		entry->last = sum;
+		IPACM_Stats::AddCounter(&entry->total, &sum);
+		strncpy(entry->upstream_name, IPACM_Wan::wan_up_dev_name, sizeof(entry->upstream_name) - 1);
+	}
+	IPACM_Stats::EndUpdate(entry);
 
 	if (ul_pipe_found || dl_pipe_found)
 	{
 		IPACMDBG_H("Update IPA_TETHERING_STATS_UPDATE_EVENT, TX(P%lu/B%lu) RX(P%lu/B%lu) DEV(%s) to LTE(%s) \n",
-					num_ul_packets,
-						num_ul_bytes,
-							num_dl_packets,
-								num_dl_bytes,
+					sum.ul_packets,
+						sum.ul_bytes,
+							sum.dl_packets,
+								sum.dl_bytes,
 									dev_name,
 										IPACM_Wan::wan_up_dev_name);
 		fp = fopen(IPA_PIPE_STATS_FILE_NAME, "w");
@@ -5673,15 +5602,72 @@ int IPACM_Lan::handle_tethering_stats_event(ipa_get_data_stats_resp_msg_v01 *dat
 		fprintf(fp, PIPE_STATS,
 				dev_name,
 					IPACM_Wan::wan_up_dev_name,
-						num_ul_bytes,
-						num_ul_packets,
-							    num_dl_bytes,
-							num_dl_packets);
+						sum.ul_bytes,
+						sum.ul_packets,
+							    sum.dl_bytes,
+							sum.dl_packets);
 		fclose(fp);
 	}
 	return IPACM_SUCCESS;
 }
 
+/* On a failed EP mapping query stats_pipe_mask_valid stays false, so
+	 the next report queries again instead of using a partial mask */
+int IPACM_Lan::init_stats_pipe_mask()
+{
+	int cnt, fd, pipe, ret = IPACM_SUCCESS;
+
+	fd = open(IPA_DEVICE_NAME, O_RDWR);
+	if (fd < 0)
+	{
+		IPACMERR("Failed opening %s.\n", IPA_DEVICE_NAME);
+		return IPACM_FAILURE;
+	}
+
+	stats_ul_pipe_mask = 0;
+	stats_dl_pipe_mask = 0;
+
+	if (tx_prop != NULL)
+	{
+		for (cnt = 0; cnt < tx_prop->num_tx_props; cnt++)
+		{
+			pipe = ioctl(fd, IPA_IOC_QUERY_EP_MAPPING, tx_prop->tx[cnt].dst_pipe);
+			IPACMDBG_H("Tx_prop_entry(%d) pipe(%d)\n", cnt, pipe);
+			if (pipe < 0)
+			{
+				IPACMERR("Failed querying EP mapping of client %d\n", tx_prop->tx[cnt].dst_pipe);
+				ret = IPACM_FAILURE;
+			}
+			else if (pipe < IPACM_STATS_MAX_PIPE)
+			{
+				stats_dl_pipe_mask |= (1U << pipe);
+			}
+		}
+	}
+
+	if (rx_prop != NULL)
+	{
+		for (cnt = 0; cnt < rx_prop->num_rx_props; cnt++)
+		{
+			pipe = ioctl(fd, IPA_IOC_QUERY_EP_MAPPING, rx_prop->rx[cnt].src_pipe);
+			IPACMDBG_H("Rx_prop_entry(%d) pipe(%d)\n", cnt, pipe);
+			if (pipe < 0)
+			{
+				IPACMERR("Failed querying EP mapping of client %d\n", rx_prop->rx[cnt].src_pipe);
+				ret = IPACM_FAILURE;
+			}
+			else if (pipe < IPACM_STATS_MAX_PIPE)
+			{
+				stats_ul_pipe_mask |= (1U << pipe);
+			}
+		}
+	}
+	close(fd);
+
+	stats_pipe_mask_valid = (ret == IPACM_SUCCESS);
+	return ret;
+}
+
 /*handle tether client */
 int IPACM_Lan::handle_tethering_client(bool reset, ipacm_client_enum ipa_client)
 {
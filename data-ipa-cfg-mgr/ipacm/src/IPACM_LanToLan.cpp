@@ -54,6 +54,9 @@ IPACM_LanToLan::IPACM_LanToLan()
 {
 	num_offload_pair_v4_ = 0;
 	num_offload_pair_v6_ = 0;
+	num_cache_connection_v4_ = 0;
+	num_cache_connection_v6_ = 0;
+	num_pending_pair_ = 0;
 	client_info_v4_.reserve(IPA_LAN_TO_LAN_MAX_WLAN_CLIENT + IPA_LAN_TO_LAN_MAX_USB_CLIENT);
 	client_info_v6_.reserve(3*(IPA_LAN_TO_LAN_MAX_WLAN_CLIENT + IPA_LAN_TO_LAN_MAX_USB_CLIENT));
 	p_instance = this;
@@ -65,6 +68,14 @@ IPACM_LanToLan::IPACM_LanToLan()
 	IPACM_EvtDispatcher::registr(IPA_LAN_CLIENT_POWER_RECOVER, this);
 	IPACM_EvtDispatcher::registr(IPA_LAN_TO_LAN_NEW_CONNECTION, this);
 	IPACM_EvtDispatcher::registr(IPA_LAN_TO_LAN_DEL_CONNECTION, this);
+	IPACM_EvtDispatcher::registr(IPA_LAN_TO_LAN_POLICY_TIMER, this);
+
+	pthread_mutex_init(&policy_lock_, NULL);
+	pthread_cond_init(&policy_cond_, NULL);
+	if(pthread_create(&policy_thread_, NULL, policy_timer_thread, this) != 0)
+	{
+		IPACMERR("Failed to create lan2lan offload policy thread.\n");
+	}
 	return;
 }
 
@@ -148,6 +159,12 @@ void IPACM_LanToLan::event_callback(ipa_cm_event_id event, void* param)
 			handle_client_power_recover(data);
 			break;
 		}
+		case IPA_LAN_TO_LAN_POLICY_TIMER:
+		{
+			IPACMDBG("Get IPA_LAN_TO_LAN_POLICY_TIMER event.\n");
+			handle_policy_timer();
+			break;
+		}
 		default:
 			break;
 	}
@@ -285,36 +302,192 @@ void IPACM_LanToLan::check_potential_link(ipa_ip_type iptype, client_info* clien
 	IPACMDBG_H("Client: IP type: %d, IPv4 addr: 0x%08x, IPv6 addr: 0x%08x%08x%08x%08x\n", iptype, client->ip.ipv4_addr,
 				client->ip.ipv6_addr[0], client->ip.ipv6_addr[1], client->ip.ipv6_addr[2], client->ip.ipv6_addr[3]);
 
-	peer_info_list::iterator peer_it;
-	int res, num = 0;
+	peer_info_table::iterator peer_it;
 
 	for(peer_it = client->peer.begin(); peer_it != client->peer.end(); peer_it++)
 	{
-		if(peer_it->peer_pointer->is_active == true && peer_it->num_connection > 0)
+		if(peer_it->second.num_connection > 0)
 		{
-			res = IPACM_SUCCESS;
-			res = add_offload_link(iptype, client, peer_it->peer_pointer);
-			res = add_offload_link(iptype, peer_it->peer_pointer, client);
-			if(res == IPACM_SUCCESS)
+			try_offload_pair(iptype, client, peer_it->first);
+		}
+	}
+	return;
+}
+
+//a pair is worth a rule slot once it carries several connections or has lived long enough
+bool IPACM_LanToLan::should_offload(peer_info* peer)
+{
+	if(peer->num_connection >= LAN2LAN_OFFLOAD_MIN_CONN)
+	{
+		return true;
+	}
+	return (time(NULL) - peer->first_conn_time >= LAN2LAN_OFFLOAD_MIN_AGE);
+}
+
+//add offload links in both directions, on failure nothing is left behind
+int IPACM_LanToLan::add_offload_pair(ipa_ip_type iptype, client_info* client, client_info* peer)
+{
+	offload_link_info_table::iterator it;
+
+	if(add_offload_link(iptype, client, peer) == IPACM_FAILURE)
+	{
+		IPACMERR("Failed to add offload link for client->peer direction.\n");
+		return IPACM_FAILURE;
+	}
+	if(add_offload_link(iptype, peer, client) == IPACM_FAILURE)
+	{
+		IPACMERR("Failed to add offload link for peer->client direction.\n");
+		it = client->link.find(peer);
+		del_offload_link(iptype, client->p_iface, peer->p_iface, &(it->second));
+		client->link.erase(it);
+		return IPACM_FAILURE;
+	}
+
+	if(iptype == IPA_IP_v4)
+	{
+		num_offload_pair_v4_ ++;
+		IPACMDBG_H("Added offload links, now num_offload_pair_v4_: %d\n", num_offload_pair_v4_);
+	}
+	else
+	{
+		num_offload_pair_v6_ ++;
+		IPACMDBG_H("Added offload links, now num_offload_pair_v6_: %d\n", num_offload_pair_v6_);
+	}
+	return IPACM_SUCCESS;
+}
+
+//offload the pair if both ends are active and the policy allows it,
+//otherwise leave it for the policy timer
+void IPACM_LanToLan::try_offload_pair(ipa_ip_type iptype, client_info* client, client_info* peer)
+{
+	peer_info_table::iterator it;
+
+	if(client->is_active == false || peer->is_active == false)
+	{
+		return;
+	}
+	if(client->link.count(peer) > 0)
+	{
+		IPACMDBG_H("Offload links already exist.\n");
+		return;
+	}
+
+	it = client->peer.find(peer);
+	if(it == client->peer.end())
+	{
+		return;
+	}
+
+	if(should_offload(&(it->second)))
+	{
+		add_offload_pair(iptype, client, peer);
+	}
+	else
+	{
+		IPACMDBG_H("Pair has %d connections, wait for offload policy.\n", it->second.num_connection);
+		set_pending_pair(num_pending_pair_ + 1);
+	}
+	return;
+}
+
+void IPACM_LanToLan::set_pending_pair(int num)
+{
+	pthread_mutex_lock(&policy_lock_);
+	num_pending_pair_ = num;
+	if(num_pending_pair_ > 0)
+	{
+		pthread_cond_signal(&policy_cond_);
+	}
+	pthread_mutex_unlock(&policy_lock_);
+	return;
+}
+
+//re-run the offload policy on every pair that has connections but no links yet
+void IPACM_LanToLan::handle_policy_timer()
+{
+	client_table_v4::iterator it_v4;
+	client_table_v6::iterator it_v6;
+	peer_info_table::iterator peer_it;
+	client_info* client;
+	client_info* peer;
+	int num_pending = 0;
+
+	for(it_v4 = client_info_v4_.begin(); it_v4 != client_info_v4_.end(); it_v4++)
+	{
+		client = &(it_v4->second);
+		for(peer_it = client->peer.begin(); peer_it != client->peer.end(); peer_it++)
+		{
+			peer = peer_it->first;
+			//visit each pair from one side only
+			if(client > peer || peer_it->second.num_connection == 0
+				|| client->is_active == false || peer->is_active == false || client->link.count(peer) > 0)
 			{
-				if(iptype == IPA_IP_v4)
-				{
-					num_offload_pair_v4_ ++;
-					IPACMDBG_H("Now the number of v4 offload links is %d.\n", num_offload_pair_v4_);
-				}
-				else
-				{
-					num_offload_pair_v6_ ++;
-					IPACMDBG_H("Now the number of v6 offload links is %d.\n", num_offload_pair_v6_);
-				}
-				num++;
+				continue;
+			}
+			if(should_offload(&(peer_it->second)))
+			{
+				add_offload_pair(IPA_IP_v4, client, peer);
+			}
+			else
+			{
+				num_pending++;
 			}
 		}
 	}
-	IPACMDBG_H("Added %d offload links in total.\n", num);
+
+	for(it_v6 = client_info_v6_.begin(); it_v6 != client_info_v6_.end(); it_v6++)
+	{
+		client = &(it_v6->second);
+		for(peer_it = client->peer.begin(); peer_it != client->peer.end(); peer_it++)
+		{
+			peer = peer_it->first;
+			if(client > peer || peer_it->second.num_connection == 0
+				|| client->is_active == false || peer->is_active == false || client->link.count(peer) > 0)
+			{
+				continue;
+			}
+			if(should_offload(&(peer_it->second)))
+			{
+				add_offload_pair(IPA_IP_v6, client, peer);
+			}
+			else
+			{
+				num_pending++;
+			}
+		}
+	}
+
+	IPACMDBG("%d lan2lan pairs still wait for offload policy.\n", num_pending);
+	set_pending_pair(num_pending);
 	return;
 }
 
+//sleeps until some pair waits on the offload policy, then asks the
+//dispatcher thread to re-check it once the age threshold can be met
+void* IPACM_LanToLan::policy_timer_thread(void* param)
+{
+	IPACM_LanToLan* lan2lan = (IPACM_LanToLan*)param;
+	ipacm_cmd_q_data evt;
+
+	while(1)
+	{
+		pthread_mutex_lock(&lan2lan->policy_lock_);
+		while(lan2lan->num_pending_pair_ == 0)
+		{
+			pthread_cond_wait(&lan2lan->policy_cond_, &lan2lan->policy_lock_);
+		}
+		pthread_mutex_unlock(&lan2lan->policy_lock_);
+
+		sleep(LAN2LAN_OFFLOAD_MIN_AGE);
+
+		memset(&evt, 0, sizeof(evt));
+		evt.event = IPA_LAN_TO_LAN_POLICY_TIMER;
+		evt.evt_data = NULL;
+		IPACM_EvtDispatcher::PostEvt(&evt);
+	}
+	return NULL;
+}
+
 int IPACM_LanToLan::add_offload_link(ipa_ip_type iptype, client_info* client, client_info* peer)
 {
 	if( (iptype == IPA_IP_v4 && num_offload_pair_v4_ >= MAX_OFFLOAD_PAIR)
@@ -382,7 +555,7 @@ int IPACM_LanToLan::add_offload_link(ipa_ip_type iptype, client_info* client, cl
 	link_info.hdr_hdl = hdr_hdl;
 	memcpy(&link_info.rt_rule_hdl, &rt_rule_hdl, sizeof(lan_to_lan_rt_rule_hdl));
 
-	client->link.push_back(link_info);
+	client->link[peer] = link_info;
 
 	return IPACM_SUCCESS;
 
@@ -470,40 +643,32 @@ int IPACM_LanToLan::turnoff_offload_links(ipa_ip_type iptype, client_info* clien
 		return IPACM_FAILURE;
 	}
 
-	bool err_flag;
-	offload_link_info_list::iterator client_it;
-	offload_link_info_list::iterator peer_it;
+	offload_link_info_table::iterator client_it;
+	offload_link_info_table::iterator peer_it;
 	client_info* peer;
 
 	for(client_it = client->link.begin(); client_it != client->link.end(); client_it++)
 	{
-		peer = client_it->peer_pointer;
-		if(del_offload_link(iptype, client->p_iface, peer->p_iface, &(*client_it)) == IPACM_FAILURE)
+		peer = client_it->first;
+		if(del_offload_link(iptype, client->p_iface, peer->p_iface, &(client_it->second)) == IPACM_FAILURE)
 		{
 			IPACMERR("Failed to delete client's offload link.\n");
 			return IPACM_FAILURE;
 		}
 
-		err_flag = true;
-		for(peer_it = peer->link.begin(); peer_it != peer->link.end(); peer_it++)
+		peer_it = peer->link.find(client);
+		if(peer_it == peer->link.end())
 		{
-			if(peer_it->peer_pointer == client)
-			{
-				if(del_offload_link(iptype, peer->p_iface, client->p_iface, &(*peer_it)) == IPACM_FAILURE)
-				{
-					IPACMERR("Failed to delete peer's offload link.\n");
-					return IPACM_FAILURE;
-				}
-				peer->link.erase(peer_it);
-				err_flag = false;
-				break;
-			}
+			IPACMERR("Unable to find corresponding offload link in peer's entry.\n");
+			return IPACM_FAILURE;
 		}
-		if(err_flag)
+		if(del_offload_link(iptype, peer->p_iface, client->p_iface, &(peer_it->second)) == IPACM_FAILURE)
 		{
-			IPACMERR("Unable to find corresponding offload link in peer's entry.\n");
+			IPACMERR("Failed to delete peer's offload link.\n");
 			return IPACM_FAILURE;
 		}
+		peer->link.erase(peer_it);
+
 		if(iptype == IPA_IP_v4)
 		{
 			num_offload_pair_v4_ --;
@@ -623,25 +788,13 @@ int IPACM_LanToLan::clear_peer_list(client_info* client)
 		return IPACM_FAILURE;
 	}
 
-	bool err_flag;
-	peer_info_list::iterator client_it;
-	peer_info_list::iterator peer_it;
+	peer_info_table::iterator client_it;
 	client_info* peer;
 
 	for(client_it = client->peer.begin(); client_it != client->peer.end(); client_it++)
 	{
-		err_flag = true;
-		peer = client_it->peer_pointer;
-		for(peer_it = peer->peer.begin(); peer_it != peer->peer.end(); peer_it++)
-		{
-			if(peer_it->peer_pointer == client)
-			{
-				peer->peer.erase(peer_it);
-				err_flag = false;
-				break;
-			}
-		}
-		if(err_flag == true)
+		peer = client_it->first;
+		if(peer->peer.erase(client) == 0)
 		{
 			IPACMERR("Failed to find peer info.\n");
 			return IPACM_FAILURE;
@@ -751,35 +904,8 @@ void IPACM_LanToLan::handle_new_lan2lan_connection(ipacm_event_connection* data)
 	}
 
 	IPACMDBG_H("Both src and dst are already in table.\n");
-	bool is_first_connection;
-	is_first_connection = add_connection(src_client_ptr, dst_client_ptr);
-
-	if(is_first_connection && src_client_ptr->is_active && dst_client_ptr->is_active)
-	{
-		IPACMDBG_H("This is first connection, add offload links.\n");
-
-		if(add_offload_link(data->iptype, src_client_ptr, dst_client_ptr) == IPACM_FAILURE)
-		{
-			IPACMERR("Failed to add offload link for src->dst direction.\n");
-			return;
-		}
-		if(add_offload_link(data->iptype, dst_client_ptr, src_client_ptr) == IPACM_FAILURE)
-		{
-			IPACMERR("Failed to add offload link for dst->src direction.\n");
-			return;
-		}
-
-		if(data->iptype == IPA_IP_v4)
-		{
-			num_offload_pair_v4_ ++;
-			IPACMDBG_H("Added offload links, now num_offload_pair_v4_: %d\n", num_offload_pair_v4_);
-		}
-		else
-		{
-			num_offload_pair_v6_ ++;
-			IPACMDBG_H("Added offload links, now num_offload_pair_v6_: %d\n", num_offload_pair_v6_);
-		}
-	}
+	add_connection(src_client_ptr, dst_client_ptr);
+	try_offload_pair(data->iptype, src_client_ptr, dst_client_ptr);
 	return;
 }
 
@@ -792,43 +918,39 @@ bool IPACM_LanToLan::add_connection(client_info* src_client, client_info* dst_cl
 		return false;
 	}
 
-	peer_info_list::iterator it;
+	peer_info_table::iterator it;
 	peer_info new_peer;
 	bool ret = false;
 
-	for(it = src_client->peer.begin(); it != src_client->peer.end(); it++)
+	it = src_client->peer.find(dst_client);
+	if(it != src_client->peer.end())
 	{
-		if(it->peer_pointer == dst_client)
-		{
-			it->num_connection++;
-			IPACMDBG_H("Find dst client entry in peer list, connection count: %d\n", it->num_connection);
-			break;
-		}
+		it->second.num_connection++;
+		IPACMDBG_H("Find dst client entry in peer list, connection count: %d\n", it->second.num_connection);
 	}
-	if(it == src_client->peer.end())
+	else
 	{
 		IPACMDBG_H("Not finding dst client entry, insert a new one in peer list.\n");
 		new_peer.peer_pointer = dst_client;
 		new_peer.num_connection = 1;
-		src_client->peer.push_back(new_peer);
+		new_peer.first_conn_time = time(NULL);
+		src_client->peer[dst_client] = new_peer;
 		ret = true;
 	}
 
-	for(it = dst_client->peer.begin(); it != dst_client->peer.end(); it++)
+	it = dst_client->peer.find(src_client);
+	if(it != dst_client->peer.end())
 	{
-		if(it->peer_pointer == src_client)
-		{
-			it->num_connection++;
-			IPACMDBG_H("Find dst client entry in peer list, connection count: %d\n", it->num_connection);
-			break;
-		}
+		it->second.num_connection++;
+		IPACMDBG_H("Find dst client entry in peer list, connection count: %d\n", it->second.num_connection);
 	}
-	if(it == dst_client->peer.end())
+	else
 	{
 		IPACMDBG_H("Not finding src client entry, insert a new one in peer list.\n");
 		new_peer.peer_pointer = src_client;
 		new_peer.num_connection = 1;
-		dst_client->peer.push_back(new_peer);
+		new_peer.first_conn_time = time(NULL);
+		dst_client->peer[src_client] = new_peer;
 		ret = true;
 	}
 	return ret;
@@ -934,47 +1056,33 @@ bool IPACM_LanToLan::remove_connection(client_info* src_client, client_info* dst
 		return false;
 	}
 
-	peer_info_list::iterator it;
+	peer_info_table::iterator it;
 	bool ret = false;
 
-	for(it = src_client->peer.begin(); it != src_client->peer.end(); it++)
+	it = src_client->peer.find(dst_client);
+	if(it != src_client->peer.end())
 	{
-		if(it->peer_pointer == dst_client)
+		it->second.num_connection--;
+		IPACMDBG_H("Find dst client entry in src peer list, connection count: %d\n", it->second.num_connection);
+		if(it->second.num_connection == 0)
 		{
-			it->num_connection--;
-			IPACMDBG_H("Find dst client entry in src peer list, connection count: %d\n", it->num_connection);
-			if(it->num_connection == 0)
-			{
-				IPACMDBG_H("Need to remove dst entry in src peer list.\n");
-				ret = true;
-			}
-			break;
+			IPACMDBG_H("Need to remove dst entry in src peer list.\n");
+			src_client->peer.erase(it);
 		}
 	}
-	if(ret == true)
-	{
-		src_client->peer.erase(it);
-	}
 
-	ret = false;
-	for(it = dst_client->peer.begin(); it != dst_client->peer.end(); it++)
+	it = dst_client->peer.find(src_client);
+	if(it != dst_client->peer.end())
 	{
-		if(it->peer_pointer == src_client)
+		it->second.num_connection--;
+		IPACMDBG_H("Find src client entry in dst peer list, connection count: %d\n", it->second.num_connection);
+		if(it->second.num_connection == 0)
 		{
-			it->num_connection--;
-			IPACMDBG_H("Find src client entry in dst peer list, connection count: %d\n", it->num_connection);
-			if(it->num_connection == 0)
-			{
-				IPACMDBG_H("Need to remove src entry in dst peer list.\n");
-				ret = true;
-			}
-			break;
+			IPACMDBG_H("Need to remove src entry in dst peer list.\n");
+			dst_client->peer.erase(it);
+			ret = true;
 		}
 	}
-	if(ret == true)
-	{
-		dst_client->peer.erase(it);
-	}
 	return ret;
 }
 
@@ -986,31 +1094,23 @@ void IPACM_LanToLan::erase_offload_link(ipa_ip_type iptype, client_info* src_cli
 		return;
 	}
 
-	offload_link_info_list::iterator it;
+	offload_link_info_table::iterator it;
 	int res_src = IPACM_FAILURE, res_dst = IPACM_FAILURE;
 
-	for(it = src_client->link.begin(); it != src_client->link.end(); it++)
+	it = src_client->link.find(dst_client);
+	if(it != src_client->link.end())
 	{
-		if(it->peer_pointer == dst_client)
-		{
-			res_src = IPACM_SUCCESS;
-			IPACMDBG_H("Find dst client entry in src link list\n");
-			res_src = del_offload_link(iptype, src_client->p_iface, dst_client->p_iface, &(*it));
-			src_client->link.erase(it);
-			break;
-		}
+		IPACMDBG_H("Find dst client entry in src link list\n");
+		res_src = del_offload_link(iptype, src_client->p_iface, dst_client->p_iface, &(it->second));
+		src_client->link.erase(it);
 	}
 
-	for(it = dst_client->link.begin(); it != dst_client->link.end(); it++)
+	it = dst_client->link.find(src_client);
+	if(it != dst_client->link.end())
 	{
-		if(it->peer_pointer == src_client)
-		{
-			res_dst = IPACM_SUCCESS;
-			IPACMDBG_H("Find src client entry in dst link list\n");
-			res_dst = del_offload_link(iptype, dst_client->p_iface, src_client->p_iface, &(*it));
-			dst_client->link.erase(it);
-			break;
-		}
+		IPACMDBG_H("Find src client entry in dst link list\n");
+		res_dst = del_offload_link(iptype, dst_client->p_iface, src_client->p_iface, &(it->second));
+		dst_client->link.erase(it);
 	}
 
 	if(res_src == IPACM_SUCCESS && res_dst == IPACM_SUCCESS)
@@ -1193,37 +1293,28 @@ int IPACM_LanToLan::remove_flt_rules(ipa_ip_type iptype, client_info* client)
 		return IPACM_FAILURE;
 	}
 
-	bool err_flag;
-	offload_link_info_list::iterator client_it;
-	offload_link_info_list::iterator peer_it;
+	offload_link_info_table::iterator client_it;
+	offload_link_info_table::iterator peer_it;
 	client_info* peer;
 
 	for(client_it = client->link.begin(); client_it != client->link.end(); client_it++)
 	{
-		if(client->p_iface->del_lan2lan_flt_rule(iptype, client_it->flt_rule_hdl) == IPACM_FAILURE)
+		if(client->p_iface->del_lan2lan_flt_rule(iptype, client_it->second.flt_rule_hdl) == IPACM_FAILURE)
 		{
 			IPACMERR("Failed to delete client's filtering rule.\n");
 		}
 
-		err_flag = true;
-		peer = client_it->peer_pointer;
-		for(peer_it = peer->link.begin(); peer_it != peer->link.end(); peer_it++)
-		{
-			if(peer_it->peer_pointer == client)
-			{
-				if(peer->p_iface->del_lan2lan_flt_rule(iptype, peer_it->flt_rule_hdl) == IPACM_FAILURE)
-				{
-					IPACMERR("Failed to delete peer's offload link.\n");
-				}
-				err_flag = false;
-				break;
-			}
-		}
-		if(err_flag)
+		peer = client_it->first;
+		peer_it = peer->link.find(client);
+		if(peer_it == peer->link.end())
 		{
 			IPACMERR("Unable to find corresponding offload link in peer's entry.\n");
 			return IPACM_FAILURE;
 		}
+		if(peer->p_iface->del_lan2lan_flt_rule(iptype, peer_it->second.flt_rule_hdl) == IPACM_FAILURE)
+		{
+			IPACMERR("Failed to delete peer's offload link.\n");
+		}
 	}
 	return IPACM_SUCCESS;
 }
@@ -1236,42 +1327,42 @@ int IPACM_LanToLan::add_flt_rules(ipa_ip_type iptype, client_info* client)
 		return IPACM_FAILURE;
 	}
 
-	bool err_flag;
-	offload_link_info_list::iterator client_it;
-	offload_link_info_list::iterator peer_it;
+	offload_link_info_table::iterator client_it;
+	offload_link_info_table::iterator peer_it;
 	client_info* peer;
+	/* all ifaces share the IPA device, one txn covers the client's and
+		 every peer's rule */
+	IPACM_RuleTxn txn(&IPACM_Iface::m_filtering, &IPACM_Iface::m_routing, &IPACM_Iface::m_header);
 
 	for(client_it = client->link.begin(); client_it != client->link.end(); client_it++)
 	{
-		peer = client_it->peer_pointer;
+		peer = client_it->first;
 		if(client->p_iface->add_lan2lan_flt_rule(iptype, client->ip.ipv4_addr, peer->ip.ipv4_addr,
-			client->ip.ipv6_addr, peer->ip.ipv6_addr, &(client_it->flt_rule_hdl)) == IPACM_FAILURE)
+			client->ip.ipv6_addr, peer->ip.ipv6_addr, &(client_it->second.flt_rule_hdl), &txn) == IPACM_FAILURE)
 		{
 			IPACMERR("Failed to add client's filtering rule.\n");
-			return IPACM_FAILURE;
+			break;
 		}
 
-		err_flag = true;
-		for(peer_it = peer->link.begin(); peer_it != peer->link.end(); peer_it++)
+		peer_it = peer->link.find(client);
+		if(peer_it == peer->link.end())
 		{
-			if(peer_it->peer_pointer == client)
-			{
-				if(peer->p_iface->add_lan2lan_flt_rule(iptype, peer->ip.ipv4_addr, client->ip.ipv4_addr,
-					peer->ip.ipv6_addr, client->ip.ipv6_addr, &(peer_it->flt_rule_hdl)) == IPACM_FAILURE)
-				{
-					IPACMERR("Failed to delete peer's offload link.\n");
-					return IPACM_FAILURE;
-				}
-				err_flag = false;
-				break;
-			}
+			IPACMERR("Unable to find corresponding offload link in peer's entry.\n");
+			break;
 		}
-		if(err_flag)
+		if(peer->p_iface->add_lan2lan_flt_rule(iptype, peer->ip.ipv4_addr, client->ip.ipv4_addr,
+			peer->ip.ipv6_addr, client->ip.ipv6_addr, &(peer_it->second.flt_rule_hdl), &txn) == IPACM_FAILURE)
 		{
-			IPACMERR("Unable to find corresponding offload link in peer's entry.\n");
-			return IPACM_FAILURE;
+			IPACMERR("Failed to delete peer's offload link.\n");
+			break;
 		}
 	}
+
+	/* the rules queued so far took their slots, install them either way */
+	if(txn.Commit() == false || client_it != client->link.end())
+	{
+		return IPACM_FAILURE;
+	}
 	return IPACM_SUCCESS;
 }
 
@@ -1455,31 +1546,72 @@ bool IPACM_LanToLan::is_potential_lan2lan_connection(ipacm_event_connection* new
 	return false;
 }
 
+static inline uint64_t conn_key_v4(uint32_t src_ipv4_addr, uint32_t dst_ipv4_addr)
+{
+	return ((uint64_t)src_ipv4_addr << 32) | dst_ipv4_addr;
+}
+
+static inline void conn_key_v6(connection_key_v6* key, uint32_t* src_ipv6_addr, uint32_t* dst_ipv6_addr)
+{
+	memcpy(key->src_ipv6_addr, src_ipv6_addr, sizeof(key->src_ipv6_addr));
+	memcpy(key->dst_ipv6_addr, dst_ipv6_addr, sizeof(key->dst_ipv6_addr));
+}
+
 void IPACM_LanToLan::cache_new_connection(ipacm_event_connection* new_conn)
 {
 	if(is_potential_lan2lan_connection(new_conn) == true)
 	{
+		cached_connection cache;
+		cache.conn = *new_conn;
+		cache.num_connection = 1;
+
 		if(new_conn->iptype == IPA_IP_v4)
 		{
-			if(connection_v4_.size() == max_cache_connection)
+			connection_table_v4::iterator it;
+
+			if(num_cache_connection_v4_ == max_cache_connection)
 			{
-				IPACMDBG_H("Cached ipv4 connections already reach maximum, clear up the list.\n");
+				IPACMDBG_H("Cached ipv4 connections already reach maximum, clear up the table.\n");
 				connection_v4_.clear();
+				num_cache_connection_v4_ = 0;
 			}
 
-			connection_v4_.push_back(*new_conn);
-			IPACMDBG_H("Cache an ipv4 connection, now the number of ipv4 cache connection is %d.\n", connection_v4_.size());
+			it = connection_v4_.find(conn_key_v4(new_conn->src_ipv4_addr, new_conn->dst_ipv4_addr));
+			if(it != connection_v4_.end())
+			{
+				it->second.num_connection++;
+			}
+			else
+			{
+				connection_v4_[conn_key_v4(new_conn->src_ipv4_addr, new_conn->dst_ipv4_addr)] = cache;
+			}
+			num_cache_connection_v4_++;
+			IPACMDBG_H("Cache an ipv4 connection, now the number of ipv4 cache connection is %d.\n", num_cache_connection_v4_);
 		}
 		else
 		{
-			if(connection_v6_.size() == max_cache_connection)
+			connection_table_v6::iterator it;
+			connection_key_v6 key;
+
+			if(num_cache_connection_v6_ == max_cache_connection)
 			{
-				IPACMDBG_H("Cached ipv6 connections already reach maximum, clear up the list.\n");
+				IPACMDBG_H("Cached ipv6 connections already reach maximum, clear up the table.\n");
 				connection_v6_.clear();
+				num_cache_connection_v6_ = 0;
 			}
 
-			connection_v6_.push_back(*new_conn);
-			IPACMDBG_H("Cache an ipv6 connection, now the number of ipv6 cache connection is %d.\n", connection_v6_.size());
+			conn_key_v6(&key, new_conn->src_ipv6_addr, new_conn->dst_ipv6_addr);
+			it = connection_v6_.find(key);
+			if(it != connection_v6_.end())
+			{
+				it->second.num_connection++;
+			}
+			else
+			{
+				connection_v6_[key] = cache;
+			}
+			num_cache_connection_v6_++;
+			IPACMDBG_H("Cache an ipv6 connection, now the number of ipv6 cache connection is %d.\n", num_cache_connection_v6_);
 		}
 	}
 	return;
@@ -1487,73 +1619,101 @@ void IPACM_LanToLan::cache_new_connection(ipacm_event_connection* new_conn)
 
 void IPACM_LanToLan::remove_cache_connection(ipacm_event_connection* del_conn)
 {
-	connection_list::iterator it;
 	if(is_potential_lan2lan_connection(del_conn) == true)
 	{
 		if(del_conn->iptype == IPA_IP_v4)
 		{
-			for(it = connection_v4_.begin(); it != connection_v4_.end(); it++)
+			connection_table_v4::iterator it;
+
+			it = connection_v4_.find(conn_key_v4(del_conn->src_ipv4_addr, del_conn->dst_ipv4_addr));
+			if(it == connection_v4_.end())
 			{
-				if(it->src_ipv4_addr == del_conn->src_ipv4_addr && it->dst_ipv4_addr == del_conn->dst_ipv4_addr)
-				{
-					IPACMDBG("Find the cached ipv4 connection, remove it from list.\n");
-					connection_v4_.erase(it);
-					IPACMDBG_H("Now the number of ipv4 cache connection is %d.\n", connection_v4_.size());
-					return;
-				}
+				IPACMDBG_H("Do not find the cached ipv4 connection, do nothing.\n");
+				return;
+			}
+			IPACMDBG("Find the cached ipv4 connection, remove it from table.\n");
+			it->second.num_connection--;
+			if(it->second.num_connection == 0)
+			{
+				connection_v4_.erase(it);
 			}
-			IPACMDBG_H("Do not find the cached ipv4 connection, do nothing.\n");
+			num_cache_connection_v4_--;
+			IPACMDBG_H("Now the number of ipv4 cache connection is %d.\n", num_cache_connection_v4_);
 		}
 		else
 		{
-			for(it = connection_v6_.begin(); it != connection_v6_.end(); it++)
+			connection_table_v6::iterator it;
+			connection_key_v6 key;
+
+			conn_key_v6(&key, del_conn->src_ipv6_addr, del_conn->dst_ipv6_addr);
+			it = connection_v6_.find(key);
+			if(it == connection_v6_.end())
 			{
-				if(memcmp(it->src_ipv6_addr, del_conn->src_ipv6_addr, 4*sizeof(uint32_t)) == 0
-					&& memcmp(it->dst_ipv6_addr, del_conn->dst_ipv6_addr, 4*sizeof(uint32_t)) == 0 )
-				{
-					IPACMDBG("Find the cached ipv6 connection, remove it from list.\n");
-					connection_v6_.erase(it);
-					IPACMDBG_H("Now the number of ipv6 cache connection is %d.\n", connection_v6_.size());
-					return;
-				}
+				IPACMDBG_H("Do not find the cached ipv6 connection, do nothing.\n");
+				return;
+			}
+			IPACMDBG("Find the cached ipv6 connection, remove it from table.\n");
+			it->second.num_connection--;
+			if(it->second.num_connection == 0)
+			{
+				connection_v6_.erase(it);
 			}
-			IPACMDBG_H("Do not find the cached ipv6 connection, do nothing.\n");
+			num_cache_connection_v6_--;
+			IPACMDBG_H("Now the number of ipv6 cache connection is %d.\n", num_cache_connection_v6_);
 		}
 	}
 	return;
 }
 
+//replay every cached connection of a pair as new_connection events
+static int post_cached_connection(cached_connection* cache)
+{
+	ipacm_cmd_q_data evt;
+	ipacm_event_connection* conn;
+	int i;
+
+	for(i = 0; i < cache->num_connection; i++)
+	{
+		conn = (ipacm_event_connection*)malloc(sizeof(ipacm_event_connection));
+		if(conn == NULL)
+		{
+			IPACMERR("Failed to allocate memory for new_connection event.\n");
+			return IPACM_FAILURE;
+		}
+		memcpy(conn, &(cache->conn), sizeof(ipacm_event_connection));
+
+		memset(&evt, 0, sizeof(evt));
+		evt.event = IPA_LAN_TO_LAN_NEW_CONNECTION;
+		evt.evt_data = (void*)conn;
+		IPACM_EvtDispatcher::PostEvt(&evt);
+	}
+	return IPACM_SUCCESS;
+}
+
 void IPACM_LanToLan::check_cache_connection(ipa_ip_type iptype, client_info* client)
 {
 #ifdef CT_OPT
-	connection_list::iterator it;
 	if(iptype == IPA_IP_v4)
 	{
+		connection_table_v4::iterator it;
+		ipacm_event_connection* conn;
+
 		it = connection_v4_.begin();
 		while(it != connection_v4_.end())
 		{
-			if( (it->src_ipv4_addr == client->ip.ipv4_addr && client_info_v4_.count(it->dst_ipv4_addr) > 0)
-				|| (it->dst_ipv4_addr == client->ip.ipv4_addr && client_info_v4_.count(it->src_ipv4_addr) > 0) )
+			conn = &(it->second.conn);
+			if( (conn->src_ipv4_addr == client->ip.ipv4_addr && client_info_v4_.count(conn->dst_ipv4_addr) > 0)
+				|| (conn->dst_ipv4_addr == client->ip.ipv4_addr && client_info_v4_.count(conn->src_ipv4_addr) > 0) )
 			{
-				IPACMDBG("Found a cache connection for src client 0x%08x and dst client 0x%08x.\n", it->src_ipv4_addr, it->dst_ipv4_addr);
-				ipacm_cmd_q_data evt;
-				ipacm_event_connection* conn;
-
-				conn = (ipacm_event_connection*)malloc(sizeof(ipacm_event_connection));
-				if(conn == NULL)
+				IPACMDBG("Found a cache connection for src client 0x%08x and dst client 0x%08x.\n", conn->src_ipv4_addr, conn->dst_ipv4_addr);
+				if(post_cached_connection(&(it->second)) == IPACM_FAILURE)
 				{
-					IPACMERR("Failed to allocate memory for new_connection event.\n");
 					return;
 				}
-				memcpy(conn, &(*it), sizeof(ipacm_event_connection));
-
-				memset(&evt, 0, sizeof(evt));
-				evt.event = IPA_LAN_TO_LAN_NEW_CONNECTION;
-				evt.evt_data = (void*)conn;
-				IPACM_EvtDispatcher::PostEvt(&evt);
 
+				num_cache_connection_v4_ -= it->second.num_connection;
 				it = connection_v4_.erase(it);
-				IPACMDBG_H("Now the number of cache connections is %d.\n", connection_v4_.size());
+				IPACMDBG_H("Now the number of cache connections is %d.\n", num_cache_connection_v4_);
 			}
 			else
 			{
@@ -1563,36 +1723,30 @@ void IPACM_LanToLan::check_cache_connection(ipa_ip_type iptype, client_info* cli
 	}
 	else
 	{
+		connection_table_v6::iterator it;
+		ipacm_event_connection* conn;
 		uint64_t src_v6_addr, dst_v6_addr;
+
 		it = connection_v6_.begin();
 		while(it != connection_v6_.end())
 		{
-			memcpy(&src_v6_addr, &(it->src_ipv6_addr[2]), sizeof(uint64_t));
-			memcpy(&dst_v6_addr, &(it->dst_ipv6_addr[2]), sizeof(uint64_t));
-			if( (memcmp(it->src_ipv6_addr, client->ip.ipv6_addr, 4*sizeof(uint32_t)) == 0 && client_info_v6_.count(dst_v6_addr) > 0)
-				|| (memcmp(it->dst_ipv6_addr, client->ip.ipv6_addr, 4*sizeof(uint32_t)) == 0 && client_info_v6_.count(src_v6_addr) > 0) )
+			conn = &(it->second.conn);
+			memcpy(&src_v6_addr, &(conn->src_ipv6_addr[2]), sizeof(uint64_t));
+			memcpy(&dst_v6_addr, &(conn->dst_ipv6_addr[2]), sizeof(uint64_t));
+			if( (memcmp(conn->src_ipv6_addr, client->ip.ipv6_addr, 4*sizeof(uint32_t)) == 0 && client_info_v6_.count(dst_v6_addr) > 0)
+				|| (memcmp(conn->dst_ipv6_addr, client->ip.ipv6_addr, 4*sizeof(uint32_t)) == 0 && client_info_v6_.count(src_v6_addr) > 0) )
 			{
-				IPACMDBG("Found a cache connection with src client 0x%08x%08x%08x%08x and dst client 0x%08x%08x%08x%08x.\n", it->src_ipv6_addr[0],
-							it->src_ipv6_addr[1], it->src_ipv6_addr[2], it->src_ipv6_addr[3], it->dst_ipv6_addr[0], it->dst_ipv6_addr[1],
-							it->dst_ipv6_addr[2], it->dst_ipv6_addr[3]);
-				ipacm_cmd_q_data evt;
-				ipacm_event_connection* conn;
-
-				conn = (ipacm_event_connection*)malloc(sizeof(ipacm_event_connection));
-				if(conn == NULL)
+				IPACMDBG("Found a cache connection with src client 0x%08x%08x%08x%08x and dst client 0x%08x%08x%08x%08x.\n", conn->src_ipv6_addr[0],
+							conn->src_ipv6_addr[1], conn->src_ipv6_addr[2], conn->src_ipv6_addr[3], conn->dst_ipv6_addr[0], conn->dst_ipv6_addr[1],
+							conn->dst_ipv6_addr[2], conn->dst_ipv6_addr[3]);
+				if(post_cached_connection(&(it->second)) == IPACM_FAILURE)
 				{
-					IPACMERR("Failed to allocate memory for new_connection event.\n");
 					return;
 				}
-				memcpy(conn, &(*it), sizeof(ipacm_event_connection));
-
-				memset(&evt, 0, sizeof(evt));
-				evt.event = IPA_LAN_TO_LAN_NEW_CONNECTION;
-				evt.evt_data = (void*)conn;
-				IPACM_EvtDispatcher::PostEvt(&evt);
 
+				num_cache_connection_v6_ -= it->second.num_connection;
 				it = connection_v6_.erase(it);
-				IPACMDBG_H("Now the number of cache connections is %d.\n", connection_v6_.size());
+				IPACMDBG_H("Now the number of cache connections is %d.\n", num_cache_connection_v6_);
 			}
 			else
 			{
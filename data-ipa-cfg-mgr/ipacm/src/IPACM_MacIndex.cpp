@@ -0,0 +1,150 @@
+/*
+Copyright (c) 2014, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_MacIndex.cpp
+
+	@brief
+	This file implements the MAC address keyed client index
+
+	@Author
+
+*/
+
+#include <string.h>
+
+#include "IPACM_MacIndex.h"
+#include "IPACM_Log.h"
+
+#define IPACM_MAC_INDEX_MASK (IPACM_MAC_INDEX_SLOTS - 1)
+
+IPACM_MacIndex::IPACM_MacIndex()
+{
+	Reset();
+}
+
+void IPACM_MacIndex::Reset()
+{
+	int i;
+
+	for (i = 0; i < IPACM_MAC_INDEX_SLOTS; i++)
+	{
+		slot[i].pos = IPACM_MAC_INDEX_EMPTY;
+	}
+	num = 0;
+}
+
+/* the vendor OUI is shared by most clients, weigh the NIC specific bytes */
+int IPACM_MacIndex::Hash(const uint8_t *mac)
+{
+	uint32_t h;
+
+	h = ((uint32_t)mac[5] | ((uint32_t)mac[4] << 8) | ((uint32_t)mac[3] << 16)) * 2654435761U;
+	h ^= ((uint32_t)mac[2] | ((uint32_t)mac[1] << 8) | ((uint32_t)mac[0] << 16));
+	return (int)((h >> 16) & IPACM_MAC_INDEX_MASK);
+}
+
+/* slot holding mac, or the empty slot ending its probe chain */
+int IPACM_MacIndex::Lookup(const uint8_t *mac)
+{
+	int i;
+
+	for (i = Hash(mac); slot[i].pos != IPACM_MAC_INDEX_EMPTY; i = (i + 1) & IPACM_MAC_INDEX_MASK)
+	{
+		if (memcmp(slot[i].mac, mac, IPA_MAC_ADDR_SIZE) == 0)
+		{
+			break;
+		}
+	}
+	return i;
+}
+
+int IPACM_MacIndex::Find(const uint8_t *mac)
+{
+	int i;
+
+	i = Lookup(mac);
+	if (slot[i].pos == IPACM_MAC_INDEX_EMPTY)
+	{
+		return IPACM_INVALID_INDEX;
+	}
+	return slot[i].pos;
+}
+
+bool IPACM_MacIndex::Insert(const uint8_t *mac, int pos)
+{
+	int i;
+
+	i = Lookup(mac);
+	if (slot[i].pos == IPACM_MAC_INDEX_EMPTY)
+	{
+		if (2 * (num + 1) > IPACM_MAC_INDEX_SLOTS)
+		{
+			IPACMERR("MAC index is full (%d entries)\n", num);
+			return false;
+		}
+		memcpy(slot[i].mac, mac, IPA_MAC_ADDR_SIZE);
+		num++;
+	}
+	slot[i].pos = pos;
+	return true;
+}
+
+/* backward shift delete, no tombstones so lookups never degrade */
+void IPACM_MacIndex::Remove(const uint8_t *mac)
+{
+	int i, j, home;
+
+	i = Lookup(mac);
+	if (slot[i].pos == IPACM_MAC_INDEX_EMPTY)
+	{
+		return;
+	}
+
+	j = i;
+	while (1)
+	{
+		j = (j + 1) & IPACM_MAC_INDEX_MASK;
+		if (slot[j].pos == IPACM_MAC_INDEX_EMPTY)
+		{
+			break;
+		}
+
+		/* slot j can fill the hole only if its home is not in (i, j] */
+		home = Hash(slot[j].mac);
+		if ((i <= j) ? (i < home && home <= j) : (i < home || home <= j))
+		{
+			continue;
+		}
+		slot[i] = slot[j];
+		i = j;
+	}
+	slot[i].pos = IPACM_MAC_INDEX_EMPTY;
+	num--;
+}
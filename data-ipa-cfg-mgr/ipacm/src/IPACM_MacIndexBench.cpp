@@ -0,0 +1,327 @@
+/*
+Copyright (c) 2013, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_MacIndexBench.cpp
+
+	@brief
+	Benchmark for the MAC keyed client index
+
+	Replays a roaming storm of wlan client add and del events against a
+	client table of IPA_MAX_NUM_WIFI_CLIENTS entries. Each event looks the
+	MAC up, as the IPACM_Wlan handlers do, then adds the client at the end
+	of the table or removes it. The table is run twice: once found by a
+	linear MAC compare with the tail shifted down on removal, as before
+	the index, and once through IPACM_MacIndex with the last entry moved
+	into the hole. Then the tables are filled up and lookups alone are
+	timed over the MAC pool, hits and misses, as on the route rule and
+	power save paths. Both tables must agree on every lookup.
+
+	The entries are spaced like get_client_memptr() entries, whose size
+	depends on the number of tx properties, so it can be set with -s.
+
+	@Author
+
+*/
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "IPACM_MacIndex.h"
+#include "IPACM_Log.h"
+
+#define MAC_BENCH_DEF_EVENTS   1000000
+#define MAC_BENCH_DEF_STRIDE   256
+#define MAC_BENCH_MAC_OFFSET   8
+
+typedef struct
+{
+	uint8_t *entries;
+	int stride;
+	int num;
+	IPACM_MacIndex idx;
+} mac_bench_table;
+
+void ipacm_log_send(void *user_data)
+{
+	(void)user_data;
+}
+
+static uint64_t bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint8_t *bench_mac(mac_bench_table *tbl, int pos)
+{
+	return tbl->entries + pos * tbl->stride + MAC_BENCH_MAC_OFFSET;
+}
+
+static int bench_scan_find(mac_bench_table *tbl, const uint8_t *mac)
+{
+	int cnt;
+
+	for(cnt = 0; cnt < tbl->num; cnt++)
+	{
+		if(memcmp(bench_mac(tbl, cnt), mac, IPA_MAC_ADDR_SIZE) == 0)
+		{
+			return cnt;
+		}
+	}
+	return IPACM_INVALID_INDEX;
+}
+
+static void bench_scan_del(mac_bench_table *tbl, int pos)
+{
+	int cnt;
+
+	for(cnt = pos; cnt < tbl->num - 1; cnt++)
+	{
+		memcpy(tbl->entries + cnt * tbl->stride,
+					 tbl->entries + (cnt + 1) * tbl->stride, tbl->stride);
+	}
+	tbl->num--;
+}
+
+static void bench_index_del(mac_bench_table *tbl, int pos)
+{
+	tbl->idx.Remove(bench_mac(tbl, pos));
+	tbl->num--;
+	if(pos != tbl->num)
+	{
+		memcpy(tbl->entries + pos * tbl->stride,
+					 tbl->entries + tbl->num * tbl->stride, tbl->stride);
+		tbl->idx.Insert(bench_mac(tbl, pos), pos);
+	}
+}
+
+/* One add or del per event */
+static void bench_storm(mac_bench_table *tbl, bool indexed, const uint8_t *macs,
+				const uint32_t *events, uint32_t num_events, uint64_t *ns, uint32_t *found)
+{
+	const uint8_t *mac;
+	uint64_t start;
+	uint32_t cnt;
+	int pos;
+
+	*found = 0;
+	start = bench_now();
+	for(cnt = 0; cnt < num_events; cnt++)
+	{
+		mac = macs + events[cnt] * IPA_MAC_ADDR_SIZE;
+		pos = indexed ? tbl->idx.Find(mac) : bench_scan_find(tbl, mac);
+		if(pos != IPACM_INVALID_INDEX)
+		{
+			(*found)++;
+			if(indexed)
+			{
+				bench_index_del(tbl, pos);
+			}
+			else
+			{
+				bench_scan_del(tbl, pos);
+			}
+		}
+		else if(tbl->num < IPA_MAX_NUM_WIFI_CLIENTS)
+		{
+			memcpy(bench_mac(tbl, tbl->num), mac, IPA_MAC_ADDR_SIZE);
+			if(indexed)
+			{
+				tbl->idx.Insert(mac, tbl->num);
+			}
+			tbl->num++;
+		}
+	}
+	*ns = bench_now() - start;
+}
+
+/* Add the pool clients not cached yet until the table is full */
+static void bench_fill(mac_bench_table *tbl, bool indexed, const uint8_t *macs, uint32_t num_macs)
+{
+	const uint8_t *mac;
+	uint32_t cnt;
+	int pos;
+
+	for(cnt = 0; cnt < num_macs && tbl->num < IPA_MAX_NUM_WIFI_CLIENTS; cnt++)
+	{
+		mac = macs + cnt * IPA_MAC_ADDR_SIZE;
+		pos = indexed ? tbl->idx.Find(mac) : bench_scan_find(tbl, mac);
+		if(pos == IPACM_INVALID_INDEX)
+		{
+			memcpy(bench_mac(tbl, tbl->num), mac, IPA_MAC_ADDR_SIZE);
+			if(indexed)
+			{
+				tbl->idx.Insert(mac, tbl->num);
+			}
+			tbl->num++;
+		}
+	}
+}
+
+/* Lookups of the pool clients, cached or not, in pool order */
+static uint64_t bench_lookups(mac_bench_table *tbl, bool indexed, const uint8_t *macs,
+				uint32_t num_macs, uint32_t num_lookups, uint32_t *hits)
+{
+	const uint8_t *mac;
+	uint64_t start;
+	uint32_t cnt;
+	int pos;
+
+	*hits = 0;
+	start = bench_now();
+	for(cnt = 0; cnt < num_lookups; cnt++)
+	{
+		mac = macs + (cnt % num_macs) * IPA_MAC_ADDR_SIZE;
+		pos = indexed ? tbl->idx.Find(mac) : bench_scan_find(tbl, mac);
+		if(pos != IPACM_INVALID_INDEX &&
+			 memcmp(bench_mac(tbl, pos), mac, IPA_MAC_ADDR_SIZE) == 0)
+		{
+			(*hits)++;
+		}
+	}
+	return bench_now() - start;
+}
+
+static void bench_usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-e events] [-m macs] [-s entry size] [-r seed]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+	mac_bench_table tbl[2];
+	uint32_t num_events = MAC_BENCH_DEF_EVENTS, num_macs = 2 * IPA_MAX_NUM_WIFI_CLIENTS;
+	uint32_t *events, cnt, found[2], hits[2];
+	unsigned int seed = 1;
+	uint64_t storm_ns[2], find_ns[2];
+	uint8_t *macs;
+	int stride = MAC_BENCH_DEF_STRIDE, opt, t;
+
+	while((opt = getopt(argc, argv, "e:m:s:r:h")) != -1)
+	{
+		switch(opt)
+		{
+		case 'e':
+			num_events = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			num_macs = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			stride = atoi(optarg);
+			break;
+		case 'r':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			bench_usage(argv[0]);
+			return 1;
+		}
+	}
+	if(num_events == 0 || num_macs == 0 || num_macs > 0x10000 || stride < MAC_BENCH_MAC_OFFSET + IPA_MAC_ADDR_SIZE)
+	{
+		bench_usage(argv[0]);
+		return 1;
+	}
+
+	/* distinct clients of one vendor OUI */
+	macs = (uint8_t *)malloc(num_macs * IPA_MAC_ADDR_SIZE);
+	events = (uint32_t *)malloc(num_events * sizeof(uint32_t));
+	if(macs == NULL || events == NULL)
+	{
+		fprintf(stderr, "unable to allocate %u events\n", num_events);
+		return 1;
+	}
+	for(cnt = 0; cnt < num_macs; cnt++)
+	{
+		macs[cnt * IPA_MAC_ADDR_SIZE] = 0x00;
+		macs[cnt * IPA_MAC_ADDR_SIZE + 1] = 0x0a;
+		macs[cnt * IPA_MAC_ADDR_SIZE + 2] = 0xf5;
+		macs[cnt * IPA_MAC_ADDR_SIZE + 3] = (uint8_t)rand_r(&seed);
+		macs[cnt * IPA_MAC_ADDR_SIZE + 4] = (uint8_t)(cnt >> 8);
+		macs[cnt * IPA_MAC_ADDR_SIZE + 5] = (uint8_t)cnt;
+	}
+	for(cnt = 0; cnt < num_events; cnt++)
+	{
+		events[cnt] = (uint32_t)rand_r(&seed) % num_macs;
+	}
+
+	for(t = 0; t < 2; t++)
+	{
+		tbl[t].entries = (uint8_t *)calloc(IPA_MAX_NUM_WIFI_CLIENTS, stride);
+		tbl[t].stride = stride;
+		tbl[t].num = 0;
+		if(tbl[t].entries == NULL)
+		{
+			fprintf(stderr, "unable to allocate the client table\n");
+			return 1;
+		}
+		bench_storm(&tbl[t], t == 1, macs, events, num_events, &storm_ns[t], &found[t]);
+		bench_fill(&tbl[t], t == 1, macs, num_macs);
+		find_ns[t] = bench_lookups(&tbl[t], t == 1, macs, num_macs, num_events, &hits[t]);
+	}
+
+	printf("%u events over %u macs, %d clients max, %d byte entries\n",
+				 num_events, num_macs, IPA_MAX_NUM_WIFI_CLIENTS, stride);
+	printf("%-6s %12s %12s\n", "table", "event ns", "lookup ns");
+	for(t = 0; t < 2; t++)
+	{
+		printf("%-6s %12.1f %12.1f\n", (t == 1) ? "index" : "scan",
+					 (double)storm_ns[t] / num_events, (double)find_ns[t] / num_events);
+	}
+
+	/* the tables hold clients in different orders, but the same set */
+	if(found[0] != found[1] || hits[0] != hits[1] || tbl[0].num != tbl[1].num ||
+		 tbl[1].idx.GetCount() != tbl[1].num)
+	{
+		printf("MISMATCH: scan found %u/%u, index found %u/%u\n",
+					 found[0], hits[0], found[1], hits[1]);
+		return 1;
+	}
+	for(cnt = 0; cnt < (uint32_t)tbl[0].num; cnt++)
+	{
+		if(tbl[1].idx.Find(bench_mac(&tbl[0], cnt)) == IPACM_INVALID_INDEX)
+		{
+			printf("MISMATCH: client %u of the scan table not indexed\n", cnt);
+			return 1;
+		}
+	}
+
+	free(tbl[0].entries);
+	free(tbl[1].entries);
+	free(events);
+	free(macs);
+	return 0;
+}
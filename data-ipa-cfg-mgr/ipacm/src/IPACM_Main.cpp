@@ -70,6 +70,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_ConntrackListener.h"
 #include "IPACM_ConntrackClient.h"
 #include "IPACM_Netlink.h"
+#include "IPACM_Stats.h"
 
 /* not defined(FEATURE_IPA_ANDROID)*/
 #ifndef FEATURE_IPA_ANDROID
@@ -145,6 +146,7 @@ const char *ipacm_event_name[] = {
 #define IPA_DRIVER_WLAN_BUF_LEN     (IPA_DRIVER_PIPE_STATS_EVENT_SIZE + IPA_DRIVER_WLAN_META_MSG)
 
 uint32_t ipacm_event_stats[IPACM_EVENT_MAX];
+uint32_t ipacm_event_latency[IPACM_EVENT_MAX][IPACM_EVT_LAT_BUCKETS];
 bool ipacm_logging = true;
 
 void ipa_is_ipacm_running(void);
@@ -702,6 +704,8 @@ int main(int argc, char **argv)
 #endif
 	IPACM_ConntrackClient *cc = IPACM_ConntrackClient::GetInstance();
 	CtList = new IPACM_ConntrackListener();
+	/* map the stats region before the first stats message arrives */
+	IPACM_Stats::GetInstance();
 
 	IPACMDBG_H("Staring IPA main\n");
 	IPACMDBG_H("ipa_cmdq_successful\n");
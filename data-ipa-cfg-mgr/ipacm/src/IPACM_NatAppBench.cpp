@@ -0,0 +1,606 @@
+/*
+Copyright (c) 2013, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_NatAppBench.cpp
+
+	@brief
+	Benchmark for the NatApp connection cache and its timer wheel
+
+	Replays a synthetic conntrack event stream against NatApp. Each event
+	picks one of the generated flows at random and adds it, adds it again
+	(a duplicate) or deletes it. The latency of each kind of call is
+	reported.
+
+	Then it fills the cache with UDP flows, of which only some carry
+	traffic, and runs UpdateUDPTimeStamp() once per timer tick. A flow is
+	destroyed, as conntrack would, once its timeout passes without NatApp
+	refreshing it, so an active flow that the wheel checks too late shows
+	up as lost. Each tick reports how many HW timestamps were queried and
+	how many conntrack entries were refreshed. A fixed period poll would
+	query every cached flow on every tick.
+
+	libipanat, libnetfilter_conntrack and IPACM_Config are replaced by the
+	stubs below, so the bench needs neither IPA hardware nor root.
+	CLOCK_MONOTONIC is replaced by a simulated clock so that the ticks,
+	UDP_TIMEOUT_UPDATE seconds each, run back to back. NatApp logs with
+	printf, so stdout goes to /dev/null and the report to stderr.
+
+	@Author
+
+*/
+
+#include <dlfcn.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+
+#include "IPACM_Conntrack_NATApp.h"
+#include "IPACM_ConntrackClient.h"
+
+#define NAT_BENCH_DEF_ENTRIES   500
+#define NAT_BENCH_DEF_EVENTS    200000
+#define NAT_BENCH_DEF_TICKS     16
+#define NAT_BENCH_DEF_ACTIVE    10
+#define NAT_BENCH_DEF_UDP_TO    120
+#define NAT_BENCH_PUBLIC_IP     0x0a000001
+
+enum nat_bench_op
+{
+	NAT_BENCH_ADD,
+	NAT_BENCH_DUP,
+	NAT_BENCH_DEL,
+	NAT_BENCH_MAX_OP
+};
+
+static const char *nat_bench_op_name[NAT_BENCH_MAX_OP] =
+{
+	"add", "dup", "del"
+};
+
+typedef struct
+{
+	uint64_t *ns;
+	uint32_t num;
+	uint32_t failed;
+} nat_bench_lat;
+
+/* Stubbed device and conntrack state */
+static int bench_max_entries = NAT_BENCH_DEF_ENTRIES;
+static int bench_active_pct = NAT_BENCH_DEF_ACTIVE;
+static uint32_t bench_rule_hdl;
+static uint32_t bench_queries;
+static uint32_t bench_ct_updates;
+static uint32_t bench_ct_src_ip;
+static uint16_t bench_ct_src_port;
+static uint32_t bench_udp_timeout = NAT_BENCH_DEF_UDP_TO;
+/* Tick at which conntrack destroys each flow, 0 once destroyed */
+static uint32_t *bench_expire;
+static uint32_t bench_num_flows;
+static time_t bench_clock_sec = UDP_TIMEOUT_UPDATE;
+
+typedef int (*bench_clock_fn)(clockid_t, struct timespec *);
+static bench_clock_fn bench_real_clock;
+
+/* NatApp only reads CLOCK_MONOTONIC to place timers on the wheel. The
+	 simulated clock stays far behind the real one, so the timed waits of
+	 WaitForTimers() return at once */
+extern "C" int clock_gettime(clockid_t clk, struct timespec *ts)
+{
+	if(clk == CLOCK_MONOTONIC)
+	{
+		ts->tv_sec = __atomic_load_n(&bench_clock_sec, __ATOMIC_RELAXED);
+		ts->tv_nsec = 0;
+		return 0;
+	}
+
+	return bench_real_clock(clk, ts);
+}
+
+static uint64_t bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t bench_tick(void)
+{
+	return (uint32_t)(bench_clock_sec / UDP_TIMEOUT_UPDATE);
+}
+
+static uint32_t bench_expiry(void)
+{
+	return bench_tick() + (bench_udp_timeout + UDP_TIMEOUT_UPDATE - 1) / UDP_TIMEOUT_UPDATE;
+}
+
+/* Rule handles are handed out in flow order, flow id + 1 */
+static bool bench_is_active(uint32_t rule_handle)
+{
+	return (int)(rule_handle % 100) < bench_active_pct;
+}
+
+void ipacm_log_send(void *user_data)
+{
+	(void)user_data;
+}
+
+IPACM_Config *IPACM_Config::pInstance = NULL;
+
+IPACM_Config::IPACM_Config()
+{
+	ipa_nat_max_entries = bench_max_entries;
+	ipa_num_alg_ports = 0;
+}
+
+IPACM_Config *IPACM_Config::GetInstance()
+{
+	if(pInstance == NULL)
+	{
+		pInstance = new IPACM_Config();
+	}
+
+	return pInstance;
+}
+
+int IPACM_Config::GetAlgPorts(int nPorts, ipacm_alg *pAlgPorts)
+{
+	(void)nPorts;
+	(void)pAlgPorts;
+	return 0;
+}
+
+extern "C"
+{
+
+int ipa_nat_add_ipv4_tbl(uint32_t public_ip_addr,
+				uint16_t number_of_entries,
+				uint32_t *table_handle)
+{
+	*table_handle = 1;
+	return 0;
+}
+
+int ipa_nat_del_ipv4_tbl(uint32_t table_handle)
+{
+	return 0;
+}
+
+int ipa_nat_add_ipv4_rule(uint32_t table_handle,
+				const ipa_nat_ipv4_rule *rule,
+				uint32_t *rule_handle)
+{
+	*rule_handle = ++bench_rule_hdl;
+	return 0;
+}
+
+int ipa_nat_add_ipv4_rules(uint32_t table_handle,
+				const ipa_nat_ipv4_rule *rules,
+				uint32_t num_rules,
+				uint32_t *rule_handles)
+{
+	uint32_t cnt;
+
+	for(cnt = 0; cnt < num_rules; cnt++)
+	{
+		rule_handles[cnt] = ++bench_rule_hdl;
+	}
+	return 0;
+}
+
+int ipa_nat_del_ipv4_rule(uint32_t table_handle,
+				uint32_t rule_handle)
+{
+	return 0;
+}
+
+/* Flows carrying traffic get a new HW timestamp every tick */
+int ipa_nat_query_timestamp(uint32_t table_handle,
+				uint32_t rule_handle,
+				uint32_t *time_stamp)
+{
+	bench_queries++;
+	*time_stamp = bench_is_active(rule_handle) ? bench_tick() : 0;
+	return 0;
+}
+
+struct nfct_handle *nfct_open(uint8_t subsys_id, unsigned subscriptions)
+{
+	return (struct nfct_handle *)&bench_ct_updates;
+}
+
+struct nf_conntrack *nfct_new(void)
+{
+	return (struct nf_conntrack *)&bench_ct_updates;
+}
+
+void nfct_set_attr_u8(struct nf_conntrack *ct, const enum nf_conntrack_attr type, uint8_t value)
+{
+}
+
+void nfct_set_attr_u16(struct nf_conntrack *ct, const enum nf_conntrack_attr type, uint16_t value)
+{
+	if(type == ATTR_PORT_SRC)
+	{
+		bench_ct_src_port = ntohs(value);
+	}
+}
+
+void nfct_set_attr_u32(struct nf_conntrack *ct, const enum nf_conntrack_attr type, uint32_t value)
+{
+	if(type == ATTR_IPV4_SRC)
+	{
+		bench_ct_src_ip = ntohl(value);
+	}
+}
+
+uint16_t nfct_get_attr_u16(const struct nf_conntrack *ct, const enum nf_conntrack_attr type)
+{
+	return 0;
+}
+
+uint32_t nfct_get_attr_u32(const struct nf_conntrack *ct, const enum nf_conntrack_attr type)
+{
+	return 0;
+}
+
+/* Refresh the conntrack timeout of the flow named by the source tuple */
+int nfct_query(struct nfct_handle *h, const enum nf_conntrack_query query, const void *data)
+{
+	uint32_t id;
+
+	bench_ct_updates++;
+	id = (bench_ct_src_port - 1024) * 200 + (bench_ct_src_ip - 0xc0a80102);
+	if(bench_expire != NULL && id < bench_num_flows && bench_expire[id] != 0)
+	{
+		bench_expire[id] = bench_expiry();
+	}
+	return 0;
+}
+
+}
+
+/* Distinct 5-tuple per flow id */
+static void bench_flow(uint32_t id, uint8_t protocol, nat_table_entry *rule)
+{
+	memset(rule, 0, sizeof(*rule));
+	rule->private_ip = 0xc0a80102 + (id % 200);
+	rule->private_port = 1024 + (id / 200) % 60000;
+	rule->target_ip = 0x08080808 + (id % 7);
+	rule->target_port = (protocol == IPPROTO_UDP) ? 53 : 443;
+	rule->public_port = 1024 + (id % 60000);
+	rule->protocol = protocol;
+}
+
+static int bench_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void bench_print_lat(FILE *out, nat_bench_lat *lat)
+{
+	uint64_t sum;
+	uint32_t cnt;
+	int op;
+
+	fprintf(out, "%-6s %8s %7s %9s %9s %9s %9s %9s\n", "op", "count", "failed",
+					"min ns", "avg ns", "p50 ns", "p99 ns", "max ns");
+	for(op = 0; op < NAT_BENCH_MAX_OP; op++)
+	{
+		if(lat[op].num == 0)
+		{
+			fprintf(out, "%-6s %8u %7u\n", nat_bench_op_name[op], 0, lat[op].failed);
+			continue;
+		}
+
+		qsort(lat[op].ns, lat[op].num, sizeof(*lat[op].ns), bench_cmp);
+		for(cnt = 0, sum = 0; cnt < lat[op].num; cnt++)
+		{
+			sum += lat[op].ns[cnt];
+		}
+		fprintf(out, "%-6s %8u %7u %9llu %9llu %9llu %9llu %9llu\n",
+						nat_bench_op_name[op], lat[op].num, lat[op].failed,
+						(unsigned long long)lat[op].ns[0],
+						(unsigned long long)(sum / lat[op].num),
+						(unsigned long long)lat[op].ns[lat[op].num / 2],
+						(unsigned long long)lat[op].ns[(uint64_t)lat[op].num * 99 / 100],
+						(unsigned long long)lat[op].ns[lat[op].num - 1]);
+	}
+}
+
+/* Random add/duplicate add/delete stream over num_flows flows */
+static int bench_events(FILE *out, NatApp *nat, uint32_t num_events,
+				uint32_t num_flows, unsigned int seed)
+{
+	nat_bench_lat lat[NAT_BENCH_MAX_OP];
+	nat_table_entry rule;
+	bool *cached;
+	uint32_t cnt, id;
+	uint64_t start;
+	int op, ret;
+
+	memset(lat, 0, sizeof(lat));
+	cached = (bool *)calloc(num_flows, sizeof(bool));
+	for(op = 0; op < NAT_BENCH_MAX_OP; op++)
+	{
+		lat[op].ns = (uint64_t *)malloc(sizeof(uint64_t) * num_events);
+	}
+	if(cached == NULL || lat[NAT_BENCH_ADD].ns == NULL ||
+		 lat[NAT_BENCH_DUP].ns == NULL || lat[NAT_BENCH_DEL].ns == NULL)
+	{
+		fprintf(out, "unable to allocate %u event samples\n", num_events);
+		ret = -1;
+		goto done;
+	}
+
+	for(cnt = 0; cnt < num_events; cnt++)
+	{
+		id = (uint32_t)rand_r(&seed) % num_flows;
+		bench_flow(id, (id & 1) ? IPPROTO_TCP : IPPROTO_UDP, &rule);
+		if(cached[id] == false)
+		{
+			op = NAT_BENCH_ADD;
+		}
+		else
+		{
+			op = (rand_r(&seed) % 4 == 0) ? NAT_BENCH_DUP : NAT_BENCH_DEL;
+		}
+
+		start = bench_now();
+		if(op == NAT_BENCH_DEL)
+		{
+			ret = nat->DeleteEntry(&rule);
+		}
+		else
+		{
+			ret = nat->AddEntry(&rule);
+		}
+		lat[op].ns[lat[op].num++] = bench_now() - start;
+
+		if(op == NAT_BENCH_ADD)
+		{
+			/* fails once the cache is full */
+			if(ret == 0)
+			{
+				cached[id] = true;
+			}
+			else
+			{
+				lat[op].failed++;
+			}
+		}
+		else if(op == NAT_BENCH_DUP)
+		{
+			/* a duplicate has to be refused */
+			if(ret == 0)
+			{
+				lat[op].failed++;
+			}
+		}
+		else
+		{
+			cached[id] = false;
+		}
+	}
+
+	fprintf(out, "%u events over %u flows, %d cache entries\n",
+					num_events, num_flows, bench_max_entries);
+	bench_print_lat(out, lat);
+
+	/* leave the cache empty for the timer wheel run */
+	for(id = 0; id < num_flows; id++)
+	{
+		if(cached[id])
+		{
+			bench_flow(id, (id & 1) ? IPPROTO_TCP : IPPROTO_UDP, &rule);
+			nat->DeleteEntry(&rule);
+		}
+	}
+	ret = 0;
+
+done:
+	for(op = 0; op < NAT_BENCH_MAX_OP; op++)
+	{
+		free(lat[op].ns);
+	}
+	free(cached);
+	return ret;
+}
+
+/* Full cache of UDP flows, each one lives until its conntrack
+	 timeout passes without a refresh */
+static int bench_timers(FILE *out, NatApp *nat, uint32_t num_ticks)
+{
+	nat_table_entry rule;
+	uint32_t tick, id, cached, active, queries, updates;
+	uint64_t start, ns;
+
+	bench_num_flows = bench_max_entries;
+	bench_expire = (uint32_t *)calloc(bench_num_flows, sizeof(uint32_t));
+	if(bench_expire == NULL)
+	{
+		fprintf(out, "unable to allocate %u flows\n", bench_num_flows);
+		return -1;
+	}
+
+	nat->UpdateTcpUdpTo(bench_udp_timeout, IPPROTO_UDP);
+	bench_rule_hdl = 0;
+	for(id = 0; id < bench_num_flows; id++)
+	{
+		bench_flow(id, IPPROTO_UDP, &rule);
+		if(nat->AddEntry(&rule) == 0)
+		{
+			bench_expire[id] = bench_expiry();
+		}
+	}
+
+	fprintf(out, "\n%u udp flows, %d%% active, udp timeout %us, tick %ds\n",
+					bench_num_flows, bench_active_pct, bench_udp_timeout, UDP_TIMEOUT_UPDATE);
+	fprintf(out, "%4s %7s %7s %9s %9s %9s\n",
+					"tick", "cached", "active", "queried", "updated", "us");
+	for(tick = 0; tick < num_ticks; tick++)
+	{
+		__atomic_add_fetch(&bench_clock_sec, UDP_TIMEOUT_UPDATE, __ATOMIC_RELAXED);
+
+		/* conntrack destroys the flows whose timeout was not refreshed */
+		cached = 0;
+		active = 0;
+		for(id = 0; id < bench_num_flows; id++)
+		{
+			if(bench_expire[id] != 0 && bench_expire[id] <= bench_tick())
+			{
+				bench_flow(id, IPPROTO_UDP, &rule);
+				nat->DeleteEntry(&rule);
+				bench_expire[id] = 0;
+			}
+			if(bench_expire[id] != 0)
+			{
+				cached++;
+				if(bench_is_active(id + 1))
+				{
+					active++;
+				}
+			}
+		}
+		if(cached == 0)
+		{
+			/* UpdateUDPTimeStamp() would wait for a new entry */
+			break;
+		}
+
+		queries = bench_queries;
+		updates = bench_ct_updates;
+		start = bench_now();
+		nat->UpdateUDPTimeStamp();
+		ns = bench_now() - start;
+		queries = bench_queries - queries;
+		updates = bench_ct_updates - updates;
+
+		fprintf(out, "%4u %7u %7u %9u %9u %9llu\n", tick + 1, cached, active,
+						queries, updates, (unsigned long long)(ns / 1000));
+	}
+
+	free(bench_expire);
+	bench_expire = NULL;
+	return 0;
+}
+
+static void bench_usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-m cache entries] [-e events] [-f flows] [-s seed]\n"
+					"       [-t ticks] [-a active %%] [-u udp timeout]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t num_events = NAT_BENCH_DEF_EVENTS, num_flows = 0;
+	uint32_t num_ticks = NAT_BENCH_DEF_TICKS;
+	unsigned int seed = 1;
+	NatApp *nat;
+	FILE *out;
+	int opt, ret;
+
+	bench_real_clock = (bench_clock_fn)dlsym(RTLD_NEXT, "clock_gettime");
+	if(bench_real_clock == NULL)
+	{
+		fprintf(stderr, "unable to find clock_gettime\n");
+		return 1;
+	}
+
+	while((opt = getopt(argc, argv, "m:e:f:s:t:a:u:h")) != -1)
+	{
+		switch(opt)
+		{
+		case 'm':
+			bench_max_entries = atoi(optarg);
+			break;
+		case 'e':
+			num_events = strtoul(optarg, NULL, 0);
+			break;
+		case 'f':
+			num_flows = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			num_ticks = strtoul(optarg, NULL, 0);
+			break;
+		case 'a':
+			bench_active_pct = atoi(optarg);
+			break;
+		case 'u':
+			bench_udp_timeout = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			bench_usage(argv[0]);
+			return 1;
+		}
+	}
+	if(bench_max_entries <= 0 || bench_max_entries > 0xffff ||
+		 bench_active_pct < 0 || bench_active_pct > 100)
+	{
+		bench_usage(argv[0]);
+		return 1;
+	}
+	if(num_flows == 0)
+	{
+		num_flows = bench_max_entries;
+	}
+
+	/* keep NatApp's debug printf out of the report */
+	out = stderr;
+	if(freopen("/dev/null", "w", stdout) == NULL)
+	{
+		fprintf(out, "unable to redirect stdout\n");
+		return 1;
+	}
+
+	nat = NatApp::GetInstance();
+	if(nat == NULL || nat->AddTable(NAT_BENCH_PUBLIC_IP) != 0)
+	{
+		fprintf(out, "unable to set up NatApp\n");
+		return 1;
+	}
+
+	ret = bench_events(out, nat, num_events, num_flows, seed);
+	if(ret == 0)
+	{
+		ret = bench_timers(out, nat, num_ticks);
+	}
+
+	return (ret == 0) ? 0 : 1;
+}
@@ -38,6 +38,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 */
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
 #include <netinet/in.h>
@@ -50,6 +51,49 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 int ipa_get_if_name(char *if_name, int if_index);
 int find_mask(int ip_v4_last, int *mask_value);
 
+/* Receive arena reused for every read on the netlink socket, only
+	 touched from the netlink listener thread */
+typedef struct
+{
+	unsigned char buf[IPA_NL_RECV_BATCH][IPA_NL_MSG_MAX_LEN];
+	struct mmsghdr msgs[IPA_NL_RECV_BATCH];
+	struct iovec iov[IPA_NL_RECV_BATCH];
+	struct sockaddr_nl nladdr[IPA_NL_RECV_BATCH];
+	ipa_nl_msg_t nlmsg;
+} ipa_nl_recv_arena_t;
+
+static ipa_nl_recv_arena_t ipa_nl_arena;
+
+/* Last neighbor state forwarded to the dispatcher for one
+	 (iface, ip) pair, plus a RTM_DELNEIGH held back for the cancel window */
+typedef struct
+{
+	bool in_use;
+	bool present;
+	bool forwarded;             /* mac_addr holds the last MAC posted */
+	int if_index;
+	enum ipa_ip_type iptype;
+	uint32_t addr[4];
+	uint8_t mac_addr[IPA_MAC_ADDR_SIZE];
+	uint64_t fwd_time;          /* last RTM_NEWNEIGH posted */
+	uint64_t last_used;         /* last event seen, for LRU eviction */
+	ipacm_event_data_all *pend_del;
+	uint64_t pend_deadline;
+	int next;
+} ipa_nl_neigh_entry_t;
+
+typedef struct
+{
+	ipa_nl_neigh_entry_t entry[IPA_NL_NEIGH_CACHE_SIZE];
+	int hash_head[IPA_NL_NEIGH_HASH_SIZE];
+	int num_pending;
+	bool inited;
+	ipa_nl_neigh_stats_t stats;
+} ipa_nl_neigh_cache_t;
+
+/* Only touched from the netlink listener thread */
+static ipa_nl_neigh_cache_t ipa_nl_neigh;
+
 #ifdef FEATURE_IPA_ANDROID
 
 #define IPACM_NL_COPY_ADDR( event_info, element )                                        \
@@ -200,13 +244,336 @@ static int ipa_nl_addfd_map
 	return IPACM_SUCCESS;
 }
 
+static uint64_t ipa_nl_get_time_ms(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void ipa_nl_neigh_key
+(
+	 const ipacm_event_data_all *data,
+	 uint32_t *addr
+	 )
+{
+	if(data->iptype == IPA_IP_v4)
+	{
+		addr[0] = data->ipv4_addr;
+		addr[1] = addr[2] = addr[3] = 0;
+	}
+	else
+	{
+		memcpy(addr, data->ipv6_addr, sizeof(data->ipv6_addr));
+	}
+}
+
+static int ipa_nl_neigh_hash
+(
+	 int if_index,
+	 const uint32_t *addr
+	 )
+{
+	uint32_t hash;
+
+	hash = (uint32_t)if_index * 0x9E3779B1;
+	hash ^= addr[0] ^ addr[1] ^ addr[2] ^ addr[3];
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6B;
+	hash ^= hash >> 13;
+
+	return hash & (IPA_NL_NEIGH_HASH_SIZE - 1);
+}
+
+/* unlink an entry from its hash chain and free the slot */
+static void ipa_nl_neigh_unlink
+(
+	 ipa_nl_neigh_entry_t *entry
+	 )
+{
+	ipa_nl_neigh_cache_t *cache = &ipa_nl_neigh;
+	int *link;
+	int idx = entry - cache->entry;
+
+	link = &cache->hash_head[ipa_nl_neigh_hash(entry->if_index, entry->addr)];
+	while(*link != -1)
+	{
+		if(*link == idx)
+		{
+			*link = entry->next;
+			break;
+		}
+		link = &cache->entry[*link].next;
+	}
+	entry->in_use = false;
+}
+
+/* post the RTM_DELNEIGH held back on an entry */
+static void ipa_nl_neigh_post_del
+(
+	 ipa_nl_neigh_entry_t *entry
+	 )
+{
+	ipa_nl_neigh_cache_t *cache = &ipa_nl_neigh;
+	ipacm_cmd_q_data evt_data;
+
+	evt_data.event = IPA_DEL_NEIGH_EVENT;
+	evt_data.evt_data = entry->pend_del;
+	entry->pend_del = NULL;
+	entry->present = false;
+	cache->num_pending--;
+	cache->stats.fwd_del++;
+
+	IPACMDBG_H("posting IPA_DEL_NEIGH_EVENT index:%d iptype:%d\n",
+						 entry->if_index, entry->iptype);
+	IPACM_EvtDispatcher::PostEvt(&evt_data);
+}
+
+/* find the cache entry of a neighbor, allocate one if asked. When the
+	 table is full the least recently used entry is evicted, its held
+	 delete (if any) is posted first */
+static ipa_nl_neigh_entry_t* ipa_nl_neigh_lookup
+(
+	 const ipacm_event_data_all *data,
+	 bool alloc
+	 )
+{
+	ipa_nl_neigh_cache_t *cache = &ipa_nl_neigh;
+	ipa_nl_neigh_entry_t *entry, *victim = NULL;
+	uint32_t addr[4];
+	int bucket, cnt;
+
+	if(!cache->inited)
+	{
+		for(cnt = 0; cnt < IPA_NL_NEIGH_HASH_SIZE; cnt++)
+		{
+			cache->hash_head[cnt] = -1;
+		}
+		cache->inited = true;
+	}
+
+	ipa_nl_neigh_key(data, addr);
+	bucket = ipa_nl_neigh_hash(data->if_index, addr);
+
+	for(cnt = cache->hash_head[bucket]; cnt != -1; cnt = cache->entry[cnt].next)
+	{
+		entry = &cache->entry[cnt];
+		if(entry->if_index == data->if_index && entry->iptype == data->iptype &&
+			 memcmp(entry->addr, addr, sizeof(addr)) == 0)
+		{
+			return entry;
+		}
+	}
+
+	if(!alloc)
+	{
+		return NULL;
+	}
+
+	for(cnt = 0; cnt < IPA_NL_NEIGH_CACHE_SIZE; cnt++)
+	{
+		entry = &cache->entry[cnt];
+		if(!entry->in_use)
+		{
+			victim = entry;
+			break;
+		}
+		if(victim == NULL || entry->last_used < victim->last_used)
+		{
+			victim = entry;
+		}
+	}
+
+	if(victim->in_use)
+	{
+		if(victim->pend_del != NULL)
+		{
+			ipa_nl_neigh_post_del(victim);
+		}
+		ipa_nl_neigh_unlink(victim);
+		cache->stats.evicted++;
+	}
+
+	memset(victim, 0, sizeof(*victim));
+	victim->in_use = true;
+	victim->if_index = data->if_index;
+	victim->iptype = data->iptype;
+	memcpy(victim->addr, addr, sizeof(addr));
+	victim->next = cache->hash_head[bucket];
+	cache->hash_head[bucket] = victim - cache->entry;
+	return victim;
+}
+
+/* drop an entry nothing downstream knows about any more */
+static void ipa_nl_neigh_release
+(
+	 ipa_nl_neigh_entry_t *entry
+	 )
+{
+	if(entry->present || entry->pend_del != NULL)
+	{
+		return;
+	}
+	ipa_nl_neigh_unlink(entry);
+}
+
+/* Forget every neighbor of an iface going down. Held deletes are posted
+	 so downstream sees the same events it would have without coalescing,
+	 and the first RTM_NEWNEIGH after the link comes back is forwarded */
+static void ipa_nl_neigh_clear_if
+(
+	 int if_index
+	 )
+{
+	ipa_nl_neigh_cache_t *cache = &ipa_nl_neigh;
+	ipa_nl_neigh_entry_t *entry;
+	int cnt;
+
+	for(cnt = 0; cnt < IPA_NL_NEIGH_CACHE_SIZE; cnt++)
+	{
+		entry = &cache->entry[cnt];
+		if(!entry->in_use || entry->if_index != if_index)
+		{
+			continue;
+		}
+		if(entry->pend_del != NULL)
+		{
+			ipa_nl_neigh_post_del(entry);
+		}
+		ipa_nl_neigh_unlink(entry);
+	}
+}
+
+/* Filter a neighbor event before it is posted. Returns true when the
+	 caller should post it now, otherwise the event has been consumed:
+	 either dropped as a no-op (data freed) or, for RTM_DELNEIGH, held for
+	 IPA_NL_NEIGH_CANCEL_MS in case the same neighbor comes straight back.
+	 Refreshes of an unchanged neighbor are only dropped within
+	 IPA_NL_NEIGH_DUP_MS of the last one forwarded, later ones still reach
+	 the ifaces that use them as retries */
+static bool ipa_nl_neigh_coalesce
+(
+	 ipa_cm_event_id event,
+	 ipacm_event_data_all *data
+	 )
+{
+	ipa_nl_neigh_cache_t *cache = &ipa_nl_neigh;
+	ipa_nl_neigh_entry_t *entry;
+	uint64_t now;
+	bool same_mac;
+
+	now = ipa_nl_get_time_ms();
+	entry = ipa_nl_neigh_lookup(data, true);
+	entry->last_used = now;
+
+	same_mac = entry->forwarded &&
+		(memcmp(entry->mac_addr, data->mac_addr, sizeof(entry->mac_addr)) == 0);
+
+	if(event == IPA_DEL_NEIGH_EVENT)
+	{
+		if(entry->pend_del != NULL)
+		{
+			/* repeated delete, keep the first deadline */
+			free(entry->pend_del);
+			cache->stats.dup_suppressed++;
+		}
+		else
+		{
+			entry->pend_deadline = now + IPA_NL_NEIGH_CANCEL_MS;
+			cache->num_pending++;
+		}
+		entry->pend_del = data;
+		entry->present = false;
+		return false;
+	}
+
+	if(entry->pend_del != NULL)
+	{
+		if(same_mac)
+		{
+			/* del + new of the same neighbor, nothing changed downstream */
+			free(entry->pend_del);
+			entry->pend_del = NULL;
+			entry->present = true;
+			cache->num_pending--;
+			free(data);
+			cache->stats.cancel_suppressed += 2;
+			IPACMDBG("Cancelled del/new neighbor pair, %d suppressed\n",
+							 cache->stats.cancel_suppressed);
+			return false;
+		}
+		/* neighbor moved to another MAC, the delete is real */
+		ipa_nl_neigh_post_del(entry);
+	}
+	else if(entry->present && same_mac &&
+					now - entry->fwd_time < IPA_NL_NEIGH_DUP_MS)
+	{
+		free(data);
+		cache->stats.dup_suppressed++;
+		IPACMDBG("Dropped neighbor refresh, %d suppressed\n",
+						 cache->stats.dup_suppressed);
+		return false;
+	}
+
+	memcpy(entry->mac_addr, data->mac_addr, sizeof(entry->mac_addr));
+	entry->present = true;
+	entry->forwarded = true;
+	entry->fwd_time = now;
+	cache->stats.fwd_new++;
+	return true;
+}
+
+/* post held deletes whose window expired, returns ms until the next one
+	 or -1 if none is pending */
+static int ipa_nl_neigh_flush(void)
+{
+	ipa_nl_neigh_cache_t *cache = &ipa_nl_neigh;
+	ipa_nl_neigh_entry_t *entry;
+	uint64_t now, next = 0;
+	int cnt;
+
+	if(cache->num_pending == 0)
+	{
+		return -1;
+	}
+
+	now = ipa_nl_get_time_ms();
+	for(cnt = 0; cnt < IPA_NL_NEIGH_CACHE_SIZE && cache->num_pending > 0; cnt++)
+	{
+		entry = &cache->entry[cnt];
+		if(!entry->in_use || entry->pend_del == NULL)
+		{
+			continue;
+		}
+
+		if(entry->pend_deadline <= now)
+		{
+			ipa_nl_neigh_post_del(entry);
+			ipa_nl_neigh_release(entry);
+		}
+		else if(next == 0 || entry->pend_deadline < next)
+		{
+			next = entry->pend_deadline;
+		}
+	}
+
+	return (next == 0) ? -1 : (int)(next - now);
+}
+
+void ipa_nl_get_neigh_stats(ipa_nl_neigh_stats_t *stats)
+{
+	memcpy(stats, &ipa_nl_neigh.stats, sizeof(*stats));
+}
+
 /*  start socket listener */
 static int ipa_nl_sock_listener_start
 (
 	 ipa_nl_sk_fd_set_info_t *sk_fd_set
 	 )
 {
-	int i, ret;
+	int i, ret, wait_ms;
+	struct timeval tv;
 
 	while(true)
 	{
@@ -215,7 +582,12 @@ static int ipa_nl_sock_listener_start
 			FD_SET(sk_fd_set->sk_fds[i].sk_fd, &(sk_fd_set->fdset));
 		}
 
-		if((ret = select(sk_fd_set->max_fd + 1, &(sk_fd_set->fdset), NULL, NULL, NULL)) < 0)
+		/* wake up in time to release held neighbor deletes */
+		wait_ms = ipa_nl_neigh_flush();
+		tv.tv_sec = wait_ms / 1000;
+		tv.tv_usec = (wait_ms % 1000) * 1000;
+
+		if((ret = select(sk_fd_set->max_fd + 1, &(sk_fd_set->fdset), NULL, NULL, (wait_ms < 0) ? NULL : &tv)) < 0)
 		{
 			IPACMERR("ipa_nl select failed\n");
 		}
@@ -250,170 +622,58 @@ static int ipa_nl_sock_listener_start
 	return IPACM_SUCCESS;
 }
 
-/* allocate memory for ipa_nl__msg */
-static struct msghdr* ipa_nl_alloc_msg
+/* re-arm the arena message headers, recvmmsg overwrites them */
+static void ipa_nl_reset_arena
 (
-	 uint32_t msglen
+	 ipa_nl_recv_arena_t *arena
 	 )
 {
-	unsigned char *buf = NULL;
-	struct sockaddr_nl *nladdr = NULL;
-	struct iovec *iov = NULL;
-	struct msghdr *msgh = NULL;
-
-	if(IPA_NL_MSG_MAX_LEN < msglen)
-	{
-		IPACMERR("Netlink message exceeds maximum length\n");
-		return NULL;
-	}
+	int cnt;
 
-	msgh = (struct msghdr *)malloc(sizeof(struct msghdr));
-	if(msgh == NULL)
+	for(cnt = 0; cnt < IPA_NL_RECV_BATCH; cnt++)
 	{
-		IPACMERR("Failed malloc for msghdr\n");
-		return NULL;
-	}
-
-	nladdr = (struct sockaddr_nl *)malloc(sizeof(struct sockaddr_nl));
-	if(nladdr == NULL)
-	{
-		IPACMERR("Failed malloc for sockaddr\n");
-		free(msgh);
-		return NULL;
-	}
+		arena->iov[cnt].iov_base = arena->buf[cnt];
+		arena->iov[cnt].iov_len = IPA_NL_MSG_MAX_LEN;
 
-	iov = (struct iovec *)malloc(sizeof(struct iovec));
-	if(iov == NULL)
-	{
-		PERROR("Failed malloc for iovec");
-		free(nladdr);
-		free(msgh);
-		return NULL;
-	}
+		memset(&arena->nladdr[cnt], 0, sizeof(struct sockaddr_nl));
+		arena->nladdr[cnt].nl_family = AF_NETLINK;
 
-	buf = (unsigned char *)malloc(msglen);
-	if(buf == NULL)
-	{
-		IPACMERR("Failed malloc for mglen\n");
-		free(iov);
-		free(nladdr);
-		free(msgh);
-		return NULL;
-	}
-
-	memset(nladdr, 0, sizeof(struct sockaddr_nl));
-	nladdr->nl_family = AF_NETLINK;
-
-	memset(msgh, 0x0, sizeof(struct msghdr));
-	msgh->msg_name = nladdr;
-	msgh->msg_namelen = sizeof(struct sockaddr_nl);
-	msgh->msg_iov = iov;
-	msgh->msg_iovlen = 1;
-
-	memset(iov, 0x0, sizeof(struct iovec));
-	iov->iov_base = buf;
-	iov->iov_len = msglen;
-
-	return msgh;
-}
-
-/* release IPA message */
-static void ipa_nl_release_msg
-(
-	 struct msghdr *msgh
-	 )
-{
-	unsigned char *buf = NULL;
-	struct sockaddr_nl *nladdr = NULL;
-	struct iovec *iov = NULL;
-
-	if(NULL == msgh)
-	{
-		return;
-	}
-
-	nladdr = (struct sockaddr_nl *)msgh->msg_name;
-	iov = msgh->msg_iov;
-	if(msgh->msg_iov)
-	{
-		buf = (unsigned char *)msgh->msg_iov->iov_base;
-	}
-
-	if(buf)
-	{
-	free(buf);
-	}
-	if(iov)
-	{
-	free(iov);
-	}
-	if(nladdr)
-	{
-	free(nladdr);
-	}
-	if(msgh)
-	{
-	free(msgh);
+		memset(&arena->msgs[cnt], 0, sizeof(struct mmsghdr));
+		arena->msgs[cnt].msg_hdr.msg_name = &arena->nladdr[cnt];
+		arena->msgs[cnt].msg_hdr.msg_namelen = sizeof(struct sockaddr_nl);
+		arena->msgs[cnt].msg_hdr.msg_iov = &arena->iov[cnt];
+		arena->msgs[cnt].msg_hdr.msg_iovlen = 1;
 	}
 	return;
 }
 
-/* receive and process nl message */
+/* receive up to IPA_NL_RECV_BATCH queued nl messages in one syscall */
 static int ipa_nl_recv
 (
 	 int              fd,
-	 struct msghdr **msg_pptr,
-	 unsigned int  *msglen_ptr
+	 ipa_nl_recv_arena_t *arena,
+	 int             *num_msgs_ptr
 	 )
 {
-	struct msghdr *msgh = NULL;
-	int rmsgl;
-
-	msgh = ipa_nl_alloc_msg(IPA_NL_MSG_MAX_LEN);
-	if(NULL == msgh)
-	{
-		IPACMERR("Failed to allocate NL message\n");
-		goto error;
-	}
+	int rmsgs;
 
+	ipa_nl_reset_arena(arena);
 
-	/* Receive message over the socket */
-	rmsgl = recvmsg(fd, msgh, 0);
+	/* The socket was reported readable, so the first datagram is there.
+		 Pick up whatever else is already queued without blocking */
+	rmsgs = recvmmsg(fd, arena->msgs, IPA_NL_RECV_BATCH, MSG_DONTWAIT, NULL);
 
 	/* Verify that something was read */
-	if(rmsgl <= 0)
+	if(rmsgs <= 0)
 	{
 		PERROR("NL recv error");
-		goto error;
-	}
-
-	/* Verify that NL address length in the received message is expected value */
-	if(sizeof(struct sockaddr_nl) != msgh->msg_namelen)
-	{
-		IPACMERR("rcvd msg with namelen != sizeof sockaddr_nl\n");
-		goto error;
-	}
-
-	/* Verify that message was not truncated. This should not occur */
-	if(msgh->msg_flags & MSG_TRUNC)
-	{
-		IPACMERR("Rcvd msg truncated!\n");
-		goto error;
+		*num_msgs_ptr = 0;
+		return IPACM_FAILURE;
 	}
 
-	*msg_pptr    = msgh;
-	*msglen_ptr = rmsgl;
+	*num_msgs_ptr = rmsgs;
 
 	return IPACM_SUCCESS;
-
-/* An error occurred while receiving the message. Free all memory before
-				 returning. */
-error:
-	ipa_nl_release_msg(msgh);
-	*msg_pptr    = NULL;
-	*msglen_ptr  = 0;
-
-	return IPACM_FAILURE;
 }
 
 /* decode the rtm netlink message */
@@ -646,6 +906,13 @@ static int ipa_nl_decode_nlmsg
 					return IPACM_SUCCESS;
 				}
 
+				if(!(msg_ptr->nl_link_info.metainfo.ifi_flags & IFF_UP) ||
+					 !(msg_ptr->nl_link_info.metainfo.ifi_flags & IFF_LOWER_UP))
+				{
+					/* neighbors learnt on this link are stale from now on */
+					ipa_nl_neigh_clear_if(msg_ptr->nl_link_info.metainfo.ifi_index);
+				}
+
 				if(IFF_UP & msg_ptr->nl_link_info.metainfo.ifi_change)
 				{
 					IPACMDBG("GOT useful newlink event\n");
@@ -772,6 +1039,8 @@ static int ipa_nl_decode_nlmsg
 					return IPACM_SUCCESS;
 				}
 
+				ipa_nl_neigh_clear_if(msg_ptr->nl_link_info.metainfo.ifi_index);
+
 				ret_val = ipa_get_if_name(dev_name, msg_ptr->nl_link_info.metainfo.ifi_index);
 				if(ret_val != IPACM_SUCCESS)
 				{
@@ -1401,6 +1670,11 @@ static int ipa_nl_decode_nlmsg
 		    evt_data.event = IPA_NEW_NEIGH_EVENT;
 		    data_all->if_index = msg_ptr->nl_neigh_info.metainfo.ndm_ifindex;
 
+		    if(!ipa_nl_neigh_coalesce(evt_data.event, data_all))
+		    {
+		    	break;
+		    }
+
 		    IPACMDBG_H("posting IPA_NEW_NEIGH_EVENT (%s):index:%d ip-family: %d\n",
                                  dev_name,
  		                    data_all->if_index,
@@ -1474,6 +1748,12 @@ static int ipa_nl_decode_nlmsg
 		    evt_data.event = IPA_DEL_NEIGH_EVENT;
 				data_all->if_index = msg_ptr->nl_neigh_info.metainfo.ndm_ifindex;
 
+		    if(!ipa_nl_neigh_coalesce(evt_data.event, data_all))
+		    {
+		    	IPACMDBG("holding IPA_DEL_NEIGH_EVENT (%s) for %d ms\n", dev_name, IPA_NL_NEIGH_CANCEL_MS);
+		    	break;
+		    }
+
 		    IPACMDBG_H("posting IPA_DEL_NEIGH_EVENT (%s):index:%d ip-family: %d\n",
                                  dev_name,
  		                    data_all->if_index,
@@ -1498,63 +1778,47 @@ static int ipa_nl_decode_nlmsg
 /*  Virtual function registered to receive incoming messages over the NETLINK routing socket*/
 int ipa_nl_recv_msg(int fd)
 {
-	struct msghdr *msghdr = NULL;
-	struct iovec *iov = NULL;
-	unsigned int msglen = 0;
-	ipa_nl_msg_t *nlmsg = NULL;
+	ipa_nl_recv_arena_t *arena = &ipa_nl_arena;
+	struct msghdr *msghdr;
+	int num_msgs = 0, cnt;
+	int ret = IPACM_SUCCESS;
 
-	nlmsg = (ipa_nl_msg_t *)malloc(sizeof(ipa_nl_msg_t));
-	if(NULL == nlmsg)
+	if(IPACM_SUCCESS != ipa_nl_recv(fd, arena, &num_msgs))
 	{
-		IPACMERR("Failed alloc of nlmsg \n");
-		goto error;
+		IPACMERR("Failed to receive nl message \n");
+		return IPACM_FAILURE;
 	}
-	else
+
+	for(cnt = 0; cnt < num_msgs; cnt++)
 	{
-		if(IPACM_SUCCESS != ipa_nl_recv(fd, &msghdr, &msglen))
+		msghdr = &arena->msgs[cnt].msg_hdr;
+
+		/* Verify that NL address length in the received message is expected value */
+		if(sizeof(struct sockaddr_nl) != msghdr->msg_namelen)
 		{
-			IPACMERR("Failed to receive nl message \n");
-			goto error;
+			IPACMERR("rcvd msg with namelen != sizeof sockaddr_nl\n");
+			ret = IPACM_FAILURE;
+			continue;
 		}
 
-		if(msghdr== NULL)
+		/* Verify that message was not truncated. This should not occur */
+		if(msghdr->msg_flags & MSG_TRUNC)
 		{
-			IPACMERR(" failed to get msghdr\n");
-			goto error;
+			IPACMERR("Rcvd msg truncated!\n");
+			ret = IPACM_FAILURE;
+			continue;
 		}
 
-		iov = msghdr->msg_iov;
-
-		memset(nlmsg, 0, sizeof(ipa_nl_msg_t));
-		if(IPACM_SUCCESS != ipa_nl_decode_nlmsg((char *)iov->iov_base, msglen, nlmsg))
+		/* decode straight out of the arena buffer */
+		memset(&arena->nlmsg, 0, sizeof(ipa_nl_msg_t));
+		if(IPACM_SUCCESS != ipa_nl_decode_nlmsg((char *)arena->buf[cnt], arena->msgs[cnt].msg_len, &arena->nlmsg))
 		{
 			IPACMERR("Failed to decode nl message \n");
-			goto error;
-		}
-		/* Release NetLink message buffer */
-		if(msghdr)
-		{
-			ipa_nl_release_msg(msghdr);
+			ret = IPACM_FAILURE;
 		}
-		if(nlmsg)
-		{
-			free(nlmsg);
-		}
-	}
-
-	return IPACM_SUCCESS;
-
-error:
-	if(msghdr)
-	{
-		ipa_nl_release_msg(msghdr);
-	}
-	if(nlmsg)
-	{
-		free(nlmsg);
 	}
 
-	return IPACM_FAILURE;
+	return ret;
 }
 
 /*  get ipa interface name */
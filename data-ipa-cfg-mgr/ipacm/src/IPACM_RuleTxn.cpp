@@ -0,0 +1,810 @@
+/* 
+Copyright (c) 2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_RuleTxn.cpp
+
+	@brief
+	This file implements the IPACM filter/route/header rule transactions
+
+	@Author
+
+*/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "IPACM_RuleTxn.h"
+#include "IPACM_Log.h"
+
+#define IPACM_TXN_IP_BIT(ip) (1 << (ip))
+
+IPACM_RuleTxn::IPACM_RuleTxn(IPACM_Filtering *flt, IPACM_Routing *rt, IPACM_Header *hdr)
+{
+	m_flt = flt;
+	m_rt = rt;
+	m_hdr = hdr;
+
+	flt_add = NULL;
+	num_flt_add = max_flt_add = 0;
+	rt_add = NULL;
+	num_rt_add = max_rt_add = 0;
+	flt_mdfy = NULL;
+	num_flt_mdfy = max_flt_mdfy = 0;
+	flt_del = NULL;
+	num_flt_del = max_flt_del = 0;
+	rt_del = NULL;
+	num_rt_del = max_rt_del = 0;
+	hdr_del = NULL;
+	num_hdr_del = max_hdr_del = 0;
+
+	flt_dirty = 0;
+	rt_dirty = 0;
+	hdr_dirty = false;
+}
+
+IPACM_RuleTxn::~IPACM_RuleTxn()
+{
+	if (num_flt_add || num_rt_add || num_flt_mdfy ||
+			num_flt_del || num_rt_del || num_hdr_del)
+	{
+		IPACMERR("rule transaction dropped without commit\n");
+	}
+
+	free(flt_add);
+	free(rt_add);
+	free(flt_mdfy);
+	free(flt_del);
+	free(rt_del);
+	free(hdr_del);
+}
+
+bool IPACM_RuleTxn::Grow(void **arr, int *max, int num, size_t size)
+{
+	void *tmp;
+	int new_max;
+
+	if (num < *max)
+	{
+		return true;
+	}
+
+	new_max = (*max == 0) ? 8 : *max * 2;
+	tmp = realloc(*arr, new_max * size);
+	if (tmp == NULL)
+	{
+		IPACMERR("unable to grow rule transaction to %d entries\n", new_max);
+		return false;
+	}
+
+	*arr = tmp;
+	*max = new_max;
+	return true;
+}
+
+bool IPACM_RuleTxn::AddFltRule(ipa_ip_type ip, ipa_client_type ep, bool global,
+															 const struct ipa_flt_rule_add *rule, uint32_t *hdl)
+{
+	ipacm_txn_flt_add *op;
+
+	if (!Grow((void **)&flt_add, &max_flt_add, num_flt_add, sizeof(*flt_add)))
+	{
+		return false;
+	}
+
+	op = &flt_add[num_flt_add++];
+	op->ip = ip;
+	op->ep = ep;
+	op->global = global;
+	memcpy(&op->rule, rule, sizeof(op->rule));
+	op->hdl = hdl;
+	return true;
+}
+
+bool IPACM_RuleTxn::ModifyFltRule(ipa_ip_type ip, const struct ipa_flt_rule_mdfy *rule)
+{
+	ipacm_txn_flt_mdfy *op;
+
+	if (!Grow((void **)&flt_mdfy, &max_flt_mdfy, num_flt_mdfy, sizeof(*flt_mdfy)))
+	{
+		return false;
+	}
+
+	op = &flt_mdfy[num_flt_mdfy++];
+	op->ip = ip;
+	memcpy(&op->rule, rule, sizeof(op->rule));
+	return true;
+}
+
+bool IPACM_RuleTxn::DelFltRule(ipa_ip_type ip, uint32_t hdl)
+{
+	if (hdl == 0)
+	{
+		IPACMDBG("invalid filter handle passed, ignoring it\n");
+		return true;
+	}
+
+	if (!Grow((void **)&flt_del, &max_flt_del, num_flt_del, sizeof(*flt_del)))
+	{
+		return false;
+	}
+
+	flt_del[num_flt_del].ip = ip;
+	flt_del[num_flt_del].hdl = hdl;
+	flt_del[num_flt_del].loc = NULL;
+	num_flt_del++;
+	return true;
+}
+
+bool IPACM_RuleTxn::DelFltRuleHdl(ipa_ip_type ip, uint32_t *hdl)
+{
+	if (!DelFltRule(ip, *hdl))
+	{
+		return false;
+	}
+
+	if (*hdl != 0)
+	{
+		flt_del[num_flt_del - 1].loc = hdl;
+	}
+	return true;
+}
+
+bool IPACM_RuleTxn::DelFltRules(ipa_ip_type ip, const uint32_t *hdls, int num)
+{
+	int cnt;
+
+	for (cnt = 0; cnt < num; cnt++)
+	{
+		if (!DelFltRule(ip, hdls[cnt]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool IPACM_RuleTxn::AddRtRule(ipa_ip_type ip, const char *rt_tbl_name,
+															const struct ipa_rt_rule_add *rule, uint32_t *hdl)
+{
+	ipacm_txn_rt_add *op;
+
+	if (!Grow((void **)&rt_add, &max_rt_add, num_rt_add, sizeof(*rt_add)))
+	{
+		return false;
+	}
+
+	op = &rt_add[num_rt_add++];
+	op->ip = ip;
+	strlcpy(op->rt_tbl_name, rt_tbl_name, sizeof(op->rt_tbl_name));
+	memcpy(&op->rule, rule, sizeof(op->rule));
+	op->hdl = hdl;
+	return true;
+}
+
+bool IPACM_RuleTxn::DelRtRule(ipa_ip_type ip, uint32_t hdl)
+{
+	if (hdl == 0)
+	{
+		IPACMDBG("No route handle passed. Ignoring it\n");
+		return true;
+	}
+
+	if (!Grow((void **)&rt_del, &max_rt_del, num_rt_del, sizeof(*rt_del)))
+	{
+		return false;
+	}
+
+	rt_del[num_rt_del].ip = ip;
+	rt_del[num_rt_del].hdl = hdl;
+	rt_del[num_rt_del].loc = NULL;
+	num_rt_del++;
+	return true;
+}
+
+bool IPACM_RuleTxn::DelHdr(uint32_t hdl)
+{
+	if (hdl == 0)
+	{
+		IPACMERR("Invalid header handle passed. Ignoring it\n");
+		return true;
+	}
+
+	if (!Grow((void **)&hdr_del, &max_hdr_del, num_hdr_del, sizeof(*hdr_del)))
+	{
+		return false;
+	}
+
+	hdr_del[num_hdr_del].hdl = hdl;
+	hdr_del[num_hdr_del].loc = NULL;
+	num_hdr_del++;
+	return true;
+}
+
+/* one IPA_IOC_DEL_FLT_RULE per ip type */
+bool IPACM_RuleTxn::CommitFltDel()
+{
+	struct ipa_ioc_del_flt_rule *req;
+	ipacm_txn_del *idx[IPACM_TXN_MAX_RULES_PER_IOCTL];
+	int ip, cnt, start, num;
+	bool res = true;
+
+	if (num_flt_del == 0)
+	{
+		return true;
+	}
+
+	req = (struct ipa_ioc_del_flt_rule *)malloc(sizeof(*req) +
+				IPACM_TXN_MAX_RULES_PER_IOCTL * sizeof(struct ipa_flt_rule_del));
+	if (req == NULL)
+	{
+		IPACMERR("unable to allocate memory for del filter rule\n");
+		return false;
+	}
+
+	for (ip = IPA_IP_v4; ip <= IPA_IP_v6; ip++)
+	{
+		for (start = 0; start < num_flt_del; start = cnt)
+		{
+			memset(req, 0, sizeof(*req));
+			req->commit = 0;
+			req->ip = (ipa_ip_type)ip;
+			for (cnt = start, num = 0; cnt < num_flt_del && num < IPACM_TXN_MAX_RULES_PER_IOCTL; cnt++)
+			{
+				if (flt_del[cnt].ip == ip)
+				{
+					req->hdl[num].hdl = flt_del[cnt].hdl;
+					req->hdl[num].status = -1;
+					idx[num++] = &flt_del[cnt];
+				}
+			}
+			if (num == 0)
+			{
+				continue;
+			}
+			req->num_hdls = num;
+
+			flt_dirty |= IPACM_TXN_IP_BIT(ip);
+			if (m_flt->DeleteFilteringRule(req) == false)
+			{
+				res = false;
+				continue;
+			}
+			for (num = 0; num < req->num_hdls; num++)
+			{
+				if (req->hdl[num].status != 0)
+				{
+					IPACMERR("Filter rule hdl 0x%x deletion failed with error:%d\n",
+									 req->hdl[num].hdl, req->hdl[num].status);
+					res = false;
+				}
+				else if (idx[num]->loc != NULL)
+				{
+					*idx[num]->loc = 0;
+				}
+			}
+		}
+	}
+
+	free(req);
+	return res;
+}
+
+/* one IPA_IOC_DEL_RT_RULE per ip type */
+bool IPACM_RuleTxn::CommitRtDel()
+{
+	struct ipa_ioc_del_rt_rule *req;
+	int ip, cnt, start, num;
+	bool res = true;
+
+	if (num_rt_del == 0)
+	{
+		return true;
+	}
+
+	req = (struct ipa_ioc_del_rt_rule *)malloc(sizeof(*req) +
+				IPACM_TXN_MAX_RULES_PER_IOCTL * sizeof(struct ipa_rt_rule_del));
+	if (req == NULL)
+	{
+		IPACMERR("unable to allocate memory for del route rule\n");
+		return false;
+	}
+
+	for (ip = IPA_IP_v4; ip <= IPA_IP_v6; ip++)
+	{
+		for (start = 0; start < num_rt_del; start = cnt)
+		{
+			memset(req, 0, sizeof(*req));
+			req->commit = 0;
+			req->ip = (ipa_ip_type)ip;
+			for (cnt = start, num = 0; cnt < num_rt_del && num < IPACM_TXN_MAX_RULES_PER_IOCTL; cnt++)
+			{
+				if (rt_del[cnt].ip == ip)
+				{
+					req->hdl[num].hdl = rt_del[cnt].hdl;
+					req->hdl[num].status = -1;
+					num++;
+				}
+			}
+			if (num == 0)
+			{
+				continue;
+			}
+			req->num_hdls = num;
+
+			rt_dirty |= IPACM_TXN_IP_BIT(ip);
+			if (m_rt->DeleteRoutingRule(req) == false)
+			{
+				res = false;
+				continue;
+			}
+			for (num = 0; num < req->num_hdls; num++)
+			{
+				if (req->hdl[num].status != 0)
+				{
+					IPACMERR("Route rule hdl 0x%x deletion failed with error:%d\n",
+									 req->hdl[num].hdl, req->hdl[num].status);
+					res = false;
+				}
+			}
+		}
+	}
+
+	free(req);
+	return res;
+}
+
+bool IPACM_RuleTxn::CommitHdrDel()
+{
+	struct ipa_ioc_del_hdr *req;
+	int cnt, start, num;
+	bool res = true;
+
+	if (num_hdr_del == 0)
+	{
+		return true;
+	}
+
+	req = (struct ipa_ioc_del_hdr *)malloc(sizeof(*req) +
+				IPACM_TXN_MAX_RULES_PER_IOCTL * sizeof(struct ipa_hdr_del));
+	if (req == NULL)
+	{
+		IPACMERR("Unable to allocate memory for del header\n");
+		return false;
+	}
+
+	for (start = 0; start < num_hdr_del; start = cnt)
+	{
+		memset(req, 0, sizeof(*req));
+		req->commit = 0;
+		for (cnt = start, num = 0; cnt < num_hdr_del && num < IPACM_TXN_MAX_RULES_PER_IOCTL; cnt++)
+		{
+			req->hdl[num].hdl = hdr_del[cnt].hdl;
+			req->hdl[num].status = -1;
+			num++;
+		}
+		req->num_hdls = num;
+
+		hdr_dirty = true;
+		if (m_hdr->DeleteHeader(req) == false)
+		{
+			res = false;
+			continue;
+		}
+		for (num = 0; num < req->num_hdls; num++)
+		{
+			if (req->hdl[num].status != 0)
+			{
+				IPACMERR("Header hdl:(%x) deletion failed!  status: %d\n",
+								 req->hdl[num].hdl, req->hdl[num].status);
+				res = false;
+			}
+		}
+	}
+
+	free(req);
+	return res;
+}
+
+/* one IPA_IOC_ADD_RT_RULE per (ip type, routing table), keeping the
+	 queued order of the rules within a table */
+bool IPACM_RuleTxn::CommitRtAdd()
+{
+	struct ipa_ioc_add_rt_rule *req;
+	ipacm_txn_rt_add *idx[IPACM_TXN_MAX_RULES_PER_IOCTL];
+	bool *done;
+	int cnt, first, num;
+	bool res = true;
+
+	if (num_rt_add == 0)
+	{
+		return true;
+	}
+
+	req = (struct ipa_ioc_add_rt_rule *)malloc(sizeof(*req) +
+				IPACM_TXN_MAX_RULES_PER_IOCTL * sizeof(struct ipa_rt_rule_add));
+	done = (bool *)calloc(num_rt_add, sizeof(bool));
+	if (req == NULL || done == NULL)
+	{
+		IPACMERR("unable to allocate memory for add route rule\n");
+		free(req);
+		free(done);
+		return false;
+	}
+
+	for (first = 0; first < num_rt_add; first++)
+	{
+		if (done[first])
+		{
+			continue;
+		}
+
+		memset(req, 0, sizeof(*req));
+		req->commit = 0;
+		req->ip = rt_add[first].ip;
+		strlcpy(req->rt_tbl_name, rt_add[first].rt_tbl_name, sizeof(req->rt_tbl_name));
+
+		for (cnt = first, num = 0; cnt < num_rt_add && num < IPACM_TXN_MAX_RULES_PER_IOCTL; cnt++)
+		{
+			if (!done[cnt] && rt_add[cnt].ip == req->ip &&
+					strncmp(rt_add[cnt].rt_tbl_name, req->rt_tbl_name, sizeof(req->rt_tbl_name)) == 0)
+			{
+				memcpy(&req->rules[num], &rt_add[cnt].rule, sizeof(req->rules[num]));
+				req->rules[num].status = -1;
+				idx[num++] = &rt_add[cnt];
+				done[cnt] = true;
+			}
+		}
+		req->num_rules = num;
+
+		rt_dirty |= IPACM_TXN_IP_BIT(req->ip);
+		if (m_rt->AddRoutingRule(req) == false)
+		{
+			IPACMERR("Routing rule addition failed for table %s\n", req->rt_tbl_name);
+			res = false;
+		}
+
+		for (cnt = 0; cnt < num; cnt++)
+		{
+			idx[cnt]->rule.rt_rule_hdl = req->rules[cnt].rt_rule_hdl;
+			idx[cnt]->rule.status = req->rules[cnt].status;
+			if (idx[cnt]->hdl != NULL)
+			{
+				*idx[cnt]->hdl = (req->rules[cnt].status == 0) ? req->rules[cnt].rt_rule_hdl : 0;
+			}
+			if (req->rules[cnt].status != 0)
+			{
+				res = false;
+			}
+		}
+	}
+
+	free(done);
+	free(req);
+	return res;
+}
+
+/* one IPA_IOC_ADD_FLT_RULE per (ip type, end point, global) table,
+	 keeping the queued order of the rules within a table */
+bool IPACM_RuleTxn::CommitFltAdd()
+{
+	struct ipa_ioc_add_flt_rule *req;
+	ipacm_txn_flt_add *idx[IPACM_TXN_MAX_RULES_PER_IOCTL];
+	bool *done;
+	int cnt, first, num;
+	bool res = true;
+
+	if (num_flt_add == 0)
+	{
+		return true;
+	}
+
+	req = (struct ipa_ioc_add_flt_rule *)malloc(sizeof(*req) +
+				IPACM_TXN_MAX_RULES_PER_IOCTL * sizeof(struct ipa_flt_rule_add));
+	done = (bool *)calloc(num_flt_add, sizeof(bool));
+	if (req == NULL || done == NULL)
+	{
+		IPACMERR("unable to allocate memory for add filter rule\n");
+		free(req);
+		free(done);
+		return false;
+	}
+
+	for (first = 0; first < num_flt_add; first++)
+	{
+		if (done[first])
+		{
+			continue;
+		}
+
+		memset(req, 0, sizeof(*req));
+		req->commit = 0;
+		req->ip = flt_add[first].ip;
+		req->ep = flt_add[first].ep;
+		req->global = flt_add[first].global;
+
+		for (cnt = first, num = 0; cnt < num_flt_add && num < IPACM_TXN_MAX_RULES_PER_IOCTL; cnt++)
+		{
+			if (!done[cnt] && flt_add[cnt].ip == req->ip &&
+					flt_add[cnt].ep == req->ep && flt_add[cnt].global == req->global)
+			{
+				memcpy(&req->rules[num], &flt_add[cnt].rule, sizeof(req->rules[num]));
+				req->rules[num].status = -1;
+				idx[num++] = &flt_add[cnt];
+				done[cnt] = true;
+			}
+		}
+		req->num_rules = num;
+
+		flt_dirty |= IPACM_TXN_IP_BIT(req->ip);
+		if (m_flt->AddFilteringRule(req) == false)
+		{
+			IPACMERR("Filtering rule addition failed for ep %d\n", req->ep);
+			res = false;
+		}
+
+		for (cnt = 0; cnt < num; cnt++)
+		{
+			idx[cnt]->rule.flt_rule_hdl = req->rules[cnt].flt_rule_hdl;
+			idx[cnt]->rule.status = req->rules[cnt].status;
+			if (idx[cnt]->hdl != NULL)
+			{
+				*idx[cnt]->hdl = (req->rules[cnt].status == 0) ? req->rules[cnt].flt_rule_hdl : 0;
+			}
+			if (req->rules[cnt].status != 0)
+			{
+				res = false;
+			}
+		}
+	}
+
+	free(done);
+	free(req);
+	return res;
+}
+
+/* one IPA_IOC_MDFY_FLT_RULE per ip type */
+bool IPACM_RuleTxn::CommitFltMdfy()
+{
+	struct ipa_ioc_mdfy_flt_rule *req;
+	int ip, cnt, start, num;
+	bool res = true;
+
+	if (num_flt_mdfy == 0)
+	{
+		return true;
+	}
+
+	req = (struct ipa_ioc_mdfy_flt_rule *)malloc(sizeof(*req) +
+				IPACM_TXN_MAX_RULES_PER_IOCTL * sizeof(struct ipa_flt_rule_mdfy));
+	if (req == NULL)
+	{
+		IPACMERR("unable to allocate memory for modify filter rule\n");
+		return false;
+	}
+
+	for (ip = IPA_IP_v4; ip <= IPA_IP_v6; ip++)
+	{
+		for (start = 0; start < num_flt_mdfy; start = cnt)
+		{
+			memset(req, 0, sizeof(*req));
+			req->commit = 0;
+			req->ip = (ipa_ip_type)ip;
+			for (cnt = start, num = 0; cnt < num_flt_mdfy && num < IPACM_TXN_MAX_RULES_PER_IOCTL; cnt++)
+			{
+				if (flt_mdfy[cnt].ip == ip)
+				{
+					memcpy(&req->rules[num], &flt_mdfy[cnt].rule, sizeof(req->rules[num]));
+					req->rules[num].status = -1;
+					num++;
+				}
+			}
+			if (num == 0)
+			{
+				continue;
+			}
+			req->num_rules = num;
+
+			flt_dirty |= IPACM_TXN_IP_BIT(ip);
+			if (m_flt->ModifyFilteringRule(req) == false)
+			{
+				res = false;
+			}
+		}
+	}
+
+	free(req);
+	return res;
+}
+
+/* Commit the tables touched since the last call. Deletions are made
+	 visible to HW from the referrers down (flt, rt, hdr) and additions from
+	 the referenced objects up (hdr, rt, flt), so the committed tables never
+	 point at an object HW no longer has */
+bool IPACM_RuleTxn::CommitTables(bool deletion)
+{
+	bool res = true;
+	int ip;
+
+	if (!deletion && hdr_dirty && m_hdr->Commit() == false)
+	{
+		res = false;
+	}
+
+	if (deletion)
+	{
+		for (ip = IPA_IP_v4; ip <= IPA_IP_v6; ip++)
+		{
+			if ((flt_dirty & IPACM_TXN_IP_BIT(ip)) && m_flt->Commit((ipa_ip_type)ip) == false)
+			{
+				res = false;
+			}
+		}
+	}
+
+	for (ip = IPA_IP_v4; ip <= IPA_IP_v6; ip++)
+	{
+		if ((rt_dirty & IPACM_TXN_IP_BIT(ip)) && m_rt->Commit((ipa_ip_type)ip) == false)
+		{
+			res = false;
+		}
+	}
+
+	if (!deletion)
+	{
+		for (ip = IPA_IP_v4; ip <= IPA_IP_v6; ip++)
+		{
+			if ((flt_dirty & IPACM_TXN_IP_BIT(ip)) && m_flt->Commit((ipa_ip_type)ip) == false)
+			{
+				res = false;
+			}
+		}
+	}
+
+	if (deletion && hdr_dirty && m_hdr->Commit() == false)
+	{
+		res = false;
+	}
+
+	flt_dirty = 0;
+	rt_dirty = 0;
+	hdr_dirty = false;
+	return res;
+}
+
+/* remove top down and commit the removals */
+bool IPACM_RuleTxn::CommitDel()
+{
+	bool res = true;
+
+	res &= CommitFltDel();
+	res &= CommitRtDel();
+	res &= CommitHdrDel();
+	res &= CommitTables(true);
+	return res;
+}
+
+/* add bottom up, then commit the additions */
+bool IPACM_RuleTxn::CommitAdd()
+{
+	bool res = true;
+
+	res &= CommitRtAdd();
+	res &= CommitFltAdd();
+	res &= CommitTables(false);
+	return res;
+}
+
+/* Take the rules added by a failed make before break commit out of HW
+	 again and drop the queued modifies/deletes, the tables are left as
+	 they were before the commit */
+bool IPACM_RuleTxn::RollbackAdd()
+{
+	int cnt;
+
+	num_flt_mdfy = 0;
+	num_flt_del = 0;
+	num_rt_del = 0;
+	num_hdr_del = 0;
+
+	for (cnt = 0; cnt < num_flt_add; cnt++)
+	{
+		if (flt_add[cnt].rule.status == 0 &&
+				DelFltRule(flt_add[cnt].ip, flt_add[cnt].rule.flt_rule_hdl) == false)
+		{
+			return false;
+		}
+		if (flt_add[cnt].hdl != NULL)
+		{
+			*flt_add[cnt].hdl = 0;
+		}
+	}
+	for (cnt = 0; cnt < num_rt_add; cnt++)
+	{
+		if (rt_add[cnt].rule.status == 0 &&
+				DelRtRule(rt_add[cnt].ip, rt_add[cnt].rule.rt_rule_hdl) == false)
+		{
+			return false;
+		}
+		if (rt_add[cnt].hdl != NULL)
+		{
+			*rt_add[cnt].hdl = 0;
+		}
+	}
+
+	return CommitDel();
+}
+
+bool IPACM_RuleTxn::Commit(ipacm_txn_order order)
+{
+	bool res = true;
+
+	IPACMDBG("Committing rule txn (order %d): flt add %d mdfy %d del %d, rt add %d del %d, hdr del %d\n",
+					 order, num_flt_add, num_flt_mdfy, num_flt_del, num_rt_add, num_rt_del, num_hdr_del);
+
+	if (order == IPACM_TXN_MAKE_BEFORE_BREAK)
+	{
+		if (CommitAdd() == false)
+		{
+			IPACMERR("rule txn addition failed, rolling it back\n");
+			if (RollbackAdd() == false)
+			{
+				IPACMERR("rule txn rollback failed\n");
+			}
+			Abort();
+			return false;
+		}
+		res &= CommitFltMdfy();
+		res &= CommitDel();
+	}
+	else
+	{
+		res &= CommitDel();
+		res &= CommitRtAdd();
+		res &= CommitFltAdd();
+		res &= CommitFltMdfy();
+		res &= CommitTables(false);
+	}
+
+	Abort();
+	return res;
+}
+
+void IPACM_RuleTxn::Abort()
+{
+	num_flt_add = 0;
+	num_rt_add = 0;
+	num_flt_mdfy = 0;
+	num_flt_del = 0;
+	num_rt_del = 0;
+	num_hdr_del = 0;
+	flt_dirty = 0;
+	rt_dirty = 0;
+	hdr_dirty = false;
+}
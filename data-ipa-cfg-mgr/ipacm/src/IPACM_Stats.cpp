@@ -0,0 +1,187 @@
+/*
+Copyright (c) 2014, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_Stats.cpp
+
+	@brief
+	This file implements the memory mapped tethering statistics region
+
+	@Author
+
+*/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include "IPACM_Stats.h"
+#include "IPACM_Log.h"
+
+IPACM_Stats *IPACM_Stats::pInstance = NULL;
+
+IPACM_Stats::IPACM_Stats()
+{
+	int fd;
+	struct stat st;
+	void *addr = MAP_FAILED;
+	int i;
+
+	memset(&dummy, 0, sizeof(dummy));
+
+	fd = open(IPACM_STATS_FILE_NAME, O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+	{
+		IPACMERR("Failed opening %s, error is %d - %s\n", IPACM_STATS_FILE_NAME, errno, strerror(errno));
+	}
+	else
+	{
+		if (fstat(fd, &st) == 0 &&
+				(st.st_size == (off_t)sizeof(ipacm_stats_region) || ftruncate(fd, sizeof(ipacm_stats_region)) == 0))
+		{
+			addr = mmap(NULL, sizeof(ipacm_stats_region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		}
+		close(fd);
+	}
+
+	if (addr == MAP_FAILED)
+	{
+		/* keep counting in memory, the handlers never see a missing region */
+		IPACMERR("Failed mapping %s, stats won't be exported\n", IPACM_STATS_FILE_NAME);
+		addr = calloc(1, sizeof(ipacm_stats_region));
+		if (addr == NULL)
+		{
+			IPACMERR("Failed to allocate stats region\n");
+			region = NULL;
+			return;
+		}
+	}
+	region = (ipacm_stats_region *)addr;
+
+	if (region->magic != IPACM_STATS_MAGIC || region->version != IPACM_STATS_VERSION
+		|| region->size != sizeof(ipacm_stats_region))
+	{
+		IPACMDBG_H("Initializing stats region, layout version %d\n", IPACM_STATS_VERSION);
+		memset(region, 0, sizeof(ipacm_stats_region));
+		region->version = IPACM_STATS_VERSION;
+		region->size = sizeof(ipacm_stats_region);
+		region->num_iface = IPACM_STATS_MAX_IFACE;
+		__sync_synchronize();
+		region->magic = IPACM_STATS_MAGIC;
+	}
+	else
+	{
+		IPACMDBG_H("Reusing stats region from previous run\n");
+		for (i = 0; i < IPACM_STATS_MAX_IFACE; i++)
+		{
+			ValidateEntry(&region->tether[i]);
+			ValidateEntry(&region->network[i]);
+		}
+	}
+}
+
+/* A previous run killed between BeginUpdate and EndUpdate leaves seq odd,
+	 and readers would retry that entry forever. Its counters may be torn,
+	 so drop them and let ClaimEntry start the entry over, then round seq
+	 up to even. */
+void IPACM_Stats::ValidateEntry(ipacm_stats_iface *entry)
+{
+	uint32_t seq = entry->seq;
+
+	if ((seq & 1) == 0 && (entry->valid == 0 || (entry->valid == 1
+		&& memchr(entry->dev_name, '\0', sizeof(entry->dev_name)) != NULL
+		&& memchr(entry->upstream_name, '\0', sizeof(entry->upstream_name)) != NULL)))
+	{
+		return;
+	}
+
+	IPACMDBG_H("Dropping stats entry %.*s, seq %u valid %u\n", IPA_IFACE_NAME_LEN,
+		entry->dev_name, seq, entry->valid);
+	if ((seq & 1) == 0)
+	{
+		seq++;
+		entry->seq = seq;
+		__sync_synchronize();
+	}
+	memset((char *)entry + offsetof(ipacm_stats_iface, valid), 0,
+		sizeof(ipacm_stats_iface) - offsetof(ipacm_stats_iface, valid));
+	__sync_synchronize();
+	entry->seq = seq + 1;
+}
+
+IPACM_Stats* IPACM_Stats::GetInstance()
+{
+	if (pInstance == NULL)
+	{
+		pInstance = new IPACM_Stats();
+		IPACMDBG("Created stats region\n");
+	}
+	return pInstance;
+}
+
+/* counters only carry over a restart if the slot still belongs to the same device */
+ipacm_stats_iface* IPACM_Stats::ClaimEntry(ipacm_stats_iface *entry, const char *dev_name)
+{
+	if (entry->valid && strncmp(entry->dev_name, dev_name, IPA_IFACE_NAME_LEN) == 0)
+	{
+		return entry;
+	}
+
+	IPACMDBG_H("Claim stats entry for %s\n", dev_name);
+	BeginUpdate(entry);
+	memset(&entry->last, 0, sizeof(entry->last));
+	memset(&entry->total, 0, sizeof(entry->total));
+	memset(entry->pipe, 0, sizeof(entry->pipe));
+	memset(entry->upstream_name, 0, sizeof(entry->upstream_name));
+	memset(entry->dev_name, 0, sizeof(entry->dev_name));
+	strncpy(entry->dev_name, dev_name, IPA_IFACE_NAME_LEN - 1);
+	entry->valid = 1;
+	EndUpdate(entry);
+	return entry;
+}
+
+ipacm_stats_iface* IPACM_Stats::GetTetherEntry(int ipa_if_num, const char *dev_name)
+{
+	if (region == NULL || ipa_if_num < 0 || ipa_if_num >= IPACM_STATS_MAX_IFACE)
+	{
+		IPACMERR("No stats entry for iface %d\n", ipa_if_num);
+		return &dummy;
+	}
+	return ClaimEntry(&region->tether[ipa_if_num], dev_name);
+}
+
+ipacm_stats_iface* IPACM_Stats::GetNetworkEntry(int ipa_if_num, const char *dev_name)
+{
+	if (region == NULL || ipa_if_num < 0 || ipa_if_num >= IPACM_STATS_MAX_IFACE)
+	{
+		IPACMERR("No stats entry for iface %d\n", ipa_if_num);
+		return &dummy;
+	}
+	return ClaimEntry(&region->network[ipa_if_num], dev_name);
+}
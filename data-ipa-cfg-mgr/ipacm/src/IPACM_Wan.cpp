@@ -50,6 +50,9 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Defs.h"
 #include <IPACM_ConntrackListener.h>
 #include "linux/ipa_qmi_service_v01.h"
+#include "IPACM_RuleTxn.h"
+#include "IPACM_Stats.h"
+#include "IPACM_CfgSnapshot.h"
 
 bool IPACM_Wan::wan_up = false;
 bool IPACM_Wan::wan_up_v6 = false;
@@ -86,6 +89,8 @@ IPACM_Wan::IPACM_Wan(int iface_index,
 {
 	num_firewall_v4 = 0;
 	num_firewall_v6 = 0;
+	firewall_enable_v4 = firewall_enable_v6 = false;
+	firewall_accept_v4 = firewall_accept_v6 = false;
 	wan_route_rule_v4_hdl = NULL;
 	wan_route_rule_v6_hdl = NULL;
 	wan_route_rule_v6_hdl_a5 = NULL;
@@ -929,14 +934,11 @@ void IPACM_Wan::event_callback(ipa_cm_event_id event, void *param)
 		{
 			if (active_v4)
 			{
-				del_dft_firewall_rules(IPA_IP_v4);
-				config_dft_firewall_rules(IPA_IP_v4);
+				update_dft_firewall_rules(IPA_IP_v4);
 			}
 			if (active_v6)
 			{
-
-				del_dft_firewall_rules(IPA_IP_v6);
-				config_dft_firewall_rules(IPA_IP_v6);
+				update_dft_firewall_rules(IPA_IP_v6);
 			}
 		}
 		break;
@@ -1687,7 +1689,7 @@ int IPACM_Wan::config_dft_firewall_rules(ipa_ip_type iptype)
 	strncpy(firewall_config.firewall_config_file, "/etc/mobileap_firewall.xml", sizeof(firewall_config.firewall_config_file));
 
 	IPACMDBG_H("Firewall XML file is %s \n", firewall_config.firewall_config_file);
-	if (IPACM_SUCCESS == IPACM_read_firewall_xml(firewall_config.firewall_config_file, &firewall_config))
+	if (IPACM_SUCCESS == IPACM_read_firewall_snapshot(firewall_config.firewall_config_file, &firewall_config))
 	{
 		IPACMDBG_H("QCMAP Firewall XML read OK \n");
 		/* find the number of v4/v6 firewall rules */
@@ -1818,6 +1820,7 @@ int IPACM_Wan::config_dft_firewall_rules(ipa_ip_type iptype)
 
 			/* copy filter hdls */
 			dft_wan_fl_hdl[0] = m_pFilteringTable->rules[0].flt_rule_hdl;
+			memcpy(&dft_wan_fl_rule[0], &m_pFilteringTable->rules[0].rule, sizeof(struct ipa_flt_rule));
 		}
 		else
 		{
@@ -1839,115 +1842,37 @@ int IPACM_Wan::config_dft_firewall_rules(ipa_ip_type iptype)
 			}
 			IPACMDBG_H("Routing handle for wan routing table:0x%x\n", IPACM_Iface::ipacmcfg->rt_tbl_lan_v4.hdl);
 
-            if(firewall_config.firewall_enable == true)
-            {
-			rule_v4 = 0;
-			for (i = 0; i < firewall_config.num_extd_firewall_entries; i++)
+			if(firewall_config.firewall_enable == true)
 			{
-				if (firewall_config.extd_firewall_entries[i].ip_vsn == 4)
+				rule_v4 = build_firewall_rules(&firewall_config, IPA_IP_v4, firewall_rule_v4, IPACM_MAX_FIREWALL_ENTRIES);
+				for (i = 0; i < rule_v4; i++)
 				{
 					memset(&flt_rule_entry, 0, sizeof(struct ipa_flt_rule_add));
-
-		    			flt_rule_entry.at_rear = true;
+					flt_rule_entry.at_rear = true;
 					flt_rule_entry.flt_rule_hdl = -1;
 					flt_rule_entry.status = -1;
-					flt_rule_entry.rule.rt_tbl_hdl = IPACM_Iface::ipacmcfg->rt_tbl_lan_v4.hdl;
-
-					/* Accept v4 matched rules*/
-                                        if(firewall_config.rule_action_accept == true)
-			                {
-			                     flt_rule_entry.rule.action = IPA_PASS_TO_DST_NAT;
-			                }
-			                else
-			                {
-			                     flt_rule_entry.rule.action = IPA_PASS_TO_EXCEPTION;
-                                        }
-
-					memcpy(&flt_rule_entry.rule.attrib,
-								 &firewall_config.extd_firewall_entries[i].attrib,
-								 sizeof(struct ipa_rule_attrib));
-
-					IPACMDBG_H("rx property attrib mask: 0x%x\n", rx_prop->rx[0].attrib.attrib_mask);
-					flt_rule_entry.rule.attrib.attrib_mask |= rx_prop->rx[0].attrib.attrib_mask;
-					flt_rule_entry.rule.attrib.meta_data_mask = rx_prop->rx[0].attrib.meta_data_mask;
-					flt_rule_entry.rule.attrib.meta_data = rx_prop->rx[0].attrib.meta_data;
+					memcpy(&flt_rule_entry.rule, &firewall_rule_v4[i], sizeof(struct ipa_flt_rule));
+					memcpy(&(m_pFilteringTable->rules[0]), &flt_rule_entry, sizeof(struct ipa_flt_rule_add));
 
-					/* check if the rule is define as TCP_UDP, split into 2 rules, 1 for TCP and 1 UDP */
-					if (firewall_config.extd_firewall_entries[i].attrib.u.v4.protocol
-							== IPACM_FIREWALL_IPPROTO_TCP_UDP)
+					IPACMDBG_H("Filter rule attrib mask: 0x%x\n",
+									 m_pFilteringTable->rules[0].rule.attrib.attrib_mask);
+					if (false == m_filtering.AddFilteringRule(m_pFilteringTable))
 					{
-						/* insert TCP rule*/
-						flt_rule_entry.rule.attrib.u.v4.protocol = IPACM_FIREWALL_IPPROTO_TCP;
-						memcpy(&(m_pFilteringTable->rules[0]), &flt_rule_entry, sizeof(struct ipa_flt_rule_add));
-
-						IPACMDBG_H("Filter rule attrib mask: 0x%x\n",
-										 m_pFilteringTable->rules[0].rule.attrib.attrib_mask);
-						if (false == m_filtering.AddFilteringRule(m_pFilteringTable))
-						{
-							IPACMERR("Error Adding RuleTable(0) to Filtering, aborting...\n");
-							free(m_pFilteringTable);
-							return IPACM_FAILURE;
-						}
-						else
-						{
-							/* save v4 firewall filter rule handler */
-							IPACMDBG_H("flt rule hdl0=0x%x, status=0x%x\n",
-											 m_pFilteringTable->rules[rule_v4].flt_rule_hdl,
-											 m_pFilteringTable->rules[rule_v4].status);
-							firewall_hdl_v4[rule_v4] = m_pFilteringTable->rules[0].flt_rule_hdl;
-							num_firewall_v4++;
-							rule_v4++;
-						}
-
-						/* insert UDP rule*/
-						flt_rule_entry.rule.attrib.u.v4.protocol = IPACM_FIREWALL_IPPROTO_UDP;
-						memcpy(&(m_pFilteringTable->rules[0]), &flt_rule_entry, sizeof(struct ipa_flt_rule_add));
-
-						IPACMDBG_H("Filter rule attrib mask: 0x%x\n",
-										 m_pFilteringTable->rules[0].rule.attrib.attrib_mask);
-						if (false == m_filtering.AddFilteringRule(m_pFilteringTable))
-						{
-							IPACMERR("Error Adding RuleTable(0) to Filtering, aborting...\n");
-							free(m_pFilteringTable);
-							return IPACM_FAILURE;
-						}
-						else
-						{
-							/* save v4 firewall filter rule handler */
-							IPACMDBG_H("flt rule hdl0=0x%x, status=0x%x\n",
-											 m_pFilteringTable->rules[rule_v4].flt_rule_hdl,
-											 m_pFilteringTable->rules[rule_v4].status);
-							firewall_hdl_v4[rule_v4] = m_pFilteringTable->rules[0].flt_rule_hdl;
-							num_firewall_v4++;
-							rule_v4++;
-						}
+						IPACMERR("Error Adding RuleTable(0) to Filtering, aborting...\n");
+						free(m_pFilteringTable);
+						return IPACM_FAILURE;
 					}
 					else
 					{
-						memcpy(&(m_pFilteringTable->rules[0]), &flt_rule_entry, sizeof(struct ipa_flt_rule_add));
-
-						IPACMDBG_H("Filter rule attrib mask: 0x%x\n",
-										 m_pFilteringTable->rules[0].rule.attrib.attrib_mask);
-						if (false == m_filtering.AddFilteringRule(m_pFilteringTable))
-						{
-							IPACMERR("Error Adding RuleTable(0) to Filtering, aborting...\n");
-							free(m_pFilteringTable);
-							return IPACM_FAILURE;
-						}
-						else
-						{
-							/* save v4 firewall filter rule handler */
-							IPACMDBG_H("flt rule hdl0=0x%x, status=0x%x\n",
-											 m_pFilteringTable->rules[rule_v4].flt_rule_hdl,
-											 m_pFilteringTable->rules[rule_v4].status);
-							firewall_hdl_v4[rule_v4] = m_pFilteringTable->rules[0].flt_rule_hdl;
-							num_firewall_v4++;
-							rule_v4++;
-						}
+						/* save v4 firewall filter rule handler */
+						IPACMDBG_H("flt rule hdl0=0x%x, status=0x%x\n",
+										 m_pFilteringTable->rules[0].flt_rule_hdl,
+										 m_pFilteringTable->rules[0].status);
+						firewall_hdl_v4[i] = m_pFilteringTable->rules[0].flt_rule_hdl;
+						num_firewall_v4++;
 					}
-				}
-			} /* end of firewall ipv4 filter rule add for loop*/
-            }
+				} /* end of firewall ipv4 filter rule add for loop*/
+			}
 			/* configure default filter rule */
 			memset(&flt_rule_entry, 0, sizeof(struct ipa_flt_rule_add));
 
@@ -2000,6 +1925,7 @@ int IPACM_Wan::config_dft_firewall_rules(ipa_ip_type iptype)
 
 			/* copy filter hdls */
 			dft_wan_fl_hdl[0] = m_pFilteringTable->rules[0].flt_rule_hdl;
+			memcpy(&dft_wan_fl_rule[0], &m_pFilteringTable->rules[0].rule, sizeof(struct ipa_flt_rule));
 		}
 
 	}
@@ -2042,6 +1968,7 @@ int IPACM_Wan::config_dft_firewall_rules(ipa_ip_type iptype)
 			}
 			/* copy filter hdls */
 			dft_wan_fl_hdl[2] = m_pFilteringTable->rules[0].flt_rule_hdl;
+			memcpy(&dft_wan_fl_rule[2], &m_pFilteringTable->rules[0].rule, sizeof(struct ipa_flt_rule));
 
 			/* End of construct ICMP rule */
 
@@ -2107,6 +2034,7 @@ int IPACM_Wan::config_dft_firewall_rules(ipa_ip_type iptype)
 
 			/* copy filter hdls */
 			dft_wan_fl_hdl[1] = m_pFilteringTable->rules[0].flt_rule_hdl;
+			memcpy(&dft_wan_fl_rule[1], &m_pFilteringTable->rules[0].rule, sizeof(struct ipa_flt_rule));
 		}
 		else
 		{
@@ -2125,98 +2053,37 @@ int IPACM_Wan::config_dft_firewall_rules(ipa_ip_type iptype)
 				return IPACM_FAILURE;
 			}
 
-            if(firewall_config.firewall_enable == true)
-            {
-			rule_v6 = 0;
-			for (i = 0; i < firewall_config.num_extd_firewall_entries; i++)
+			if(firewall_config.firewall_enable == true)
 			{
-				if (firewall_config.extd_firewall_entries[i].ip_vsn == 6)
+				rule_v6 = build_firewall_rules(&firewall_config, IPA_IP_v6, firewall_rule_v6, IPACM_MAX_FIREWALL_ENTRIES);
+				for (i = 0; i < rule_v6; i++)
 				{
 					memset(&flt_rule_entry, 0, sizeof(struct ipa_flt_rule_add));
-
-		    			flt_rule_entry.at_rear = true;
+					flt_rule_entry.at_rear = true;
 					flt_rule_entry.flt_rule_hdl = -1;
 					flt_rule_entry.status = -1;
+					memcpy(&flt_rule_entry.rule, &firewall_rule_v6[i], sizeof(struct ipa_flt_rule));
+					memcpy(&(m_pFilteringTable->rules[0]), &flt_rule_entry, sizeof(struct ipa_flt_rule_add));
 
-				    /* matched rules for v6 go PASS_TO_ROUTE */
-                                    if(firewall_config.rule_action_accept == true)
-			            {
-			                flt_rule_entry.rule.action = IPA_PASS_TO_ROUTING;
-			            }
-			            else
-			            {
-					flt_rule_entry.rule.action = IPA_PASS_TO_EXCEPTION;
-                                    }
-
-		    			flt_rule_entry.rule.rt_tbl_hdl = IPACM_Iface::ipacmcfg->rt_tbl_wan_v6.hdl;
-					memcpy(&flt_rule_entry.rule.attrib,
-								 &firewall_config.extd_firewall_entries[i].attrib,
-								 sizeof(struct ipa_rule_attrib));
-					flt_rule_entry.rule.attrib.attrib_mask |= rx_prop->rx[0].attrib.attrib_mask;
-					flt_rule_entry.rule.attrib.meta_data_mask = rx_prop->rx[0].attrib.meta_data_mask;
-					flt_rule_entry.rule.attrib.meta_data = rx_prop->rx[0].attrib.meta_data;
-
-					/* check if the rule is define as TCP/UDP */
-					if (firewall_config.extd_firewall_entries[i].attrib.u.v6.next_hdr == IPACM_FIREWALL_IPPROTO_TCP_UDP)
+					IPACMDBG_H("Filter rule attrib mask: 0x%x\n",
+									 m_pFilteringTable->rules[0].rule.attrib.attrib_mask);
+					if (false == m_filtering.AddFilteringRule(m_pFilteringTable))
 					{
-						/* insert TCP rule*/
-						flt_rule_entry.rule.attrib.u.v6.next_hdr = IPACM_FIREWALL_IPPROTO_TCP;
-						memcpy(&(m_pFilteringTable->rules[0]), &flt_rule_entry, sizeof(struct ipa_flt_rule_add));
-						if (false == m_filtering.AddFilteringRule(m_pFilteringTable))
-						{
-							IPACMERR("Error Adding Filtering rules, aborting...\n");
-							free(m_pFilteringTable);
-							return IPACM_FAILURE;
-						}
-						else
-						{
-							/* save v4 firewall filter rule handler */
-							IPACMDBG_H("flt rule hdl0=0x%x, status=0x%x\n", m_pFilteringTable->rules[0].flt_rule_hdl, m_pFilteringTable->rules[0].status);
-							firewall_hdl_v6[rule_v6] = m_pFilteringTable->rules[0].flt_rule_hdl;
-							num_firewall_v6++;
-							rule_v6++;
-						}
-
-						/* insert UDP rule*/
-						flt_rule_entry.rule.attrib.u.v6.next_hdr = IPACM_FIREWALL_IPPROTO_UDP;
-						memcpy(&(m_pFilteringTable->rules[0]), &flt_rule_entry, sizeof(struct ipa_flt_rule_add));
-						if (false == m_filtering.AddFilteringRule(m_pFilteringTable))
-						{
-							IPACMERR("Error Adding Filtering rules, aborting...\n");
-							free(m_pFilteringTable);
-							return IPACM_FAILURE;
-						}
-						else
-						{
-							/* save v6 firewall filter rule handler */
-							IPACMDBG_H("flt rule hdl0=0x%x, status=0x%x\n", m_pFilteringTable->rules[0].flt_rule_hdl, m_pFilteringTable->rules[0].status);
-							firewall_hdl_v6[rule_v6] = m_pFilteringTable->rules[0].flt_rule_hdl;
-							num_firewall_v6++;
-							rule_v6++;
-						}
+						IPACMERR("Error Adding RuleTable(0) to Filtering, aborting...\n");
+						free(m_pFilteringTable);
+						return IPACM_FAILURE;
 					}
 					else
 					{
-
-						memcpy(&(m_pFilteringTable->rules[0]), &flt_rule_entry, sizeof(struct ipa_flt_rule_add));
-						if (false == m_filtering.AddFilteringRule(m_pFilteringTable))
-						{
-							IPACMERR("Error Adding Filtering rules, aborting...\n");
-							free(m_pFilteringTable);
-							return IPACM_FAILURE;
-						}
-						else
-						{
-							/* save v6 firewall filter rule handler */
-							IPACMDBG_H("flt rule hdl0=0x%x, status=0x%x\n", m_pFilteringTable->rules[0].flt_rule_hdl, m_pFilteringTable->rules[0].status);
-							firewall_hdl_v6[rule_v6] = m_pFilteringTable->rules[0].flt_rule_hdl;
-							num_firewall_v6++;
-							rule_v6++;
-						}
+						/* save v6 firewall filter rule handler */
+						IPACMDBG_H("flt rule hdl0=0x%x, status=0x%x\n",
+										 m_pFilteringTable->rules[0].flt_rule_hdl,
+										 m_pFilteringTable->rules[0].status);
+						firewall_hdl_v6[i] = m_pFilteringTable->rules[0].flt_rule_hdl;
+						num_firewall_v6++;
 					}
-				}
-			} /* end of firewall ipv6 filter rule add for loop*/
-            }
+				} /* end of firewall ipv6 filter rule add for loop*/
+			}
 
 			/* Construct ICMP rule */
 			memset(&flt_rule_entry, 0, sizeof(struct ipa_flt_rule_add));
@@ -2245,6 +2112,7 @@ int IPACM_Wan::config_dft_firewall_rules(ipa_ip_type iptype)
 			}
 			/* copy filter hdls */
 			dft_wan_fl_hdl[2] = m_pFilteringTable->rules[0].flt_rule_hdl;
+			memcpy(&dft_wan_fl_rule[2], &m_pFilteringTable->rules[0].rule, sizeof(struct ipa_flt_rule));
 			/* End of construct ICMP rule */
 
 			/* setup default wan filter rule */
@@ -2302,9 +2170,22 @@ int IPACM_Wan::config_dft_firewall_rules(ipa_ip_type iptype)
 			}
 			/* copy filter hdls*/
 			dft_wan_fl_hdl[1] = m_pFilteringTable->rules[0].flt_rule_hdl;
+			memcpy(&dft_wan_fl_rule[1], &m_pFilteringTable->rules[0].rule, sizeof(struct ipa_flt_rule));
 		}
 	}
 
+	/* remember what the installed rules were built with */
+	if (iptype == IPA_IP_v4)
+	{
+		firewall_enable_v4 = firewall_config.firewall_enable;
+		firewall_accept_v4 = firewall_config.rule_action_accept;
+	}
+	else
+	{
+		firewall_enable_v6 = firewall_config.firewall_enable;
+		firewall_accept_v6 = firewall_config.rule_action_accept;
+	}
+
 	if(m_pFilteringTable != NULL)
 	{
 		free(m_pFilteringTable);
@@ -2312,6 +2193,338 @@ int IPACM_Wan::config_dft_firewall_rules(ipa_ip_type iptype)
 	return IPACM_SUCCESS;
 }
 
+/* build the firewall filter rules of iptype from config, TCP_UDP entries expanded */
+int IPACM_Wan::build_firewall_rules(IPACM_firewall_conf_t *config, ipa_ip_type iptype,
+		struct ipa_flt_rule *rules, int max_rules)
+{
+	struct ipa_flt_rule rule;
+	firewall_ip_version_enum vsn;
+	int i, num = 0;
+
+	vsn = (iptype == IPA_IP_v4) ? IP_V4 : IP_V6;
+	for (i = 0; i < config->num_extd_firewall_entries; i++)
+	{
+		if (config->extd_firewall_entries[i].ip_vsn != vsn)
+		{
+			continue;
+		}
+
+		memset(&rule, 0, sizeof(rule));
+		if (iptype == IPA_IP_v4)
+		{
+			rule.rt_tbl_hdl = IPACM_Iface::ipacmcfg->rt_tbl_lan_v4.hdl;
+			/* Accept v4 matched rules*/
+			rule.action = (config->rule_action_accept == true) ? IPA_PASS_TO_DST_NAT : IPA_PASS_TO_EXCEPTION;
+		}
+		else
+		{
+			rule.rt_tbl_hdl = IPACM_Iface::ipacmcfg->rt_tbl_wan_v6.hdl;
+			/* matched rules for v6 go PASS_TO_ROUTE */
+			rule.action = (config->rule_action_accept == true) ? IPA_PASS_TO_ROUTING : IPA_PASS_TO_EXCEPTION;
+		}
+		memcpy(&rule.attrib, &config->extd_firewall_entries[i].attrib, sizeof(struct ipa_rule_attrib));
+		rule.attrib.attrib_mask |= rx_prop->rx[0].attrib.attrib_mask;
+		rule.attrib.meta_data_mask = rx_prop->rx[0].attrib.meta_data_mask;
+		rule.attrib.meta_data = rx_prop->rx[0].attrib.meta_data;
+
+		/* check if the rule is define as TCP_UDP, split into 2 rules, 1 for TCP and 1 UDP */
+		if ((iptype == IPA_IP_v4 && rule.attrib.u.v4.protocol == IPACM_FIREWALL_IPPROTO_TCP_UDP) ||
+				(iptype == IPA_IP_v6 && rule.attrib.u.v6.next_hdr == IPACM_FIREWALL_IPPROTO_TCP_UDP))
+		{
+			if (num + 2 > max_rules)
+			{
+				IPACMERR("Too many firewall rules, dropping entry %d\n", i);
+				break;
+			}
+			if (iptype == IPA_IP_v4)
+			{
+				rule.attrib.u.v4.protocol = IPACM_FIREWALL_IPPROTO_TCP;
+				memcpy(&rules[num++], &rule, sizeof(rule));
+				rule.attrib.u.v4.protocol = IPACM_FIREWALL_IPPROTO_UDP;
+				memcpy(&rules[num++], &rule, sizeof(rule));
+			}
+			else
+			{
+				rule.attrib.u.v6.next_hdr = IPACM_FIREWALL_IPPROTO_TCP;
+				memcpy(&rules[num++], &rule, sizeof(rule));
+				rule.attrib.u.v6.next_hdr = IPACM_FIREWALL_IPPROTO_UDP;
+				memcpy(&rules[num++], &rule, sizeof(rule));
+			}
+		}
+		else
+		{
+			if (num + 1 > max_rules)
+			{
+				IPACMERR("Too many firewall rules, dropping entry %d\n", i);
+				break;
+			}
+			memcpy(&rules[num++], &rule, sizeof(rule));
+		}
+	}
+
+	return num;
+}
+
+/* sort firewall rules (and their handles, if any) into canonical order */
+static void ipacm_sort_firewall_rules(struct ipa_flt_rule *rules, uint32_t *hdls, int num)
+{
+	struct ipa_flt_rule rule;
+	uint32_t hdl = 0;
+	int i, j;
+
+	for (i = 1; i < num; i++)
+	{
+		memcpy(&rule, &rules[i], sizeof(rule));
+		if (hdls != NULL)
+		{
+			hdl = hdls[i];
+		}
+		for (j = i; j > 0 && memcmp(&rules[j - 1], &rule, sizeof(rule)) > 0; j--)
+		{
+			memcpy(&rules[j], &rules[j - 1], sizeof(rule));
+			if (hdls != NULL)
+			{
+				hdls[j] = hdls[j - 1];
+			}
+		}
+		memcpy(&rules[j], &rule, sizeof(rule));
+		if (hdls != NULL)
+		{
+			hdls[j] = hdl;
+		}
+	}
+}
+
+/* for STA mode: re-read the firewall config and only add/modify/delete the
+	 firewall rules that changed, the default rules stay in place. Falls back
+	 to a full reinstall when the enable/accept settings change */
+int IPACM_Wan::update_dft_firewall_rules(ipa_ip_type iptype)
+{
+	IPACM_firewall_conf_t *new_config = NULL;
+	struct ipa_flt_rule *new_rules = NULL, *installed_rules;
+	struct ipa_flt_rule_add flt_rule_entry;
+	struct ipa_flt_rule_mdfy flt_rule_mdfy;
+	IPACM_RuleTxn txn(&m_filtering, &m_routing, &m_header);
+	uint32_t *installed_hdls;
+	int *num_installed;
+	int del_idx[IPACM_MAX_FIREWALL_ENTRIES], add_idx[IPACM_MAX_FIREWALL_ENTRIES];
+	uint32_t new_dft_hdl[IPA_NUM_DEFAULT_WAN_FILTER_RULES];
+	int num_new, num_del = 0, num_add = 0, num_mdfy, num_keep, num_dft;
+	int i, j, cmp, res = IPACM_SUCCESS;
+	bool enable, accept, applied;
+
+	IPACMDBG_H("ip-family: %d; \n", iptype);
+
+	if (rx_prop == NULL)
+	{
+		IPACMDBG_H("No rx properties registered for iface %s\n", dev_name);
+		return IPACM_SUCCESS;
+	}
+
+	new_config = (IPACM_firewall_conf_t *)calloc(1, sizeof(IPACM_firewall_conf_t));
+	new_rules = (struct ipa_flt_rule *)calloc(IPACM_MAX_FIREWALL_ENTRIES, sizeof(struct ipa_flt_rule));
+	if (new_config == NULL || new_rules == NULL)
+	{
+		IPACMERR("Unable to allocate firewall config\n");
+		res = IPACM_FAILURE;
+		goto fail;
+	}
+
+	strncpy(new_config->firewall_config_file, "/etc/mobileap_firewall.xml", sizeof(new_config->firewall_config_file));
+	if (IPACM_SUCCESS != IPACM_read_firewall_snapshot(new_config->firewall_config_file, new_config))
+	{
+		IPACMERR("QCMAP Firewall XML read failed, reinstall with default configuration \n");
+		goto reload;
+	}
+
+	if (iptype == IPA_IP_v4)
+	{
+		enable = firewall_enable_v4;
+		accept = firewall_accept_v4;
+		installed_rules = firewall_rule_v4;
+		installed_hdls = firewall_hdl_v4;
+		num_installed = &num_firewall_v4;
+		if (false == m_routing.GetRoutingTable(&IPACM_Iface::ipacmcfg->rt_tbl_lan_v4))
+		{
+			IPACMERR("m_routing.GetRoutingTable(rt_tbl_lan_v4) Failed.\n");
+			res = IPACM_FAILURE;
+			goto fail;
+		}
+	}
+	else
+	{
+		enable = firewall_enable_v6;
+		accept = firewall_accept_v6;
+		installed_rules = firewall_rule_v6;
+		installed_hdls = firewall_hdl_v6;
+		num_installed = &num_firewall_v6;
+		if (false == m_routing.GetRoutingTable(&IPACM_Iface::ipacmcfg->rt_tbl_wan_v6))
+		{
+			IPACMERR("m_routing.GetRoutingTable(rt_tbl_wan_v6) Failed.\n");
+			res = IPACM_FAILURE;
+			goto fail;
+		}
+	}
+
+	/* enable/accept decide the default and frag rules and every rule's action */
+	if (new_config->firewall_enable != enable || new_config->rule_action_accept != accept)
+	{
+		IPACMDBG_H("Firewall enable/action changed, reinstall all rules\n");
+		goto reload;
+	}
+
+	num_new = 0;
+	if (new_config->firewall_enable == true)
+	{
+		num_new = build_firewall_rules(new_config, iptype, new_rules, IPACM_MAX_FIREWALL_ENTRIES);
+	}
+
+	/* diff the two sorted lists, every firewall rule has the same action so
+		 their order within the table does not matter */
+	ipacm_sort_firewall_rules(installed_rules, installed_hdls, *num_installed);
+	ipacm_sort_firewall_rules(new_rules, NULL, num_new);
+	for (i = 0, j = 0; i < *num_installed || j < num_new; )
+	{
+		if (i < *num_installed && j < num_new)
+		{
+			cmp = memcmp(&installed_rules[i], &new_rules[j], sizeof(struct ipa_flt_rule));
+		}
+		else
+		{
+			cmp = (i < *num_installed) ? -1 : 1;
+		}
+
+		if (cmp == 0)
+		{
+			i++;
+			j++;
+		}
+		else if (cmp < 0)
+		{
+			del_idx[num_del++] = i++;
+		}
+		else
+		{
+			add_idx[num_add++] = j++;
+		}
+	}
+
+	IPACMDBG_H("firewall ip-family %d: %d installed, %d new, %d removed, %d added\n",
+					 iptype, *num_installed, num_new, num_del, num_add);
+	if (num_del == 0 && num_add == 0)
+	{
+		goto done;
+	}
+
+	/* rewrite removed rules in place with added ones, keeps their position
+		 ahead of the default rule */
+	num_mdfy = (num_del < num_add) ? num_del : num_add;
+	for (i = 0; i < num_mdfy; i++)
+	{
+		memset(&flt_rule_mdfy, 0, sizeof(flt_rule_mdfy));
+		memcpy(&flt_rule_mdfy.rule, &new_rules[add_idx[i]], sizeof(struct ipa_flt_rule));
+		flt_rule_mdfy.rule_hdl = installed_hdls[del_idx[i]];
+		flt_rule_mdfy.status = -1;
+		txn.ModifyFltRule(iptype, &flt_rule_mdfy);
+		memcpy(&installed_rules[del_idx[i]], &new_rules[add_idx[i]], sizeof(struct ipa_flt_rule));
+	}
+
+	/* drop the rest of the removed rules, the txn clears their handle
+		 once they are gone from HW */
+	for (i = num_mdfy; i < num_del; i++)
+	{
+		txn.DelFltRuleHdl(iptype, &installed_hdls[del_idx[i]]);
+	}
+
+	/* the rest of the added rules have to go in front of the default rule(s):
+		 append them plus a copy of the default rule(s), then drop the old ones.
+		 The txn installs the additions before it removes anything, so the
+		 table always ends with a default rule */
+	num_dft = (iptype == IPA_IP_v4) ? 1 : 2;
+	memset(new_dft_hdl, 0, sizeof(new_dft_hdl));
+	if (num_add > num_mdfy)
+	{
+		for (i = num_mdfy; i < num_add; i++)
+		{
+			memset(&flt_rule_entry, 0, sizeof(flt_rule_entry));
+			flt_rule_entry.at_rear = true;
+			flt_rule_entry.flt_rule_hdl = -1;
+			flt_rule_entry.status = -1;
+			memcpy(&flt_rule_entry.rule, &new_rules[add_idx[i]], sizeof(struct ipa_flt_rule));
+			memcpy(&installed_rules[*num_installed], &new_rules[add_idx[i]], sizeof(struct ipa_flt_rule));
+			txn.AddFltRule(iptype, rx_prop->rx[0].src_pipe, false, &flt_rule_entry, &installed_hdls[*num_installed]);
+			(*num_installed)++;
+		}
+
+		/* v4: default rule, v6: ICMP rule then default rule */
+		for (i = 0; i < num_dft; i++)
+		{
+			j = (iptype == IPA_IP_v4) ? 0 : ((i == 0) ? 2 : 1);
+			memset(&flt_rule_entry, 0, sizeof(flt_rule_entry));
+			flt_rule_entry.at_rear = true;
+			flt_rule_entry.flt_rule_hdl = -1;
+			flt_rule_entry.status = -1;
+			memcpy(&flt_rule_entry.rule, &dft_wan_fl_rule[j], sizeof(struct ipa_flt_rule));
+			txn.AddFltRule(iptype, rx_prop->rx[0].src_pipe, false, &flt_rule_entry, &new_dft_hdl[j]);
+			txn.DelFltRuleHdl(iptype, &dft_wan_fl_hdl[j]);
+		}
+	}
+
+	applied = txn.Commit(IPACM_TXN_MAKE_BEFORE_BREAK);
+
+	/* Match the handles to what HW has, also after a failed commit so the
+		 reload below only deletes rules that still exist: a failed addition
+		 left a 0 handle, a failed deletion kept its handle */
+	for (i = 0, num_keep = 0; i < *num_installed; i++)
+	{
+		if (installed_hdls[i] != 0)
+		{
+			installed_hdls[num_keep] = installed_hdls[i];
+			memcpy(&installed_rules[num_keep], &installed_rules[i], sizeof(struct ipa_flt_rule));
+			num_keep++;
+		}
+	}
+	*num_installed = num_keep;
+	for (i = 0; i < num_dft; i++)
+	{
+		j = (iptype == IPA_IP_v4) ? 0 : ((i == 0) ? 2 : 1);
+		if (new_dft_hdl[j] == 0)
+		{
+			continue;
+		}
+		if (dft_wan_fl_hdl[j] == 0)
+		{
+			dft_wan_fl_hdl[j] = new_dft_hdl[j];
+			continue;
+		}
+		/* the old copy could not be deleted and is still installed, drop the new one */
+		if (m_filtering.DeleteFilteringHdls(&new_dft_hdl[j], iptype, 1) == false)
+		{
+			IPACMERR("Failed to remove duplicate default rule hdl 0x%x\n", new_dft_hdl[j]);
+		}
+	}
+
+	if (applied == false)
+	{
+		IPACMERR("Failed to apply firewall delta, reinstall all rules\n");
+		goto reload;
+	}
+
+done:
+	/* keep the parsed config in sync with what is installed */
+	memcpy(&firewall_config, new_config, sizeof(IPACM_firewall_conf_t));
+	goto fail;
+
+reload:
+	del_dft_firewall_rules(iptype);
+	res = config_dft_firewall_rules(iptype);
+
+fail:
+	free(new_config);
+	free(new_rules);
+	return res;
+}
+
 /* configure the initial firewall filter rules */
 int IPACM_Wan::config_dft_firewall_rules_ex(struct ipa_flt_rule_add *rules, int rule_offset, ipa_ip_type iptype)
 {
@@ -2341,7 +2554,7 @@ int IPACM_Wan::config_dft_firewall_rules_ex(struct ipa_flt_rule_add *rules, int
 	strncpy(firewall_config.firewall_config_file, "/etc/mobileap_firewall.xml", sizeof(firewall_config.firewall_config_file));
 
 	IPACMDBG_H("Firewall XML file is %s \n", firewall_config.firewall_config_file);
-	if (IPACM_SUCCESS == IPACM_read_firewall_xml(firewall_config.firewall_config_file, &firewall_config))
+	if (IPACM_SUCCESS == IPACM_read_firewall_snapshot(firewall_config.firewall_config_file, &firewall_config))
 	{
 		IPACMDBG_H("QCMAP Firewall XML read OK \n");
 	}
@@ -5298,6 +5511,8 @@ int IPACM_Wan::handle_wan_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptyp
 /*handle eth client */
 int IPACM_Wan::handle_network_stats_update(ipa_get_apn_data_stats_resp_msg_v01 *data)
 {
+	ipacm_stats_iface *entry;
+	ipacm_stats_counter stats;
 	FILE *fp = NULL;
 
 	for (int apn_index =0; apn_index < data->apn_data_stats_list_len; apn_index++)
@@ -5310,6 +5525,17 @@ int IPACM_Wan::handle_network_stats_update(ipa_get_apn_data_stats_resp_msg_v01 *
 						data->apn_data_stats_list[apn_index].num_ul_bytes,
 							data->apn_data_stats_list[apn_index].num_dl_packets,
 								data->apn_data_stats_list[apn_index].num_dl_bytes);
+			stats.ul_packets = data->apn_data_stats_list[apn_index].num_ul_packets;
+			stats.ul_bytes = data->apn_data_stats_list[apn_index].num_ul_bytes;
+			stats.dl_packets = data->apn_data_stats_list[apn_index].num_dl_packets;
+			stats.dl_bytes = data->apn_data_stats_list[apn_index].num_dl_bytes;
+
+			entry = IPACM_Stats::GetInstance()->GetNetworkEntry(ipa_if_num, dev_name);
+			IPACM_Stats::BeginUpdate(entry);
+			entry->last = stats;
+			IPACM_Stats::AddCounter(&entry->total, &stats);
+			IPACM_Stats::EndUpdate(entry);
+
 			fp = fopen(IPA_NETWORK_STATS_FILE_NAME, "w");
 			if ( fp == NULL )
 			{
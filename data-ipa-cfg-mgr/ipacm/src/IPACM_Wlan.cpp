@@ -347,18 +347,23 @@ void IPACM_Wlan::event_callback(ipa_cm_event_id event, void *param)
 					{
 						if((data->iptype == IPA_IP_v6 || data->iptype == IPA_IP_MAX) && num_dft_rt_v6 == 1)
 						{
+							IPACM_RuleTxn txn(&m_filtering, &m_routing, &m_header);
+
+							/* STA mode: the prefix and default rule go in with one commit */
 							if(wlan_ap_index == 0) //install ipv6 prefix rule only once
 							{
-								install_ipv6_prefix_flt_rule(IPACM_Wan::backhaul_ipv6_prefix);
+								install_ipv6_prefix_flt_rule(IPACM_Wan::backhaul_ipv6_prefix, &txn);
 							}
 							if(IPACM_Wan::backhaul_is_sta_mode == false)
 							{
+								txn.Commit();
 								ext_prop = IPACM_Iface::ipacmcfg->GetExtProp(IPA_IP_v6);
 								IPACM_Lan::handle_wan_up_ex(ext_prop, IPA_IP_v6);
 							}
 							else
 							{
-								IPACM_Lan::handle_wan_up(IPA_IP_v6);
+								IPACM_Lan::handle_wan_up(IPA_IP_v6, &txn);
+								txn.Commit();
 							}
 						}
 					}
@@ -421,18 +426,23 @@ void IPACM_Wlan::event_callback(ipa_cm_event_id event, void *param)
 		{
 			if(ip_type == IPA_IP_v6 || ip_type == IPA_IP_MAX)
 			{
+				IPACM_RuleTxn txn(&m_filtering, &m_routing, &m_header);
+
+				/* STA mode: the prefix and default rule go in with one commit */
 				if(wlan_ap_index == 0) //install ipv6 prefix rule only once
 				{
-					install_ipv6_prefix_flt_rule(data_wan_tether->ipv6_prefix);
+					install_ipv6_prefix_flt_rule(data_wan_tether->ipv6_prefix, &txn);
 				}
 				if(data_wan_tether->is_sta == false)
 				{
+					txn.Commit();
 					ext_prop = IPACM_Iface::ipacmcfg->GetExtProp(IPA_IP_v6);
 					IPACM_Lan::handle_wan_up_ex(ext_prop, IPA_IP_v6);
 				}
 				else
 				{
-					IPACM_Lan::handle_wan_up(IPA_IP_v6);
+					IPACM_Lan::handle_wan_up(IPA_IP_v6, &txn);
+					txn.Commit();
 				}
 			}
 		}
@@ -540,18 +550,23 @@ void IPACM_Wlan::event_callback(ipa_cm_event_id event, void *param)
 #ifdef FEATURE_ETH_BRIDGE_LE
 			eth_bridge_install_wlan_guest_ap_ipv6_flt_rule();
 #endif
+			IPACM_RuleTxn txn(&m_filtering, &m_routing, &m_header);
+
+			/* STA mode: the prefix and default rule go in with one commit */
 			if(wlan_ap_index == 0) //install ipv6 prefix rule only once
 			{
-				install_ipv6_prefix_flt_rule(data_wan->ipv6_prefix);
+				install_ipv6_prefix_flt_rule(data_wan->ipv6_prefix, &txn);
 			}
 			if(data_wan->is_sta == false)
 			{
+				txn.Commit();
 				ext_prop = IPACM_Iface::ipacmcfg->GetExtProp(IPA_IP_v6);
 				IPACM_Lan::handle_wan_up_ex(ext_prop, IPA_IP_v6);
 			}
 			else
 			{
-				IPACM_Lan::handle_wan_up(IPA_IP_v6);
+				IPACM_Lan::handle_wan_up(IPA_IP_v6, &txn);
+				txn.Commit();
 			}
 		}
 		break;
@@ -1809,6 +1824,11 @@ int IPACM_Wlan::handle_wlan_client_init_ex(ipacm_event_data_wlan_ex *data)
 		get_client_memptr(wlan_client, num_wifi_client)->ipv4_set = false;
 		get_client_memptr(wlan_client, num_wifi_client)->ipv6_set = 0;
 		get_client_memptr(wlan_client, num_wifi_client)->power_save_set=false;
+		/* keep the first entry indexed if the station re-associates without a del */
+		if (get_wlan_client_index(get_client_memptr(wlan_client, num_wifi_client)->mac) == IPACM_INVALID_INDEX)
+		{
+			wlan_client_idx.Insert(get_client_memptr(wlan_client, num_wifi_client)->mac, num_wifi_client);
+		}
 		num_wifi_client++;
 		header_name_count++; //keep increasing header_name_count
 		IPACM_Wlan::total_num_wifi_clients++;
@@ -2169,7 +2189,7 @@ int IPACM_Wlan::handle_wlan_client_pwrsave(uint8_t *mac_addr)
 /*handle wifi client del mode*/
 int IPACM_Wlan::handle_wlan_client_down_evt(uint8_t *mac_addr)
 {
-	int clt_indx;
+	int clt_indx, last;
 	uint32_t tx_index;
 	int num_wifi_client_tmp = num_wifi_client;
 	int num_v6;
@@ -2232,51 +2252,58 @@ int IPACM_Wlan::handle_wlan_client_down_evt(uint8_t *mac_addr)
 	get_client_memptr(wlan_client, clt_indx)->route_rule_set_v6 = 0;
 	free(get_client_memptr(wlan_client, clt_indx)->p_hdr_info);
 
-	for (; clt_indx < num_wifi_client_tmp - 1; clt_indx++)
+	/* fill the hole with the last client, the table is unordered */
+	last = num_wifi_client_tmp - 1;
+	if (clt_indx != last)
 	{
-		get_client_memptr(wlan_client, clt_indx)->p_hdr_info = get_client_memptr(wlan_client, (clt_indx + 1))->p_hdr_info;
+		get_client_memptr(wlan_client, clt_indx)->p_hdr_info = get_client_memptr(wlan_client, last)->p_hdr_info;
 
 		memcpy(get_client_memptr(wlan_client, clt_indx)->mac,
-					 get_client_memptr(wlan_client, (clt_indx + 1))->mac,
+					 get_client_memptr(wlan_client, last)->mac,
 					 sizeof(get_client_memptr(wlan_client, clt_indx)->mac));
 
-		get_client_memptr(wlan_client, clt_indx)->hdr_hdl_v4 = get_client_memptr(wlan_client, (clt_indx + 1))->hdr_hdl_v4;
-		get_client_memptr(wlan_client, clt_indx)->hdr_hdl_v6 = get_client_memptr(wlan_client, (clt_indx + 1))->hdr_hdl_v6;
-		get_client_memptr(wlan_client, clt_indx)->v4_addr = get_client_memptr(wlan_client, (clt_indx + 1))->v4_addr;
+		get_client_memptr(wlan_client, clt_indx)->hdr_hdl_v4 = get_client_memptr(wlan_client, last)->hdr_hdl_v4;
+		get_client_memptr(wlan_client, clt_indx)->hdr_hdl_v6 = get_client_memptr(wlan_client, last)->hdr_hdl_v6;
+		get_client_memptr(wlan_client, clt_indx)->v4_addr = get_client_memptr(wlan_client, last)->v4_addr;
 
-		get_client_memptr(wlan_client, clt_indx)->ipv4_set = get_client_memptr(wlan_client, (clt_indx + 1))->ipv4_set;
-		get_client_memptr(wlan_client, clt_indx)->ipv6_set = get_client_memptr(wlan_client, (clt_indx + 1))->ipv6_set;
-		get_client_memptr(wlan_client, clt_indx)->ipv4_header_set = get_client_memptr(wlan_client, (clt_indx + 1))->ipv4_header_set;
-		get_client_memptr(wlan_client, clt_indx)->ipv6_header_set = get_client_memptr(wlan_client, (clt_indx + 1))->ipv6_header_set;
+		get_client_memptr(wlan_client, clt_indx)->ipv4_set = get_client_memptr(wlan_client, last)->ipv4_set;
+		get_client_memptr(wlan_client, clt_indx)->ipv6_set = get_client_memptr(wlan_client, last)->ipv6_set;
+		get_client_memptr(wlan_client, clt_indx)->ipv4_header_set = get_client_memptr(wlan_client, last)->ipv4_header_set;
+		get_client_memptr(wlan_client, clt_indx)->ipv6_header_set = get_client_memptr(wlan_client, last)->ipv6_header_set;
 
-		get_client_memptr(wlan_client, clt_indx)->route_rule_set_v4 = get_client_memptr(wlan_client, (clt_indx + 1))->route_rule_set_v4;
-		get_client_memptr(wlan_client, clt_indx)->route_rule_set_v6 = get_client_memptr(wlan_client, (clt_indx + 1))->route_rule_set_v6;
+		get_client_memptr(wlan_client, clt_indx)->route_rule_set_v4 = get_client_memptr(wlan_client, last)->route_rule_set_v4;
+		get_client_memptr(wlan_client, clt_indx)->route_rule_set_v6 = get_client_memptr(wlan_client, last)->route_rule_set_v6;
 
                 for(num_v6=0;num_v6< get_client_memptr(wlan_client, clt_indx)->ipv6_set;num_v6++)
 	        {
-		    get_client_memptr(wlan_client, clt_indx)->v6_addr[num_v6][0] = get_client_memptr(wlan_client, (clt_indx + 1))->v6_addr[num_v6][0];
-		    get_client_memptr(wlan_client, clt_indx)->v6_addr[num_v6][1] = get_client_memptr(wlan_client, (clt_indx + 1))->v6_addr[num_v6][1];
-		    get_client_memptr(wlan_client, clt_indx)->v6_addr[num_v6][2] = get_client_memptr(wlan_client, (clt_indx + 1))->v6_addr[num_v6][2];
-		    get_client_memptr(wlan_client, clt_indx)->v6_addr[num_v6][3] = get_client_memptr(wlan_client, (clt_indx + 1))->v6_addr[num_v6][3];
+		    get_client_memptr(wlan_client, clt_indx)->v6_addr[num_v6][0] = get_client_memptr(wlan_client, last)->v6_addr[num_v6][0];
+		    get_client_memptr(wlan_client, clt_indx)->v6_addr[num_v6][1] = get_client_memptr(wlan_client, last)->v6_addr[num_v6][1];
+		    get_client_memptr(wlan_client, clt_indx)->v6_addr[num_v6][2] = get_client_memptr(wlan_client, last)->v6_addr[num_v6][2];
+		    get_client_memptr(wlan_client, clt_indx)->v6_addr[num_v6][3] = get_client_memptr(wlan_client, last)->v6_addr[num_v6][3];
                 }
 
 		for (tx_index = 0; tx_index < iface_query->num_tx_props; tx_index++)
 		{
 			get_client_memptr(wlan_client, clt_indx)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v4 =
-				 get_client_memptr(wlan_client, (clt_indx + 1))->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v4;
+				 get_client_memptr(wlan_client, last)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v4;
 
 			for(num_v6=0;num_v6< get_client_memptr(wlan_client, clt_indx)->route_rule_set_v6;num_v6++)
 			{
 			  get_client_memptr(wlan_client, clt_indx)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6[num_v6] =
-			   	 get_client_memptr(wlan_client, (clt_indx + 1))->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6[num_v6];
+			   	 get_client_memptr(wlan_client, last)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6[num_v6];
 			  get_client_memptr(wlan_client, clt_indx)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6_wan[num_v6] =
-			   	 get_client_memptr(wlan_client, (clt_indx + 1))->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6_wan[num_v6];
+			   	 get_client_memptr(wlan_client, last)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6_wan[num_v6];
 		    }
 		}
 	}
 
 	IPACMDBG_H(" %d wifi client deleted successfully \n", num_wifi_client);
 	num_wifi_client = num_wifi_client - 1;
+	reindex_wlan_client(mac_addr);
+	if (clt_indx != last)
+	{
+		reindex_wlan_client(get_client_memptr(wlan_client, clt_indx)->mac);
+	}
 	IPACM_Wlan::total_num_wifi_clients = IPACM_Wlan::total_num_wifi_clients - 1;
 	IPACMDBG_H(" Number of wifi client: %d\n", num_wifi_client);
 
@@ -2860,14 +2887,8 @@ int IPACM_Wlan::add_lan2lan_hdr(ipa_ip_type iptype, uint8_t* src_mac, uint8_t* d
 					memcpy(pHeader->hdr[0].hdr, sCopyHeader.hdr, sCopyHeader.hdr_len);
 				}
 
-				for(j=0; j<num_wifi_client; j++)	//Add src/dst mac to the header
-				{
-					if(memcmp(dst_mac, get_client_memptr(wlan_client, j)->mac, IPA_MAC_ADDR_SIZE) == 0)
-					{
-						break;
-					}
-				}
-				if(j == num_wifi_client)
+				j = wlan_client_idx.Find(dst_mac);	//Add src/dst mac to the header
+				if(j == IPACM_INVALID_INDEX)
 				{
 					IPACMERR("Not able to find the wifi client from mac addr.\n");
 					res = IPACM_FAILURE;
@@ -2977,14 +2998,8 @@ int IPACM_Wlan::add_lan2lan_hdr(ipa_ip_type iptype, uint8_t* src_mac, uint8_t* d
 					memcpy(pHeader->hdr[0].hdr, sCopyHeader.hdr, sCopyHeader.hdr_len);
 				}
 
-				for(j=0; j<num_wifi_client; j++)	//Add src/dst mac to the header
-				{
-					if(memcmp(dst_mac, get_client_memptr(wlan_client, j)->mac, IPA_MAC_ADDR_SIZE) == 0)
-					{
-						break;
-					}
-				}
-				if(j == num_wifi_client)
+				j = wlan_client_idx.Find(dst_mac);	//Add src/dst mac to the header
+				if(j == IPACM_INVALID_INDEX)
 				{
 					IPACMERR("Not able to find the wifi client from mac addr.\n");
 					res = IPACM_FAILURE;
@@ -3999,19 +4014,15 @@ int IPACM_Wlan::eth_bridge_add_self_client_flt_rule(uint8_t* mac, ipa_ip_type ip
 		return IPACM_FAILURE;
 	}
 
-	for(i=0; i<wlan_client_flt_info_count; i++)
+	client_position = wlan_client_flt_info_idx.Find(mac);
+	if(client_position != IPACM_INVALID_INDEX)
 	{
-		if(memcmp(eth_bridge_wlan_client_flt_info[i].mac, mac, sizeof(eth_bridge_wlan_client_flt_info[i].mac)) == 0)
+		client_is_found = true;
+		if( (iptype == IPA_IP_v4 && eth_bridge_wlan_client_flt_info[client_position].flt_rule_set_v4 == true)
+			|| (iptype == IPA_IP_v6 && eth_bridge_wlan_client_flt_info[client_position].flt_rule_set_v6 == true))
 		{
-			client_is_found = true;
-			client_position = i;
-			if( (iptype == IPA_IP_v4 && eth_bridge_wlan_client_flt_info[i].flt_rule_set_v4 == true)
-				|| (iptype == IPA_IP_v6 && eth_bridge_wlan_client_flt_info[i].flt_rule_set_v6 == true))
-			{
-				IPACMDBG_H("Flt rule for iptype %d has been set.\n", iptype);
-				return IPACM_SUCCESS;
-			}
-			break;
+			IPACMDBG_H("Flt rule for iptype %d has been set.\n", iptype);
+			return IPACM_SUCCESS;
 		}
 	}
 
@@ -4137,6 +4148,7 @@ int IPACM_Wlan::eth_bridge_add_self_client_flt_rule(uint8_t* mac, ipa_ip_type ip
 	{
 		client_position = wlan_client_flt_info_count;
 		wlan_client_flt_info_count++;
+		wlan_client_flt_info_idx.Insert(mac, client_position);
 	}
 
 	memcpy(eth_bridge_wlan_client_flt_info[client_position].mac, mac, sizeof(eth_bridge_wlan_client_flt_info[client_position].mac));
@@ -4170,15 +4182,8 @@ int IPACM_Wlan::eth_bridge_del_self_client_flt_rule(uint8_t* mac)
 	IPACMDBG_H("Receive WLAN client MAC 0x%02x%02x%02x%02x%02x%02x.\n", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
 
 	int i, j, res = IPACM_SUCCESS;
-	for(i=0; i<wlan_client_flt_info_count; i++)
-	{
-		if(memcmp(eth_bridge_wlan_client_flt_info[i].mac, mac, sizeof(eth_bridge_wlan_client_flt_info[i].mac)) == 0)
-		{
-			break;
-		}
-	}
-
-	if(i == wlan_client_flt_info_count)
+	i = wlan_client_flt_info_idx.Find(mac);
+	if(i == IPACM_INVALID_INDEX)
 	{
 		IPACMERR("Do not find the wlan client.\n");
 		return IPACM_FAILURE;
@@ -4233,11 +4238,15 @@ int IPACM_Wlan::eth_bridge_del_self_client_flt_rule(uint8_t* mac)
 		}
 	}
 
-	for(j=i+1; j<wlan_client_flt_info_count; j++)
+	/* fill the hole with the last entry, the table is unordered */
+	wlan_client_flt_info_idx.Remove(mac);
+	j = wlan_client_flt_info_count - 1;
+	if(i != j)
 	{
-		memcpy(&(eth_bridge_wlan_client_flt_info[j-1]), &(eth_bridge_wlan_client_flt_info[j]), sizeof(eth_bridge_client_flt_info));
+		memcpy(&(eth_bridge_wlan_client_flt_info[i]), &(eth_bridge_wlan_client_flt_info[j]), sizeof(eth_bridge_client_flt_info));
+		wlan_client_flt_info_idx.Insert(eth_bridge_wlan_client_flt_info[i].mac, i);
 	}
-	memset(&(eth_bridge_wlan_client_flt_info[wlan_client_flt_info_count-1]), 0, sizeof(eth_bridge_client_flt_info));
+	memset(&(eth_bridge_wlan_client_flt_info[j]), 0, sizeof(eth_bridge_client_flt_info));
 	wlan_client_flt_info_count--;
 
 	return res;
@@ -4315,26 +4324,20 @@ int IPACM_Wlan::eth_bridge_add_wlan_client_rt_rule(uint8_t* mac, eth_bridge_src_
 	{
 		if(iptype == IPA_IP_v4)
 		{
-			for(i=0; i<wlan_client_rt_from_wlan_info_count_v4; i++)
+			if(eth_bridge_get_client_rt_info_idx(SRC_WLAN, iptype)->Find(mac) != IPACM_INVALID_INDEX)
 			{
-				if(memcmp(eth_bridge_get_client_rt_info_ptr(i, SRC_WLAN, iptype)->mac, mac, sizeof(eth_bridge_get_client_rt_info_ptr(i, SRC_WLAN, iptype)->mac)) == 0)
-				{
-					IPACMDBG_H("The client's routing rule was added before.\n");
-					return IPACM_SUCCESS;
-				}
+				IPACMDBG_H("The client's routing rule was added before.\n");
+				return IPACM_SUCCESS;
 			}
 			memcpy(eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_wlan_info_count_v4, src, iptype)->mac, mac,
 					sizeof(eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_wlan_info_count_v4, src, iptype)->mac));
 		}
 		else
 		{
-			for(i=0; i<wlan_client_rt_from_wlan_info_count_v6; i++)
+			if(eth_bridge_get_client_rt_info_idx(SRC_WLAN, iptype)->Find(mac) != IPACM_INVALID_INDEX)
 			{
-				if(memcmp(eth_bridge_get_client_rt_info_ptr(i, SRC_WLAN, iptype)->mac, mac, sizeof(eth_bridge_get_client_rt_info_ptr(i, SRC_WLAN, iptype)->mac)) == 0)
-				{
-					IPACMDBG_H("The client's routing rule was added before.\n");
-					return IPACM_SUCCESS;
-				}
+				IPACMDBG_H("The client's routing rule was added before.\n");
+				return IPACM_SUCCESS;
 			}
 			memcpy(eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_wlan_info_count_v6, src, iptype)->mac, mac,
 					sizeof(eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_wlan_info_count_v6, src, iptype)->mac));
@@ -4344,26 +4347,20 @@ int IPACM_Wlan::eth_bridge_add_wlan_client_rt_rule(uint8_t* mac, eth_bridge_src_
 	{
 		if(iptype == IPA_IP_v4)
 		{
-			for(i=0; i<wlan_client_rt_from_usb_info_count_v4; i++)
+			if(eth_bridge_get_client_rt_info_idx(SRC_USB, iptype)->Find(mac) != IPACM_INVALID_INDEX)
 			{
-				if(memcmp(eth_bridge_get_client_rt_info_ptr(i, SRC_USB, iptype)->mac, mac, sizeof(eth_bridge_get_client_rt_info_ptr(i, SRC_USB, iptype)->mac)) == 0)
-				{
-					IPACMDBG_H("The client's routing rule was added before.\n");
-					return IPACM_SUCCESS;
-				}
+				IPACMDBG_H("The client's routing rule was added before.\n");
+				return IPACM_SUCCESS;
 			}
 			memcpy(eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_usb_info_count_v4, src, iptype)->mac, mac,
 					sizeof(eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_usb_info_count_v4, src, iptype)->mac));
 		}
 		else
 		{
-			for(i=0; i<wlan_client_rt_from_usb_info_count_v6; i++)
+			if(eth_bridge_get_client_rt_info_idx(SRC_USB, iptype)->Find(mac) != IPACM_INVALID_INDEX)
 			{
-				if(memcmp(eth_bridge_get_client_rt_info_ptr(i, SRC_USB, iptype)->mac, mac, sizeof(eth_bridge_get_client_rt_info_ptr(i, SRC_USB, iptype)->mac)) == 0)
-				{
-					IPACMDBG_H("The client's routing rule was added before.\n");
-					return IPACM_SUCCESS;
-				}
+				IPACMDBG_H("The client's routing rule was added before.\n");
+				return IPACM_SUCCESS;
 			}
 			memcpy(eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_usb_info_count_v6, src, iptype)->mac, mac,
 					sizeof(eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_usb_info_count_v6, src, iptype)->mac));
@@ -4495,11 +4492,13 @@ int IPACM_Wlan::eth_bridge_add_wlan_client_rt_rule(uint8_t* mac, eth_bridge_src_
 			}
 			if(iptype == IPA_IP_v4)
 			{
+				eth_bridge_get_client_rt_info_idx(src, iptype)->Insert(mac, wlan_client_rt_from_wlan_info_count_v4);
 				wlan_client_rt_from_wlan_info_count_v4++;
 				IPACMDBG_H("Now the number of IPv4 rt rule on wlan-wlan rt table is %d.\n", wlan_client_rt_from_wlan_info_count_v4);
 			}
 			else
 			{
+				eth_bridge_get_client_rt_info_idx(src, iptype)->Insert(mac, wlan_client_rt_from_wlan_info_count_v6);
 				wlan_client_rt_from_wlan_info_count_v6++;
 				IPACMDBG_H("Now the number of IPv6 rt rule on wlan-wlan rt table is %d.\n", wlan_client_rt_from_wlan_info_count_v6);
 			}
@@ -4519,11 +4518,13 @@ int IPACM_Wlan::eth_bridge_add_wlan_client_rt_rule(uint8_t* mac, eth_bridge_src_
 			}
 			if(iptype == IPA_IP_v4)
 			{
+				eth_bridge_get_client_rt_info_idx(src, iptype)->Insert(mac, wlan_client_rt_from_usb_info_count_v4);
 				wlan_client_rt_from_usb_info_count_v4++;
 				IPACMDBG_H("Now the number of IPv4 rt rule on usb-wlan rt table is %d.\n", wlan_client_rt_from_usb_info_count_v4);
 			}
 			else
 			{
+				eth_bridge_get_client_rt_info_idx(src, iptype)->Insert(mac, wlan_client_rt_from_usb_info_count_v6);
 				wlan_client_rt_from_usb_info_count_v6++;
 				IPACMDBG_H("Now the number of IPv6 rt rule on usb-wlan rt table is %d.\n", wlan_client_rt_from_usb_info_count_v6);
 			}
@@ -4556,40 +4557,13 @@ int IPACM_Wlan::eth_bridge_del_wlan_client_rt_rule(uint8_t* mac, eth_bridge_src_
 	int i, position;
 
 	/* first delete the rt rules from IPv4 rt table*/
-	if(src == SRC_WLAN)
-	{
-		for(i=0; i<wlan_client_rt_from_wlan_info_count_v4; i++)
-		{
-			if(memcmp(eth_bridge_get_client_rt_info_ptr(i, src, IPA_IP_v4)->mac, mac, sizeof(eth_bridge_get_client_rt_info_ptr(i, src, IPA_IP_v4)->mac)) == 0)
-			{
-				position = i;
-				IPACMDBG_H("The client is found at position %d.\n", position);
-				break;
-			}
-		}
-		if(i == wlan_client_rt_from_wlan_info_count_v4)
-		{
-			IPACMERR("The client is not found.\n");
-			return IPACM_FAILURE;
-		}
-	}
-	else
+	position = eth_bridge_get_client_rt_info_idx(src, IPA_IP_v4)->Find(mac);
+	if(position == IPACM_INVALID_INDEX)
 	{
-		for(i=0; i<wlan_client_rt_from_usb_info_count_v4; i++)
-		{
-			if(memcmp(eth_bridge_get_client_rt_info_ptr(i, src, IPA_IP_v4)->mac, mac, sizeof(eth_bridge_get_client_rt_info_ptr(i, src, IPA_IP_v4)->mac)) == 0)
-			{
-				position = i;
-				IPACMDBG_H("The client is found at position %d.\n", position);
-				break;
-			}
-		}
-		if(i == wlan_client_rt_from_usb_info_count_v4)
-		{
-			IPACMERR("The client is not found.\n");
-			return IPACM_FAILURE;
-		}
+		IPACMERR("The client is not found.\n");
+		return IPACM_FAILURE;
 	}
+	IPACMDBG_H("The client is found at position %d.\n", position);
 
 	for(i=0; i<each_client_rt_rule_count_v4; i++)
 	{
@@ -4602,9 +4576,11 @@ int IPACM_Wlan::eth_bridge_del_wlan_client_rt_rule(uint8_t* mac, eth_bridge_src_
 
 	if(src == SRC_WLAN)
 	{
-		for(i=position+1; i<wlan_client_rt_from_wlan_info_count_v4; i++)
+		eth_bridge_get_client_rt_info_idx(src, IPA_IP_v4)->Remove(mac);
+		if(position != wlan_client_rt_from_wlan_info_count_v4-1)
 		{
-			memcpy(eth_bridge_get_client_rt_info_ptr(i-1, src, IPA_IP_v4), eth_bridge_get_client_rt_info_ptr(i, src, IPA_IP_v4), client_rt_info_size_v4);
+			memcpy(eth_bridge_get_client_rt_info_ptr(position, src, IPA_IP_v4), eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_wlan_info_count_v4-1, src, IPA_IP_v4), client_rt_info_size_v4);
+			eth_bridge_get_client_rt_info_idx(src, IPA_IP_v4)->Insert(eth_bridge_get_client_rt_info_ptr(position, src, IPA_IP_v4)->mac, position);
 		}
 		memset(eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_wlan_info_count_v4-1, src, IPA_IP_v4), 0, client_rt_info_size_v4);
 		wlan_client_rt_from_wlan_info_count_v4--;
@@ -4612,9 +4588,11 @@ int IPACM_Wlan::eth_bridge_del_wlan_client_rt_rule(uint8_t* mac, eth_bridge_src_
 	}
 	else
 	{
-		for(i=position+1; i<wlan_client_rt_from_usb_info_count_v4; i++)
+		eth_bridge_get_client_rt_info_idx(src, IPA_IP_v4)->Remove(mac);
+		if(position != wlan_client_rt_from_usb_info_count_v4-1)
 		{
-			memcpy(eth_bridge_get_client_rt_info_ptr(i-1, src, IPA_IP_v4), eth_bridge_get_client_rt_info_ptr(i, src, IPA_IP_v4), client_rt_info_size_v4);
+			memcpy(eth_bridge_get_client_rt_info_ptr(position, src, IPA_IP_v4), eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_usb_info_count_v4-1, src, IPA_IP_v4), client_rt_info_size_v4);
+			eth_bridge_get_client_rt_info_idx(src, IPA_IP_v4)->Insert(eth_bridge_get_client_rt_info_ptr(position, src, IPA_IP_v4)->mac, position);
 		}
 		memset(eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_usb_info_count_v4-1, src, IPA_IP_v4), 0, client_rt_info_size_v4);
 		wlan_client_rt_from_usb_info_count_v4--;
@@ -4622,40 +4600,13 @@ int IPACM_Wlan::eth_bridge_del_wlan_client_rt_rule(uint8_t* mac, eth_bridge_src_
 	}
 
 	/*delete rt rules from IPv6 rt table */
-	if(src == SRC_WLAN)
-	{
-		for(i=0; i<wlan_client_rt_from_wlan_info_count_v6; i++)
-		{
-			if(memcmp(eth_bridge_get_client_rt_info_ptr(i, src, IPA_IP_v6)->mac, mac, sizeof(eth_bridge_get_client_rt_info_ptr(i, src, IPA_IP_v6)->mac)) == 0)
-			{
-				position = i;
-				IPACMDBG_H("The client is found at position %d.\n", position);
-				break;
-			}
-		}
-		if(i == wlan_client_rt_from_wlan_info_count_v6)
-		{
-			IPACMERR("The client is not found.\n");
-			return IPACM_FAILURE;
-		}
-	}
-	else
+	position = eth_bridge_get_client_rt_info_idx(src, IPA_IP_v6)->Find(mac);
+	if(position == IPACM_INVALID_INDEX)
 	{
-		for(i=0; i<wlan_client_rt_from_usb_info_count_v6; i++)
-		{
-			if(memcmp(eth_bridge_get_client_rt_info_ptr(i, src, IPA_IP_v6)->mac, mac, sizeof(eth_bridge_get_client_rt_info_ptr(i, src, IPA_IP_v6)->mac)) == 0)
-			{
-				position = i;
-				IPACMDBG_H("The client is found at position %d.\n", position);
-				break;
-			}
-		}
-		if(i == wlan_client_rt_from_usb_info_count_v6)
-		{
-			IPACMERR("The client is not found.\n");
-			return IPACM_FAILURE;
-		}
+		IPACMERR("The client is not found.\n");
+		return IPACM_FAILURE;
 	}
+	IPACMDBG_H("The client is found at position %d.\n", position);
 
 	for(i=0; i<each_client_rt_rule_count_v6; i++)
 	{
@@ -4668,9 +4619,11 @@ int IPACM_Wlan::eth_bridge_del_wlan_client_rt_rule(uint8_t* mac, eth_bridge_src_
 
 	if(src == SRC_WLAN)
 	{
-		for(i=position+1; i<wlan_client_rt_from_wlan_info_count_v6; i++)
+		eth_bridge_get_client_rt_info_idx(src, IPA_IP_v6)->Remove(mac);
+		if(position != wlan_client_rt_from_wlan_info_count_v6-1)
 		{
-			memcpy(eth_bridge_get_client_rt_info_ptr(i-1, src, IPA_IP_v6), eth_bridge_get_client_rt_info_ptr(i, src, IPA_IP_v6), client_rt_info_size_v6);
+			memcpy(eth_bridge_get_client_rt_info_ptr(position, src, IPA_IP_v6), eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_wlan_info_count_v6-1, src, IPA_IP_v6), client_rt_info_size_v6);
+			eth_bridge_get_client_rt_info_idx(src, IPA_IP_v6)->Insert(eth_bridge_get_client_rt_info_ptr(position, src, IPA_IP_v6)->mac, position);
 		}
 		memset(eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_wlan_info_count_v6-1, src, IPA_IP_v6), 0, client_rt_info_size_v6);
 		wlan_client_rt_from_wlan_info_count_v6--;
@@ -4678,9 +4631,11 @@ int IPACM_Wlan::eth_bridge_del_wlan_client_rt_rule(uint8_t* mac, eth_bridge_src_
 	}
 	else
 	{
-		for(i=position+1; i<wlan_client_rt_from_usb_info_count_v6; i++)
+		eth_bridge_get_client_rt_info_idx(src, IPA_IP_v6)->Remove(mac);
+		if(position != wlan_client_rt_from_usb_info_count_v6-1)
 		{
-			memcpy(eth_bridge_get_client_rt_info_ptr(i-1, src, IPA_IP_v6), eth_bridge_get_client_rt_info_ptr(i, src, IPA_IP_v6), client_rt_info_size_v6);
+			memcpy(eth_bridge_get_client_rt_info_ptr(position, src, IPA_IP_v6), eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_usb_info_count_v6-1, src, IPA_IP_v6), client_rt_info_size_v6);
+			eth_bridge_get_client_rt_info_idx(src, IPA_IP_v6)->Insert(eth_bridge_get_client_rt_info_ptr(position, src, IPA_IP_v6)->mac, position);
 		}
 		memset(eth_bridge_get_client_rt_info_ptr(wlan_client_rt_from_usb_info_count_v6-1, src, IPA_IP_v6), 0, client_rt_info_size_v6);
 		wlan_client_rt_from_usb_info_count_v6--;
@@ -4718,13 +4673,18 @@ eth_bridge_client_rt_info* IPACM_Wlan::eth_bridge_get_client_rt_info_ptr(uint8_t
 	return (eth_bridge_client_rt_info*)result;
 }
 
-void IPACM_Wlan::eth_bridge_add_wlan_client(uint8_t* mac, int if_num)
+IPACM_MacIndex* IPACM_Wlan::eth_bridge_get_client_rt_info_idx(eth_bridge_src_iface src, ipa_ip_type iptype)
 {
-	if(IPACM_Lan::num_wlan_client == IPA_LAN_TO_LAN_MAX_WLAN_CLIENT)
+	if(src == SRC_WLAN)
 	{
-		IPACMDBG_H("WLAN client table is already full.\n");
-		return;
+		return (iptype == IPA_IP_v4) ? &wlan_client_rt_from_wlan_info_idx_v4 : &wlan_client_rt_from_wlan_info_idx_v6;
 	}
+	return (iptype == IPA_IP_v4) ? &wlan_client_rt_from_usb_info_idx_v4 : &wlan_client_rt_from_usb_info_idx_v6;
+}
+
+void IPACM_Wlan::eth_bridge_add_wlan_client(uint8_t* mac, int if_num)
+{
+	int i;
 
 	if(mac == NULL)
 	{
@@ -4732,6 +4692,21 @@ void IPACM_Wlan::eth_bridge_add_wlan_client(uint8_t* mac, int if_num)
 		return;
 	}
 
+	i = IPACM_Lan::eth_bridge_wlan_client_idx.Find(mac);
+	if(i != IPACM_INVALID_INDEX)
+	{
+		IPACMDBG_H("WLAN client is already cached at position %d.\n", i);
+		IPACM_Lan::eth_bridge_wlan_client[i].ipa_if_num = if_num;
+		return;
+	}
+
+	if(IPACM_Lan::num_wlan_client == IPA_LAN_TO_LAN_MAX_WLAN_CLIENT)
+	{
+		IPACMDBG_H("WLAN client table is already full.\n");
+		return;
+	}
+
+	IPACM_Lan::eth_bridge_wlan_client_idx.Insert(mac, IPACM_Lan::num_wlan_client);
 	memcpy(IPACM_Lan::eth_bridge_wlan_client[IPACM_Lan::num_wlan_client].mac, mac, sizeof(IPACM_Lan::eth_bridge_wlan_client[IPACM_Lan::num_wlan_client].mac));
 	IPACM_Lan::eth_bridge_wlan_client[IPACM_Lan::num_wlan_client].ipa_if_num = if_num;
 	IPACM_Lan::num_wlan_client++;
@@ -4747,25 +4722,22 @@ void IPACM_Wlan::eth_bridge_del_wlan_client(uint8_t* mac)
 	}
 
 	int i, j;
-	for(i=0; i<IPACM_Lan::num_wlan_client; i++)
-	{
-		if(memcmp(IPACM_Lan::eth_bridge_wlan_client[i].mac, mac, sizeof(IPACM_Lan::eth_bridge_wlan_client[i].mac)) == 0)
-		{
-			IPACMDBG_H("Found WLAN client at position %d.\n", i);
-			break;
-		}
-	}
-
-	if(i == IPACM_Lan::num_wlan_client)
+	i = IPACM_Lan::eth_bridge_wlan_client_idx.Find(mac);
+	if(i == IPACM_INVALID_INDEX)
 	{
 		IPACMDBG_H("Not finding the WLAN client.\n");
 		return;
 	}
+	IPACMDBG_H("Found WLAN client at position %d.\n", i);
 
-	for(j=i+1; j<IPACM_Lan::num_wlan_client; j++)
+	/* fill the hole with the last entry, the table is unordered */
+	IPACM_Lan::eth_bridge_wlan_client_idx.Remove(mac);
+	j = IPACM_Lan::num_wlan_client - 1;
+	if(i != j)
 	{
-		memcpy(IPACM_Lan::eth_bridge_wlan_client[j-1].mac, IPACM_Lan::eth_bridge_wlan_client[j].mac, sizeof(IPACM_Lan::eth_bridge_wlan_client[j].mac));
-		IPACM_Lan::eth_bridge_wlan_client[j-1].ipa_if_num = IPACM_Lan::eth_bridge_wlan_client[j].ipa_if_num;
+		memcpy(IPACM_Lan::eth_bridge_wlan_client[i].mac, IPACM_Lan::eth_bridge_wlan_client[j].mac, sizeof(IPACM_Lan::eth_bridge_wlan_client[j].mac));
+		IPACM_Lan::eth_bridge_wlan_client[i].ipa_if_num = IPACM_Lan::eth_bridge_wlan_client[j].ipa_if_num;
+		IPACM_Lan::eth_bridge_wlan_client_idx.Insert(IPACM_Lan::eth_bridge_wlan_client[i].mac, i);
 	}
 	IPACM_Lan::num_wlan_client--;
 	return;
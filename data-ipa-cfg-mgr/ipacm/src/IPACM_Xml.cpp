@@ -40,1158 +40,884 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <libxml/xmlreader.h>
 
 #include "IPACM_Xml.h"
 #include "IPACM_Log.h"
 #include "IPACM_Netlink.h"
 
-static char* IPACM_read_content_element
-(
-	 xmlNode* element
-);
-
-static int32_t IPACM_util_icmp_string
-(
-	 const char* xml_str,
-	 const char* str
-);
-
-static int ipacm_cfg_xml_parse_tree
-(
-	 xmlNode* xml_node,
-	 IPACM_conf_t *config
-);
+/* Both XML files are read with a streaming reader, the element names are
+	 resolved through a perfect hash table built once from the tag list and
+	 the parsed values are stored straight into the config structures */
 
-static int IPACM_firewall_xml_parse_tree
-(
-	 xmlNode* xml_node,
-	 IPACM_firewall_conf_t *config
-);
+enum ipacm_xml_tag_id
+{
+	IPACM_XML_TAG_NONE = 0,
+	/* IPACM config */
+	IPACM_XML_TAG_SYSTEM,
+	IPACM_XML_TAG_ODU,
+	IPACM_XML_TAG_ODUMODE,
+	IPACM_XML_TAG_IPACMCFG,
+	IPACM_XML_TAG_IPACMIFACECFG,
+	IPACM_XML_TAG_IFACE,
+	IPACM_XML_TAG_NAME,
+	IPACM_XML_TAG_CATEGORY,
+	IPACM_XML_TAG_IPACMPRIVATESUBNETCFG,
+	IPACM_XML_TAG_SUBNET,
+	IPACM_XML_TAG_SUBNETADDRESS,
+	IPACM_XML_TAG_SUBNETMASK,
+	IPACM_XML_TAG_IPACMALG,
+	IPACM_XML_TAG_ALG,
+	IPACM_XML_TAG_PROTOCOL,
+	IPACM_XML_TAG_PORT,
+	IPACM_XML_TAG_IPACMNAT,
+	IPACM_XML_TAG_NAT_MAXENTRIES,
+	/* firewall config */
+	IPACM_XML_TAG_MOBILEAPFIREWALLCFG,
+	IPACM_XML_TAG_FIREWALL,
+	IPACM_XML_TAG_FIREWALLENABLED,
+	IPACM_XML_TAG_FIREWALLPKTSALLOWED,
+	IPACM_XML_TAG_IPFAMILY,
+	IPACM_XML_TAG_IPV4SOURCEADDRESS,
+	IPACM_XML_TAG_IPV4SOURCEIPADDRESS,
+	IPACM_XML_TAG_IPV4SOURCESUBNETMASK,
+	IPACM_XML_TAG_IPV4DESTINATIONADDRESS,
+	IPACM_XML_TAG_IPV4DESTINATIONIPADDRESS,
+	IPACM_XML_TAG_IPV4DESTINATIONSUBNETMASK,
+	IPACM_XML_TAG_IPV4TYPEOFSERVICE,
+	IPACM_XML_TAG_TOSVALUE,
+	IPACM_XML_TAG_TOSMASK,
+	IPACM_XML_TAG_IPV4NEXTHEADERPROTOCOL,
+	IPACM_XML_TAG_IPV6SOURCEADDRESS,
+	IPACM_XML_TAG_IPV6SOURCEIPADDRESS,
+	IPACM_XML_TAG_IPV6SOURCEPREFIX,
+	IPACM_XML_TAG_IPV6DESTINATIONADDRESS,
+	IPACM_XML_TAG_IPV6DESTINATIONIPADDRESS,
+	IPACM_XML_TAG_IPV6DESTINATIONPREFIX,
+	IPACM_XML_TAG_IPV6TRAFFICCLASS,
+	IPACM_XML_TAG_TRFCLSVALUE,
+	IPACM_XML_TAG_TRFCLSMASK,
+	IPACM_XML_TAG_IPV6NEXTHEADERPROTOCOL,
+	IPACM_XML_TAG_TCPSOURCE,
+	IPACM_XML_TAG_TCPSOURCEPORT,
+	IPACM_XML_TAG_TCPSOURCERANGE,
+	IPACM_XML_TAG_TCPDESTINATION,
+	IPACM_XML_TAG_TCPDESTINATIONPORT,
+	IPACM_XML_TAG_TCPDESTINATIONRANGE,
+	IPACM_XML_TAG_UDPSOURCE,
+	IPACM_XML_TAG_UDPSOURCEPORT,
+	IPACM_XML_TAG_UDPSOURCERANGE,
+	IPACM_XML_TAG_UDPDESTINATION,
+	IPACM_XML_TAG_UDPDESTINATIONPORT,
+	IPACM_XML_TAG_UDPDESTINATIONRANGE,
+	IPACM_XML_TAG_ICMPTYPE,
+	IPACM_XML_TAG_ICMPCODE,
+	IPACM_XML_TAG_ESPSPI,
+	IPACM_XML_TAG_TCP_UDPSOURCE,
+	IPACM_XML_TAG_TCP_UDPSOURCEPORT,
+	IPACM_XML_TAG_TCP_UDPSOURCERANGE,
+	IPACM_XML_TAG_TCP_UDPDESTINATION,
+	IPACM_XML_TAG_TCP_UDPDESTINATIONPORT,
+	IPACM_XML_TAG_TCP_UDPDESTINATIONRANGE,
+	IPACM_XML_TAG_MAX
+};
+
+typedef struct
+{
+	const char *name;
+	int id;
+} ipacm_xml_tag;
 
-/*Reads content (stored as child) of the element */
-static char* IPACM_read_content_element
-(
-	 xmlNode* element
-)
+static const ipacm_xml_tag ipacm_xml_tags[] =
+{
+	{system_TAG, IPACM_XML_TAG_SYSTEM},
+	{ODU_TAG, IPACM_XML_TAG_ODU},
+	{ODUMODE_TAG, IPACM_XML_TAG_ODUMODE},
+	{IPACMCFG_TAG, IPACM_XML_TAG_IPACMCFG},
+	{IPACMIFACECFG_TAG, IPACM_XML_TAG_IPACMIFACECFG},
+	{IFACE_TAG, IPACM_XML_TAG_IFACE},
+	{NAME_TAG, IPACM_XML_TAG_NAME},
+	{CATEGORY_TAG, IPACM_XML_TAG_CATEGORY},
+	{IPACMPRIVATESUBNETCFG_TAG, IPACM_XML_TAG_IPACMPRIVATESUBNETCFG},
+	{SUBNET_TAG, IPACM_XML_TAG_SUBNET},
+	{SUBNETADDRESS_TAG, IPACM_XML_TAG_SUBNETADDRESS},
+	{SUBNETMASK_TAG, IPACM_XML_TAG_SUBNETMASK},
+	{IPACMALG_TAG, IPACM_XML_TAG_IPACMALG},
+	{ALG_TAG, IPACM_XML_TAG_ALG},
+	{Protocol_TAG, IPACM_XML_TAG_PROTOCOL},
+	{Port_TAG, IPACM_XML_TAG_PORT},
+	{IPACMNat_TAG, IPACM_XML_TAG_IPACMNAT},
+	{NAT_MaxEntries_TAG, IPACM_XML_TAG_NAT_MAXENTRIES},
+	{MobileAPFirewallCfg_TAG, IPACM_XML_TAG_MOBILEAPFIREWALLCFG},
+	{Firewall_TAG, IPACM_XML_TAG_FIREWALL},
+	{FirewallEnabled_TAG, IPACM_XML_TAG_FIREWALLENABLED},
+	{FirewallPktsAllowed_TAG, IPACM_XML_TAG_FIREWALLPKTSALLOWED},
+	{IPFamily_TAG, IPACM_XML_TAG_IPFAMILY},
+	{IPV4SourceAddress_TAG, IPACM_XML_TAG_IPV4SOURCEADDRESS},
+	{IPV4SourceIPAddress_TAG, IPACM_XML_TAG_IPV4SOURCEIPADDRESS},
+	{IPV4SourceSubnetMask_TAG, IPACM_XML_TAG_IPV4SOURCESUBNETMASK},
+	{IPV4DestinationAddress_TAG, IPACM_XML_TAG_IPV4DESTINATIONADDRESS},
+	{IPV4DestinationIPAddress_TAG, IPACM_XML_TAG_IPV4DESTINATIONIPADDRESS},
+	{IPV4DestinationSubnetMask_TAG, IPACM_XML_TAG_IPV4DESTINATIONSUBNETMASK},
+	{IPV4TypeOfService_TAG, IPACM_XML_TAG_IPV4TYPEOFSERVICE},
+	{TOSValue_TAG, IPACM_XML_TAG_TOSVALUE},
+	{TOSMask_TAG, IPACM_XML_TAG_TOSMASK},
+	{IPV4NextHeaderProtocol_TAG, IPACM_XML_TAG_IPV4NEXTHEADERPROTOCOL},
+	{IPV6SourceAddress_TAG, IPACM_XML_TAG_IPV6SOURCEADDRESS},
+	{IPV6SourceIPAddress_TAG, IPACM_XML_TAG_IPV6SOURCEIPADDRESS},
+	{IPV6SourcePrefix_TAG, IPACM_XML_TAG_IPV6SOURCEPREFIX},
+	{IPV6DestinationAddress_TAG, IPACM_XML_TAG_IPV6DESTINATIONADDRESS},
+	{IPV6DestinationIPAddress_TAG, IPACM_XML_TAG_IPV6DESTINATIONIPADDRESS},
+	{IPV6DestinationPrefix_TAG, IPACM_XML_TAG_IPV6DESTINATIONPREFIX},
+	{IPV6TrafficClass_TAG, IPACM_XML_TAG_IPV6TRAFFICCLASS},
+	{TrfClsValue_TAG, IPACM_XML_TAG_TRFCLSVALUE},
+	{TrfClsMask_TAG, IPACM_XML_TAG_TRFCLSMASK},
+	{IPV6NextHeaderProtocol_TAG, IPACM_XML_TAG_IPV6NEXTHEADERPROTOCOL},
+	{TCPSource_TAG, IPACM_XML_TAG_TCPSOURCE},
+	{TCPSourcePort_TAG, IPACM_XML_TAG_TCPSOURCEPORT},
+	{TCPSourceRange_TAG, IPACM_XML_TAG_TCPSOURCERANGE},
+	{TCPDestination_TAG, IPACM_XML_TAG_TCPDESTINATION},
+	{TCPDestinationPort_TAG, IPACM_XML_TAG_TCPDESTINATIONPORT},
+	{TCPDestinationRange_TAG, IPACM_XML_TAG_TCPDESTINATIONRANGE},
+	{UDPSource_TAG, IPACM_XML_TAG_UDPSOURCE},
+	{UDPSourcePort_TAG, IPACM_XML_TAG_UDPSOURCEPORT},
+	{UDPSourceRange_TAG, IPACM_XML_TAG_UDPSOURCERANGE},
+	{UDPDestination_TAG, IPACM_XML_TAG_UDPDESTINATION},
+	{UDPDestinationPort_TAG, IPACM_XML_TAG_UDPDESTINATIONPORT},
+	{UDPDestinationRange_TAG, IPACM_XML_TAG_UDPDESTINATIONRANGE},
+	{ICMPType_TAG, IPACM_XML_TAG_ICMPTYPE},
+	{ICMPCode_TAG, IPACM_XML_TAG_ICMPCODE},
+	{ESPSPI_TAG, IPACM_XML_TAG_ESPSPI},
+	{TCP_UDPSource_TAG, IPACM_XML_TAG_TCP_UDPSOURCE},
+	{TCP_UDPSourcePort_TAG, IPACM_XML_TAG_TCP_UDPSOURCEPORT},
+	{TCP_UDPSourceRange_TAG, IPACM_XML_TAG_TCP_UDPSOURCERANGE},
+	{TCP_UDPDestination_TAG, IPACM_XML_TAG_TCP_UDPDESTINATION},
+	{TCP_UDPDestinationPort_TAG, IPACM_XML_TAG_TCP_UDPDESTINATIONPORT},
+	{TCP_UDPDestinationRange_TAG, IPACM_XML_TAG_TCP_UDPDESTINATIONRANGE}
+};
+
+#define IPACM_XML_NUM_TAGS (int)(sizeof(ipacm_xml_tags) / sizeof(ipacm_xml_tags[0]))
+
+/* power of 2, about sixteen times the number of tags so a collision free
+	 seed turns up within the first few tries */
+#define IPACM_XML_TAG_SLOTS 1024
+#define IPACM_XML_TAG_MAX_SEED 4096
+
+/* deepest element the walker tracks, the config files use less than 8 */
+#define IPACM_XML_MAX_DEPTH 16
+
+/* what the walker does with an element */
+#define IPACM_XML_SKIP 0          /* ignore it and its children */
+#define IPACM_XML_CONTAINER 1     /* walk its children */
+#define IPACM_XML_LEAF 2          /* hand its text to the content callback */
+
+typedef int (*ipacm_xml_element_cb)(int tag, void *config);
+typedef void (*ipacm_xml_content_cb)(int tag, char *content, void *config);
+
+/* slot -> index + 1 into ipacm_xml_tags, 0 if empty */
+static uint8_t ipacm_xml_tag_table[IPACM_XML_TAG_SLOTS];
+static uint32_t ipacm_xml_tag_seed;
+static pthread_once_t ipacm_xml_tag_once = PTHREAD_ONCE_INIT;
+
+/* case insensitive, element names are matched regardless of case */
+static uint32_t ipacm_xml_tag_hash(const char *name, uint32_t seed)
 {
-	xmlNode* child_ptr;
+	uint32_t h = 2166136261U ^ seed;
 
-	for (child_ptr  = element->children;
-			 child_ptr != NULL;
-			 child_ptr  = child_ptr->next)
+	while (*name != '\0')
 	{
-		if (child_ptr->type == XML_TEXT_NODE)
-		{
-			return (char*)child_ptr->content;
-		}
+		h = (h ^ (uint8_t)tolower((unsigned char)*name)) * 16777619U;
+		name++;
 	}
-	return NULL;
+	h ^= h >> 15;
+	return h & (IPACM_XML_TAG_SLOTS - 1);
 }
 
-/* insensitive comparison of a libxml's string (xml_str) and a regular string (str)*/
-static int32_t IPACM_util_icmp_string
-(
-	 const char* xml_str,
-	 const char* str
-)
+/* pick the first seed that gives every tag its own slot */
+static void ipacm_xml_tag_table_init(void)
 {
-	int32_t ret = -1;
+	uint32_t seed, slot;
+	int i;
 
-	if (NULL != xml_str && NULL != str)
+	for (seed = 0; seed < IPACM_XML_TAG_MAX_SEED; seed++)
 	{
-		uint32_t len1 = strlen(str);
-		uint32_t len2 = strlen(xml_str);
-		/* If the lengths match, do the string comparison */
-		if (len1 == len2)
+		memset(ipacm_xml_tag_table, 0, sizeof(ipacm_xml_tag_table));
+		for (i = 0; i < IPACM_XML_NUM_TAGS; i++)
+		{
+			slot = ipacm_xml_tag_hash(ipacm_xml_tags[i].name, seed);
+			if (ipacm_xml_tag_table[slot] != 0)
+			{
+				break;
+			}
+			ipacm_xml_tag_table[slot] = i + 1;
+		}
+		if (i == IPACM_XML_NUM_TAGS)
 		{
-			ret = strncasecmp(xml_str, str, len1);
+			ipacm_xml_tag_seed = seed;
+			IPACMDBG("XML tag table uses seed %d\n", seed);
+			return;
 		}
 	}
 
-	return ret;
+	/* can't happen with the current tag list, leaves every lookup unmatched */
+	IPACMERR("No perfect hash seed for %d XML tags\n", IPACM_XML_NUM_TAGS);
+	memset(ipacm_xml_tag_table, 0, sizeof(ipacm_xml_tag_table));
 }
 
-/* This function read IPACM XML and populate the IPA CM Cfg */
-int ipacm_read_cfg_xml(char *xml_file, IPACM_conf_t *config)
+static int ipacm_xml_tag_lookup(const char *name)
 {
-	xmlDocPtr doc = NULL;
-	xmlNode* root = NULL;
-	int ret_val = IPACM_SUCCESS;
+	int index;
 
-	/* Invoke the XML parser and obtain the parse tree */
-	doc = xmlReadFile(xml_file, "UTF-8", XML_PARSE_NOBLANKS);
-	if (doc == NULL) {
-		IPACMDBG_H("IPACM_xml_parse: libxml returned parse error!\n");
-		return IPACM_FAILURE;
+	if (name == NULL)
+	{
+		return IPACM_XML_TAG_NONE;
 	}
-
-	/*Get the root of the tree*/
-	root = xmlDocGetRootElement(doc);
-
-	memset(config, 0, sizeof(IPACM_conf_t));
-
-	/* parse the xml tree returned by libxml */
-	ret_val = ipacm_cfg_xml_parse_tree(root, config);
-
-	if (ret_val != IPACM_SUCCESS)
+	index = ipacm_xml_tag_table[ipacm_xml_tag_hash(name, ipacm_xml_tag_seed)];
+	if (index == 0 || strcasecmp(ipacm_xml_tags[index - 1].name, name) != 0)
 	{
-		IPACMDBG_H("IPACM_xml_parse: ipacm_cfg_xml_parse_tree returned parse error!\n");
+		return IPACM_XML_TAG_NONE;
 	}
-
-	/* Free up the libxml's parse tree */
-	xmlFreeDoc(doc);
-
-	return ret_val;
+	return ipacm_xml_tags[index - 1].id;
 }
 
-/* This function traverses the xml tree*/
-static int ipacm_cfg_xml_parse_tree
+/* Walks the elements the way the config is nested: the root and the children
+	 of container elements are passed to element_cb, the first text of a leaf
+	 element is passed to content_cb */
+static int ipacm_xml_stream
 (
-	 xmlNode* xml_node,
-	 IPACM_conf_t *config
+	 char *xml_file,
+	 ipacm_xml_element_cb element_cb,
+	 ipacm_xml_content_cb content_cb,
+	 void *config
 )
 {
-	int32_t ret_val = IPACM_SUCCESS;
-	int str_size;
-	char* content;
+	xmlTextReaderPtr reader;
+	bool walk[IPACM_XML_MAX_DEPTH];
 	char content_buf[MAX_XML_STR_LEN];
+	const char *content;
+	int leaf_tag = IPACM_XML_TAG_NONE, leaf_depth = 0;
+	int depth, tag, ret;
+
+	pthread_once(&ipacm_xml_tag_once, ipacm_xml_tag_table_init);
 
-	if (NULL == xml_node)
-		return ret_val;
+	reader = xmlReaderForFile(xml_file, "UTF-8", XML_PARSE_NOBLANKS);
+	if (reader == NULL)
+	{
+		IPACMDBG_H("IPACM_xml_parse: libxml failed to open %s\n", xml_file);
+		return IPACM_FAILURE;
+	}
 
-	while ( xml_node != NULL &&
-				 ret_val == IPACM_SUCCESS)
+	while ((ret = xmlTextReaderRead(reader)) == 1)
 	{
-		switch (xml_node->type)
+		depth = xmlTextReaderDepth(reader);
+		switch (xmlTextReaderNodeType(reader))
 		{
-		case XML_ELEMENT_NODE:
+		case XML_READER_TYPE_ELEMENT:
+			if (leaf_tag != IPACM_XML_TAG_NONE && depth <= leaf_depth)
 			{
-				if (IPACM_util_icmp_string((char*)xml_node->name,
-																	 system_TAG) == 0 ||
-						IPACM_util_icmp_string((char*)xml_node->name,
-																	 ODU_TAG) == 0 ||
-						IPACM_util_icmp_string((char*)xml_node->name,
-																	 IPACMCFG_TAG) == 0 ||
-						IPACM_util_icmp_string((char*)xml_node->name,
-																	 IPACMIFACECFG_TAG) == 0 ||
-						IPACM_util_icmp_string((char*)xml_node->name,
-																	 IFACE_TAG) == 0 ||
-						IPACM_util_icmp_string((char*)xml_node->name,
-																	 IPACMPRIVATESUBNETCFG_TAG) == 0 ||
-						IPACM_util_icmp_string((char*)xml_node->name,
-																	 SUBNET_TAG) == 0 ||
-						IPACM_util_icmp_string((char*)xml_node->name,
-																	 IPACMALG_TAG) == 0 ||
-						IPACM_util_icmp_string((char*)xml_node->name,
-																	 ALG_TAG) == 0 ||
-						IPACM_util_icmp_string((char*)xml_node->name,
-																	 IPACMNat_TAG) == 0)
-				{
-					if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																					IFACE_TAG))
-					{
-						/* increase iface entry number */
-						config->iface_config.num_iface_entries++;
-					}
-
-					if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																					SUBNET_TAG))
-					{
-						/* increase iface entry number */
-						config->private_subnet_config.num_subnet_entries++;
-					}
-
-					if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																					ALG_TAG))
-					{
-						/* increase iface entry number */
-						config->alg_config.num_alg_entries++;
-					}
-					/* go to child */
-					ret_val = ipacm_cfg_xml_parse_tree(xml_node->children,
-																						 config);
-				}
-				else if (IPACM_util_icmp_string((char*)xml_node->name,
-																	ODUMODE_TAG) == 0)
-				{
-					IPACMDBG("inside ODU-XML\n");
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						if (0 == strncasecmp(content_buf, ODU_ROUTER_TAG, str_size))
-						{
-							config->router_mode_enable = true;
-							IPACMDBG("router-mode enable %d\n", config->router_mode_enable);
-						}
-						else if (0 == strncasecmp(content_buf, ODU_BRIDGE_TAG, str_size))
-						{
-							config->router_mode_enable = false;
-							IPACMDBG("router-mode enable %d\n", config->router_mode_enable);
-						}
-					}
-				}
-				else if (IPACM_util_icmp_string((char*)xml_node->name,
-																				NAME_TAG) == 0)
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						strncpy(config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].iface_name, content_buf, str_size);
-						IPACMDBG_H("Name %s\n", config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].iface_name);
-					}
-				}
-				else if (IPACM_util_icmp_string((char*)xml_node->name,
-																				CATEGORY_TAG) == 0)
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						if (0 == strncasecmp(content_buf, WANIF_TAG, str_size))
-						{
-							config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat = WAN_IF;
-							IPACMDBG_H("Category %d\n", config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat);
-						}
-						else if (0 == strncasecmp(content_buf, LANIF_TAG, str_size))
-						{
-							config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat = LAN_IF;
-							IPACMDBG_H("Category %d\n", config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat);
-						}
-						else if (0 == strncasecmp(content_buf, WLANIF_TAG, str_size))
-						{
-							config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat = WLAN_IF;
-							IPACMDBG_H("Category %d\n", config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat);
-						}
-						else  if (0 == strncasecmp(content_buf, VIRTUALIF_TAG, str_size))
-						{
-							config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat = VIRTUAL_IF;
-							IPACMDBG_H("Category %d\n", config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat);
-						}
-						else  if (0 == strncasecmp(content_buf, UNKNOWNIF_TAG, str_size))
-						{
-							config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat = UNKNOWN_IF;
-							IPACMDBG_H("Category %d\n", config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat);
-						}
-						else  if (0 == strncasecmp(content_buf, ETHIF_TAG, str_size))
-						{
-							config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat = ETH_IF;
-							IPACMDBG_H("Category %d\n", config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat);
-						}
-						else  if (0 == strncasecmp(content_buf, ODUIF_TAG, str_size))
-						{
-							config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat = ODU_IF;
-							IPACMDBG("Category %d\n", config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1].if_cat);
-						}
-					}
-				}
-				else if (IPACM_util_icmp_string((char*)xml_node->name,
-																				SUBNETADDRESS_TAG) == 0)
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						content_buf[MAX_XML_STR_LEN-1] = '\0';
-						config->private_subnet_config.private_subnet_entries[config->private_subnet_config.num_subnet_entries - 1].subnet_addr
-							 = ntohl(inet_addr(content_buf));
-						IPACMDBG_H("subnet_addr: %s \n", content_buf);
-					}
-				}
-				else if (IPACM_util_icmp_string((char*)xml_node->name,
-																				SUBNETMASK_TAG) == 0)
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						content_buf[MAX_XML_STR_LEN-1] = '\0';
-						config->private_subnet_config.private_subnet_entries[config->private_subnet_config.num_subnet_entries - 1].subnet_mask
-							 = ntohl(inet_addr(content_buf));
-						IPACMDBG_H("subnet_mask: %s \n", content_buf);
-					}
-				}
-				else if (IPACM_util_icmp_string((char*)xml_node->name,
-																				Protocol_TAG) == 0)
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						content_buf[MAX_XML_STR_LEN-1] = '\0';
-
-						if (0 == strncasecmp(content_buf, TCP_PROTOCOL_TAG, str_size))
-						{
-							config->alg_config.alg_entries[config->alg_config.num_alg_entries - 1].protocol = IPPROTO_TCP;
-							IPACMDBG_H("Protocol %s: %d\n", content_buf, config->alg_config.alg_entries[config->alg_config.num_alg_entries - 1].protocol);
-						}
-						else if (0 == strncasecmp(content_buf, UDP_PROTOCOL_TAG, str_size))
-						{
-							config->alg_config.alg_entries[config->alg_config.num_alg_entries - 1].protocol = IPPROTO_UDP;
-							IPACMDBG_H("Protocol %s: %d\n", content_buf, config->alg_config.alg_entries[config->alg_config.num_alg_entries - 1].protocol);
-						}
-					}
-				}
-				else if (IPACM_util_icmp_string((char*)xml_node->name,
-																				Port_TAG) == 0)
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->alg_config.alg_entries[config->alg_config.num_alg_entries - 1].port
-							 = atoi(content_buf);
-						IPACMDBG_H("port %d\n", config->alg_config.alg_entries[config->alg_config.num_alg_entries - 1].port);
-					}
-				}
-				else if (IPACM_util_icmp_string((char*)xml_node->name,
-																				NAT_MaxEntries_TAG) == 0)
+				leaf_tag = IPACM_XML_TAG_NONE;
+			}
+			if (depth < 0 || depth >= IPACM_XML_MAX_DEPTH)
+			{
+				break;
+			}
+			walk[depth] = false;
+			if (depth > 0 && walk[depth - 1] == false)
+			{
+				break;
+			}
+
+			tag = ipacm_xml_tag_lookup((const char *)xmlTextReaderConstLocalName(reader));
+			switch (element_cb(tag, config))
+			{
+			case IPACM_XML_CONTAINER:
+				walk[depth] = true;
+				break;
+			case IPACM_XML_LEAF:
+				if (xmlTextReaderIsEmptyElement(reader) == 0)
+				{
+					leaf_tag = tag;
+					leaf_depth = depth;
+				}
+				break;
+			default:
+				break;
+			}
+			break;
+
+		case XML_READER_TYPE_TEXT:
+			if (leaf_tag != IPACM_XML_TAG_NONE && depth == leaf_depth + 1)
+			{
+				content = (const char *)xmlTextReaderConstValue(reader);
+				if (content != NULL)
 				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->nat_max_entries = atoi(content_buf);
-						IPACMDBG_H("Nat Table Max Entries %d\n", config->nat_max_entries);
-					}
+					memset(content_buf, 0, sizeof(content_buf));
+					strncpy(content_buf, content, MAX_XML_STR_LEN - 1);
+					content_cb(leaf_tag, content_buf, config);
 				}
+				leaf_tag = IPACM_XML_TAG_NONE;
 			}
 			break;
+
+		case XML_READER_TYPE_END_ELEMENT:
+			if (leaf_tag != IPACM_XML_TAG_NONE && depth <= leaf_depth)
+			{
+				leaf_tag = IPACM_XML_TAG_NONE;
+			}
+			break;
+
 		default:
 			break;
 		}
-		/* go to sibling */
-		xml_node = xml_node->next;
-	} /* end while */
-	return ret_val;
+	}
+	xmlFreeTextReader(reader);
+
+	if (ret != 0)
+	{
+		IPACMDBG_H("IPACM_xml_parse: libxml returned parse error!\n");
+		return IPACM_FAILURE;
+	}
+	return IPACM_SUCCESS;
 }
 
-/* This function read QCMAP CM Firewall XML and populate the QCMAP CM Cfg */
-int IPACM_read_firewall_xml(char *xml_file, IPACM_firewall_conf_t *config)
+/* insensitive prefix comparison of the element text with a value tag */
+static int32_t IPACM_util_icmp_content
+(
+	 const char* content,
+	 const char* str
+)
 {
-	xmlDocPtr doc = NULL;
-	xmlNode* root = NULL;
-	int ret_val;
+	return strncasecmp(content, str, strlen(content));
+}
 
-	IPACM_ASSERT(xml_file != NULL);
-	IPACM_ASSERT(config != NULL);
+static int ipacm_cfg_xml_element(int tag, void *data)
+{
+	IPACM_conf_t *config = (IPACM_conf_t *)data;
 
-	/* invoke the XML parser and obtain the parse tree */
-	doc = xmlReadFile(xml_file, "UTF-8", XML_PARSE_NOBLANKS);
-    if (doc == NULL) {
-        IPACMDBG_H("IPACM_xml_parse: libxml returned parse error\n");
-		return IPACM_FAILURE;
-    }
-	/*get the root of the tree*/
-	root = xmlDocGetRootElement(doc);
+	switch (tag)
+	{
+	case IPACM_XML_TAG_SYSTEM:
+	case IPACM_XML_TAG_ODU:
+	case IPACM_XML_TAG_IPACMCFG:
+	case IPACM_XML_TAG_IPACMIFACECFG:
+	case IPACM_XML_TAG_IPACMPRIVATESUBNETCFG:
+	case IPACM_XML_TAG_IPACMALG:
+	case IPACM_XML_TAG_IPACMNAT:
+		return IPACM_XML_CONTAINER;
+
+	case IPACM_XML_TAG_IFACE:
+		if (config->iface_config.num_iface_entries >= IPA_MAX_IFACE_ENTRIES)
+		{
+			IPACMERR("More than %d ifaces in config, ignore the rest\n", IPA_MAX_IFACE_ENTRIES);
+			return IPACM_XML_SKIP;
+		}
+		/* increase iface entry number */
+		config->iface_config.num_iface_entries++;
+		return IPACM_XML_CONTAINER;
 
-	/* parse the xml tree returned by libxml*/
-	ret_val = IPACM_firewall_xml_parse_tree(root, config);
+	case IPACM_XML_TAG_SUBNET:
+		if (config->private_subnet_config.num_subnet_entries >= IPA_MAX_PRIVATE_SUBNET_ENTRIES)
+		{
+			IPACMERR("More than %d private subnets in config, ignore the rest\n", IPA_MAX_PRIVATE_SUBNET_ENTRIES);
+			return IPACM_XML_SKIP;
+		}
+		config->private_subnet_config.num_subnet_entries++;
+		return IPACM_XML_CONTAINER;
 
-	if (ret_val != IPACM_SUCCESS)
+	case IPACM_XML_TAG_ALG:
+		if (config->alg_config.num_alg_entries >= IPA_MAX_ALG_ENTRIES)
+		{
+			IPACMERR("More than %d ALG entries in config, ignore the rest\n", IPA_MAX_ALG_ENTRIES);
+			return IPACM_XML_SKIP;
+		}
+		config->alg_config.num_alg_entries++;
+		return IPACM_XML_CONTAINER;
+
+	case IPACM_XML_TAG_ODUMODE:
+	case IPACM_XML_TAG_NAT_MAXENTRIES:
+		return IPACM_XML_LEAF;
+
+	case IPACM_XML_TAG_NAME:
+	case IPACM_XML_TAG_CATEGORY:
+		return (config->iface_config.num_iface_entries > 0) ? IPACM_XML_LEAF : IPACM_XML_SKIP;
+
+	case IPACM_XML_TAG_SUBNETADDRESS:
+	case IPACM_XML_TAG_SUBNETMASK:
+		return (config->private_subnet_config.num_subnet_entries > 0) ? IPACM_XML_LEAF : IPACM_XML_SKIP;
+
+	case IPACM_XML_TAG_PROTOCOL:
+	case IPACM_XML_TAG_PORT:
+		return (config->alg_config.num_alg_entries > 0) ? IPACM_XML_LEAF : IPACM_XML_SKIP;
+
+	default:
+		return IPACM_XML_SKIP;
+	}
+}
+
+static void ipacm_cfg_xml_content(int tag, char *content_buf, void *data)
+{
+	IPACM_conf_t *config = (IPACM_conf_t *)data;
+	ipa_ifi_dev_name_t *iface;
+	ipa_private_subnet *subnet;
+	ipacm_alg *alg;
+
+	iface = &config->iface_config.iface_entries[config->iface_config.num_iface_entries - 1];
+	subnet = &config->private_subnet_config.private_subnet_entries[config->private_subnet_config.num_subnet_entries - 1];
+	alg = &config->alg_config.alg_entries[config->alg_config.num_alg_entries - 1];
+
+	switch (tag)
 	{
-		IPACMDBG_H("IPACM_xml_parse: ipacm_firewall_xml_parse_tree returned parse error!\n");
+	case IPACM_XML_TAG_ODUMODE:
+		IPACMDBG("inside ODU-XML\n");
+		if (0 == IPACM_util_icmp_content(content_buf, ODU_ROUTER_TAG))
+		{
+			config->router_mode_enable = true;
+			IPACMDBG("router-mode enable %d\n", config->router_mode_enable);
+		}
+		else if (0 == IPACM_util_icmp_content(content_buf, ODU_BRIDGE_TAG))
+		{
+			config->router_mode_enable = false;
+			IPACMDBG("router-mode enable %d\n", config->router_mode_enable);
+		}
+		break;
+
+	case IPACM_XML_TAG_NAME:
+		strncpy(iface->iface_name, content_buf, sizeof(iface->iface_name) - 1);
+		IPACMDBG_H("Name %s\n", iface->iface_name);
+		break;
+
+	case IPACM_XML_TAG_CATEGORY:
+		if (0 == IPACM_util_icmp_content(content_buf, WANIF_TAG))
+		{
+			iface->if_cat = WAN_IF;
+		}
+		else if (0 == IPACM_util_icmp_content(content_buf, LANIF_TAG))
+		{
+			iface->if_cat = LAN_IF;
+		}
+		else if (0 == IPACM_util_icmp_content(content_buf, WLANIF_TAG))
+		{
+			iface->if_cat = WLAN_IF;
+		}
+		else if (0 == IPACM_util_icmp_content(content_buf, VIRTUALIF_TAG))
+		{
+			iface->if_cat = VIRTUAL_IF;
+		}
+		else if (0 == IPACM_util_icmp_content(content_buf, UNKNOWNIF_TAG))
+		{
+			iface->if_cat = UNKNOWN_IF;
+		}
+		else if (0 == IPACM_util_icmp_content(content_buf, ETHIF_TAG))
+		{
+			iface->if_cat = ETH_IF;
+		}
+		else if (0 == IPACM_util_icmp_content(content_buf, ODUIF_TAG))
+		{
+			iface->if_cat = ODU_IF;
+		}
+		IPACMDBG_H("Category %d\n", iface->if_cat);
+		break;
+
+	case IPACM_XML_TAG_SUBNETADDRESS:
+		subnet->subnet_addr = ntohl(inet_addr(content_buf));
+		IPACMDBG_H("subnet_addr: %s \n", content_buf);
+		break;
+
+	case IPACM_XML_TAG_SUBNETMASK:
+		subnet->subnet_mask = ntohl(inet_addr(content_buf));
+		IPACMDBG_H("subnet_mask: %s \n", content_buf);
+		break;
+
+	case IPACM_XML_TAG_PROTOCOL:
+		if (0 == IPACM_util_icmp_content(content_buf, TCP_PROTOCOL_TAG))
+		{
+			alg->protocol = IPPROTO_TCP;
+			IPACMDBG_H("Protocol %s: %d\n", content_buf, alg->protocol);
+		}
+		else if (0 == IPACM_util_icmp_content(content_buf, UDP_PROTOCOL_TAG))
+		{
+			alg->protocol = IPPROTO_UDP;
+			IPACMDBG_H("Protocol %s: %d\n", content_buf, alg->protocol);
+		}
+		break;
+
+	case IPACM_XML_TAG_PORT:
+		alg->port = atoi(content_buf);
+		IPACMDBG_H("port %d\n", alg->port);
+		break;
+
+	case IPACM_XML_TAG_NAT_MAXENTRIES:
+		config->nat_max_entries = atoi(content_buf);
+		IPACMDBG_H("Nat Table Max Entries %d\n", config->nat_max_entries);
+		break;
+
+	default:
+		break;
 	}
+}
 
-	/* free the tree */
-    xmlFreeDoc(doc);
+/* This function read IPACM XML and populate the IPA CM Cfg */
+int ipacm_read_cfg_xml(char *xml_file, IPACM_conf_t *config)
+{
+	int ret_val;
 
+	memset(config, 0, sizeof(IPACM_conf_t));
+
+	ret_val = ipacm_xml_stream(xml_file, ipacm_cfg_xml_element, ipacm_cfg_xml_content, config);
+	if (ret_val != IPACM_SUCCESS)
+	{
+		IPACMDBG_H("IPACM_xml_parse: ipacm_read_cfg_xml returned parse error!\n");
+		memset(config, 0, sizeof(IPACM_conf_t));
+	}
 	return ret_val;
 }
 
-
-/* This function traverses the firewall xml tree */
-static int IPACM_firewall_xml_parse_tree
-(
-	 xmlNode* xml_node,
-	 IPACM_firewall_conf_t *config
-)
+static int IPACM_firewall_xml_element(int tag, void *data)
 {
-	int mask_value_v6, mask_index;
-	int32_t ret_val = IPACM_SUCCESS;
-	char *content;
-	int str_size;
-	char content_buf[MAX_XML_STR_LEN];
-	struct in6_addr ip6_addr;
+	IPACM_firewall_conf_t *config = (IPACM_firewall_conf_t *)data;
+	struct ipa_rule_attrib *attrib;
 
-	IPACM_ASSERT(config != NULL);
+	switch (tag)
+	{
+	case IPACM_XML_TAG_SYSTEM:
+	case IPACM_XML_TAG_MOBILEAPFIREWALLCFG:
+		return IPACM_XML_CONTAINER;
+
+	case IPACM_XML_TAG_FIREWALL:
+		if (config->num_extd_firewall_entries >= IPACM_MAX_FIREWALL_ENTRIES)
+		{
+			IPACMERR("More than %d firewall rules, ignore the rest\n", IPACM_MAX_FIREWALL_ENTRIES);
+			return IPACM_XML_SKIP;
+		}
+		/* increase firewall entry num */
+		config->num_extd_firewall_entries++;
+		return IPACM_XML_CONTAINER;
+
+	case IPACM_XML_TAG_FIREWALLENABLED:
+	case IPACM_XML_TAG_FIREWALLPKTSALLOWED:
+		return IPACM_XML_LEAF;
 
-	if (NULL == xml_node)
-		return ret_val;
+	default:
+		break;
+	}
 
-	while ( xml_node != NULL &&
-				 ret_val == IPACM_SUCCESS)
+	/* everything else belongs to the current rule */
+	if (config->num_extd_firewall_entries == 0)
 	{
-		switch (xml_node->type)
+		return IPACM_XML_SKIP;
+	}
+	attrib = &config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib;
+
+	switch (tag)
+	{
+	case IPACM_XML_TAG_IPV4SOURCEADDRESS:
+	case IPACM_XML_TAG_IPV6SOURCEADDRESS:
+		attrib->attrib_mask |= IPA_FLT_SRC_ADDR;
+		return IPACM_XML_CONTAINER;
+
+	case IPACM_XML_TAG_IPV4DESTINATIONADDRESS:
+	case IPACM_XML_TAG_IPV6DESTINATIONADDRESS:
+		attrib->attrib_mask |= IPA_FLT_DST_ADDR;
+		return IPACM_XML_CONTAINER;
+
+	case IPACM_XML_TAG_IPV4TYPEOFSERVICE:
+		attrib->attrib_mask |= IPA_FLT_TOS;
+		return IPACM_XML_CONTAINER;
+
+	case IPACM_XML_TAG_IPV6TRAFFICCLASS:
+		attrib->attrib_mask |= IPA_FLT_TC;
+		return IPACM_XML_CONTAINER;
+
+	case IPACM_XML_TAG_TCPSOURCE:
+	case IPACM_XML_TAG_TCPDESTINATION:
+	case IPACM_XML_TAG_UDPSOURCE:
+	case IPACM_XML_TAG_UDPDESTINATION:
+	case IPACM_XML_TAG_TCP_UDPSOURCE:
+	case IPACM_XML_TAG_TCP_UDPDESTINATION:
+		return IPACM_XML_CONTAINER;
+
+	case IPACM_XML_TAG_IPFAMILY:
+	case IPACM_XML_TAG_IPV4SOURCEIPADDRESS:
+	case IPACM_XML_TAG_IPV4SOURCESUBNETMASK:
+	case IPACM_XML_TAG_IPV4DESTINATIONIPADDRESS:
+	case IPACM_XML_TAG_IPV4DESTINATIONSUBNETMASK:
+	case IPACM_XML_TAG_TOSVALUE:
+	case IPACM_XML_TAG_TOSMASK:
+	case IPACM_XML_TAG_IPV4NEXTHEADERPROTOCOL:
+	case IPACM_XML_TAG_IPV6SOURCEIPADDRESS:
+	case IPACM_XML_TAG_IPV6SOURCEPREFIX:
+	case IPACM_XML_TAG_IPV6DESTINATIONIPADDRESS:
+	case IPACM_XML_TAG_IPV6DESTINATIONPREFIX:
+	case IPACM_XML_TAG_TRFCLSVALUE:
+	case IPACM_XML_TAG_TRFCLSMASK:
+	case IPACM_XML_TAG_IPV6NEXTHEADERPROTOCOL:
+	case IPACM_XML_TAG_TCPSOURCEPORT:
+	case IPACM_XML_TAG_TCPSOURCERANGE:
+	case IPACM_XML_TAG_TCPDESTINATIONPORT:
+	case IPACM_XML_TAG_TCPDESTINATIONRANGE:
+	case IPACM_XML_TAG_UDPSOURCEPORT:
+	case IPACM_XML_TAG_UDPSOURCERANGE:
+	case IPACM_XML_TAG_UDPDESTINATIONPORT:
+	case IPACM_XML_TAG_UDPDESTINATIONRANGE:
+	case IPACM_XML_TAG_ICMPTYPE:
+	case IPACM_XML_TAG_ICMPCODE:
+	case IPACM_XML_TAG_ESPSPI:
+	case IPACM_XML_TAG_TCP_UDPSOURCEPORT:
+	case IPACM_XML_TAG_TCP_UDPSOURCERANGE:
+	case IPACM_XML_TAG_TCP_UDPDESTINATIONPORT:
+	case IPACM_XML_TAG_TCP_UDPDESTINATIONRANGE:
+		return IPACM_XML_LEAF;
+
+	default:
+		return IPACM_XML_SKIP;
+	}
+}
+
+/* prefix length to the 4 words of an IPv6 mask */
+static void IPACM_firewall_v6_prefix(int mask_value_v6, uint32_t *mask)
+{
+	int mask_index;
+
+	for (mask_index = 0; mask_index < 4; mask_index++)
+	{
+		if (mask_value_v6 >= 32)
+		{
+			mask_v6(32, &mask[mask_index]);
+			mask_value_v6 -= 32;
+		}
+		else
 		{
+			mask_v6(mask_value_v6, &mask[mask_index]);
+			mask_value_v6 = 0;
+		}
+	}
+}
 
-		case XML_ELEMENT_NODE:
-			{
-				if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																				system_TAG) ||
-						0 == IPACM_util_icmp_string((char*)xml_node->name,
-																				MobileAPFirewallCfg_TAG) ||
-						0 == IPACM_util_icmp_string((char*)xml_node->name,
-																				Firewall_TAG) ||
+/* IPv6 address text to the host order words of an IPA rule */
+static void IPACM_firewall_v6_addr(const char *content_buf, uint32_t *addr)
+{
+	struct in6_addr ip6_addr;
+	int i;
 
-						0 == IPACM_util_icmp_string((char*)xml_node->name,
-																				FirewallEnabled_TAG)  ||
-						0 == IPACM_util_icmp_string((char*)xml_node->name,
-																				FirewallPktsAllowed_TAG)
+	inet_pton(AF_INET6, content_buf, &ip6_addr);
+	memcpy(addr, ip6_addr.s6_addr, IPACM_IPV6_ADDR_LEN * sizeof(uint8_t));
+	for (i = 0; i < 4; i++)
+	{
+		addr[i] = ntohl(addr[i]);
+	}
+}
 
+static void IPACM_firewall_xml_content(int tag, char *content_buf, void *data)
+{
+	IPACM_firewall_conf_t *config = (IPACM_firewall_conf_t *)data;
+	IPACM_extd_firewall_entry_conf_t *entry;
+	struct ipa_rule_attrib *attrib;
+	int range;
 
-																				)
-				{
-					if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																					Firewall_TAG))
-					{
-						/* increase firewall entry num */
-						config->num_extd_firewall_entries++;
-					}
-
-
-					if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																					FirewallPktsAllowed_TAG))
-					{
-						/* setup action of matched rules */
-					    content = IPACM_read_content_element(xml_node);
-					    if (content)
-					    {
-						        str_size = strlen(content);
-						        memset(content_buf, 0, sizeof(content_buf));
-						        memcpy(content_buf, (void *)content, str_size);
-							if (atoi(content_buf)==1)
-							{
-					    	            config->rule_action_accept = true;
-							}
-							else
-							{
-					    	            config->rule_action_accept = false;
-							}
-				    	                IPACMDBG_H(" Allow traffic which matches rules ?:%d\n",config->rule_action_accept);
-					    }
-				        }
-
-					if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																					FirewallEnabled_TAG))
-					{
-						/* setup if firewall enable or not */
-					    content = IPACM_read_content_element(xml_node);
-					    if (content)
-					    {
-						        str_size = strlen(content);
-						        memset(content_buf, 0, sizeof(content_buf));
-						        memcpy(content_buf, (void *)content, str_size);
-							if (atoi(content_buf)==1)
-							{
-					    	            config->firewall_enable = true;
-							}
-						        else
-							{
-					    	            config->firewall_enable = false;
-							}
-				    	                IPACMDBG_H(" Firewall Enable?:%d\n", config->firewall_enable);
-				            }
-					}
-					/* go to child */
-					ret_val = IPACM_firewall_xml_parse_tree(xml_node->children,
-																									config);
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPFamily_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].ip_vsn
-							 = (firewall_ip_version_enum)atoi(content_buf);
-						IPACMDBG_H("\n IP family type is %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].ip_vsn);
-
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV4SourceAddress_TAG))
-				{
-					config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_SRC_ADDR;
-					/* go to child */
-					ret_val = IPACM_firewall_xml_parse_tree(xml_node->children,
-																									config);
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV4SourceIPAddress_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						content_buf[MAX_XML_STR_LEN-1] = '\0';
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v4.src_addr
-							 = ntohl(inet_addr(content_buf));
-						IPACMDBG_H("IPv4 source address is: %s \n", content_buf);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV4SourceSubnetMask_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						content_buf[MAX_XML_STR_LEN-1] = '\0';
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v4.src_addr_mask
-							 = ntohl(inet_addr(content_buf));
-						IPACMDBG_H("IPv4 source subnet mask is: %s \n", content_buf);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV4DestinationAddress_TAG))
-				{
-					config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_DST_ADDR;
-					/* go to child */
-					ret_val = IPACM_firewall_xml_parse_tree(xml_node->children,
-																									config);
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV4DestinationIPAddress_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						content_buf[MAX_XML_STR_LEN-1] = '\0';
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v4.dst_addr
-							 = ntohl(inet_addr(content_buf));
-						IPACMDBG_H("IPv4 destination address is: %s \n", content_buf);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV4DestinationSubnetMask_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						content_buf[MAX_XML_STR_LEN-1] = '\0';
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v4.dst_addr_mask
-							 = ntohl(inet_addr(content_buf));
-						IPACMDBG_H("IPv4 destination subnet mask is: %s \n", content_buf);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV4TypeOfService_TAG))
-				{
-					config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_TOS;
-					/* go to child */
-					ret_val = IPACM_firewall_xml_parse_tree(xml_node->children,
-																									config);
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TOSValue_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v4.tos
-							 = atoi(content_buf);
-
-						IPACMDBG_H("\n IPV4 TOS val is %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v4.tos);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TOSMask_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v4.tos
-							 &= atoi(content_buf);
-
-						IPACMDBG_H("\n IPv4 TOS mask is %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v4.tos);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV4NextHeaderProtocol_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_PROTOCOL;
-
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v4.protocol = atoi(content_buf);
-
-						IPACMDBG_H("\n IPv4 next header prot is %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v4.protocol);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV6SourceAddress_TAG))
-				{
-					config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |=
-						 IPA_FLT_SRC_ADDR;
-					/* go to child */
-					ret_val = IPACM_firewall_xml_parse_tree(xml_node->children,
-																									config);
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV6SourceIPAddress_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						inet_pton(AF_INET6, content_buf, &ip6_addr);
-						memcpy(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.src_addr,
-									 ip6_addr.s6_addr, IPACM_IPV6_ADDR_LEN * sizeof(uint8_t));
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.src_addr[0]=ntohl(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.src_addr[0]);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.src_addr[1]=ntohl(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.src_addr[1]);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.src_addr[2]=ntohl(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.src_addr[2]);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.src_addr[3]=ntohl(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.src_addr[3]);
-
-						IPACMDBG_H("\n ipv6 source addr is %d \n ",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.src_addr[0]);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV6SourcePrefix_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						mask_value_v6 = atoi(content_buf);
-						for (mask_index = 0; mask_index < 4; mask_index++)
-						{
-							if (mask_value_v6 >= 32)
-							{
-								mask_v6(32, &(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.src_addr_mask[mask_index]));
-								mask_value_v6 -= 32;
-							}
-							else
-							{
-								mask_v6(mask_value_v6, &(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.src_addr_mask[mask_index]));
-								mask_value_v6 = 0;
-							}
-						}
-						IPACMDBG_H("\n ipv6 source prefix is %d \n",
-										 atoi(content_buf));
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV6DestinationAddress_TAG))
-				{
-					config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |=
-						 IPA_FLT_DST_ADDR;
-					/* go to child */
-					ret_val = IPACM_firewall_xml_parse_tree(xml_node->children,
-																									config);
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV6DestinationIPAddress_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						inet_pton(AF_INET6, content_buf, &ip6_addr);
-						memcpy(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.dst_addr,
-									 ip6_addr.s6_addr, IPACM_IPV6_ADDR_LEN * sizeof(uint8_t));
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.dst_addr[0]=ntohl(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.dst_addr[0]);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.dst_addr[1]=ntohl(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.dst_addr[1]);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.dst_addr[2]=ntohl(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.dst_addr[2]);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.dst_addr[3]=ntohl(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.dst_addr[3]);
-						IPACMDBG_H("\n ipv6 dest addr is %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.dst_addr[0]);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV6DestinationPrefix_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						mask_value_v6 = atoi(content_buf);
-						for (mask_index = 0; mask_index < 4; mask_index++)
-						{
-							if (mask_value_v6 >= 32)
-							{
-								mask_v6(32, &(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.dst_addr_mask[mask_index]));
-								mask_value_v6 -= 32;
-							}
-							else
-							{
-								mask_v6(mask_value_v6, &(config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.dst_addr_mask[mask_index]));
-								mask_value_v6 = 0;
-							}
-						}
-						IPACMDBG_H("\n ipv6 dest prefix is %d \n",
-										 atoi(content_buf));
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV6TrafficClass_TAG))
-				{
-					config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_TC;
-					/* go to child */
-					ret_val = IPACM_firewall_xml_parse_tree(xml_node->children,
-																									config);
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TrfClsValue_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.tc
-							 = atoi(content_buf);
-						IPACMDBG_H("\n ipv6 trf class val is %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.tc);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TrfClsMask_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.tc
-							 &= atoi(content_buf);
-
-						IPACMDBG_H("\n ipv6 trf class mask is %d \n",
-										 atoi(content_buf));
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 IPV6NextHeaderProtocol_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_NEXT_HDR;
-
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.next_hdr
-							 = atoi(content_buf);
-						IPACMDBG_H("\n ipv6 next header protocol is %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.u.v6.next_hdr);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TCPSource_TAG))
-				{
-					/* go to child */
-					ret_val = IPACM_firewall_xml_parse_tree(xml_node->children,
-																									config);
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TCPSourcePort_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port
-							 = atoi(content_buf);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TCPSourceRange_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						if (atoi(content_buf) != 0)
-						{
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_SRC_PORT_RANGE;
- 						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port_lo
-							 = config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port;
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port_hi
-							 = config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port + atoi(content_buf);
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port
-							 = 0;
-						  IPACMDBG_H("\n tcp source port from %d to %d \n",
-						                 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port_lo,
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port_hi);
-						}
-						else
-						{
-					       config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_SRC_PORT;
-                           IPACMDBG_H("\n tcp source port= %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port);
-						}
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TCPDestination_TAG))
-				{
-					/* go to child */
-					ret_val = IPACM_firewall_xml_parse_tree(xml_node->children,
-																									config);
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TCPDestinationPort_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port
-							 = atoi(content_buf);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TCPDestinationRange_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						if(atoi(content_buf)!=0)
-						{
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_DST_PORT_RANGE;
- 						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port_lo
-							 = config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port;
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port_hi
-							 = config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port + atoi(content_buf);
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port
-							 = 0;
-						  IPACMDBG_H("\n tcp dest port from %d to %d \n",
-						                 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port_lo,
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port_hi);
-						}
-						else
-						{
-					      config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_DST_PORT;
-						  IPACMDBG_H("\n tcp dest port= %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port);
-						}
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 UDPSource_TAG))
-				{
-					/* go to child */
-					ret_val = IPACM_firewall_xml_parse_tree(xml_node->children,
-																									config);
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 UDPSourcePort_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port
-							 = atoi(content_buf);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 UDPSourceRange_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						if(atoi(content_buf)!=0)
-						{
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_SRC_PORT_RANGE;
- 						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port_lo
-							 = config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port;
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port_hi
-							 = config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port + atoi(content_buf);
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port
-							 = 0;
-						  IPACMDBG_H("\n udp source port from %d to %d \n",
-						                 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port_lo,
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port_hi);
-						}
-						else
-						{
-					      config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_SRC_PORT;
-						  IPACMDBG_H("\n udp source port= %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port);
-
-						}
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 UDPDestination_TAG))
-				{
-					/* go to child */
-					ret_val = IPACM_firewall_xml_parse_tree(xml_node->children,
-																									config);
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 UDPDestinationPort_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port
-							 = atoi(content_buf);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 UDPDestinationRange_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						if(atoi(content_buf)!=0)
-						{
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_DST_PORT_RANGE;
- 						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port_lo
-							 = config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port;
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port_hi
-							 = config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port + atoi(content_buf);
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port
-							 = 0;
-						  IPACMDBG_H("\n UDP dest port from %d to %d \n",
-						                 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port_lo,
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port_hi);
-						}
-						else
-						{
-					      config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_DST_PORT;
-						  IPACMDBG_H("\n UDP dest port= %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port);
-
-						}
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 ICMPType_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.type = atoi(content_buf);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_TYPE;
-						IPACMDBG_H("\n icmp type is %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.type);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 ICMPCode_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.code = atoi(content_buf);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_CODE;
-						IPACMDBG_H("\n icmp code is %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.code);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 ESPSPI_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.spi = atoi(content_buf);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_SPI;
-						IPACMDBG_H("\n esp spi is %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.spi);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TCP_UDPSource_TAG))
-				{
-					/* go to child */
-					ret_val = IPACM_firewall_xml_parse_tree(xml_node->children,
-																									config);
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TCP_UDPSourcePort_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content,str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port
-							 = atoi(content_buf);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TCP_UDPSourceRange_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						if(atoi(content_buf)!=0)
-						{
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_SRC_PORT_RANGE;
- 						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port_lo
-							 = config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port;
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port_hi
-							 = config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port + atoi(content_buf);
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port
-							 = 0;
-						  IPACMDBG_H("\n tcp_udp source port from %d to %d \n",
-						                 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port_lo,
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port_hi);
-						}
-						else
-						{
-	  				      config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_SRC_PORT;
-						  IPACMDBG_H("\n tcp_udp source port= %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.src_port);
-
-						}
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TCP_UDPDestination_TAG))
-				{
-					ret_val = IPACM_firewall_xml_parse_tree(xml_node->children,
-																									config);
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TCP_UDPDestinationPort_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port
-							 = atoi(content_buf);
-					}
-				}
-				else if (0 == IPACM_util_icmp_string((char*)xml_node->name,
-																						 TCP_UDPDestinationRange_TAG))
-				{
-					content = IPACM_read_content_element(xml_node);
-					if (content)
-					{
-						str_size = strlen(content);
-						memset(content_buf, 0, sizeof(content_buf));
-						memcpy(content_buf, (void *)content, str_size);
-						if(atoi(content_buf)!=0)
-						{
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_DST_PORT_RANGE;
- 						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port_lo
-							 = config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port;
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port_hi
-							 = config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port + atoi(content_buf);
-						  config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port
-							 = 0;
-						  IPACMDBG_H("\n tcp_udp dest port from %d to %d \n",
-						                 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port_lo,
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port_hi);
-						}
-						else
-						{
-					      config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.attrib_mask |= IPA_FLT_DST_PORT;
-						  IPACMDBG_H("\n tcp_udp dest port= %d \n",
-										 config->extd_firewall_entries[config->num_extd_firewall_entries - 1].attrib.dst_port);
-
-						}
-					}
-				}
-			}
-			break;
+	switch (tag)
+	{
+	case IPACM_XML_TAG_FIREWALLPKTSALLOWED:
+		/* setup action of matched rules */
+		config->rule_action_accept = (atoi(content_buf) == 1);
+		IPACMDBG_H(" Allow traffic which matches rules ?:%d\n", config->rule_action_accept);
+		return;
+
+	case IPACM_XML_TAG_FIREWALLENABLED:
+		/* setup if firewall enable or not */
+		config->firewall_enable = (atoi(content_buf) == 1);
+		IPACMDBG_H(" Firewall Enable?:%d\n", config->firewall_enable);
+		return;
+
+	default:
+		break;
+	}
 
-		default:
-			break;
+	entry = &config->extd_firewall_entries[config->num_extd_firewall_entries - 1];
+	attrib = &entry->attrib;
+
+	switch (tag)
+	{
+	case IPACM_XML_TAG_IPFAMILY:
+		entry->ip_vsn = (firewall_ip_version_enum)atoi(content_buf);
+		IPACMDBG_H("\n IP family type is %d \n", entry->ip_vsn);
+		break;
+
+	case IPACM_XML_TAG_IPV4SOURCEIPADDRESS:
+		attrib->u.v4.src_addr = ntohl(inet_addr(content_buf));
+		IPACMDBG_H("IPv4 source address is: %s \n", content_buf);
+		break;
+
+	case IPACM_XML_TAG_IPV4SOURCESUBNETMASK:
+		attrib->u.v4.src_addr_mask = ntohl(inet_addr(content_buf));
+		IPACMDBG_H("IPv4 source subnet mask is: %s \n", content_buf);
+		break;
+
+	case IPACM_XML_TAG_IPV4DESTINATIONIPADDRESS:
+		attrib->u.v4.dst_addr = ntohl(inet_addr(content_buf));
+		IPACMDBG_H("IPv4 destination address is: %s \n", content_buf);
+		break;
+
+	case IPACM_XML_TAG_IPV4DESTINATIONSUBNETMASK:
+		attrib->u.v4.dst_addr_mask = ntohl(inet_addr(content_buf));
+		IPACMDBG_H("IPv4 destination subnet mask is: %s \n", content_buf);
+		break;
+
+	case IPACM_XML_TAG_TOSVALUE:
+		attrib->u.v4.tos = atoi(content_buf);
+		IPACMDBG_H("\n IPV4 TOS val is %d \n", attrib->u.v4.tos);
+		break;
+
+	case IPACM_XML_TAG_TOSMASK:
+		attrib->u.v4.tos &= atoi(content_buf);
+		IPACMDBG_H("\n IPv4 TOS mask is %d \n", attrib->u.v4.tos);
+		break;
+
+	case IPACM_XML_TAG_IPV4NEXTHEADERPROTOCOL:
+		attrib->attrib_mask |= IPA_FLT_PROTOCOL;
+		attrib->u.v4.protocol = atoi(content_buf);
+		IPACMDBG_H("\n IPv4 next header prot is %d \n", attrib->u.v4.protocol);
+		break;
+
+	case IPACM_XML_TAG_IPV6SOURCEIPADDRESS:
+		IPACM_firewall_v6_addr(content_buf, attrib->u.v6.src_addr);
+		IPACMDBG_H("\n ipv6 source addr is %d \n ", attrib->u.v6.src_addr[0]);
+		break;
+
+	case IPACM_XML_TAG_IPV6SOURCEPREFIX:
+		IPACM_firewall_v6_prefix(atoi(content_buf), attrib->u.v6.src_addr_mask);
+		IPACMDBG_H("\n ipv6 source prefix is %d \n", atoi(content_buf));
+		break;
+
+	case IPACM_XML_TAG_IPV6DESTINATIONIPADDRESS:
+		IPACM_firewall_v6_addr(content_buf, attrib->u.v6.dst_addr);
+		IPACMDBG_H("\n ipv6 dest addr is %d \n", attrib->u.v6.dst_addr[0]);
+		break;
+
+	case IPACM_XML_TAG_IPV6DESTINATIONPREFIX:
+		IPACM_firewall_v6_prefix(atoi(content_buf), attrib->u.v6.dst_addr_mask);
+		IPACMDBG_H("\n ipv6 dest prefix is %d \n", atoi(content_buf));
+		break;
+
+	case IPACM_XML_TAG_TRFCLSVALUE:
+		attrib->u.v6.tc = atoi(content_buf);
+		IPACMDBG_H("\n ipv6 trf class val is %d \n", attrib->u.v6.tc);
+		break;
+
+	case IPACM_XML_TAG_TRFCLSMASK:
+		attrib->u.v6.tc &= atoi(content_buf);
+		IPACMDBG_H("\n ipv6 trf class mask is %d \n", atoi(content_buf));
+		break;
+
+	case IPACM_XML_TAG_IPV6NEXTHEADERPROTOCOL:
+		attrib->attrib_mask |= IPA_FLT_NEXT_HDR;
+		attrib->u.v6.next_hdr = atoi(content_buf);
+		IPACMDBG_H("\n ipv6 next header protocol is %d \n", attrib->u.v6.next_hdr);
+		break;
+
+	case IPACM_XML_TAG_TCPSOURCEPORT:
+	case IPACM_XML_TAG_UDPSOURCEPORT:
+	case IPACM_XML_TAG_TCP_UDPSOURCEPORT:
+		attrib->src_port = atoi(content_buf);
+		break;
+
+	case IPACM_XML_TAG_TCPSOURCERANGE:
+	case IPACM_XML_TAG_UDPSOURCERANGE:
+	case IPACM_XML_TAG_TCP_UDPSOURCERANGE:
+		range = atoi(content_buf);
+		if (range != 0)
+		{
+			attrib->attrib_mask |= IPA_FLT_SRC_PORT_RANGE;
+			attrib->src_port_lo = attrib->src_port;
+			attrib->src_port_hi = attrib->src_port + range;
+			attrib->src_port = 0;
+			IPACMDBG_H("\n source port from %d to %d \n", attrib->src_port_lo, attrib->src_port_hi);
 		}
-		/* go to sibling */
-		xml_node = xml_node->next;
-	} /* end while */
-	return ret_val;
+		else
+		{
+			attrib->attrib_mask |= IPA_FLT_SRC_PORT;
+			IPACMDBG_H("\n source port= %d \n", attrib->src_port);
+		}
+		break;
+
+	case IPACM_XML_TAG_TCPDESTINATIONPORT:
+	case IPACM_XML_TAG_UDPDESTINATIONPORT:
+	case IPACM_XML_TAG_TCP_UDPDESTINATIONPORT:
+		attrib->dst_port = atoi(content_buf);
+		break;
+
+	case IPACM_XML_TAG_TCPDESTINATIONRANGE:
+	case IPACM_XML_TAG_UDPDESTINATIONRANGE:
+	case IPACM_XML_TAG_TCP_UDPDESTINATIONRANGE:
+		range = atoi(content_buf);
+		if (range != 0)
+		{
+			attrib->attrib_mask |= IPA_FLT_DST_PORT_RANGE;
+			attrib->dst_port_lo = attrib->dst_port;
+			attrib->dst_port_hi = attrib->dst_port + range;
+			attrib->dst_port = 0;
+			IPACMDBG_H("\n dest port from %d to %d \n", attrib->dst_port_lo, attrib->dst_port_hi);
+		}
+		else
+		{
+			attrib->attrib_mask |= IPA_FLT_DST_PORT;
+			IPACMDBG_H("\n dest port= %d \n", attrib->dst_port);
+		}
+		break;
+
+	case IPACM_XML_TAG_ICMPTYPE:
+		attrib->type = atoi(content_buf);
+		attrib->attrib_mask |= IPA_FLT_TYPE;
+		IPACMDBG_H("\n icmp type is %d \n", attrib->type);
+		break;
+
+	case IPACM_XML_TAG_ICMPCODE:
+		attrib->code = atoi(content_buf);
+		attrib->attrib_mask |= IPA_FLT_CODE;
+		IPACMDBG_H("\n icmp code is %d \n", attrib->code);
+		break;
+
+	case IPACM_XML_TAG_ESPSPI:
+		attrib->spi = atoi(content_buf);
+		attrib->attrib_mask |= IPA_FLT_SPI;
+		IPACMDBG_H("\n esp spi is %d \n", attrib->spi);
+		break;
+
+	default:
+		break;
+	}
 }
 
+/* This function read QCMAP CM Firewall XML and populate the QCMAP CM Cfg */
+int IPACM_read_firewall_xml(char *xml_file, IPACM_firewall_conf_t *config)
+{
+	IPACM_firewall_conf_t *parsed;
+	int ret_val;
+
+	IPACM_ASSERT(xml_file != NULL);
+	IPACM_ASSERT(config != NULL);
+
+	/* parse into a copy, a half parsed file must not replace the
+		 caller's defaults */
+	parsed = (IPACM_firewall_conf_t *)malloc(sizeof(IPACM_firewall_conf_t));
+	if (parsed == NULL)
+	{
+		IPACMERR("Unable to allocate memory for firewall config\n");
+		return IPACM_FAILURE;
+	}
+	memcpy(parsed, config, sizeof(IPACM_firewall_conf_t));
 
+	ret_val = ipacm_xml_stream(xml_file, IPACM_firewall_xml_element, IPACM_firewall_xml_content, parsed);
+	if (ret_val != IPACM_SUCCESS)
+	{
+		IPACMDBG_H("IPACM_xml_parse: IPACM_read_firewall_xml returned parse error!\n");
+	}
+	else
+	{
+		memcpy(config, parsed, sizeof(IPACM_firewall_conf_t));
+	}
+
+	free(parsed);
+	return ret_val;
+}
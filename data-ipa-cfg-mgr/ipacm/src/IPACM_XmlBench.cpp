@@ -0,0 +1,366 @@
+/*
+Copyright (c) 2013, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_XmlBench.cpp
+
+	@brief
+	Parse benchmark for the IPACM XML configuration readers
+
+	Generates firewall configurations of 10, 100 and 1000 rules (or the
+	counts given with -r) and parses each of them, and the main IPACM
+	configuration, with IPACM_read_firewall_xml() and ipacm_read_cfg_xml().
+	For each file it reports the best parse time and the peak libxml2 heap
+	in use during a parse, counted through xmlMemSetup(). Only the first
+	IPACM_MAX_FIREWALL_ENTRIES rules are stored, the rest still has to be
+	parsed.
+
+	The readers log with printf, so stdout goes to /dev/null and the report
+	to stderr.
+
+	@Author
+
+*/
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "IPACM_Xml.h"
+#include "IPACM_Log.h"
+#include "IPACM_Netlink.h"
+#include <libxml/xmlmemory.h>
+
+#define XML_BENCH_DEF_ITERS  200
+#define XML_BENCH_MAX_RULES  8
+#define XML_BENCH_CFG_FILE   "/vendor/etc/IPACM_cfg.xml"
+#define XML_BENCH_TMP_DIR    "/data/local/tmp"
+
+/* Every libxml2 allocation is prefixed with its size */
+typedef union
+{
+	size_t size;
+	long double align;
+} xml_bench_hdr;
+
+static size_t bench_heap_used;
+static size_t bench_heap_peak;
+
+static void *bench_xml_malloc(size_t size)
+{
+	xml_bench_hdr *hdr;
+
+	hdr = (xml_bench_hdr *)malloc(sizeof(*hdr) + size);
+	if(hdr == NULL)
+	{
+		return NULL;
+	}
+	hdr->size = size;
+	bench_heap_used += size;
+	if(bench_heap_used > bench_heap_peak)
+	{
+		bench_heap_peak = bench_heap_used;
+	}
+	return hdr + 1;
+}
+
+static void bench_xml_free(void *ptr)
+{
+	xml_bench_hdr *hdr;
+
+	if(ptr == NULL)
+	{
+		return;
+	}
+	hdr = (xml_bench_hdr *)ptr - 1;
+	bench_heap_used -= hdr->size;
+	free(hdr);
+}
+
+static void *bench_xml_realloc(void *ptr, size_t size)
+{
+	xml_bench_hdr *hdr;
+	size_t old_size;
+
+	if(ptr == NULL)
+	{
+		return bench_xml_malloc(size);
+	}
+	hdr = (xml_bench_hdr *)ptr - 1;
+	old_size = hdr->size;
+	hdr = (xml_bench_hdr *)realloc(hdr, sizeof(*hdr) + size);
+	if(hdr == NULL)
+	{
+		return NULL;
+	}
+	hdr->size = size;
+	bench_heap_used = bench_heap_used - old_size + size;
+	if(bench_heap_used > bench_heap_peak)
+	{
+		bench_heap_peak = bench_heap_used;
+	}
+	return hdr + 1;
+}
+
+static char *bench_xml_strdup(const char *str)
+{
+	size_t len = strlen(str) + 1;
+	char *dup;
+
+	dup = (char *)bench_xml_malloc(len);
+	if(dup != NULL)
+	{
+		memcpy(dup, str, len);
+	}
+	return dup;
+}
+
+void ipacm_log_send(void *user_data)
+{
+	(void)user_data;
+}
+
+/* Same as the netlink helper, the only symbol needed from IPACM_Netlink */
+int mask_v6(int index, uint32_t *mask)
+{
+	if(index > 32)
+	{
+		return -1;
+	}
+	*mask = (index == 0) ? 0 : (0xFFFFFFFF << (32 - index));
+	return 0;
+}
+
+/* Write a firewall config of num_rules rules, alternating ipv4 rules on
+	 the source address and ipv6 rules on the destination address */
+static int bench_write_firewall(const char *path, uint32_t num_rules)
+{
+	static const char *ports[] = { "TCP_UDP", "UDP", "TCP" };
+	const char *port;
+	uint32_t cnt;
+	FILE *fp;
+
+	fp = fopen(path, "w");
+	if(fp == NULL)
+	{
+		return -1;
+	}
+
+	fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+					"<system><MobileAPFirewallCfg>\n"
+					"<FirewallEnabled>1</FirewallEnabled>\n"
+					"<FirewallPktsAllowed>0</FirewallPktsAllowed>\n");
+	for(cnt = 0; cnt < num_rules; cnt++)
+	{
+		port = ports[cnt % 3];
+		fprintf(fp, "<Firewall>\n");
+		if(cnt % 2 == 0)
+		{
+			fprintf(fp, "<IPFamily>4</IPFamily>\n"
+							"<IPV4SourceAddress><IPV4SourceIPAddress>10.%u.%u.1</IPV4SourceIPAddress>"
+							"<IPV4SourceSubnetMask>255.255.255.0</IPV4SourceSubnetMask></IPV4SourceAddress>\n"
+							"<IPV4TypeOfService><TOSValue>12</TOSValue><TOSMask>255</TOSMask></IPV4TypeOfService>\n"
+							"<IPV4NextHeaderProtocol>6</IPV4NextHeaderProtocol>\n",
+							(cnt >> 8) & 0xFF, cnt & 0xFF);
+		}
+		else
+		{
+			fprintf(fp, "<IPFamily>6</IPFamily>\n"
+							"<IPV6DestinationAddress><IPV6DestinationIPAddress>2001:db8::%x</IPV6DestinationIPAddress>"
+							"<IPV6DestinationPrefix>64</IPV6DestinationPrefix></IPV6DestinationAddress>\n"
+							"<IPV6TrafficClass><TrfClsValue>3</TrfClsValue><TrfClsMask>7</TrfClsMask></IPV6TrafficClass>\n"
+							"<IPV6NextHeaderProtocol>17</IPV6NextHeaderProtocol>\n",
+							cnt + 1);
+		}
+		fprintf(fp, "<%sSource><%sSourcePort>%u</%sSourcePort><%sSourceRange>0</%sSourceRange></%sSource>\n"
+						"<%sDestination><%sDestinationPort>%u</%sDestinationPort>"
+						"<%sDestinationRange>9</%sDestinationRange></%sDestination>\n"
+						"</Firewall>\n",
+						port, port, 1024 + cnt, port, port, port, port,
+						port, port, 2048 + cnt, port, port, port, port);
+	}
+	fprintf(fp, "</MobileAPFirewallCfg></system>\n");
+
+	return fclose(fp);
+}
+
+static uint64_t bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Best of iters parses of one file, -1 if it does not parse */
+static int bench_parse(FILE *out, const char *name, char *path, bool firewall, uint32_t iters)
+{
+	static IPACM_firewall_conf_t fw_conf;
+	static IPACM_conf_t conf;
+	uint64_t start, ns, best = 0;
+	uint32_t cnt;
+	int ret = 0;
+
+	bench_heap_peak = bench_heap_used;
+	for(cnt = 0; cnt < iters; cnt++)
+	{
+		start = bench_now();
+		if(firewall)
+		{
+			memset(&fw_conf, 0, sizeof(fw_conf));
+			ret = IPACM_read_firewall_xml(path, &fw_conf);
+		}
+		else
+		{
+			memset(&conf, 0, sizeof(conf));
+			ret = ipacm_read_cfg_xml(path, &conf);
+		}
+		ns = bench_now() - start;
+		if(ret != IPACM_SUCCESS)
+		{
+			fprintf(out, "%-16s unable to parse %s\n", name, path);
+			return -1;
+		}
+		if(cnt == 0 || ns < best)
+		{
+			best = ns;
+		}
+	}
+
+	fprintf(out, "%-16s %9u %9llu %9zu\n", name,
+					firewall ? (uint32_t)fw_conf.num_extd_firewall_entries : (uint32_t)conf.iface_config.num_iface_entries,
+					(unsigned long long)(best / 1000), bench_heap_peak - bench_heap_used);
+	return 0;
+}
+
+static void bench_usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-c IPACM_cfg.xml] [-i iterations] [-r rules]...\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t rules[XML_BENCH_MAX_RULES] = { 10, 100, 1000 };
+	uint32_t num_rules = 3, iters = XML_BENCH_DEF_ITERS, cnt;
+	char cfg_file[IPA_MAX_FILE_LEN] = XML_BENCH_CFG_FILE;
+	char fw_file[IPA_MAX_FILE_LEN];
+	const char *tmp_dir;
+	char name[32];
+	bool user_rules = false;
+	FILE *out;
+	int opt, fd, ret = 0;
+
+	while((opt = getopt(argc, argv, "c:i:r:h")) != -1)
+	{
+		switch(opt)
+		{
+		case 'c':
+			strlcpy(cfg_file, optarg, sizeof(cfg_file));
+			break;
+		case 'i':
+			iters = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			if(user_rules == false)
+			{
+				num_rules = 0;
+				user_rules = true;
+			}
+			if(num_rules == XML_BENCH_MAX_RULES)
+			{
+				bench_usage(argv[0]);
+				return 1;
+			}
+			rules[num_rules++] = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			bench_usage(argv[0]);
+			return 1;
+		}
+	}
+	if(iters == 0)
+	{
+		bench_usage(argv[0]);
+		return 1;
+	}
+
+	if(xmlMemSetup(bench_xml_free, bench_xml_malloc, bench_xml_realloc, bench_xml_strdup) != 0)
+	{
+		fprintf(stderr, "unable to hook the libxml2 allocator\n");
+		return 1;
+	}
+
+	tmp_dir = getenv("TMPDIR");
+	snprintf(fw_file, sizeof(fw_file), "%s/ipacm_fw_XXXXXX",
+					 (tmp_dir != NULL) ? tmp_dir : XML_BENCH_TMP_DIR);
+	fd = mkstemp(fw_file);
+	if(fd < 0)
+	{
+		fprintf(stderr, "unable to create %s\n", fw_file);
+		return 1;
+	}
+	close(fd);
+
+	/* keep the readers' debug printf out of the report */
+	out = stderr;
+	if(freopen("/dev/null", "w", stdout) == NULL)
+	{
+		fprintf(out, "unable to redirect stdout\n");
+		unlink(fw_file);
+		return 1;
+	}
+
+	fprintf(out, "best of %u parses\n", iters);
+	fprintf(out, "%-16s %9s %9s %9s\n", "file", "entries", "us", "heap");
+	if(bench_parse(out, "IPACM_cfg.xml", cfg_file, false, iters) != 0)
+	{
+		ret = 1;
+	}
+
+	for(cnt = 0; cnt < num_rules; cnt++)
+	{
+		if(bench_write_firewall(fw_file, rules[cnt]) != 0)
+		{
+			fprintf(out, "unable to write %s\n", fw_file);
+			ret = 1;
+			break;
+		}
+		snprintf(name, sizeof(name), "firewall %u", rules[cnt]);
+		if(bench_parse(out, name, fw_file, true, iters) != 0)
+		{
+			ret = 1;
+		}
+	}
+
+	unlink(fw_file);
+	return ret;
+}
@@ -98,6 +98,38 @@ int ipa_nat_add_ipv4_rule(uint32_t table_handle,
 int ipa_nat_del_ipv4_rule(uint32_t table_handle,
 				uint32_t rule_handle);
 
+/**
+ * ipa_nat_add_ipv4_rules() - to insert several ipv4 rules
+ * @table_handle: [in] handle of ipv4 nat table
+ * @rules: [in] array of new rules
+ * @num_rules: [in] number of rules in array
+ * @rule_handles: [out] handle of each rule, 0 if it was not added
+ *
+ * To insert new ipv4 nat rules into ipv4 nat table with as
+ * few dma commands to hw as possible
+ *
+ * Returns:	0  On Success, negative if any rule failed
+ */
+int ipa_nat_add_ipv4_rules(uint32_t table_handle,
+				const ipa_nat_ipv4_rule *rules,
+				uint32_t num_rules,
+				uint32_t *rule_handles);
+
+/**
+ * ipa_nat_del_ipv4_rules() - to delete several ipv4 nat rules
+ * @table_handle: [in] handle of ipv4 nat table
+ * @rule_handles: [in/out] ipv4 nat rule handles, reset to 0 once deleted
+ * @num_rules: [in] number of handles in array
+ *
+ * To delete ipv4 nat rules from ipv4 nat table with as
+ * few dma commands to hw as possible
+ *
+ * Returns:	0  On Success, negative if any rule failed
+ */
+int ipa_nat_del_ipv4_rules(uint32_t table_handle,
+				uint32_t *rule_handles,
+				uint32_t num_rules);
+
 
 /**
  * ipa_nat_query_timestamp() - to query timestamp
@@ -114,3 +146,54 @@ int ipa_nat_query_timestamp(uint32_t  table_handle,
 				uint32_t  rule_handle,
 				uint32_t  *time_stamp);
 
+
+#define IPA_NAT_CHAIN_HIST_BUCKETS 8
+
+/**
+ * struct ipa_nat_ipv4_tbl_stats - occupancy of an ipv4 nat table
+ * @table_entries: number of base (and index) table entries
+ * @expn_table_entries: number of expansion table entries
+ * @base_used: active base table entries
+ * @expn_used: active expansion table entries
+ * @index_used: active index table entries
+ * @index_expn_used: active index expansion table entries
+ * @max_chain: longest chain walked from a base table bucket
+ * @max_index_chain: longest chain walked from an index table bucket
+ * @chain_hist: number of base table buckets per chain length, the
+ *	last bucket also counts all longer chains
+ * @index_chain_hist: same as chain_hist, for the index table
+ * @dma_cmds: IPA_IOC_NAT_DMA commands posted for the table
+ * @dma_entries: dma entries carried by those commands
+ * @dma_cmd_allocs: dma commands that had to be allocated because
+ *	the preallocated one was in use, stays 0 in steady state
+ */
+typedef struct {
+	uint16_t table_entries;
+	uint16_t expn_table_entries;
+	uint16_t base_used;
+	uint16_t expn_used;
+	uint16_t index_used;
+	uint16_t index_expn_used;
+	uint16_t max_chain;
+	uint16_t max_index_chain;
+	uint32_t chain_hist[IPA_NAT_CHAIN_HIST_BUCKETS];
+	uint32_t index_chain_hist[IPA_NAT_CHAIN_HIST_BUCKETS];
+	uint32_t dma_cmds;
+	uint32_t dma_entries;
+	uint32_t dma_cmd_allocs;
+} ipa_nat_ipv4_tbl_stats;
+
+/**
+ * ipa_nat_query_ipv4_tbl_stats() - to query table occupancy
+ * @table_handle: [in] handle of ipv4 nat table
+ * @stats: [out] occupancy and chain length histogram
+ *
+ * To retrieve how full the base and expansion tables are
+ * and how long the collision chains have grown, for
+ * sizing the nat tables
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_query_ipv4_tbl_stats(uint32_t table_handle,
+				ipa_nat_ipv4_tbl_stats *stats);
+
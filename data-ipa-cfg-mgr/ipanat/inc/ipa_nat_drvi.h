@@ -49,6 +49,35 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define NAT_MMAP_MEM_SIZE (2 * 1024UL * 1024UL - 1)
 #endif
 
+#ifdef IPA_NAT_SIM
+/* Host builds: /dev/ipa, the nat table device, its mmap and the
+	 dma commands are emulated in memory by ipa_nat_sim.c */
+int ipa_nat_sim_open(const char *path, int flags);
+int ipa_nat_sim_close(int fd);
+int ipa_nat_sim_ioctl(int fd, unsigned long req, void *arg);
+void *ipa_nat_sim_mmap(void *addr, size_t len, int prot, int flags,
+				int fd, off_t offset);
+int ipa_nat_sim_munmap(void *addr, size_t len);
+
+#define IPA_NAT_OPEN    ipa_nat_sim_open
+#define IPA_NAT_CLOSE   ipa_nat_sim_close
+#define IPA_NAT_IOCTL   ipa_nat_sim_ioctl
+#define IPA_NAT_MMAP    ipa_nat_sim_mmap
+#define IPA_NAT_MUNMAP  ipa_nat_sim_munmap
+
+#if !defined(__BIONIC__) && !defined(USE_GLIB)
+/* glibc hosts have no strlcpy */
+size_t ipa_nat_sim_strlcpy(char *dst, const char *src, size_t size);
+#define strlcpy ipa_nat_sim_strlcpy
+#endif
+#else
+#define IPA_NAT_OPEN    open
+#define IPA_NAT_CLOSE   close
+#define IPA_NAT_IOCTL   ioctl
+#define IPA_NAT_MMAP    mmap
+#define IPA_NAT_MUNMAP  munmap
+#endif
+
 #define IPA_DEV_NAME       "/dev/ipa"
 #define NAT_DEV_DIR        "/dev"
 #define NAT_DEV_NAME       "ipaNatTable"
@@ -86,6 +115,16 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define INDX_TBL_ENTRY_SIZE_IN_BITS  16
 
+/* Max dma entries posted in one IPA_IOC_NAT_DMA command
+   (entries field of ipa_ioc_nat_dma_cmd is 8 bits wide) */
+#define IPA_NAT_MAX_DMA_ENTRIES_PER_CMD  64
+/* Max dma entries generated by a single rule add/delete */
+#define IPA_NAT_MAX_DMA_ENTRIES_PER_RULE 3
+/* Size of a dma command holding the most entries we ever post */
+#define IPA_NAT_DMA_CMD_SIZE \
+	(sizeof(struct ipa_ioc_nat_dma_cmd) + \
+	 (IPA_NAT_MAX_DMA_ENTRIES_PER_CMD * sizeof(struct ipa_ioc_nat_dma_one)))
+
 /* ----------- Rule id -----------------------
 
    ------------------------------------------------
@@ -313,6 +352,13 @@ struct ipa_nat_ip4_table_cache {
 	struct ipa_nat_indx_tbl_meta_info *index_expn_table_meta;
 
 	uint16_t *rule_id_array;
+
+	/* dma command reused by every add/delete on this table */
+	struct ipa_ioc_nat_dma_cmd *dma_cmd;
+	uint8_t dma_cmd_busy;
+	uint32_t dma_cmds;
+	uint32_t dma_entries;
+	uint32_t dma_cmd_allocs;
 #ifdef IPA_ON_R3PC
 	uint32_t mmap_offset;
 #endif
@@ -337,6 +383,32 @@ typedef enum {
 	IPA_NAT_DEL_TYPE_LAST,
 } del_type;
 
+/* State carried from building the delete dma commands
+   to the sw table update done once the dma is posted */
+struct ipa_nat_del_ctx {
+	struct ipa_nat_ip4_table_cache *cache_ptr;
+	struct ipa_nat_rule *tbl_ptr;
+	struct ipa_nat_indx_tbl_rule *indx_tbl_ptr;
+	uint16_t cur_tbl_entry;
+	del_type rule_pos;
+	uint16_t indx_tbl_entry;
+	del_type indx_rule_pos;
+	uint16_t indx_next_entry;
+};
+
+/* Pending dma commands of a batched add/delete along with
+   the hash buckets they touch, used to detect chain conflicts */
+struct ipa_nat_dma_batch {
+	struct ipa_ioc_nat_dma_cmd *cmd;
+	uint8_t tbl_indx;
+	uint8_t expn_pending;
+	uint16_t num_rules;
+	uint16_t dst_bucket[IPA_NAT_MAX_DMA_ENTRIES_PER_CMD];
+	uint16_t src_bucket[IPA_NAT_MAX_DMA_ENTRIES_PER_CMD];
+	uint16_t tbl_entry[IPA_NAT_MAX_DMA_ENTRIES_PER_CMD];
+	uint32_t rule_indx[IPA_NAT_MAX_DMA_ENTRIES_PER_CMD];
+};
+
 /**
  * ipa_nati_parse_ipv4_rule_hdl() - prase rule handle
  * @tbl_hdl:	[in] nat table rule
@@ -398,10 +470,18 @@ int ipa_nati_query_timestamp(uint32_t  tbl_hdl,
 				uint32_t  rule_hdl,
 				uint32_t  *time_stamp);
 
+int ipa_nati_query_ipv4_tbl_stats(uint32_t tbl_hdl,
+				ipa_nat_ipv4_tbl_stats *stats);
+
 int ipa_nati_add_ipv4_rule(uint32_t tbl_hdl,
 				const ipa_nat_ipv4_rule *clnt_rule,
 				uint32_t *rule_hdl);
 
+int ipa_nati_add_ipv4_rules(uint32_t tbl_hdl,
+				const ipa_nat_ipv4_rule *clnt_rules,
+				uint32_t num_rules,
+				uint32_t *rule_hdls);
+
 int ipa_nati_generate_rule(uint32_t tbl_hdl,
 				const ipa_nat_ipv4_rule *clnt_rule,
 				struct ipa_nat_sw_rule *rule,
@@ -426,17 +506,24 @@ uint16_t ipa_nati_index_expn_get_free_entry(struct ipa_nat_indx_tbl_rule *tbl,
 void ipa_nati_copy_ipv4_rule_to_hw(
 				struct ipa_nat_ip4_table_cache *ipv4_cache,
 				struct ipa_nat_sw_rule *rule,
-				uint16_t entry, uint8_t tbl_index);
+				uint16_t entry, uint8_t tbl_index,
+				struct ipa_ioc_nat_dma_cmd *batch);
 
 void ipa_nati_copy_ipv4_index_rule_to_hw(
 				struct ipa_nat_ip4_table_cache *ipv4_cache,
 				struct ipa_nat_indx_tbl_sw_rule *indx_sw_rule,
-				uint16_t entry, uint8_t tbl_index);
+				uint16_t entry, uint8_t tbl_index,
+				struct ipa_ioc_nat_dma_cmd *batch);
 
 void ipa_nati_write_next_index(uint8_t tbl_indx,
 				nat_table_type tbl_type,
 				uint16_t value,
-				uint32_t offset);
+				uint32_t offset,
+				struct ipa_ioc_nat_dma_cmd *batch);
+
+void ipa_nati_gen_enable_dma_cmd(uint8_t tbl_indx,
+				uint16_t entry,
+				struct ipa_ioc_nat_dma_one *dma);
 
 int ipa_nati_post_ipv4_dma_cmd(uint8_t tbl_indx,
 				uint16_t entry);
@@ -444,11 +531,24 @@ int ipa_nati_post_ipv4_dma_cmd(uint8_t tbl_indx,
 int ipa_nati_del_ipv4_rule(uint32_t tbl_hdl,
 				uint32_t rule_hdl);
 
+int ipa_nati_del_ipv4_rules(uint32_t tbl_hdl,
+				uint32_t *rule_hdls,
+				uint32_t num_rules);
+
 int ipa_nati_post_del_dma_cmd(uint8_t tbl_indx,
 				uint16_t tbl_entry,
 				uint8_t expn_tbl,
 				del_type rule_pos);
 
+int ipa_nati_gen_del_dma_cmd(uint8_t tbl_indx,
+				uint16_t tbl_entry,
+				uint8_t expn_tbl,
+				del_type rule_pos,
+				struct ipa_ioc_nat_dma_cmd *cmd,
+				struct ipa_nat_del_ctx *ctx);
+
+void ipa_nati_update_del_sw_rules(struct ipa_nat_del_ctx *ctx);
+
 void ipa_nati_find_index_rule_pos(
 				struct ipa_nat_ip4_table_cache *cache_ptr,
 				uint16_t tbl_entry,
@@ -1,8 +1,8 @@
+LOCAL_PATH := $(call my-dir)
+
 ifneq (,$(filter $(QCOM_BOARD_PLATFORMS),$(TARGET_BOARD_PLATFORM)))
 ifneq (, $(filter aarch64 arm arm64, $(TARGET_ARCH)))
 
-LOCAL_PATH := $(call my-dir)
-
 include $(CLEAR_VARS)
 
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/../inc
@@ -10,7 +10,8 @@ LOCAL_C_INCLUDES += $(LOCAL_PATH)
 LOCAL_HEADER_LIBRARIES := generated_kernel_headers
 
 LOCAL_SRC_FILES := ipa_nat_drv.c \
-                   ipa_nat_drvi.c
+                   ipa_nat_drvi.c \
+                   ipa_nat_sim.c
 
 LOCAL_MODULE_PATH_64 := $(TARGET_OUT_VENDOR)/lib64
 LOCAL_MODULE_PATH_32 := $(TARGET_OUT_VENDOR)/lib
@@ -26,3 +27,27 @@ include $(BUILD_SHARED_LIBRARY)
 
 endif # $(TARGET_ARCH)
 endif
+
+# Host replay benchmark: the nat table code against the simulated device.
+# Kept out of the target guards, it only needs the nat subset of the IPA
+# UAPI that is checked in under inc/sim.
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../inc
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../inc/sim
+LOCAL_C_INCLUDES += $(LOCAL_PATH)
+
+LOCAL_SRC_FILES := ipa_nat_drv.c \
+                   ipa_nat_drvi.c \
+                   ipa_nat_sim.c \
+                   ipa_nat_logi.c \
+                   ipa_nat_sim_replay.c
+
+LOCAL_CFLAGS := -DIPA_NAT_SIM
+LOCAL_CFLAGS += \
+    -Wno-unused-parameter
+
+LOCAL_MODULE := ipanat_sim_replay
+LOCAL_MODULE_HOST_OS := linux
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_HOST_EXECUTABLE)
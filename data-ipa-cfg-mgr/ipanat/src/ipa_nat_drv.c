@@ -146,6 +146,59 @@ int ipa_nat_del_ipv4_rule(uint32_t tbl_hdl,
   return 0;
 }
 
+/**
+ * ipa_nat_add_ipv4_rules() - to insert several ipv4 rules
+ * @table_handle: [in] handle of ipv4 nat table
+ * @rules: [in] array of new rules
+ * @num_rules: [in] number of rules in array
+ * @rule_handles: [out] handle of each rule, 0 if it was not added
+ *
+ * To insert new ipv4 nat rules into ipv4 nat table with as
+ * few dma commands to hw as possible
+ *
+ * Returns:	0  On Success, negative if any rule failed
+ */
+int ipa_nat_add_ipv4_rules(uint32_t tbl_hdl,
+		const ipa_nat_ipv4_rule *clnt_rules,
+		uint32_t num_rules,
+		uint32_t *rule_hdls)
+{
+  if (IPA_NAT_INVALID_NAT_ENTRY == tbl_hdl ||
+      tbl_hdl > IPA_NAT_MAX_IP4_TBLS || NULL == rule_hdls ||
+      NULL == clnt_rules) {
+    IPAERR("invalid parameters\n");
+    return -EINVAL;
+  }
+  IPADBG("Passed Table handle: 0x%x, %d rules\n", tbl_hdl, num_rules);
+
+  return ipa_nati_add_ipv4_rules(tbl_hdl, clnt_rules, num_rules, rule_hdls);
+}
+
+/**
+ * ipa_nat_del_ipv4_rules() - to delete several ipv4 nat rules
+ * @table_handle: [in] handle of ipv4 nat table
+ * @rule_handles: [in/out] ipv4 nat rule handles, reset to 0 once deleted
+ * @num_rules: [in] number of handles in array
+ *
+ * To delete ipv4 nat rules from ipv4 nat table with as
+ * few dma commands to hw as possible
+ *
+ * Returns:	0  On Success, negative if any rule failed
+ */
+int ipa_nat_del_ipv4_rules(uint32_t tbl_hdl,
+		uint32_t *rule_hdls,
+		uint32_t num_rules)
+{
+  if (IPA_NAT_INVALID_NAT_ENTRY == tbl_hdl ||
+      tbl_hdl > IPA_NAT_MAX_IP4_TBLS || NULL == rule_hdls) {
+    IPAERR("invalid parameters\n");
+    return -EINVAL;
+  }
+  IPADBG("Passed Table handle: 0x%x, %d rules\n", tbl_hdl, num_rules);
+
+  return ipa_nati_del_ipv4_rules(tbl_hdl, rule_hdls, num_rules);
+}
+
 /**
  * ipa_nat_query_timestamp() - to query timestamp
  * @table_handle: [in] handle of ipv4 nat table
@@ -172,4 +225,27 @@ int ipa_nat_query_timestamp(uint32_t  tbl_hdl,
   return ipa_nati_query_timestamp(tbl_hdl, rule_hdl, time_stamp);
 }
 
+/**
+ * ipa_nat_query_ipv4_tbl_stats() - to query table occupancy
+ * @table_handle: [in] handle of ipv4 nat table
+ * @stats: [out] occupancy and chain length histogram
+ *
+ * To retrieve how full the base and expansion tables are
+ * and how long the collision chains have grown, for
+ * sizing the nat tables
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_query_ipv4_tbl_stats(uint32_t tbl_hdl,
+		ipa_nat_ipv4_tbl_stats *stats)
+{
+  if (IPA_NAT_INVALID_NAT_ENTRY == tbl_hdl ||
+      tbl_hdl > IPA_NAT_MAX_IP4_TBLS || NULL == stats) {
+    IPAERR("invalid parameters passed \n");
+    return -EINVAL;
+  }
+  IPADBG("Passed Table: 0x%x\n", tbl_hdl);
+
+  return ipa_nati_query_ipv4_tbl_stats(tbl_hdl, stats);
+}
 
@@ -167,7 +167,7 @@ int CreateNatDevice(struct ipa_ioc_nat_alloc_mem *mem)
 {
 	int ret;
 
-	ret = ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_ALLOC_NAT_MEM, mem);
+	ret = IPA_NAT_IOCTL(ipv4_nat_cache.ipa_fd, IPA_IOC_ALLOC_NAT_MEM, mem);
 	if (ret != 0) {
 		perror("CreateNatDevice(): ioctl error value");
 		IPAERR("unable to post nat mem init. Error ;%d\n", ret);
@@ -583,6 +583,73 @@ uint32_t ipa_nati_get_index_entry_offset(struct ipa_nat_ip4_table_cache *cache_p
 	return ret;
 }
 
+/**
+ * ipa_nati_get_dma_cmd() - Get an empty dma command
+ * @tbl_indx: [in] nat table index
+ *
+ * Hands out the dma command preallocated for the table, big
+ * enough for IPA_NAT_MAX_DMA_ENTRIES_PER_CMD entries. A command
+ * of the same size is only allocated while that one is in use
+ *
+ * Returns: command with no entries, NULL on failure
+ */
+static struct ipa_ioc_nat_dma_cmd *ipa_nati_get_dma_cmd(uint8_t tbl_indx)
+{
+	struct ipa_nat_ip4_table_cache *cache_ptr = &ipv4_nat_cache.ip4_tbl[tbl_indx];
+	struct ipa_ioc_nat_dma_cmd *cmd;
+
+	if (NULL != cache_ptr->dma_cmd && !cache_ptr->dma_cmd_busy) {
+		cache_ptr->dma_cmd_busy = 1;
+		cmd = cache_ptr->dma_cmd;
+	} else {
+		cmd = (struct ipa_ioc_nat_dma_cmd *)malloc(IPA_NAT_DMA_CMD_SIZE);
+		if (NULL == cmd) {
+			IPAERR("unable to allocate memory\n");
+			return NULL;
+		}
+		cache_ptr->dma_cmd_allocs++;
+	}
+
+	cmd->entries = 0;
+	return cmd;
+}
+
+/**
+ * ipa_nati_put_dma_cmd() - Release a dma command
+ * @tbl_indx: [in] nat table index
+ * @cmd: [in] command from ipa_nati_get_dma_cmd()
+ *
+ * Returns: None
+ */
+static void ipa_nati_put_dma_cmd(uint8_t tbl_indx,
+				struct ipa_ioc_nat_dma_cmd *cmd)
+{
+	struct ipa_nat_ip4_table_cache *cache_ptr = &ipv4_nat_cache.ip4_tbl[tbl_indx];
+
+	if (cmd == cache_ptr->dma_cmd) {
+		cache_ptr->dma_cmd_busy = 0;
+	} else {
+		free(cmd);
+	}
+}
+
+/**
+ * ipa_nati_post_dma_cmd() - Post a dma command to the kernel
+ * @tbl_indx: [in] nat table index
+ * @cmd: [in] command to post
+ *
+ * Returns: result of the IPA_IOC_NAT_DMA ioctl
+ */
+static int ipa_nati_post_dma_cmd(uint8_t tbl_indx,
+				struct ipa_ioc_nat_dma_cmd *cmd)
+{
+	struct ipa_nat_ip4_table_cache *cache_ptr = &ipv4_nat_cache.ip4_tbl[tbl_indx];
+
+	cache_ptr->dma_cmds++;
+	cache_ptr->dma_entries += cmd->entries;
+	return IPA_NAT_IOCTL(ipv4_nat_cache.ipa_fd, IPA_IOC_NAT_DMA, cmd);
+}
+
 /* ------------------------------------------
 		UTILITY FUNCTIONS END
 --------------------------------------------*/
@@ -718,7 +785,7 @@ int ipa_nati_alloc_table(uint16_t number_of_entries,
 	IPADBG("Nat Base and Index Table size: %d\n", mem->size);
 
 	if (!ipv4_nat_cache.ipa_fd) {
-		fd = open(IPA_DEV_NAME, O_RDONLY);
+		fd = IPA_NAT_OPEN(IPA_DEV_NAME, O_RDONLY);
 		if (fd < 0) {
 			perror("ipa_nati_alloc_table(): open error value:");
 			IPAERR("unable to open ipa device\n");
@@ -790,10 +857,22 @@ int ipa_nati_update_cache(struct ipa_ioc_nat_alloc_mem *mem,
 					 sizeof(uint16_t) * (tbl_entries + expn_tbl_entries));
 	}
 
+	/* Allocate the dma command reused by rule add/delete */
+	if (NULL == ipv4_nat_cache.ip4_tbl[index].dma_cmd) {
+		ipv4_nat_cache.ip4_tbl[index].dma_cmd =
+			 (struct ipa_ioc_nat_dma_cmd *)malloc(IPA_NAT_DMA_CMD_SIZE);
+
+		if (NULL == ipv4_nat_cache.ip4_tbl[index].dma_cmd) {
+			IPAERR("Fail to allocate dma command\n");
+			return -ENOMEM;
+		}
+		ipv4_nat_cache.ip4_tbl[index].dma_cmd_busy = 0;
+	}
+
 
 	/* open the nat table */
 	strlcpy(mem->dev_name, NAT_DEV_FULL_NAME, IPA_RESOURCE_NAME_MAX);
-	fd = open(mem->dev_name, O_RDWR);
+	fd = IPA_NAT_OPEN(mem->dev_name, O_RDWR);
 	if (fd < 0) {
 		perror("ipa_nati_update_cache(): open error value:");
 		IPAERR("unable to open nat device. Error:%d\n", fd);
@@ -808,12 +887,12 @@ int ipa_nati_update_cache(struct ipa_ioc_nat_alloc_mem *mem,
 
 	/* open the nat device Table */
 #ifndef IPA_ON_R3PC
-	ipv4_rules_addr = (void *)mmap(NULL, mem->size,
+	ipv4_rules_addr = (void *)IPA_NAT_MMAP(NULL, mem->size,
 																 prot, flags,
 																 fd, offset);
 #else
 	IPADBG("user space r3pc\n");
-	ipv4_rules_addr = (void *)mmap((caddr_t)0, NAT_MMAP_MEM_SIZE,
+	ipv4_rules_addr = (void *)IPA_NAT_MMAP((caddr_t)0, NAT_MMAP_MEM_SIZE,
 																 prot, flags,
 																 fd, offset);
 #endif
@@ -823,7 +902,7 @@ int ipa_nati_update_cache(struct ipa_ioc_nat_alloc_mem *mem,
 	}
 
 #ifdef IPA_ON_R3PC
-	ret = ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_GET_NAT_OFFSET, &nat_mem_offset);
+	ret = IPA_NAT_IOCTL(ipv4_nat_cache.ipa_fd, IPA_IOC_GET_NAT_OFFSET, &nat_mem_offset);
 	if (ret != 0) {
 		perror("ipa_nati_post_ipv4_init_cmd(): ioctl error value");
 		IPAERR("unable to post ant offset cmd Error: %d\n", ret);
@@ -877,7 +956,7 @@ int ipa_nati_post_ipv4_init_cmd(uint8_t tbl_index)
 
 	cmd.ip_addr = ipv4_nat_cache.ip4_tbl[tbl_index].public_addr;
 
-	ret = ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_V4_INIT_NAT, &cmd);
+	ret = IPA_NAT_IOCTL(ipv4_nat_cache.ipa_fd, IPA_IOC_V4_INIT_NAT, &cmd);
 	if (ret != 0) {
 		perror("ipa_nati_post_ipv4_init_cmd(): ioctl error value");
 		IPAERR("unable to post init cmd Error: %d\n", ret);
@@ -903,21 +982,21 @@ int ipa_nati_del_ipv4_table(uint32_t tbl_hdl)
 
 	/* unmap the device memory from user space */
 #ifndef IPA_ON_R3PC
-	munmap(addr, ipv4_nat_cache.ip4_tbl[index].size);
+	IPA_NAT_MUNMAP(addr, ipv4_nat_cache.ip4_tbl[index].size);
 #else
 	addr = (char *)addr - ipv4_nat_cache.ip4_tbl[index].mmap_offset;
-	munmap(addr, NAT_MMAP_MEM_SIZE);
+	IPA_NAT_MUNMAP(addr, NAT_MMAP_MEM_SIZE);
 #endif
 
 	/* close the file descriptor of nat device */
-	if (close(ipv4_nat_cache.ip4_tbl[index].nat_fd)) {
+	if (IPA_NAT_CLOSE(ipv4_nat_cache.ip4_tbl[index].nat_fd)) {
 		IPAERR("unable to close the file descriptor\n");
 		return -EINVAL;
 	}
 
 	del_cmd.table_index = index;
 	del_cmd.public_ip_addr = ipv4_nat_cache.ip4_tbl[index].public_addr;
-	ret = ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_V4_DEL_NAT, &del_cmd);
+	ret = IPA_NAT_IOCTL(ipv4_nat_cache.ipa_fd, IPA_IOC_V4_DEL_NAT, &del_cmd);
 	if (ret != 0) {
 		perror("ipa_nati_del_ipv4_table(): ioctl error value");
 		IPAERR("unable to post nat del command init Error: %d\n", ret);
@@ -928,6 +1007,7 @@ int ipa_nati_del_ipv4_table(uint32_t tbl_hdl)
 
 	free(ipv4_nat_cache.ip4_tbl[index].index_expn_table_meta);
 	free(ipv4_nat_cache.ip4_tbl[index].rule_id_array);
+	free(ipv4_nat_cache.ip4_tbl[index].dma_cmd);
 
 	memset(&ipv4_nat_cache.ip4_tbl[index],
 				 0,
@@ -968,6 +1048,162 @@ int ipa_nati_query_timestamp(uint32_t  tbl_hdl,
 	return 0;
 }
 
+/**
+ * ipa_nati_rule_chain_len() - Length of a base table chain
+ * @cache_ptr: [in] ipv4 table cache
+ * @entry: [in] base table bucket
+ *
+ * Counts the entries a lookup hashing to @entry has to walk,
+ * the head (even a dead one kept for its next index) and every
+ * expansion table entry linked behind it
+ *
+ * Returns: chain length, 0 for an unused bucket
+ */
+static uint16_t ipa_nati_rule_chain_len(struct ipa_nat_ip4_table_cache *cache_ptr,
+				uint16_t entry)
+{
+	struct ipa_nat_rule *tbl, *expn_tbl;
+	uint16_t nxt_indx, len = 0;
+
+	tbl = (struct ipa_nat_rule *)cache_ptr->ipv4_rules_addr;
+	expn_tbl = (struct ipa_nat_rule *)cache_ptr->ipv4_expn_rules_addr;
+
+	nxt_indx = Read16BitFieldValue(tbl[entry].nxt_indx_pub_port,
+																 NEXT_INDEX_FIELD);
+	if (!Read16BitFieldValue(tbl[entry].ip_cksm_enbl, ENABLE_FIELD) &&
+			nxt_indx == IPA_NAT_INVALID_NAT_ENTRY) {
+		return 0;
+	}
+
+	for (len = 1; nxt_indx != IPA_NAT_INVALID_NAT_ENTRY; len++) {
+		if (nxt_indx < cache_ptr->table_entries ||
+				len > cache_ptr->expn_table_entries) {
+			IPAERR("broken chain at bucket %d, next index %d\n", entry, nxt_indx);
+			break;
+		}
+		nxt_indx = Read16BitFieldValue(
+			 expn_tbl[nxt_indx - cache_ptr->table_entries].nxt_indx_pub_port,
+			 NEXT_INDEX_FIELD);
+	}
+
+	return len;
+}
+
+/**
+ * ipa_nati_index_chain_len() - Length of an index table chain
+ * @cache_ptr: [in] ipv4 table cache
+ * @entry: [in] index table bucket
+ *
+ * Same as ipa_nati_rule_chain_len() for the index table
+ * and its expansion table
+ *
+ * Returns: chain length, 0 for an unused bucket
+ */
+static uint16_t ipa_nati_index_chain_len(struct ipa_nat_ip4_table_cache *cache_ptr,
+				uint16_t entry)
+{
+	struct ipa_nat_indx_tbl_rule *indx_tbl, *indx_expn_tbl;
+	uint16_t nxt_indx, len = 0;
+
+	indx_tbl = (struct ipa_nat_indx_tbl_rule *)cache_ptr->index_table_addr;
+	indx_expn_tbl =
+		 (struct ipa_nat_indx_tbl_rule *)cache_ptr->index_table_expn_addr;
+
+	nxt_indx = Read16BitFieldValue(indx_tbl[entry].tbl_entry_nxt_indx,
+																 INDX_TBL_NEXT_INDEX_FILED);
+	if (!Read16BitFieldValue(indx_tbl[entry].tbl_entry_nxt_indx,
+													 INDX_TBL_TBL_ENTRY_FIELD) &&
+			nxt_indx == IPA_NAT_INVALID_NAT_ENTRY) {
+		return 0;
+	}
+
+	for (len = 1; nxt_indx != IPA_NAT_INVALID_NAT_ENTRY; len++) {
+		if (nxt_indx < cache_ptr->table_entries ||
+				len > cache_ptr->expn_table_entries) {
+			IPAERR("broken index chain at bucket %d, next index %d\n",
+						 entry, nxt_indx);
+			break;
+		}
+		nxt_indx = Read16BitFieldValue(
+			 indx_expn_tbl[nxt_indx - cache_ptr->table_entries].tbl_entry_nxt_indx,
+			 INDX_TBL_NEXT_INDEX_FILED);
+	}
+
+	return len;
+}
+
+int ipa_nati_query_ipv4_tbl_stats(uint32_t tbl_hdl,
+				ipa_nat_ipv4_tbl_stats *stats)
+{
+	struct ipa_nat_ip4_table_cache *cache_ptr;
+	struct ipa_nat_rule *tbl_ptr;
+	struct ipa_nat_indx_tbl_rule *indx_tbl_ptr;
+	uint16_t cnt, len;
+
+	cache_ptr = &ipv4_nat_cache.ip4_tbl[tbl_hdl - 1];
+	if (!cache_ptr->valid) {
+		IPAERR("invalid table handle\n");
+		return -EINVAL;
+	}
+
+	memset(stats, 0, sizeof(ipa_nat_ipv4_tbl_stats));
+	stats->table_entries = cache_ptr->table_entries;
+	stats->expn_table_entries = cache_ptr->expn_table_entries;
+	stats->dma_cmds = cache_ptr->dma_cmds;
+	stats->dma_entries = cache_ptr->dma_entries;
+	stats->dma_cmd_allocs = cache_ptr->dma_cmd_allocs;
+
+	/* Entry 0 is never used, hashes of zero go to the last bucket */
+	tbl_ptr = (struct ipa_nat_rule *)cache_ptr->ipv4_rules_addr;
+	indx_tbl_ptr = (struct ipa_nat_indx_tbl_rule *)cache_ptr->index_table_addr;
+	for (cnt = 1; cnt < cache_ptr->table_entries; cnt++) {
+		if (Read16BitFieldValue(tbl_ptr[cnt].ip_cksm_enbl, ENABLE_FIELD)) {
+			stats->base_used++;
+		}
+		if (Read16BitFieldValue(indx_tbl_ptr[cnt].tbl_entry_nxt_indx,
+														INDX_TBL_TBL_ENTRY_FIELD)) {
+			stats->index_used++;
+		}
+
+		len = ipa_nati_rule_chain_len(cache_ptr, cnt);
+		if (len > stats->max_chain) {
+			stats->max_chain = len;
+		}
+		if (len >= IPA_NAT_CHAIN_HIST_BUCKETS) {
+			len = IPA_NAT_CHAIN_HIST_BUCKETS - 1;
+		}
+		stats->chain_hist[len]++;
+
+		len = ipa_nati_index_chain_len(cache_ptr, cnt);
+		if (len > stats->max_index_chain) {
+			stats->max_index_chain = len;
+		}
+		if (len >= IPA_NAT_CHAIN_HIST_BUCKETS) {
+			len = IPA_NAT_CHAIN_HIST_BUCKETS - 1;
+		}
+		stats->index_chain_hist[len]++;
+	}
+
+	tbl_ptr = (struct ipa_nat_rule *)cache_ptr->ipv4_expn_rules_addr;
+	indx_tbl_ptr =
+		 (struct ipa_nat_indx_tbl_rule *)cache_ptr->index_table_expn_addr;
+	for (cnt = 1; cnt < cache_ptr->expn_table_entries; cnt++) {
+		if (Read16BitFieldValue(tbl_ptr[cnt].ip_cksm_enbl, ENABLE_FIELD)) {
+			stats->expn_used++;
+		}
+		if (Read16BitFieldValue(indx_tbl_ptr[cnt].tbl_entry_nxt_indx,
+														INDX_TBL_TBL_ENTRY_FIELD)) {
+			stats->index_expn_used++;
+		}
+	}
+
+	IPADBG("base %d/%d expn %d/%d max chain %d index max chain %d\n",
+				 stats->base_used, stats->table_entries,
+				 stats->expn_used, stats->expn_table_entries,
+				 stats->max_chain, stats->max_index_chain);
+	return 0;
+}
+
 int ipa_nati_add_ipv4_rule(uint32_t tbl_hdl,
 				const ipa_nat_ipv4_rule *clnt_rule,
 				uint32_t *rule_hdl)
@@ -989,11 +1225,13 @@ int ipa_nati_add_ipv4_rule(uint32_t tbl_hdl,
 	}
 
 	tbl_ptr = &ipv4_nat_cache.ip4_tbl[tbl_hdl-1];
-	ipa_nati_copy_ipv4_rule_to_hw(tbl_ptr, &sw_rule, new_entry, (uint8_t)(tbl_hdl-1));
+	ipa_nati_copy_ipv4_rule_to_hw(tbl_ptr, &sw_rule, new_entry,
+																(uint8_t)(tbl_hdl-1), NULL);
 	ipa_nati_copy_ipv4_index_rule_to_hw(tbl_ptr,
 																			&index_sw_rule,
 																			new_index_tbl_entry,
-																			(uint8_t)(tbl_hdl-1));
+																			(uint8_t)(tbl_hdl-1),
+																			NULL);
 
 	IPADBG("new entry:%d, new index entry: %d\n", new_entry, new_index_tbl_entry);
 	if (ipa_nati_post_ipv4_dma_cmd((uint8_t)(tbl_hdl - 1), new_entry)) {
@@ -1015,6 +1253,250 @@ int ipa_nati_add_ipv4_rule(uint32_t tbl_hdl,
 	return 0;
 }
 
+/**
+ * ipa_nati_rule_buckets() - base and index table buckets of a rule
+ * @tbl_ptr: [in] nat table
+ * @clnt_rule: [in] rule
+ * @dst_bucket: [out] dst_hash() entry into base table
+ * @src_bucket: [out] src_hash() entry into index table
+ *
+ * Two rules only ever share list links in the base or index
+ * tables if they hash to the same bucket of that table.
+ *
+ * Returns: None
+ */
+static void ipa_nati_rule_buckets(struct ipa_nat_ip4_table_cache *tbl_ptr,
+				const ipa_nat_ipv4_rule *clnt_rule,
+				uint16_t *dst_bucket,
+				uint16_t *src_bucket)
+{
+	*dst_bucket = dst_hash(clnt_rule->target_ip,
+												 clnt_rule->target_port,
+												 clnt_rule->public_port,
+												 clnt_rule->protocol,
+												 tbl_ptr->table_entries-1);
+
+	*src_bucket = src_hash(clnt_rule->private_ip,
+												 clnt_rule->private_port,
+												 clnt_rule->target_ip,
+												 clnt_rule->target_port,
+												 clnt_rule->protocol,
+												 tbl_ptr->table_entries-1);
+}
+
+/**
+ * ipa_nati_batch_conflict() - check rule against a pending batch
+ * @batch: [in] pending batch
+ * @dst_bucket: [in] base table bucket of the new rule
+ * @src_bucket: [in] index table bucket of the new rule
+ *
+ * The sw copy of a list is stale until the batch carrying its
+ * next_index/enable updates is posted, so a rule touching a list
+ * already modified by the batch has to wait for the batch to flush.
+ *
+ * Returns: 1 if the batch must be flushed first, 0 otherwise
+ */
+static int ipa_nati_batch_conflict(struct ipa_nat_dma_batch *batch,
+				uint16_t dst_bucket,
+				uint16_t src_bucket)
+{
+	int cnt;
+
+	if (batch->cmd->entries + IPA_NAT_MAX_DMA_ENTRIES_PER_RULE >
+			IPA_NAT_MAX_DMA_ENTRIES_PER_CMD) {
+		return 1;
+	}
+
+	for (cnt = 0; cnt < batch->num_rules; cnt++) {
+		if (batch->dst_bucket[cnt] == dst_bucket ||
+				batch->src_bucket[cnt] == src_bucket) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * ipa_nati_post_dma_batch() - post all pending dma commands at once
+ * @batch: [in/out] batch, emptied on return
+ *
+ * Returns: 0 on success, negative on failure
+ */
+static int ipa_nati_post_dma_batch(struct ipa_nat_dma_batch *batch)
+{
+	int ret = 0;
+
+	if (batch->cmd->entries == 0) {
+		return 0;
+	}
+
+	IPADBG("posting %d dma entries for %d rules\n",
+				 batch->cmd->entries, batch->num_rules);
+	if (ipa_nati_post_dma_cmd(batch->tbl_indx, batch->cmd)) {
+		perror("ipa_nati_post_dma_batch(): ioctl error value");
+		IPAERR("unable to post batched dma cmd\n");
+		IPADBG("ipa fd %d\n", ipv4_nat_cache.ipa_fd);
+		ret = -EIO;
+	}
+
+	batch->cmd->entries = 0;
+	return ret;
+}
+
+/**
+ * ipa_nati_alloc_dma_batch() - allocate an empty dma batch
+ * @batch: [out] batch to initialize
+ * @tbl_indx: [in] nat table index
+ *
+ * Returns: 0 on success, negative on failure
+ */
+static int ipa_nati_alloc_dma_batch(struct ipa_nat_dma_batch *batch,
+				uint8_t tbl_indx)
+{
+	memset(batch, 0, sizeof(*batch));
+	batch->tbl_indx = tbl_indx;
+
+	batch->cmd = ipa_nati_get_dma_cmd(tbl_indx);
+	if (NULL == batch->cmd) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/**
+ * ipa_nati_commit_add_batch() - post batched adds, hand out handles
+ * @batch: [in/out] pending batch, emptied on return
+ * @tbl_hdl: [in] nat table handle
+ * @rule_hdls: [out] handles of the rules in the batch
+ *
+ * Returns: 0 on success, negative on failure
+ */
+static int ipa_nati_commit_add_batch(struct ipa_nat_dma_batch *batch,
+				uint32_t tbl_hdl,
+				uint32_t *rule_hdls)
+{
+	int ret, cnt;
+	uint32_t indx;
+
+	ret = ipa_nati_post_dma_batch(batch);
+
+	for (cnt = 0; cnt < batch->num_rules && ret == 0; cnt++) {
+		indx = batch->rule_indx[cnt];
+		rule_hdls[indx] = ipa_nati_make_rule_hdl((uint16_t)tbl_hdl,
+																						 batch->tbl_entry[cnt]);
+		if (!rule_hdls[indx]) {
+			IPAERR("unable to generate rule handle\n");
+			ret = -EINVAL;
+		}
+	}
+
+	batch->num_rules = 0;
+	batch->expn_pending = 0;
+	return ret;
+}
+
+/**
+ * ipa_nati_add_ipv4_rules() - insert several rules with batched dma
+ * @tbl_hdl: [in] nat table handle
+ * @clnt_rules: [in] rules to insert
+ * @num_rules: [in] number of rules
+ * @rule_hdls: [out] per rule handle, IPA_NAT_INVALID_NAT_ENTRY on failure
+ *
+ * Same as calling ipa_nati_add_ipv4_rule() for every rule, but the
+ * next_index and enable updates of consecutive rules are coalesced
+ * into one IPA_IOC_NAT_DMA command, flushed when full or when a rule
+ * lands on a list already touched by the pending command.
+ *
+ * Returns: 0 if every rule was added, negative otherwise
+ */
+int ipa_nati_add_ipv4_rules(uint32_t tbl_hdl,
+				const ipa_nat_ipv4_rule *clnt_rules,
+				uint32_t num_rules,
+				uint32_t *rule_hdls)
+{
+	struct ipa_nat_ip4_table_cache *tbl_ptr;
+	struct ipa_nat_rule *base_tbl;
+	struct ipa_nat_sw_rule sw_rule;
+	struct ipa_nat_indx_tbl_sw_rule index_sw_rule;
+	struct ipa_nat_dma_batch batch;
+	uint16_t new_entry, new_index_tbl_entry;
+	uint16_t dst_bucket, src_bucket;
+	uint8_t tbl_indx = (uint8_t)(tbl_hdl - 1);
+	uint32_t cnt;
+	int ret = 0;
+
+	tbl_ptr = &ipv4_nat_cache.ip4_tbl[tbl_indx];
+	if (!tbl_ptr->valid) {
+		IPAERR("invalid table handle\n");
+		return -EINVAL;
+	}
+
+	if (ipa_nati_alloc_dma_batch(&batch, tbl_indx)) {
+		return -ENOMEM;
+	}
+
+	base_tbl = (struct ipa_nat_rule *)tbl_ptr->ipv4_rules_addr;
+	for (cnt = 0; cnt < num_rules; cnt++) {
+		rule_hdls[cnt] = IPA_NAT_INVALID_NAT_ENTRY;
+
+		ipa_nati_rule_buckets(tbl_ptr, &clnt_rules[cnt],
+													&dst_bucket, &src_bucket);
+
+		/* A collision takes a free expansion entry, which is only
+			 seen as used once the enable bit of a pending rule is set */
+		if (ipa_nati_batch_conflict(&batch, dst_bucket, src_bucket) ||
+				(batch.expn_pending &&
+				 Read16BitFieldValue(base_tbl[dst_bucket].ip_cksm_enbl, ENABLE_FIELD))) {
+			if (ipa_nati_commit_add_batch(&batch, tbl_hdl, rule_hdls)) {
+				ret = -EIO;
+			}
+		}
+
+		memset(&sw_rule, 0, sizeof(sw_rule));
+		memset(&index_sw_rule, 0, sizeof(index_sw_rule));
+
+		if (ipa_nati_generate_rule(tbl_hdl, &clnt_rules[cnt],
+						&sw_rule, &index_sw_rule,
+						&new_entry, &new_index_tbl_entry)) {
+			IPAERR("unable to generate rule %d\n", cnt);
+			ret = -EINVAL;
+			continue;
+		}
+
+		ipa_nati_copy_ipv4_rule_to_hw(tbl_ptr, &sw_rule, new_entry,
+																	tbl_indx, batch.cmd);
+		ipa_nati_copy_ipv4_index_rule_to_hw(tbl_ptr, &index_sw_rule,
+																				new_index_tbl_entry,
+																				tbl_indx, batch.cmd);
+		ipa_nati_gen_enable_dma_cmd(tbl_indx, new_entry,
+																&batch.cmd->dma[batch.cmd->entries]);
+		batch.cmd->entries++;
+
+		IPADBG("new entry:%d, new index entry: %d\n", new_entry, new_index_tbl_entry);
+		if (new_entry >= tbl_ptr->table_entries) {
+			batch.expn_pending = 1;
+		}
+		batch.dst_bucket[batch.num_rules] = dst_bucket;
+		batch.src_bucket[batch.num_rules] = src_bucket;
+		batch.tbl_entry[batch.num_rules] = new_entry;
+		batch.rule_indx[batch.num_rules] = cnt;
+		batch.num_rules++;
+	}
+
+	if (ipa_nati_commit_add_batch(&batch, tbl_hdl, rule_hdls)) {
+		ret = -EIO;
+	}
+	ipa_nati_put_dma_cmd(tbl_indx, batch.cmd);
+
+#ifdef NAT_DUMP
+	ipa_nat_dump_ipv4_table(tbl_hdl);
+#endif
+
+	return ret;
+}
+
 int ipa_nati_generate_rule(uint32_t tbl_hdl,
 				const ipa_nat_ipv4_rule *clnt_rule,
 				struct ipa_nat_sw_rule *rule,
@@ -1282,18 +1764,26 @@ uint16_t ipa_nati_index_expn_get_free_entry(
 void ipa_nati_write_next_index(uint8_t tbl_indx,
 				nat_table_type tbl_type,
 				uint16_t value,
-				uint32_t offset)
+				uint32_t offset,
+				struct ipa_ioc_nat_dma_cmd *batch)
 {
 	struct ipa_ioc_nat_dma_cmd *cmd;
 
 	IPADBG("Updating next index field of table %d on collosion using dma\n", tbl_type);
 	IPADBG("table index: %d, value: %d offset;%d\n", tbl_indx, value, offset);
 
-	cmd = (struct ipa_ioc_nat_dma_cmd *)
-	malloc(sizeof(struct ipa_ioc_nat_dma_cmd)+
-				 sizeof(struct ipa_ioc_nat_dma_one));
+	/* Batched add, the caller posts the command */
+	if (NULL != batch) {
+		batch->dma[batch->entries].table_index = tbl_indx;
+		batch->dma[batch->entries].base_addr = tbl_type;
+		batch->dma[batch->entries].data = value;
+		batch->dma[batch->entries].offset = offset;
+		batch->entries++;
+		return;
+	}
+
+	cmd = ipa_nati_get_dma_cmd(tbl_indx);
 	if (NULL == cmd) {
-		IPAERR("unable to allocate memory\n");
 		return;
 	}
 
@@ -1303,7 +1793,7 @@ void ipa_nati_write_next_index(uint8_t tbl_indx,
 	cmd->dma[0].offset = offset;
 
 	cmd->entries = 1;
-	if (ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_NAT_DMA, cmd)) {
+	if (ipa_nati_post_dma_cmd(tbl_indx, cmd)) {
 		perror("ipa_nati_post_ipv4_dma_cmd(): ioctl error value");
 		IPAERR("unable to call dma icotl to update next index\n");
 		IPAERR("ipa fd %d\n", ipv4_nat_cache.ipa_fd);
@@ -1311,7 +1801,7 @@ void ipa_nati_write_next_index(uint8_t tbl_indx,
 	}
 
 fail:
-	free(cmd);
+	ipa_nati_put_dma_cmd(tbl_indx, cmd);
 
 	return;
 }
@@ -1319,7 +1809,8 @@ fail:
 void ipa_nati_copy_ipv4_rule_to_hw(
 				struct ipa_nat_ip4_table_cache *ipv4_cache,
 				struct ipa_nat_sw_rule *rule,
-				uint16_t entry, uint8_t tbl_index)
+				uint16_t entry, uint8_t tbl_index,
+				struct ipa_ioc_nat_dma_cmd *batch)
 {
 	struct ipa_nat_rule *tbl_ptr;
 	uint16_t prev_entry = rule->prev_index;
@@ -1355,7 +1846,7 @@ void ipa_nati_copy_ipv4_rule_to_hw(
 		offset = ipa_nati_get_entry_offset(ipv4_cache, tbl_type, prev_entry);
 		offset += IPA_NAT_RULE_NEXT_FIELD_OFFSET;
 
-		ipa_nati_write_next_index(tbl_index, tbl_type, entry, offset);
+		ipa_nati_write_next_index(tbl_index, tbl_type, entry, offset, batch);
 	}
 
 	return;
@@ -1365,7 +1856,8 @@ void ipa_nati_copy_ipv4_index_rule_to_hw(
 				struct ipa_nat_ip4_table_cache *ipv4_cache,
 				struct ipa_nat_indx_tbl_sw_rule *indx_sw_rule,
 				uint16_t entry,
-				uint8_t tbl_index)
+				uint8_t tbl_index,
+				struct ipa_ioc_nat_dma_cmd *batch)
 {
 	struct ipa_nat_indx_tbl_rule *tbl_ptr;
 	struct ipa_nat_sw_indx_tbl_rule sw_rule;
@@ -1406,54 +1898,66 @@ void ipa_nati_copy_ipv4_index_rule_to_hw(
 		offset += IPA_NAT_INDEX_RULE_NEXT_FIELD_OFFSET;
 
 		IPADBG("Updating next index field of index table on collosion using dma()\n");
-		ipa_nati_write_next_index(tbl_index, tbl_type, entry, offset);
+		ipa_nati_write_next_index(tbl_index, tbl_type, entry, offset, batch);
 	}
 
 	return;
 }
 
-int ipa_nati_post_ipv4_dma_cmd(uint8_t tbl_indx,
-				uint16_t entry)
+/**
+ * ipa_nati_gen_enable_dma_cmd() - dma command enabling a new rule
+ * @tbl_indx: [in] nat table index
+ * @entry: [in] base or expansion table entry of the rule
+ * @dma: [out] filled dma command
+ *
+ * Returns: None
+ */
+void ipa_nati_gen_enable_dma_cmd(uint8_t tbl_indx,
+				uint16_t entry,
+				struct ipa_ioc_nat_dma_one *dma)
 {
-	struct ipa_ioc_nat_dma_cmd *cmd;
 	struct ipa_nat_rule *tbl_ptr;
 	uint32_t offset = ipv4_nat_cache.ip4_tbl[tbl_indx].tbl_addr_offset;
-	int ret = 0;
-
-	cmd = (struct ipa_ioc_nat_dma_cmd *)
-	malloc(sizeof(struct ipa_ioc_nat_dma_cmd)+
-				 sizeof(struct ipa_ioc_nat_dma_one));
-	if (NULL == cmd) {
-		IPAERR("unable to allocate memory\n");
-		return -ENOMEM;
-	}
 
 	if (entry < ipv4_nat_cache.ip4_tbl[tbl_indx].table_entries) {
 		tbl_ptr =
 			 (struct ipa_nat_rule *)ipv4_nat_cache.ip4_tbl[tbl_indx].ipv4_rules_addr;
 
-		cmd->dma[0].table_index = tbl_indx;
-		cmd->dma[0].base_addr = IPA_NAT_BASE_TBL;
-		cmd->dma[0].data = IPA_NAT_FLAG_ENABLE_BIT_MASK;
+		dma->table_index = tbl_indx;
+		dma->base_addr = IPA_NAT_BASE_TBL;
+		dma->data = IPA_NAT_FLAG_ENABLE_BIT_MASK;
 
-		cmd->dma[0].offset = (char *)&tbl_ptr[entry] - (char *)tbl_ptr;
-		cmd->dma[0].offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
+		dma->offset = (char *)&tbl_ptr[entry] - (char *)tbl_ptr;
+		dma->offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
 	} else {
 		tbl_ptr =
 			 (struct ipa_nat_rule *)ipv4_nat_cache.ip4_tbl[tbl_indx].ipv4_expn_rules_addr;
 		entry = entry - ipv4_nat_cache.ip4_tbl[tbl_indx].table_entries;
 
-		cmd->dma[0].table_index = tbl_indx;
-		cmd->dma[0].base_addr = IPA_NAT_EXPN_TBL;
-		cmd->dma[0].data = IPA_NAT_FLAG_ENABLE_BIT_MASK;
+		dma->table_index = tbl_indx;
+		dma->base_addr = IPA_NAT_EXPN_TBL;
+		dma->data = IPA_NAT_FLAG_ENABLE_BIT_MASK;
 
-		cmd->dma[0].offset = (char *)&tbl_ptr[entry] - (char *)tbl_ptr;
-		cmd->dma[0].offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
-		cmd->dma[0].offset += offset;
+		dma->offset = (char *)&tbl_ptr[entry] - (char *)tbl_ptr;
+		dma->offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
+		dma->offset += offset;
 	}
+}
 
+int ipa_nati_post_ipv4_dma_cmd(uint8_t tbl_indx,
+				uint16_t entry)
+{
+	struct ipa_ioc_nat_dma_cmd *cmd;
+	int ret = 0;
+
+	cmd = ipa_nati_get_dma_cmd(tbl_indx);
+	if (NULL == cmd) {
+		return -ENOMEM;
+	}
+
+	ipa_nati_gen_enable_dma_cmd(tbl_indx, entry, &cmd->dma[0]);
 	cmd->entries = 1;
-	if (ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_NAT_DMA, cmd)) {
+	if (ipa_nati_post_dma_cmd(tbl_indx, cmd)) {
 		perror("ipa_nati_post_ipv4_dma_cmd(): ioctl error value");
 		IPAERR("unable to call dma icotl\n");
 		IPADBG("ipa fd %d\n", ipv4_nat_cache.ipa_fd);
@@ -1464,7 +1968,7 @@ int ipa_nati_post_ipv4_dma_cmd(uint8_t tbl_indx,
 
 
 fail:
-	free(cmd);
+	ipa_nati_put_dma_cmd(tbl_indx, cmd);
 
 	return ret;
 }
@@ -1519,16 +2023,158 @@ int ipa_nati_del_ipv4_rule(uint32_t tbl_hdl,
 	return 0;
 }
 
-void ReorderCmds(struct ipa_ioc_nat_dma_cmd *cmd, int size)
+/**
+ * ipa_nati_commit_del_batch() - post batched deletes, update sw tables
+ * @batch: [in/out] pending batch, emptied on return
+ * @ctx: [in] per rule state from ipa_nati_gen_del_dma_cmd()
+ * @rule_hdls: [in/out] handles of deleted rules are reset
+ *
+ * Returns: 0 on success, negative on failure
+ */
+static int ipa_nati_commit_del_batch(struct ipa_nat_dma_batch *batch,
+				struct ipa_nat_del_ctx *ctx,
+				uint32_t *rule_hdls)
+{
+	struct ipa_nat_ip4_table_cache *tbl_ptr;
+	uint32_t indx;
+	int ret, cnt;
+
+	tbl_ptr = &ipv4_nat_cache.ip4_tbl[batch->tbl_indx];
+	ret = ipa_nati_post_dma_batch(batch);
+
+	for (cnt = 0; cnt < batch->num_rules && ret == 0; cnt++) {
+		indx = batch->rule_indx[cnt];
+		ipa_nati_update_del_sw_rules(&ctx[cnt]);
+
+		/* Reset rule_id_array entry */
+		tbl_ptr->rule_id_array[rule_hdls[indx]-1] = IPA_NAT_INVALID_NAT_ENTRY;
+		rule_hdls[indx] = IPA_NAT_INVALID_NAT_ENTRY;
+	}
+
+	if (batch->num_rules && ret == 0) {
+		ipa_nati_del_dead_ipv4_head_nodes(batch->tbl_indx);
+	}
+
+	batch->num_rules = 0;
+	return ret;
+}
+
+/**
+ * ipa_nati_del_ipv4_rules() - delete several rules with batched dma
+ * @tbl_hdl: [in] nat table handle
+ * @rule_hdls: [in/out] rules to delete, reset to
+ *             IPA_NAT_INVALID_NAT_ENTRY once deleted
+ * @num_rules: [in] number of rules
+ *
+ * Returns: 0 if every rule was deleted, negative otherwise
+ */
+int ipa_nati_del_ipv4_rules(uint32_t tbl_hdl,
+				uint32_t *rule_hdls,
+				uint32_t num_rules)
+{
+	struct ipa_nat_ip4_table_cache *tbl_ptr;
+	struct ipa_nat_rule *rule_tbl;
+	struct ipa_nat_sw_rule sw_rule;
+	struct ipa_nat_dma_batch batch;
+	struct ipa_nat_del_ctx ctx[IPA_NAT_MAX_DMA_ENTRIES_PER_CMD];
+	ipa_nat_ipv4_rule clnt_rule;
+	uint16_t dst_bucket, src_bucket;
+	uint16_t tbl_entry;
+	uint8_t expn_tbl;
+	del_type rule_pos;
+	uint8_t tbl_indx = (uint8_t)(tbl_hdl - 1);
+	uint32_t cnt;
+	int ret = 0;
+
+	tbl_ptr = &ipv4_nat_cache.ip4_tbl[tbl_indx];
+	if (!tbl_ptr->valid) {
+		IPAERR("invalid table handle\n");
+		return -EINVAL;
+	}
+
+	if (ipa_nati_alloc_dma_batch(&batch, tbl_indx)) {
+		return -ENOMEM;
+	}
+
+	for (cnt = 0; cnt < num_rules; cnt++) {
+		if (IPA_NAT_INVALID_NAT_ENTRY == rule_hdls[cnt]) {
+			continue;
+		}
+
+		ipa_nati_parse_ipv4_rule_hdl(tbl_indx, (uint16_t)rule_hdls[cnt],
+																 &expn_tbl, &tbl_entry);
+		if (IPA_NAT_INVALID_NAT_ENTRY == tbl_entry) {
+			IPAERR("Invalid Rule Entry\n");
+			ret = -EINVAL;
+			continue;
+		}
+
+		rule_tbl = (struct ipa_nat_rule *)tbl_ptr->ipv4_rules_addr;
+		if (expn_tbl) {
+			rule_tbl = (struct ipa_nat_rule *)tbl_ptr->ipv4_expn_rules_addr;
+		}
+
+		/* Recover the lists the rule belongs to from the rule itself */
+		memcpy(&sw_rule, &rule_tbl[tbl_entry], sizeof(sw_rule));
+		clnt_rule.private_ip = sw_rule.private_ip;
+		clnt_rule.private_port = sw_rule.private_port;
+		clnt_rule.target_ip = sw_rule.target_ip;
+		clnt_rule.target_port = sw_rule.target_port;
+		clnt_rule.public_port = sw_rule.public_port;
+		clnt_rule.protocol = sw_rule.protocol;
+		ipa_nati_rule_buckets(tbl_ptr, &clnt_rule, &dst_bucket, &src_bucket);
+
+		if (ipa_nati_batch_conflict(&batch, dst_bucket, src_bucket)) {
+			if (ipa_nati_commit_del_batch(&batch, ctx, rule_hdls)) {
+				ret = -EIO;
+			}
+		}
+
+		ipa_nati_find_rule_pos(tbl_ptr, expn_tbl, tbl_entry, &rule_pos);
+		IPADBG("tbl_entry:%d expn_tbl:%d rule_pos:%d\n", tbl_entry, expn_tbl, rule_pos);
+
+		if (ipa_nati_gen_del_dma_cmd(tbl_indx, tbl_entry, expn_tbl, rule_pos,
+																 batch.cmd, &ctx[batch.num_rules])) {
+			ret = -EINVAL;
+			continue;
+		}
+
+		batch.dst_bucket[batch.num_rules] = dst_bucket;
+		batch.src_bucket[batch.num_rules] = src_bucket;
+		batch.rule_indx[batch.num_rules] = cnt;
+		batch.num_rules++;
+	}
+
+	if (ipa_nati_commit_del_batch(&batch, ctx, rule_hdls)) {
+		ret = -EIO;
+	}
+	ipa_nati_put_dma_cmd(tbl_indx, batch.cmd);
+
+#ifdef NAT_DUMP
+	IPADBG("Dumping Table after deleting rules\n");
+	ipa_nat_dump_ipv4_table(tbl_hdl);
+#endif
+
+	return ret;
+}
+
+/**
+ * ReorderCmds() - move index table commands ahead of base table ones
+ * @dma: [in/out] dma commands generated for one rule deletion
+ * @entries: [in] number of commands, at most IPA_NAT_MAX_DMA_ENTRIES_PER_RULE
+ *
+ * Returns: None
+ */
+void ReorderCmds(struct ipa_ioc_nat_dma_one *dma, int entries)
 {
 	int indx_tbl_start = 0, cnt, cnt1;
-	struct ipa_ioc_nat_dma_cmd *tmp;
+	struct ipa_ioc_nat_dma_one tmp[IPA_NAT_MAX_DMA_ENTRIES_PER_RULE];
 
-	IPADBG("called ReorderCmds() with entries :%d\n", cmd->entries);
+	IPADBG("called ReorderCmds() with entries :%d\n", entries);
 
-	for (cnt = 0; cnt < cmd->entries; cnt++) {
-		if (cmd->dma[cnt].base_addr == IPA_NAT_INDX_TBL ||
-				cmd->dma[cnt].base_addr == IPA_NAT_INDEX_EXPN_TBL) {
+	for (cnt = 0; cnt < entries; cnt++) {
+		if (dma[cnt].base_addr == IPA_NAT_INDX_TBL ||
+				dma[cnt].base_addr == IPA_NAT_INDEX_EXPN_TBL) {
 			indx_tbl_start = cnt;
 			break;
 		}
@@ -1539,27 +2185,18 @@ void ReorderCmds(struct ipa_ioc_nat_dma_cmd *cmd, int size)
 		return;
 	}
 
-	tmp = (struct ipa_ioc_nat_dma_cmd *)malloc(size);
-	if (tmp == NULL) {
-		IPAERR("unable to allocate memory\n");
-		return;
-	}
-
 	cnt1 = 0;
-	tmp->entries = cmd->entries;
-	for (cnt = indx_tbl_start; cnt < cmd->entries; cnt++) {
-		tmp->dma[cnt1] = cmd->dma[cnt];
+	for (cnt = indx_tbl_start; cnt < entries; cnt++) {
+		tmp[cnt1] = dma[cnt];
 		cnt1++;
 	}
 
 	for (cnt = 0; cnt < indx_tbl_start; cnt++) {
-		tmp->dma[cnt1] = cmd->dma[cnt];
+		tmp[cnt1] = dma[cnt];
 		cnt1++;
 	}
 
-	memset(cmd, 0, size);
-	memcpy(cmd, tmp, size);
-	free(tmp);
+	memcpy(dma, tmp, sizeof(struct ipa_ioc_nat_dma_one) * entries);
 
 	return;
 }
@@ -1569,35 +2206,74 @@ int ipa_nati_post_del_dma_cmd(uint8_t tbl_indx,
 				uint8_t expn_tbl,
 				del_type rule_pos)
 {
+	struct ipa_ioc_nat_dma_cmd *cmd;
+	struct ipa_nat_del_ctx ctx;
+	int ret = 0;
+
+	cmd = ipa_nati_get_dma_cmd(tbl_indx);
+	if (NULL == cmd) {
+		return -ENOMEM;
+	}
 
-#define MAX_DMA_ENTRIES_FOR_DEL 3
+	ret = ipa_nati_gen_del_dma_cmd(tbl_indx, cur_tbl_entry,
+					expn_tbl, rule_pos, cmd, &ctx);
+	if (ret) {
+		goto fail;
+	}
 
+	if (ipa_nati_post_dma_cmd(tbl_indx, cmd)) {
+		perror("ipa_nati_post_del_dma_cmd(): ioctl error value");
+		IPAERR("unable to post cmd\n");
+		IPADBG("ipa fd %d\n", ipv4_nat_cache.ipa_fd);
+		ret = -EIO;
+		goto fail;
+	}
+
+	ipa_nati_update_del_sw_rules(&ctx);
+
+fail:
+	ipa_nati_put_dma_cmd(tbl_indx, cmd);
+
+	return ret;
+}
+
+/**
+ * ipa_nati_gen_del_dma_cmd() - generate dma commands to delete a rule
+ * @tbl_indx: [in] nat table index
+ * @cur_tbl_entry: [in] entry of the rule in base/expansion table
+ * @expn_tbl: [in] rule lives in expansion table or not
+ * @rule_pos: [in] position of the rule in its base table list
+ * @cmd: [in/out] dma commands are appended after cmd->entries
+ * @ctx: [out] state needed by ipa_nati_update_del_sw_rules()
+ *
+ * Appends up to IPA_NAT_MAX_DMA_ENTRIES_PER_RULE commands, index
+ * table commands first. Nothing in the table is modified until
+ * the commands are posted and ipa_nati_update_del_sw_rules() runs.
+ *
+ * Returns: 0 on success, negative on failure
+ */
+int ipa_nati_gen_del_dma_cmd(uint8_t tbl_indx,
+				uint16_t cur_tbl_entry,
+				uint8_t expn_tbl,
+				del_type rule_pos,
+				struct ipa_ioc_nat_dma_cmd *cmd,
+				struct ipa_nat_del_ctx *ctx)
+{
 	struct ipa_nat_ip4_table_cache *cache_ptr;
 	struct ipa_nat_indx_tbl_rule *indx_tbl_ptr;
 	struct ipa_nat_rule *tbl_ptr;
-	int ret = 0, size = 0;
+	struct ipa_ioc_nat_dma_one *dma;
 
 	uint16_t indx_tbl_entry = IPA_NAT_INVALID_NAT_ENTRY;
 	del_type indx_rule_pos;
 
-	struct ipa_ioc_nat_dma_cmd *cmd;
 	uint8_t no_of_cmds = 0;
 
 	uint16_t prev_entry = IPA_NAT_INVALID_NAT_ENTRY;
 	uint16_t next_entry = IPA_NAT_INVALID_NAT_ENTRY;
 	uint16_t indx_next_entry = IPA_NAT_INVALID_NAT_ENTRY;
-	uint16_t indx_next_next_entry = IPA_NAT_INVALID_NAT_ENTRY;
-	uint16_t table_entry;
-
-	size = sizeof(struct ipa_ioc_nat_dma_cmd)+
-	(MAX_DMA_ENTRIES_FOR_DEL * sizeof(struct ipa_ioc_nat_dma_one));
-
-	cmd = (struct ipa_ioc_nat_dma_cmd *)malloc(size);
-	if (NULL == cmd) {
-		IPAERR("unable to allocate memory\n");
-		return -ENOMEM;
-	}
 
+	dma = &cmd->dma[cmd->entries];
 	cache_ptr = &ipv4_nat_cache.ip4_tbl[tbl_indx];
 	if (!expn_tbl) {
 		tbl_ptr = (struct ipa_nat_rule *)cache_ptr->ipv4_rules_addr;
@@ -1609,8 +2285,7 @@ int ipa_nati_post_del_dma_cmd(uint8_t tbl_indx,
 	if (!Read16BitFieldValue(tbl_ptr[cur_tbl_entry].ip_cksm_enbl,
 													 ENABLE_FIELD)) {
 		IPAERR("Deleting invalid(not enabled) rule\n");
-		ret = -EINVAL;
-		goto fail;
+		return -EINVAL;
 	}
 
 	indx_tbl_entry =
@@ -1622,30 +2297,30 @@ int ipa_nati_post_del_dma_cmd(uint8_t tbl_indx,
 	 ================================================*/
 	/* Just delete the current rule by disabling the flag field */
 	if (IPA_NAT_DEL_TYPE_ONLY_ONE == rule_pos) {
-		cmd->dma[no_of_cmds].table_index = tbl_indx;
-		cmd->dma[no_of_cmds].base_addr = IPA_NAT_BASE_TBL;
-		cmd->dma[no_of_cmds].data = IPA_NAT_FLAG_DISABLE_BIT_MASK;
+		dma[no_of_cmds].table_index = tbl_indx;
+		dma[no_of_cmds].base_addr = IPA_NAT_BASE_TBL;
+		dma[no_of_cmds].data = IPA_NAT_FLAG_DISABLE_BIT_MASK;
 
-		cmd->dma[no_of_cmds].offset =
+		dma[no_of_cmds].offset =
 			 ipa_nati_get_entry_offset(cache_ptr,
-					cmd->dma[no_of_cmds].base_addr,
+					dma[no_of_cmds].base_addr,
 					cur_tbl_entry);
-		cmd->dma[no_of_cmds].offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
+		dma[no_of_cmds].offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
 	}
 
 	/* Just update the protocol field to invalid */
 	else if (IPA_NAT_DEL_TYPE_HEAD == rule_pos) {
-		cmd->dma[no_of_cmds].table_index = tbl_indx;
-		cmd->dma[no_of_cmds].base_addr = IPA_NAT_BASE_TBL;
-		cmd->dma[no_of_cmds].data = IPA_NAT_INVALID_PROTO_FIELD_VALUE;
+		dma[no_of_cmds].table_index = tbl_indx;
+		dma[no_of_cmds].base_addr = IPA_NAT_BASE_TBL;
+		dma[no_of_cmds].data = IPA_NAT_INVALID_PROTO_FIELD_VALUE;
 
-		cmd->dma[no_of_cmds].offset =
+		dma[no_of_cmds].offset =
 			 ipa_nati_get_entry_offset(cache_ptr,
-					cmd->dma[no_of_cmds].base_addr,
+					dma[no_of_cmds].base_addr,
 					cur_tbl_entry);
-		cmd->dma[no_of_cmds].offset += IPA_NAT_RULE_PROTO_FIELD_OFFSET;
+		dma[no_of_cmds].offset += IPA_NAT_RULE_PROTO_FIELD_OFFSET;
 
-		IPADBG("writing invalid proto: 0x%x\n", cmd->dma[no_of_cmds].data);
+		IPADBG("writing invalid proto: 0x%x\n", dma[no_of_cmds].data);
 	}
 
 	/*
@@ -1657,22 +2332,22 @@ int ipa_nati_post_del_dma_cmd(uint8_t tbl_indx,
 			Read16BitFieldValue(tbl_ptr[cur_tbl_entry].sw_spec_params,
 				SW_SPEC_PARAM_PREV_INDEX_FIELD);
 
-		cmd->dma[no_of_cmds].table_index = tbl_indx;
-		cmd->dma[no_of_cmds].data =
+		dma[no_of_cmds].table_index = tbl_indx;
+		dma[no_of_cmds].data =
 			Read16BitFieldValue(tbl_ptr[cur_tbl_entry].nxt_indx_pub_port,
 					NEXT_INDEX_FIELD);
 
-		cmd->dma[no_of_cmds].base_addr = IPA_NAT_BASE_TBL;
+		dma[no_of_cmds].base_addr = IPA_NAT_BASE_TBL;
 		if (prev_entry >= cache_ptr->table_entries) {
-			cmd->dma[no_of_cmds].base_addr = IPA_NAT_EXPN_TBL;
+			dma[no_of_cmds].base_addr = IPA_NAT_EXPN_TBL;
 			prev_entry -= cache_ptr->table_entries;
 		}
 
-		cmd->dma[no_of_cmds].offset =
+		dma[no_of_cmds].offset =
 			ipa_nati_get_entry_offset(cache_ptr,
-				cmd->dma[no_of_cmds].base_addr, prev_entry);
+				dma[no_of_cmds].base_addr, prev_entry);
 
-		cmd->dma[no_of_cmds].offset += IPA_NAT_RULE_NEXT_FIELD_OFFSET;
+		dma[no_of_cmds].offset += IPA_NAT_RULE_NEXT_FIELD_OFFSET;
 	}
 
 	/*
@@ -1683,20 +2358,20 @@ int ipa_nati_post_del_dma_cmd(uint8_t tbl_indx,
 			Read16BitFieldValue(tbl_ptr[cur_tbl_entry].sw_spec_params,
 				SW_SPEC_PARAM_PREV_INDEX_FIELD);
 
-		cmd->dma[no_of_cmds].table_index = tbl_indx;
-		cmd->dma[no_of_cmds].data = IPA_NAT_INVALID_NAT_ENTRY;
+		dma[no_of_cmds].table_index = tbl_indx;
+		dma[no_of_cmds].data = IPA_NAT_INVALID_NAT_ENTRY;
 
-		cmd->dma[no_of_cmds].base_addr = IPA_NAT_BASE_TBL;
+		dma[no_of_cmds].base_addr = IPA_NAT_BASE_TBL;
 		if (prev_entry >= cache_ptr->table_entries) {
-			cmd->dma[no_of_cmds].base_addr = IPA_NAT_EXPN_TBL;
+			dma[no_of_cmds].base_addr = IPA_NAT_EXPN_TBL;
 			prev_entry -= cache_ptr->table_entries;
 		}
 
-		cmd->dma[no_of_cmds].offset =
+		dma[no_of_cmds].offset =
 			ipa_nati_get_entry_offset(cache_ptr,
-				cmd->dma[no_of_cmds].base_addr, prev_entry);
+				dma[no_of_cmds].base_addr, prev_entry);
 
-		cmd->dma[no_of_cmds].offset += IPA_NAT_RULE_NEXT_FIELD_OFFSET;
+		dma[no_of_cmds].offset += IPA_NAT_RULE_NEXT_FIELD_OFFSET;
 	}
 
 	/* ================================================
@@ -1723,16 +2398,16 @@ int ipa_nati_post_del_dma_cmd(uint8_t tbl_indx,
 	/* Just delete the current rule by resetting nat_table_index field to 0 */
 	if (IPA_NAT_DEL_TYPE_ONLY_ONE == indx_rule_pos) {
 		no_of_cmds++;
-		cmd->dma[no_of_cmds].base_addr = IPA_NAT_INDX_TBL;
-		cmd->dma[no_of_cmds].table_index = tbl_indx;
-		cmd->dma[no_of_cmds].data = IPA_NAT_INVALID_NAT_ENTRY;
+		dma[no_of_cmds].base_addr = IPA_NAT_INDX_TBL;
+		dma[no_of_cmds].table_index = tbl_indx;
+		dma[no_of_cmds].data = IPA_NAT_INVALID_NAT_ENTRY;
 
-		cmd->dma[no_of_cmds].offset =
+		dma[no_of_cmds].offset =
 			ipa_nati_get_index_entry_offset(cache_ptr,
-			cmd->dma[no_of_cmds].base_addr,
+			dma[no_of_cmds].base_addr,
 			indx_tbl_entry);
 
-		cmd->dma[no_of_cmds].offset +=
+		dma[no_of_cmds].offset +=
 			IPA_NAT_INDEX_RULE_NAT_INDEX_FIELD_OFFSET;
 	}
 
@@ -1745,37 +2420,37 @@ int ipa_nati_post_del_dma_cmd(uint8_t tbl_indx,
 		next_entry -= cache_ptr->table_entries;
 
 		no_of_cmds++;
-		cmd->dma[no_of_cmds].base_addr = IPA_NAT_INDX_TBL;
-		cmd->dma[no_of_cmds].table_index = tbl_indx;
+		dma[no_of_cmds].base_addr = IPA_NAT_INDX_TBL;
+		dma[no_of_cmds].table_index = tbl_indx;
 
 		/* Copy the nat_table_index field value of next entry */
 		indx_tbl_ptr =
 			 (struct ipa_nat_indx_tbl_rule *)cache_ptr->index_table_expn_addr;
-		cmd->dma[no_of_cmds].data =
+		dma[no_of_cmds].data =
 			Read16BitFieldValue(indx_tbl_ptr[next_entry].tbl_entry_nxt_indx,
 				INDX_TBL_TBL_ENTRY_FIELD);
 
-		cmd->dma[no_of_cmds].offset =
+		dma[no_of_cmds].offset =
 			ipa_nati_get_index_entry_offset(cache_ptr,
-					cmd->dma[no_of_cmds].base_addr,
+					dma[no_of_cmds].base_addr,
 					indx_tbl_entry);
 
-		cmd->dma[no_of_cmds].offset +=
+		dma[no_of_cmds].offset +=
 			IPA_NAT_INDEX_RULE_NAT_INDEX_FIELD_OFFSET;
 
 		/* Copy the next_index field value of next entry */
 		no_of_cmds++;
-		cmd->dma[no_of_cmds].base_addr = IPA_NAT_INDX_TBL;
-		cmd->dma[no_of_cmds].table_index = tbl_indx;
-		cmd->dma[no_of_cmds].data =
+		dma[no_of_cmds].base_addr = IPA_NAT_INDX_TBL;
+		dma[no_of_cmds].table_index = tbl_indx;
+		dma[no_of_cmds].data =
 			Read16BitFieldValue(indx_tbl_ptr[next_entry].tbl_entry_nxt_indx,
 				INDX_TBL_NEXT_INDEX_FILED);
 
-		cmd->dma[no_of_cmds].offset =
+		dma[no_of_cmds].offset =
 			ipa_nati_get_index_entry_offset(cache_ptr,
-				cmd->dma[no_of_cmds].base_addr, indx_tbl_entry);
+				dma[no_of_cmds].base_addr, indx_tbl_entry);
 
-		cmd->dma[no_of_cmds].offset +=
+		dma[no_of_cmds].offset +=
 			IPA_NAT_INDEX_RULE_NEXT_FIELD_OFFSET;
 		indx_next_entry = next_entry;
 	}
@@ -1788,27 +2463,27 @@ int ipa_nati_post_del_dma_cmd(uint8_t tbl_indx,
 		prev_entry = cache_ptr->index_expn_table_meta[indx_tbl_entry].prev_index;
 
 		no_of_cmds++;
-		cmd->dma[no_of_cmds].table_index = tbl_indx;
-		cmd->dma[no_of_cmds].data =
+		dma[no_of_cmds].table_index = tbl_indx;
+		dma[no_of_cmds].data =
 			Read16BitFieldValue(indx_tbl_ptr[indx_tbl_entry].tbl_entry_nxt_indx,
 				INDX_TBL_NEXT_INDEX_FILED);
 
-		cmd->dma[no_of_cmds].base_addr = IPA_NAT_INDX_TBL;
+		dma[no_of_cmds].base_addr = IPA_NAT_INDX_TBL;
 		if (prev_entry >= cache_ptr->table_entries) {
-			cmd->dma[no_of_cmds].base_addr = IPA_NAT_INDEX_EXPN_TBL;
+			dma[no_of_cmds].base_addr = IPA_NAT_INDEX_EXPN_TBL;
 			prev_entry -= cache_ptr->table_entries;
 		}
 
 		IPADBG("prev_entry: %d update with cur next_index: %d\n",
-				prev_entry, cmd->dma[no_of_cmds].data);
+				prev_entry, dma[no_of_cmds].data);
 		IPADBG("prev_entry: %d exist in table_type:%d\n",
-				prev_entry, cmd->dma[no_of_cmds].base_addr);
+				prev_entry, dma[no_of_cmds].base_addr);
 
-		cmd->dma[no_of_cmds].offset =
+		dma[no_of_cmds].offset =
 			ipa_nati_get_index_entry_offset(cache_ptr,
-				cmd->dma[no_of_cmds].base_addr, prev_entry);
+				dma[no_of_cmds].base_addr, prev_entry);
 
-		cmd->dma[no_of_cmds].offset +=
+		dma[no_of_cmds].offset +=
 			IPA_NAT_INDEX_RULE_NEXT_FIELD_OFFSET;
 	}
 
@@ -1817,42 +2492,71 @@ int ipa_nati_post_del_dma_cmd(uint8_t tbl_indx,
 		prev_entry = cache_ptr->index_expn_table_meta[indx_tbl_entry].prev_index;
 
 		no_of_cmds++;
-		cmd->dma[no_of_cmds].table_index = tbl_indx;
-		cmd->dma[no_of_cmds].data = IPA_NAT_INVALID_NAT_ENTRY;
+		dma[no_of_cmds].table_index = tbl_indx;
+		dma[no_of_cmds].data = IPA_NAT_INVALID_NAT_ENTRY;
 
-		cmd->dma[no_of_cmds].base_addr = IPA_NAT_INDX_TBL;
+		dma[no_of_cmds].base_addr = IPA_NAT_INDX_TBL;
 		if (prev_entry >= cache_ptr->table_entries) {
-			cmd->dma[no_of_cmds].base_addr = IPA_NAT_INDEX_EXPN_TBL;
+			dma[no_of_cmds].base_addr = IPA_NAT_INDEX_EXPN_TBL;
 			prev_entry -= cache_ptr->table_entries;
 		}
 
 		IPADBG("Reseting prev_entry: %d next_index\n", prev_entry);
 		IPADBG("prev_entry: %d exist in table_type:%d\n",
-			prev_entry, cmd->dma[no_of_cmds].base_addr);
+			prev_entry, dma[no_of_cmds].base_addr);
 
-		cmd->dma[no_of_cmds].offset =
+		dma[no_of_cmds].offset =
 			 ipa_nati_get_index_entry_offset(cache_ptr,
-					cmd->dma[no_of_cmds].base_addr, prev_entry);
+					dma[no_of_cmds].base_addr, prev_entry);
 
-		cmd->dma[no_of_cmds].offset +=
+		dma[no_of_cmds].offset +=
 			IPA_NAT_INDEX_RULE_NEXT_FIELD_OFFSET;
 	}
 
 	/* ================================================
 	 Index Table rule Deletion End
 	 ================================================*/
-	cmd->entries = no_of_cmds + 1;
-
-	if (cmd->entries > 1) {
-		ReorderCmds(cmd, size);
-	}
-	if (ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_NAT_DMA, cmd)) {
-		perror("ipa_nati_post_del_dma_cmd(): ioctl error value");
-		IPAERR("unable to post cmd\n");
-		IPADBG("ipa fd %d\n", ipv4_nat_cache.ipa_fd);
-		ret = -EIO;
-		goto fail;
+	if (no_of_cmds > 0) {
+		ReorderCmds(dma, no_of_cmds + 1);
 	}
+	cmd->entries += no_of_cmds + 1;
+
+	ctx->cache_ptr = cache_ptr;
+	ctx->tbl_ptr = tbl_ptr;
+	ctx->indx_tbl_ptr = indx_tbl_ptr;
+	ctx->cur_tbl_entry = cur_tbl_entry;
+	ctx->rule_pos = rule_pos;
+	ctx->indx_tbl_entry = indx_tbl_entry;
+	ctx->indx_rule_pos = indx_rule_pos;
+	ctx->indx_next_entry = indx_next_entry;
+
+	return 0;
+}
+
+/**
+ * ipa_nati_update_del_sw_rules() - update sw table state after delete
+ * @ctx: [in] state returned by ipa_nati_gen_del_dma_cmd()
+ *
+ * Must be called only after the dma commands generated along
+ * with ctx were posted successfully.
+ *
+ * Returns: None
+ */
+void ipa_nati_update_del_sw_rules(struct ipa_nat_del_ctx *ctx)
+{
+	struct ipa_nat_ip4_table_cache *cache_ptr = ctx->cache_ptr;
+	struct ipa_nat_rule *tbl_ptr = ctx->tbl_ptr;
+	struct ipa_nat_indx_tbl_rule *indx_tbl_ptr = ctx->indx_tbl_ptr;
+	uint16_t cur_tbl_entry = ctx->cur_tbl_entry;
+	del_type rule_pos = ctx->rule_pos;
+	uint16_t indx_tbl_entry = ctx->indx_tbl_entry;
+	del_type indx_rule_pos = ctx->indx_rule_pos;
+	uint16_t indx_next_entry = ctx->indx_next_entry;
+
+	uint16_t prev_entry = IPA_NAT_INVALID_NAT_ENTRY;
+	uint16_t next_entry = IPA_NAT_INVALID_NAT_ENTRY;
+	uint16_t indx_next_next_entry = IPA_NAT_INVALID_NAT_ENTRY;
+	uint16_t table_entry;
 
 	/* if entry exist in IPA_NAT_DEL_TYPE_MIDDLE of list
 			 Update the previous entry in sw specific parameters
@@ -1960,10 +2664,7 @@ int ipa_nati_post_del_dma_cmd(uint8_t tbl_indx,
 
 	}
 
-fail:
-	free(cmd);
-
-	return ret;
+	return;
 }
 
 void ipa_nati_find_index_rule_pos(
@@ -2058,6 +2759,7 @@ void ipa_nat_dump_ipv4_table(uint32_t tbl_hdl)
 {
 	struct ipa_nat_rule *tbl_ptr;
 	struct ipa_nat_indx_tbl_rule *indx_tbl_ptr;
+	ipa_nat_ipv4_tbl_stats stats;
 	int cnt;
 	uint8_t atl_one = 0;
 
@@ -2147,6 +2849,23 @@ void ipa_nat_dump_ipv4_table(uint32_t tbl_hdl)
 	}
 	atl_one = 0;
 
+	/* Print occupancy and chain lengths */
+	if (!ipa_nati_query_ipv4_tbl_stats(tbl_hdl, &stats)) {
+		IPADUMP("Base: %d/%d  Expn: %d/%d  Index: %d/%d  Index-expn: %d/%d\n",
+						stats.base_used, stats.table_entries,
+						stats.expn_used, stats.expn_table_entries,
+						stats.index_used, stats.table_entries,
+						stats.index_expn_used, stats.expn_table_entries);
+		IPADUMP("Chain length:");
+		for (cnt = 0; cnt < IPA_NAT_CHAIN_HIST_BUCKETS; cnt++) {
+			IPADUMP(" %d%s:%d/%d", cnt,
+							(cnt == IPA_NAT_CHAIN_HIST_BUCKETS - 1) ? "+" : "",
+							stats.chain_hist[cnt], stats.index_chain_hist[cnt]);
+		}
+		IPADUMP("  max:%d/%d\n", stats.max_chain, stats.max_index_chain);
+		IPADUMP("Dma cmds: %d  entries: %d  allocs: %d\n",
+						stats.dma_cmds, stats.dma_entries, stats.dma_cmd_allocs);
+	}
 }
 
 void ipa_nati_print_rule(
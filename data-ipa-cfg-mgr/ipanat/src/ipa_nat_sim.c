@@ -0,0 +1,218 @@
+/*
+Copyright (c) 2013, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ipa_nat_drv.h"
+#include "ipa_nat_drvi.h"
+
+#ifdef IPA_NAT_SIM
+
+/* Fake descriptors handed out for /dev/ipa and the nat table device */
+#define IPA_NAT_SIM_IPA_FD   0x7a01
+#define IPA_NAT_SIM_NAT_FD   0x7a02
+
+#define IPA_NAT_SIM_NUM_TBLS  (IPA_NAT_INDEX_EXPN_TBL + 1)
+
+/**
+ * struct ipa_nat_sim_dev - emulated nat memory
+ * @mem: nat table memory, what the device would let us mmap
+ * @size: size of @mem
+ * @tbl_offset: offset of each nat_table_type table in @mem,
+ *	set by IPA_IOC_V4_INIT_NAT
+ * @init: IPA_IOC_V4_INIT_NAT was posted
+ */
+struct ipa_nat_sim_dev {
+	char *mem;
+	size_t size;
+	uint32_t tbl_offset[IPA_NAT_SIM_NUM_TBLS];
+	uint8_t init;
+};
+
+static struct ipa_nat_sim_dev ipa_nat_sim;
+
+int ipa_nat_sim_open(const char *path, int flags)
+{
+	if (!strcmp(path, IPA_DEV_NAME)) {
+		return IPA_NAT_SIM_IPA_FD;
+	}
+
+	if (!strcmp(path, NAT_DEV_FULL_NAME) && NULL != ipa_nat_sim.mem) {
+		return IPA_NAT_SIM_NAT_FD;
+	}
+
+	IPAERR("no such simulated device %s\n", path);
+	errno = ENOENT;
+	return -1;
+}
+
+int ipa_nat_sim_close(int fd)
+{
+	if (IPA_NAT_SIM_IPA_FD != fd && IPA_NAT_SIM_NAT_FD != fd) {
+		errno = EBADF;
+		return -1;
+	}
+	return 0;
+}
+
+void *ipa_nat_sim_mmap(void *addr, size_t len, int prot, int flags,
+		int fd, off_t offset)
+{
+	if (IPA_NAT_SIM_NAT_FD != fd || NULL == ipa_nat_sim.mem ||
+			offset + len > ipa_nat_sim.size) {
+		IPAERR("invalid simulated mmap fd %d len %zu\n", fd, len);
+		return NULL;
+	}
+
+	return ipa_nat_sim.mem + offset;
+}
+
+int ipa_nat_sim_munmap(void *addr, size_t len)
+{
+	return 0;
+}
+
+/**
+ * ipa_nat_sim_dma() - Apply a dma command to the nat memory
+ * @cmd: [in] dma command
+ *
+ * Each entry writes 16 bits at the given offset of the
+ * selected table, as the IPA does for IPA_IOC_NAT_DMA
+ *
+ * Returns: 0 on success, negative on failure
+ */
+static int ipa_nat_sim_dma(struct ipa_ioc_nat_dma_cmd *cmd)
+{
+	uint32_t addr;
+	uint16_t data;
+	int cnt;
+
+	if (!ipa_nat_sim.init) {
+		IPAERR("dma before nat init\n");
+		return -EPERM;
+	}
+
+	/* validate everything first, the command is applied as a whole */
+	for (cnt = 0; cnt < cmd->entries; cnt++) {
+		if (cmd->dma[cnt].table_index >= IPA_NAT_MAX_IP4_TBLS ||
+				cmd->dma[cnt].base_addr >= IPA_NAT_SIM_NUM_TBLS) {
+			IPAERR("invalid dma entry %d\n", cnt);
+			return -EINVAL;
+		}
+
+		addr = ipa_nat_sim.tbl_offset[cmd->dma[cnt].base_addr] +
+			 cmd->dma[cnt].offset;
+		if (addr + sizeof(data) > ipa_nat_sim.size) {
+			IPAERR("dma entry %d offset 0x%x out of range\n", cnt, addr);
+			return -EINVAL;
+		}
+	}
+
+	for (cnt = 0; cnt < cmd->entries; cnt++) {
+		addr = ipa_nat_sim.tbl_offset[cmd->dma[cnt].base_addr] +
+			 cmd->dma[cnt].offset;
+		data = cmd->dma[cnt].data;
+		memcpy(ipa_nat_sim.mem + addr, &data, sizeof(data));
+	}
+
+	return 0;
+}
+
+int ipa_nat_sim_ioctl(int fd, unsigned long req, void *arg)
+{
+	struct ipa_ioc_nat_alloc_mem *mem;
+	struct ipa_ioc_v4_nat_init *init;
+	int ret = 0;
+
+	if (IPA_NAT_SIM_IPA_FD != fd) {
+		errno = EBADF;
+		return -1;
+	}
+
+	switch (req) {
+	case IPA_IOC_ALLOC_NAT_MEM:
+		mem = (struct ipa_ioc_nat_alloc_mem *)arg;
+		if (NULL != ipa_nat_sim.mem) {
+			ret = -EEXIST;
+			break;
+		}
+		ipa_nat_sim.mem = calloc(1, mem->size);
+		if (NULL == ipa_nat_sim.mem) {
+			ret = -ENOMEM;
+			break;
+		}
+		ipa_nat_sim.size = mem->size;
+		mem->offset = 0;
+		break;
+
+	case IPA_IOC_V4_INIT_NAT:
+		init = (struct ipa_ioc_v4_nat_init *)arg;
+		ipa_nat_sim.tbl_offset[IPA_NAT_BASE_TBL] = init->ipv4_rules_offset;
+		ipa_nat_sim.tbl_offset[IPA_NAT_EXPN_TBL] = init->expn_rules_offset;
+		ipa_nat_sim.tbl_offset[IPA_NAT_INDX_TBL] = init->index_offset;
+		ipa_nat_sim.tbl_offset[IPA_NAT_INDEX_EXPN_TBL] = init->index_expn_offset;
+		ipa_nat_sim.init = 1;
+		break;
+
+	case IPA_IOC_NAT_DMA:
+		ret = ipa_nat_sim_dma((struct ipa_ioc_nat_dma_cmd *)arg);
+		break;
+
+	case IPA_IOC_V4_DEL_NAT:
+		free(ipa_nat_sim.mem);
+		memset(&ipa_nat_sim, 0, sizeof(ipa_nat_sim));
+		break;
+
+	default:
+		IPAERR("unsupported simulated ioctl 0x%lx\n", req);
+		ret = -ENOTTY;
+		break;
+	}
+
+	if (ret) {
+		errno = -ret;
+		return -1;
+	}
+	return 0;
+}
+
+#if !defined(__BIONIC__) && !defined(USE_GLIB)
+size_t ipa_nat_sim_strlcpy(char *dst, const char *src, size_t size)
+{
+	size_t len = strlen(src);
+
+	if (size) {
+		size_t cnt = (len < size - 1) ? len : size - 1;
+
+		memcpy(dst, src, cnt);
+		dst[cnt] = '\0';
+	}
+	return len;
+}
+#endif
+
+#endif /* IPA_NAT_SIM */
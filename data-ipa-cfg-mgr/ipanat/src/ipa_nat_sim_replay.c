@@ -0,0 +1,506 @@
+/*
+Copyright (c) 2013, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Host benchmark for the nat table code, built with IPA_NAT_SIM so the
+ * device is emulated by ipa_nat_sim.c.
+ *
+ * Replays a trace of rule operations against one ipv4 nat table and
+ * reports per-operation latency, chain lengths and table fill. Trace
+ * lines, '#' starts a comment:
+ *
+ *   add <id> <private ip> <private port> <target ip> <target port>
+ *       <public port> <protocol>
+ *   del <id>
+ *   query <id>
+ *   stats
+ *
+ * <id> names a flow within the trace, "stats" prints the table
+ * occupancy at that point. Without a trace file, -g generates a
+ * reproducible add/delete/query churn instead.
+ */
+
+#include "ipa_nat_drv.h"
+#include "ipa_nat_drvi.h"
+
+#include <time.h>
+#include <arpa/inet.h>
+
+#define IPA_NAT_REPLAY_DEF_ENTRIES   1000
+#define IPA_NAT_REPLAY_DEF_PUBLIC_IP 0x0a000001
+#define IPA_NAT_REPLAY_MAX_LINE      256
+
+enum ipa_nat_replay_op {
+	IPA_NAT_REPLAY_ADD,
+	IPA_NAT_REPLAY_DEL,
+	IPA_NAT_REPLAY_QUERY,
+	IPA_NAT_REPLAY_MAX_OP
+};
+
+static const char *ipa_nat_replay_op_name[IPA_NAT_REPLAY_MAX_OP] = {
+	"add", "del", "query"
+};
+
+/**
+ * struct ipa_nat_replay_lat - latency samples of one operation type
+ * @ns: sample per call, in ns
+ * @num: samples recorded
+ * @max: room in @ns
+ * @failed: calls that returned an error
+ */
+struct ipa_nat_replay_lat {
+	uint64_t *ns;
+	uint32_t num;
+	uint32_t max;
+	uint32_t failed;
+};
+
+/**
+ * struct ipa_nat_replay - replay state
+ * @tbl_hdl: nat table under test
+ * @rule_hdl: rule handle per trace flow id, 0 when not installed
+ * @num_ids: room in @rule_hdl
+ * @lat: latency per operation type
+ */
+struct ipa_nat_replay {
+	uint32_t tbl_hdl;
+	uint32_t *rule_hdl;
+	uint32_t num_ids;
+	struct ipa_nat_replay_lat lat[IPA_NAT_REPLAY_MAX_OP];
+};
+
+static uint64_t ipa_nat_replay_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int ipa_nat_replay_record(struct ipa_nat_replay_lat *lat,
+				uint64_t ns, int ret)
+{
+	uint64_t *tmp;
+
+	if (ret != 0) {
+		lat->failed++;
+	}
+
+	if (lat->num == lat->max) {
+		lat->max = lat->max ? 2 * lat->max : 1024;
+		tmp = (uint64_t *)realloc(lat->ns, lat->max * sizeof(*lat->ns));
+		if (NULL == tmp) {
+			IPAERR("unable to allocate latency samples\n");
+			return -ENOMEM;
+		}
+		lat->ns = tmp;
+	}
+	lat->ns[lat->num++] = ns;
+	return 0;
+}
+
+/* grow the id -> rule handle map so that @id fits */
+static int ipa_nat_replay_reserve(struct ipa_nat_replay *rp, uint32_t id)
+{
+	uint32_t *tmp, num;
+
+	if (id < rp->num_ids) {
+		return 0;
+	}
+
+	num = rp->num_ids ? rp->num_ids : 1024;
+	while (num <= id) {
+		num *= 2;
+	}
+	tmp = (uint32_t *)realloc(rp->rule_hdl, num * sizeof(*rp->rule_hdl));
+	if (NULL == tmp) {
+		IPAERR("unable to allocate %u flow ids\n", num);
+		return -ENOMEM;
+	}
+	memset(tmp + rp->num_ids, 0, (num - rp->num_ids) * sizeof(*tmp));
+	rp->rule_hdl = tmp;
+	rp->num_ids = num;
+	return 0;
+}
+
+static int ipa_nat_replay_add(struct ipa_nat_replay *rp, uint32_t id,
+				const ipa_nat_ipv4_rule *rule)
+{
+	uint64_t start, end;
+	uint32_t hdl = 0;
+	int ret;
+
+	if (ipa_nat_replay_reserve(rp, id)) {
+		return -ENOMEM;
+	}
+	if (rp->rule_hdl[id] != 0) {
+		IPAERR("flow %u added twice\n", id);
+		return -EINVAL;
+	}
+
+	start = ipa_nat_replay_now();
+	ret = ipa_nat_add_ipv4_rule(rp->tbl_hdl, rule, &hdl);
+	end = ipa_nat_replay_now();
+
+	if (ret == 0) {
+		rp->rule_hdl[id] = hdl;
+	}
+	return ipa_nat_replay_record(&rp->lat[IPA_NAT_REPLAY_ADD], end - start, ret);
+}
+
+static int ipa_nat_replay_del(struct ipa_nat_replay *rp, uint32_t id)
+{
+	uint64_t start, end;
+	int ret;
+
+	if (id >= rp->num_ids || rp->rule_hdl[id] == 0) {
+		/* the add failed or never happened, nothing to time */
+		rp->lat[IPA_NAT_REPLAY_DEL].failed++;
+		return 0;
+	}
+
+	start = ipa_nat_replay_now();
+	ret = ipa_nat_del_ipv4_rule(rp->tbl_hdl, rp->rule_hdl[id]);
+	end = ipa_nat_replay_now();
+
+	rp->rule_hdl[id] = 0;
+	return ipa_nat_replay_record(&rp->lat[IPA_NAT_REPLAY_DEL], end - start, ret);
+}
+
+static int ipa_nat_replay_query(struct ipa_nat_replay *rp, uint32_t id)
+{
+	uint64_t start, end;
+	uint32_t ts;
+	int ret;
+
+	if (id >= rp->num_ids || rp->rule_hdl[id] == 0) {
+		rp->lat[IPA_NAT_REPLAY_QUERY].failed++;
+		return 0;
+	}
+
+	start = ipa_nat_replay_now();
+	ret = ipa_nat_query_timestamp(rp->tbl_hdl, rp->rule_hdl[id], &ts);
+	end = ipa_nat_replay_now();
+
+	return ipa_nat_replay_record(&rp->lat[IPA_NAT_REPLAY_QUERY], end - start, ret);
+}
+
+static void ipa_nat_replay_print_stats(struct ipa_nat_replay *rp)
+{
+	ipa_nat_ipv4_tbl_stats stats;
+	int i;
+
+	if (ipa_nat_query_ipv4_tbl_stats(rp->tbl_hdl, &stats)) {
+		IPAERR("unable to query table stats\n");
+		return;
+	}
+
+	printf("table fill: base %u/%u (%.1f%%), expn %u/%u (%.1f%%)\n",
+		stats.base_used, stats.table_entries,
+		stats.table_entries ? 100.0 * stats.base_used / stats.table_entries : 0.0,
+		stats.expn_used, stats.expn_table_entries,
+		stats.expn_table_entries ? 100.0 * stats.expn_used / stats.expn_table_entries : 0.0);
+	printf("index fill: base %u/%u, expn %u/%u\n",
+		stats.index_used, stats.table_entries,
+		stats.index_expn_used, stats.expn_table_entries);
+	printf("max chain: rules %u, index %u\n",
+		stats.max_chain, stats.max_index_chain);
+
+	printf("chain length  rule buckets  index buckets\n");
+	for (i = 0; i < IPA_NAT_CHAIN_HIST_BUCKETS; i++) {
+		printf("%*d%s  %12u  %13u\n", 11, i,
+			(i == IPA_NAT_CHAIN_HIST_BUCKETS - 1) ? "+" : " ",
+			stats.chain_hist[i], stats.index_chain_hist[i]);
+	}
+	printf("dma: %u commands, %u entries, %u command allocations\n",
+		stats.dma_cmds, stats.dma_entries, stats.dma_cmd_allocs);
+}
+
+static int ipa_nat_replay_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void ipa_nat_replay_print_lat(struct ipa_nat_replay *rp)
+{
+	struct ipa_nat_replay_lat *lat;
+	uint64_t sum;
+	uint32_t i;
+	int op;
+
+	printf("%-6s %8s %7s %9s %9s %9s %9s %9s\n", "op", "count", "failed",
+		"min ns", "avg ns", "p50 ns", "p99 ns", "max ns");
+	for (op = 0; op < IPA_NAT_REPLAY_MAX_OP; op++) {
+		lat = &rp->lat[op];
+		if (lat->num == 0) {
+			printf("%-6s %8u %7u\n", ipa_nat_replay_op_name[op], 0, lat->failed);
+			continue;
+		}
+
+		qsort(lat->ns, lat->num, sizeof(*lat->ns), ipa_nat_replay_cmp);
+		for (i = 0, sum = 0; i < lat->num; i++) {
+			sum += lat->ns[i];
+		}
+		printf("%-6s %8u %7u %9llu %9llu %9llu %9llu %9llu\n",
+			ipa_nat_replay_op_name[op], lat->num, lat->failed,
+			(unsigned long long)lat->ns[0],
+			(unsigned long long)(sum / lat->num),
+			(unsigned long long)lat->ns[lat->num / 2],
+			(unsigned long long)lat->ns[(uint64_t)lat->num * 99 / 100],
+			(unsigned long long)lat->ns[lat->num - 1]);
+	}
+}
+
+static int ipa_nat_replay_parse_ip(const char *str, uint32_t *ip)
+{
+	struct in_addr addr;
+
+	if (inet_pton(AF_INET, str, &addr) != 1) {
+		return -EINVAL;
+	}
+	*ip = ntohl(addr.s_addr);
+	return 0;
+}
+
+static int ipa_nat_replay_line(struct ipa_nat_replay *rp, char *line,
+				unsigned int lineno)
+{
+	char op[16], pip[20], tip[20];
+	unsigned int id, pport, tport, pubport, proto;
+	ipa_nat_ipv4_rule rule;
+	char *hash;
+	int n;
+
+	hash = strchr(line, '#');
+	if (hash != NULL) {
+		*hash = '\0';
+	}
+	if (sscanf(line, "%15s", op) != 1) {
+		return 0;
+	}
+
+	if (!strcmp(op, "add")) {
+		n = sscanf(line, "%*s %u %19s %u %19s %u %u %u", &id, pip, &pport,
+			tip, &tport, &pubport, &proto);
+		memset(&rule, 0, sizeof(rule));
+		if (n != 7 ||
+			ipa_nat_replay_parse_ip(pip, &rule.private_ip) ||
+			ipa_nat_replay_parse_ip(tip, &rule.target_ip)) {
+			goto bad;
+		}
+		rule.private_port = (uint16_t)pport;
+		rule.target_port = (uint16_t)tport;
+		rule.public_port = (uint16_t)pubport;
+		rule.protocol = (uint8_t)proto;
+		return ipa_nat_replay_add(rp, id, &rule);
+	} else if (!strcmp(op, "del")) {
+		if (sscanf(line, "%*s %u", &id) != 1) {
+			goto bad;
+		}
+		return ipa_nat_replay_del(rp, id);
+	} else if (!strcmp(op, "query")) {
+		if (sscanf(line, "%*s %u", &id) != 1) {
+			goto bad;
+		}
+		return ipa_nat_replay_query(rp, id);
+	} else if (!strcmp(op, "stats")) {
+		printf("-- stats at line %u --\n", lineno);
+		ipa_nat_replay_print_stats(rp);
+		return 0;
+	}
+
+bad:
+	IPAERR("line %u: cannot parse \"%s\"\n", lineno, line);
+	return -EINVAL;
+}
+
+static int ipa_nat_replay_file(struct ipa_nat_replay *rp, const char *path)
+{
+	char line[IPA_NAT_REPLAY_MAX_LINE];
+	unsigned int lineno = 0;
+	FILE *fp;
+	int ret = 0;
+
+	fp = strcmp(path, "-") ? fopen(path, "r") : stdin;
+	if (NULL == fp) {
+		PERROR("unable to open trace");
+		return -errno;
+	}
+
+	while (ret == 0 && fgets(line, sizeof(line), fp) != NULL) {
+		lineno++;
+		line[strcspn(line, "\n")] = '\0';
+		ret = ipa_nat_replay_line(rp, line, lineno);
+	}
+
+	if (fp != stdin) {
+		fclose(fp);
+	}
+	return ret;
+}
+
+/* xorshift32, keeps generated traces identical across libcs */
+static uint32_t ipa_nat_replay_rand(uint32_t *state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+/*
+ * Synthetic churn: @num_ops operations over at most @working_set live
+ * flows. Adds dominate until the working set is reached, then flows are
+ * deleted and replaced, with a query mixed in every few operations.
+ */
+static int ipa_nat_replay_generate(struct ipa_nat_replay *rp,
+				uint32_t num_ops, uint32_t working_set, uint32_t seed)
+{
+	ipa_nat_ipv4_rule rule;
+	uint32_t *live, num_live = 0, next_id = 0, state, r, i, slot;
+	int ret = 0;
+
+	live = (uint32_t *)calloc(working_set, sizeof(*live));
+	if (NULL == live) {
+		IPAERR("unable to allocate working set\n");
+		return -ENOMEM;
+	}
+	state = seed ? seed : 1;
+
+	for (i = 0; i < num_ops && ret == 0; i++) {
+		r = ipa_nat_replay_rand(&state) % 100;
+
+		if (num_live > 0 && r < 15) {
+			slot = ipa_nat_replay_rand(&state) % num_live;
+			ret = ipa_nat_replay_query(rp, live[slot]);
+		} else if (num_live > 0 &&
+			(num_live == working_set || r < 15 + 35 * num_live / working_set)) {
+			slot = ipa_nat_replay_rand(&state) % num_live;
+			ret = ipa_nat_replay_del(rp, live[slot]);
+			live[slot] = live[--num_live];
+		} else {
+			memset(&rule, 0, sizeof(rule));
+			rule.private_ip = 0xc0a80000 | (ipa_nat_replay_rand(&state) & 0xffff);
+			rule.target_ip = ipa_nat_replay_rand(&state);
+			rule.private_port = (uint16_t)ipa_nat_replay_rand(&state);
+			rule.target_port = (uint16_t)ipa_nat_replay_rand(&state);
+			rule.public_port = (uint16_t)ipa_nat_replay_rand(&state);
+			rule.protocol = (ipa_nat_replay_rand(&state) & 1) ? IPPROTO_TCP : IPPROTO_UDP;
+			ret = ipa_nat_replay_add(rp, next_id, &rule);
+			if (ret == 0 && rp->rule_hdl[next_id] != 0) {
+				/* only flows the table accepted can be deleted/queried */
+				live[num_live++] = next_id;
+			}
+			next_id++;
+		}
+	}
+
+	free(live);
+	return ret;
+}
+
+static void ipa_nat_replay_usage(const char *prog)
+{
+	printf("usage: %s [-e entries] [-p public ip] [trace | -]\n"
+		"       %s [-e entries] [-p public ip] -g ops [-w working set] [-s seed]\n",
+		prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+	struct ipa_nat_replay rp;
+	uint32_t public_ip = IPA_NAT_REPLAY_DEF_PUBLIC_IP;
+	uint32_t entries = IPA_NAT_REPLAY_DEF_ENTRIES;
+	uint32_t num_ops = 0, working_set = 0, seed = 1;
+	const char *trace = NULL;
+	int opt, ret, op;
+
+	while ((opt = getopt(argc, argv, "e:p:g:w:s:h")) != -1) {
+		switch (opt) {
+		case 'e':
+			entries = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			if (ipa_nat_replay_parse_ip(optarg, &public_ip)) {
+				ipa_nat_replay_usage(argv[0]);
+				return 1;
+			}
+			break;
+		case 'g':
+			num_ops = strtoul(optarg, NULL, 0);
+			break;
+		case 'w':
+			working_set = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			ipa_nat_replay_usage(argv[0]);
+			return 1;
+		}
+	}
+	if (optind < argc) {
+		trace = argv[optind];
+	}
+	if ((trace == NULL) == (num_ops == 0) || entries == 0 || entries > 0xffff) {
+		ipa_nat_replay_usage(argv[0]);
+		return 1;
+	}
+	if (working_set == 0) {
+		working_set = entries;
+	}
+
+	memset(&rp, 0, sizeof(rp));
+	if (ipa_nat_add_ipv4_tbl(public_ip, (uint16_t)entries, &rp.tbl_hdl)) {
+		IPAERR("unable to create a table of %u entries\n", entries);
+		return 1;
+	}
+
+	if (trace != NULL) {
+		ret = ipa_nat_replay_file(&rp, trace);
+	} else {
+		ret = ipa_nat_replay_generate(&rp, num_ops, working_set, seed);
+	}
+
+	ipa_nat_replay_print_lat(&rp);
+	ipa_nat_replay_print_stats(&rp);
+
+	ipa_nat_del_ipv4_tbl(rp.tbl_hdl);
+	for (op = 0; op < IPA_NAT_REPLAY_MAX_OP; op++) {
+		free(rp.lat[op].ns);
+	}
+	free(rp.rule_hdl);
+	return ret ? 1 : 0;
+}